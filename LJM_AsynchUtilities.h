@@ -0,0 +1,480 @@
+/**
+ * Name: LJM_AsynchUtilities.h
+ * Desc: Provides a buffered asynchronous serial (UART) port. Once started, a
+ *       background thread continuously drains ASYNCH_DATA_RX into a host-side
+ *       ring buffer and sends bytes written with AsynchWrite, coalesced into
+ *       transmissions of up to the device's TX buffer size. AsynchRead and
+ *       AsynchWrite only access the host-side buffers, so they do not
+ *       communicate with the device and support timeouts.
+ *       The poll interval is chosen from the baud rate so that the device's
+ *       RX buffer is drained before it can fill.
+ * Note: While an AsynchPort is running, only its thread should communicate
+ *       with the ASYNCH_* registers of the device.
+ *       Programs that include this file must link with pthread on Linux and
+ *       Mac OS X (see LJM_ThreadUtilities.h).
+**/
+
+#ifndef LJM_ASYNCH_UTILITIES
+#define LJM_ASYNCH_UTILITIES
+
+#include "LJM_ThreadUtilities.h"
+
+// The sizes of the host-side buffers
+enum { ASYNCH_HOST_RX_BYTES = 65536 };
+enum { ASYNCH_HOST_TX_BYTES = 8192 };
+
+// The largest device RX or TX buffer an AsynchPort uses
+enum { ASYNCH_MAX_DEVICE_BUFFER_BYTES = 2048 };
+
+enum { ASYNCH_MIN_POLL_MS = 1 };
+enum { ASYNCH_MAX_POLL_MS = 50 };
+
+typedef struct AsynchPort {
+	int handle;
+
+	// Configuration
+	int rxDIONum;
+	int txDIONum;
+	int baud;
+	int numDataBits;
+	int parity;
+	int numStopBits;
+	int deviceRXBufferBytes;
+	int deviceTXBufferBytes;
+
+	// Start bit, data bits, parity bit and stop bits
+	int bitsPerByte;
+
+	// The poll interval, from the time the device RX buffer takes to half fill
+	int pollMS;
+
+	Thread thread;
+	Mutex mutex;
+	volatile int stopRequested;
+
+	// Host-side RX ring buffer, protected by mutex
+	unsigned char aRXRing[ASYNCH_HOST_RX_BYTES];
+	int rxHead;
+	int rxCount;
+
+	// Bytes written with AsynchWrite that have not been sent yet, protected by
+	// mutex
+	unsigned char aTXPending[ASYNCH_HOST_TX_BYTES];
+	int txCount;
+
+	// The host tick when the last transmission will have finished
+	LJM_LONG_LONG_RETURN txBusyUntil;
+
+	// Reused by the thread
+	double aValues[ASYNCH_MAX_DEVICE_BUFFER_BYTES + 3];
+	const char * aNames[4];
+	int aWrites[4];
+	int aNumValues[4];
+
+	// Statistics
+	unsigned long numPolls;
+	unsigned long numBytesReceived;
+	unsigned long numBytesSent;
+	unsigned long numTransmissions;
+	unsigned long numBytesDropped;
+	int maxDeviceRXBacklog;
+	unsigned long numErrors;
+	int lastErr;
+} AsynchPort;
+
+/**
+ * Desc: Initializes port. Nothing is written to the device until
+ *       StartAsynchPort is called.
+ * Para: rxDIONum, txDIONum, the DIO numbers of the RX and TX lines
+ *       baud, the baud rate
+ *       numDataBits, parity, numStopBits, such as 8, 0 (none) and 1
+ *       deviceRXBufferBytes, deviceTXBufferBytes, the sizes of the device's
+ *           buffers, up to ASYNCH_MAX_DEVICE_BUFFER_BYTES
+**/
+void InitAsynchPort(AsynchPort * port, int handle, int rxDIONum, int txDIONum,
+	int baud, int numDataBits, int parity, int numStopBits,
+	int deviceRXBufferBytes, int deviceTXBufferBytes);
+
+/**
+ * Desc: Configures and enables asynch on the device and starts the thread that
+ *       drains received bytes and sends written bytes.
+ * Retr: the LJM error code, which is LJME_NOERROR on success
+**/
+int StartAsynchPort(AsynchPort * port);
+
+/**
+ * Desc: Stops the thread and disables asynch on the device. Bytes that have
+ *       not been sent yet are discarded; call AsynchFlush first to send them.
+**/
+void StopAsynchPort(AsynchPort * port);
+
+/**
+ * Desc: Copies up to numBytes received bytes into aBytes, waiting up to
+ *       timeoutMS for at least one byte to be received.
+ * Retr: the number of bytes copied, which is 0 on timeout
+**/
+int AsynchRead(AsynchPort * port, unsigned char * aBytes, int numBytes,
+	int timeoutMS);
+
+/**
+ * Desc: Queues numBytes of aBytes to be sent, waiting up to timeoutMS for
+ *       space in the host-side TX buffer.
+ * Retr: the number of bytes queued, which is less than numBytes on timeout
+**/
+int AsynchWrite(AsynchPort * port, const unsigned char * aBytes, int numBytes,
+	int timeoutMS);
+
+/**
+ * Desc: Waits up to timeoutMS for all queued bytes to be passed to the device.
+ * Retr: 1 if all bytes were passed to the device, 0 on timeout
+**/
+int AsynchFlush(AsynchPort * port, int timeoutMS);
+
+/**
+ * Desc: Returns the number of received bytes that can be read
+**/
+int AsynchBytesAvailable(AsynchPort * port);
+
+/**
+ * Desc: Prints the number of polls, bytes received and sent, dropped bytes,
+ *       the largest device RX backlog and the number of errors of port
+**/
+void PrintAsynchPortStatistics(const AsynchPort * port);
+
+
+// Source
+
+void InitAsynchPort(AsynchPort * port, int handle, int rxDIONum, int txDIONum,
+	int baud, int numDataBits, int parity, int numStopBits,
+	int deviceRXBufferBytes, int deviceTXBufferBytes)
+{
+	int halfFillMS;
+
+	memset(port, 0, sizeof(AsynchPort));
+	port->handle = handle;
+	port->rxDIONum = rxDIONum;
+	port->txDIONum = txDIONum;
+	port->baud = baud;
+	port->numDataBits = numDataBits;
+	port->parity = parity;
+	port->numStopBits = numStopBits;
+	port->deviceRXBufferBytes = deviceRXBufferBytes;
+	port->deviceTXBufferBytes = deviceTXBufferBytes;
+	if (port->deviceRXBufferBytes > ASYNCH_MAX_DEVICE_BUFFER_BYTES) {
+		port->deviceRXBufferBytes = ASYNCH_MAX_DEVICE_BUFFER_BYTES;
+	}
+	if (port->deviceTXBufferBytes > ASYNCH_MAX_DEVICE_BUFFER_BYTES) {
+		port->deviceTXBufferBytes = ASYNCH_MAX_DEVICE_BUFFER_BYTES;
+	}
+
+	port->bitsPerByte = 1 + numDataBits + (parity ? 1 : 0) + numStopBits;
+	halfFillMS = (int)(500.0 * port->deviceRXBufferBytes * port->bitsPerByte /
+		baud);
+	port->pollMS = halfFillMS;
+	if (port->pollMS < ASYNCH_MIN_POLL_MS) {
+		port->pollMS = ASYNCH_MIN_POLL_MS;
+	}
+	if (port->pollMS > ASYNCH_MAX_POLL_MS) {
+		port->pollMS = ASYNCH_MAX_POLL_MS;
+	}
+}
+
+// Sends up to deviceTXBufferBytes of the pending bytes, if any, and reads
+// ASYNCH_NUM_BYTES_RX, in one LJM_eNames call
+// Retr: the LJM error code. numRX is the number of bytes the device has
+//       received.
+int _SendAsynchAndPoll(AsynchPort * port, int * numRX)
+{
+	int i, err;
+	int numTX = 0;
+	int numFrames = 0;
+	int numValues = 0;
+	int errorAddress = INITIAL_ERR_ADDRESS;
+
+	// Wait for the previous transmission to finish before starting another
+	if (LJM_GetHostTick() >= port->txBusyUntil) {
+		LockMutex(&port->mutex);
+		numTX = port->txCount;
+		if (numTX > port->deviceTXBufferBytes) {
+			numTX = port->deviceTXBufferBytes;
+		}
+		for (i = 0; i < numTX; i++) {
+			port->aValues[1 + i] = port->aTXPending[i];
+		}
+		UnlockMutex(&port->mutex);
+	}
+
+	if (numTX > 0) {
+		port->aNames[0] = "ASYNCH_NUM_BYTES_TX";
+		port->aNumValues[0] = 1;
+		port->aValues[0] = numTX;
+
+		port->aNames[1] = "ASYNCH_DATA_TX";
+		port->aNumValues[1] = numTX;
+
+		port->aNames[2] = "ASYNCH_TX_GO";
+		port->aNumValues[2] = 1;
+		port->aValues[1 + numTX] = 1;
+
+		for (i = 0; i < 3; i++) {
+			port->aWrites[i] = LJM_WRITE;
+		}
+		numFrames = 3;
+		numValues = numTX + 2;
+	}
+
+	port->aNames[numFrames] = "ASYNCH_NUM_BYTES_RX";
+	port->aWrites[numFrames] = LJM_READ;
+	port->aNumValues[numFrames] = 1;
+	numFrames++;
+
+	err = LJM_eNames(port->handle, numFrames, port->aNames, port->aWrites,
+		port->aNumValues, port->aValues, &errorAddress);
+	port->numPolls++;
+	if (err != LJME_NOERROR) {
+		return err;
+	}
+
+	*numRX = (int)port->aValues[numValues];
+
+	if (numTX > 0) {
+		port->txBusyUntil = LJM_GetHostTick() +
+			(LJM_LONG_LONG_RETURN)numTX * port->bitsPerByte * 1000000 /
+			port->baud;
+
+		LockMutex(&port->mutex);
+		port->txCount -= numTX;
+		memmove(port->aTXPending, port->aTXPending + numTX, port->txCount);
+		UnlockMutex(&port->mutex);
+		port->numBytesSent += numTX;
+		port->numTransmissions++;
+	}
+
+	return LJME_NOERROR;
+}
+
+// Reads numRX bytes from ASYNCH_DATA_RX into the RX ring
+int _DrainAsynchRX(AsynchPort * port, int numRX)
+{
+	int i, err, index;
+	int errorAddress = INITIAL_ERR_ADDRESS;
+
+	if (numRX > port->deviceRXBufferBytes) {
+		numRX = port->deviceRXBufferBytes;
+	}
+	err = LJM_eReadNameArray(port->handle, "ASYNCH_DATA_RX", numRX,
+		port->aValues, &errorAddress);
+	if (err != LJME_NOERROR) {
+		return err;
+	}
+
+	LockMutex(&port->mutex);
+	for (i = 0; i < numRX; i++) {
+		if (port->rxCount == ASYNCH_HOST_RX_BYTES) {
+			port->numBytesDropped += numRX - i;
+			break;
+		}
+		index = (port->rxHead + port->rxCount) % ASYNCH_HOST_RX_BYTES;
+		port->aRXRing[index] = (unsigned char)port->aValues[i];
+		port->rxCount++;
+	}
+	UnlockMutex(&port->mutex);
+	port->numBytesReceived += numRX;
+
+	return LJME_NOERROR;
+}
+
+// Thread function for StartAsynchPort
+void _AsynchPortThread(void * portPtr)
+{
+	AsynchPort * port = (AsynchPort *)portPtr;
+	int err, numRX;
+
+	while (!port->stopRequested) {
+		numRX = 0;
+		err = _SendAsynchAndPoll(port, &numRX);
+		if (err == LJME_NOERROR && numRX > 0) {
+			if (numRX > port->maxDeviceRXBacklog) {
+				port->maxDeviceRXBacklog = numRX;
+			}
+			err = _DrainAsynchRX(port, numRX);
+		}
+		if (err != LJME_NOERROR) {
+			port->numErrors++;
+			port->lastErr = err;
+			MillisecondSleep(ASYNCH_MAX_POLL_MS);
+			continue;
+		}
+
+		// Poll again right away while the device RX buffer is filling faster
+		// than it is being drained
+		if (numRX < port->deviceRXBufferBytes / 2) {
+			MillisecondSleep(port->pollMS);
+		}
+	}
+}
+
+int StartAsynchPort(AsynchPort * port)
+{
+	enum { NUM_FRAMES = 10 };
+	const char * aNames[NUM_FRAMES] = {
+		"ASYNCH_ENABLE",
+		"ASYNCH_RX_DIONUM",
+		"ASYNCH_TX_DIONUM",
+		"ASYNCH_BAUD",
+		"ASYNCH_NUM_DATA_BITS",
+		"ASYNCH_PARITY",
+		"ASYNCH_NUM_STOP_BITS",
+		"ASYNCH_RX_BUFFER_SIZE_BYTES",
+		"ASYNCH_TX_BUFFER_SIZE_BYTES",
+		"ASYNCH_ENABLE"
+	};
+	double aValues[NUM_FRAMES];
+	int err;
+	int errorAddress = INITIAL_ERR_ADDRESS;
+
+	aValues[0] = 0;
+	aValues[1] = port->rxDIONum;
+	aValues[2] = port->txDIONum;
+	aValues[3] = port->baud;
+	aValues[4] = port->numDataBits;
+	aValues[5] = port->parity;
+	aValues[6] = port->numStopBits;
+	aValues[7] = port->deviceRXBufferBytes;
+	aValues[8] = port->deviceTXBufferBytes;
+	aValues[9] = 1;
+
+	err = WriteNames(port->handle, NUM_FRAMES, aNames, aValues,
+		&errorAddress);
+	if (err != LJME_NOERROR) {
+		return err;
+	}
+
+	InitMutex(&port->mutex);
+	port->stopRequested = 0;
+	if (StartThread(&port->thread, _AsynchPortThread, port) != 0) {
+		printf("StartAsynchPort: could not start the asynch thread\n");
+		DestroyMutex(&port->mutex);
+		LJM_CloseAll();
+		exit(1);
+	}
+
+	return LJME_NOERROR;
+}
+
+void StopAsynchPort(AsynchPort * port)
+{
+	int err;
+
+	port->stopRequested = 1;
+	JoinThread(port->thread);
+	DestroyMutex(&port->mutex);
+
+	err = LJM_eWriteName(port->handle, "ASYNCH_ENABLE", 0);
+	PrintErrorIfError(err, "StopAsynchPort: ASYNCH_ENABLE");
+}
+
+int AsynchRead(AsynchPort * port, unsigned char * aBytes, int numBytes,
+	int timeoutMS)
+{
+	int i, numRead;
+	LJM_LONG_LONG_RETURN start = LJM_GetHostTick();
+
+	while (AsynchBytesAvailable(port) == 0) {
+		if ((LJM_GetHostTick() - start) / 1000 >= timeoutMS) {
+			return 0;
+		}
+		MillisecondSleep(ASYNCH_MIN_POLL_MS);
+	}
+
+	LockMutex(&port->mutex);
+	numRead = port->rxCount;
+	if (numRead > numBytes) {
+		numRead = numBytes;
+	}
+	for (i = 0; i < numRead; i++) {
+		aBytes[i] = port->aRXRing[port->rxHead];
+		port->rxHead = (port->rxHead + 1) % ASYNCH_HOST_RX_BYTES;
+	}
+	port->rxCount -= numRead;
+	UnlockMutex(&port->mutex);
+
+	return numRead;
+}
+
+int AsynchWrite(AsynchPort * port, const unsigned char * aBytes, int numBytes,
+	int timeoutMS)
+{
+	int numCopied;
+	int numQueued = 0;
+	LJM_LONG_LONG_RETURN start = LJM_GetHostTick();
+
+	while (numQueued < numBytes) {
+		LockMutex(&port->mutex);
+		numCopied = ASYNCH_HOST_TX_BYTES - port->txCount;
+		if (numCopied > numBytes - numQueued) {
+			numCopied = numBytes - numQueued;
+		}
+		memcpy(port->aTXPending + port->txCount, aBytes + numQueued,
+			numCopied);
+		port->txCount += numCopied;
+		UnlockMutex(&port->mutex);
+
+		numQueued += numCopied;
+		if (numQueued < numBytes) {
+			if ((LJM_GetHostTick() - start) / 1000 >= timeoutMS) {
+				break;
+			}
+			MillisecondSleep(ASYNCH_MIN_POLL_MS);
+		}
+	}
+
+	return numQueued;
+}
+
+int AsynchFlush(AsynchPort * port, int timeoutMS)
+{
+	int txCount;
+	LJM_LONG_LONG_RETURN start = LJM_GetHostTick();
+
+	for (;;) {
+		LockMutex(&port->mutex);
+		txCount = port->txCount;
+		UnlockMutex(&port->mutex);
+
+		if (txCount == 0) {
+			return 1;
+		}
+		if ((LJM_GetHostTick() - start) / 1000 >= timeoutMS) {
+			return 0;
+		}
+		MillisecondSleep(ASYNCH_MIN_POLL_MS);
+	}
+}
+
+int AsynchBytesAvailable(AsynchPort * port)
+{
+	int rxCount;
+	LockMutex(&port->mutex);
+	rxCount = port->rxCount;
+	UnlockMutex(&port->mutex);
+	return rxCount;
+}
+
+void PrintAsynchPortStatistics(const AsynchPort * port)
+{
+	char errorString[LJM_MAX_NAME_SIZE];
+
+	printf("Asynch: %lu polls (every %d ms when idle), %lu bytes received, "
+		"%lu bytes sent in %lu transmissions\n", port->numPolls, port->pollMS,
+		port->numBytesReceived, port->numBytesSent, port->numTransmissions);
+	printf("    largest device RX backlog: %d of %d bytes, "
+		"%lu bytes dropped\n", port->maxDeviceRXBacklog,
+		port->deviceRXBufferBytes, port->numBytesDropped);
+	if (port->numErrors > 0) {
+		LJM_ErrorToString(port->lastErr, errorString);
+		printf("    %lu errors, last: %s\n", port->numErrors, errorString);
+	}
+}
+
+#endif // #define LJM_ASYNCH_UTILITIES
@@ -0,0 +1,333 @@
+/**
+ * Name: LJM_CalibrationUtilities.h
+ * Desc: Provides host-side conversion of raw analog input readings to volts
+ *       using the calibration constants stored in device flash.
+ *       LoadDeviceCalibration reads the constants of a T7 or T4 once with
+ *       LJM_FlashUtilities.h and caches them on disk by serial number and
+ *       firmware version, so later runs only need to read FIRMWARE_VERSION.
+ *       A RawToVoltsConverter then converts whole blocks of raw stream data,
+ *       as returned by LJM_eStreamRead when the LJM_STREAM_AIN_BINARY
+ *       configuration is enabled, to volts.
+ * Note: Raw stream data is always converted by the high speed converter, so
+ *       the T7 conversion uses the HS constants of each channel's range. The
+ *       T8 is not supported because its stream data is not 16-bit.
+ *       Channels that are not analog inputs must not be passed to
+ *       ConvertRawToVolts.
+**/
+
+#ifndef LJM_CALIBRATION_UTILITIES
+#define LJM_CALIBRATION_UTILITIES
+
+#include "LJM_FlashUtilities.h"
+
+// Where the calibration constants are in flash
+static const int CAL_FLASH_ADDRESS = 0x3C4000;
+
+// The number of float32 calibration constants of each device type
+enum { CAL_NUM_T7_VALUES = 41 };
+enum { CAL_NUM_T4_VALUES = 19 };
+enum { CAL_MAX_VALUES = 41 };
+
+// The maximum number of channels of one RawToVoltsConverter
+enum { CAL_MAX_CHANNELS = 128 };
+
+typedef struct {
+	float PSlope;
+	float NSlope;
+	float Center;
+	float Offset;
+} Cal_Set;
+
+// The layout of the T7 and T8 calibration constants in flash. HS and HR are
+// indexed by gain index (0: +/-10 V, 1: +/-1 V, 2: +/-0.1 V, 3: +/-0.01 V).
+typedef struct{
+	Cal_Set HS[4];
+	Cal_Set HR[4];
+
+	struct{
+		float Slope;
+		float Offset;
+	} DAC[2];
+
+	float Temp_Slope;
+	float Temp_Offset;
+
+	float ISource_10u;
+	float ISource_200u;
+
+	float I_Bias;
+} DeviceCalibrationT7;
+
+typedef DeviceCalibrationT7 DeviceCalibrationT8;
+
+// The layout of the T4 calibration constants in flash
+typedef struct{
+	struct { // 0
+		float Slope;
+		float Offset;
+	} HV[4];
+	struct { // 32
+		float Slope;
+		float Offset;
+	} LV;
+	struct { // 40
+		float Slope;
+		float Offset;
+	} SpecV;
+	struct { // 48
+		float Slope;
+		float Offset;
+	} DAC[2];
+
+	float Temp_Slope;   // 64
+	float Temp_Offset;  // 68
+
+	float I_Bias;   // 72
+} DeviceCalibrationT4;
+
+typedef struct DeviceCalibration {
+	int deviceType;
+	int serialNumber;
+	int numValues;
+
+	// The constants in flash order. Use T7Calibration or T4Calibration to
+	// access them by name.
+	float aValues[CAL_MAX_VALUES];
+} DeviceCalibration;
+
+// Per-channel constants, expanded for one scan so that the conversion loop
+// does not branch on the device type or range
+typedef struct RawToVoltsConverter {
+	int numChannels;
+	double aCenter[CAL_MAX_CHANNELS];
+	double aPositiveSlope[CAL_MAX_CHANNELS];
+	double aNegativeSlope[CAL_MAX_CHANNELS];
+	double aOffset[CAL_MAX_CHANNELS];
+} RawToVoltsConverter;
+
+/**
+ * Desc: Return cal's constants as the device type's flash layout
+**/
+const DeviceCalibrationT7 * T7Calibration(const DeviceCalibration * cal);
+const DeviceCalibrationT4 * T4Calibration(const DeviceCalibration * cal);
+
+/**
+ * Desc: Reads the calibration constants of the device of handle from flash.
+ *       This takes one round trip over Ethernet or WiFi and 4 over USB for a
+ *       T7.
+ * Retr: the LJM error code, which is LJME_NOERROR on success
+**/
+int ReadDeviceCalibration(int handle, DeviceCalibration * cal);
+
+/**
+ * Desc: Gets the calibration constants of the device of handle with
+ *       ReadFlashRegionCached, so they are only read from flash if cacheDir
+ *       has no cache file for its serial number and firmware version.
+ * Para: cacheDir, the directory of the cache files, or NULL to always read
+ *       flash
+ * Retr: the LJM error code, which is LJME_NOERROR on success
+**/
+int LoadDeviceCalibration(int handle, const char * cacheDir,
+	DeviceCalibration * cal);
+
+/**
+ * Desc: Prepares converter for a scan list of analog inputs.
+ * Para: aChannels, the AIN number of each channel of the scan list
+ *       aRanges, the AIN#_RANGE of each channel, such as 10 or 0.1. Ignored
+ *           for the T4.
+**/
+void InitRawToVolts(RawToVoltsConverter * converter,
+	const DeviceCalibration * cal, int numChannels, const int * aChannels,
+	const double * aRanges);
+
+/**
+ * Desc: Converts numScans scans of raw readings in aRaw to volts in aVolts.
+ *       aRaw and aVolts may be the same array. LJM_DUMMY_VALUE readings, which
+ *       mark skipped scans, are left as LJM_DUMMY_VALUE.
+**/
+void ConvertRawToVolts(const RawToVoltsConverter * converter, int numScans,
+	const double * aRaw, double * aVolts);
+
+/**
+ * Desc: Prints the calibration constants used for raw conversions
+**/
+void PrintDeviceCalibration(const DeviceCalibration * cal);
+
+
+// Source
+
+const DeviceCalibrationT7 * T7Calibration(const DeviceCalibration * cal)
+{
+	return (const DeviceCalibrationT7 *)cal->aValues;
+}
+
+const DeviceCalibrationT4 * T4Calibration(const DeviceCalibration * cal)
+{
+	return (const DeviceCalibrationT4 *)cal->aValues;
+}
+
+// Reads the calibration constants with ReadFlashRegionCached if cacheDir is
+// not NULL, or ReadFlashRegion otherwise
+int _ReadDeviceCalibration(int handle, const char * cacheDir,
+	DeviceCalibration * cal)
+{
+	double calValues[CAL_MAX_VALUES];
+	int err, i;
+	int connectionType, ipAddress, port, maxBytesPerMB;
+
+	memset(cal, 0, sizeof(DeviceCalibration));
+	err = LJM_GetHandleInfo(handle, &cal->deviceType, &connectionType,
+		&cal->serialNumber, &ipAddress, &port, &maxBytesPerMB);
+	if (err != LJME_NOERROR) {
+		return err;
+	}
+
+	if (cal->deviceType == LJM_dtT4) {
+		cal->numValues = CAL_NUM_T4_VALUES;
+	}
+	else {
+		cal->numValues = CAL_NUM_T7_VALUES;
+	}
+
+	if (cacheDir == NULL) {
+		err = ReadFlashRegion(handle, CAL_FLASH_ADDRESS, cal->numValues,
+			LJM_FLOAT32, calValues, NULL);
+	}
+	else {
+		err = ReadFlashRegionCached(handle, cacheDir, CAL_FLASH_ADDRESS,
+			cal->numValues, LJM_FLOAT32, calValues, NULL);
+	}
+	if (err != LJME_NOERROR) {
+		return err;
+	}
+
+	for (i = 0; i < cal->numValues; i++) {
+		cal->aValues[i] = (float)calValues[i];
+	}
+
+	return LJME_NOERROR;
+}
+
+int ReadDeviceCalibration(int handle, DeviceCalibration * cal)
+{
+	return _ReadDeviceCalibration(handle, NULL, cal);
+}
+
+int LoadDeviceCalibration(int handle, const char * cacheDir,
+	DeviceCalibration * cal)
+{
+	return _ReadDeviceCalibration(handle, cacheDir, cal);
+}
+
+// Returns the gain index of an AIN#_RANGE value
+int _RangeToGainIndex(double range)
+{
+	if (range >= 10 || range <= 0) {
+		return 0;
+	}
+	if (range >= 1) {
+		return 1;
+	}
+	if (range >= 0.1) {
+		return 2;
+	}
+	return 3;
+}
+
+void InitRawToVolts(RawToVoltsConverter * converter,
+	const DeviceCalibration * cal, int numChannels, const int * aChannels,
+	const double * aRanges)
+{
+	int i;
+	const DeviceCalibrationT7 * t7 = T7Calibration(cal);
+	const DeviceCalibrationT4 * t4 = T4Calibration(cal);
+	const Cal_Set * calSet;
+
+	if (numChannels > CAL_MAX_CHANNELS) {
+		printf("InitRawToVolts: more than %d channels\n", CAL_MAX_CHANNELS);
+		LJM_CloseAll();
+		exit(1);
+	}
+
+	converter->numChannels = numChannels;
+	for (i = 0; i < numChannels; i++) {
+		if (cal->deviceType == LJM_dtT4) {
+			// volts = bits * Slope + Offset, with the HV constants for AIN0
+			// to AIN3 and the LV constants for the other inputs
+			converter->aCenter[i] = 0;
+			if (aChannels[i] < 4) {
+				converter->aPositiveSlope[i] = t4->HV[aChannels[i]].Slope;
+				converter->aOffset[i] = t4->HV[aChannels[i]].Offset;
+			}
+			else {
+				converter->aPositiveSlope[i] = t4->LV.Slope;
+				converter->aOffset[i] = t4->LV.Offset;
+			}
+			converter->aNegativeSlope[i] = converter->aPositiveSlope[i];
+		}
+		else {
+			// volts = (bits - Center) * PSlope above Center, or
+			//         (Center - bits) * NSlope below Center
+			calSet = &t7->HS[_RangeToGainIndex(aRanges[i])];
+			converter->aCenter[i] = calSet->Center;
+			converter->aPositiveSlope[i] = calSet->PSlope;
+			converter->aNegativeSlope[i] = -calSet->NSlope;
+			converter->aOffset[i] = 0;
+		}
+	}
+}
+
+void ConvertRawToVolts(const RawToVoltsConverter * converter, int numScans,
+	const double * aRaw, double * aVolts)
+{
+	int scanI, chanI;
+	const int numChannels = converter->numChannels;
+	const double * aCenter = converter->aCenter;
+	const double * aPositiveSlope = converter->aPositiveSlope;
+	const double * aNegativeSlope = converter->aNegativeSlope;
+	const double * aOffset = converter->aOffset;
+	const double * raw;
+	double * volts;
+	double bits, difference, slope;
+
+	// The inner loop has no branches other than selects, so that the compiler
+	// can vectorize it
+	for (scanI = 0; scanI < numScans; scanI++) {
+		raw = aRaw + scanI * numChannels;
+		volts = aVolts + scanI * numChannels;
+		for (chanI = 0; chanI < numChannels; chanI++) {
+			bits = raw[chanI];
+			difference = bits - aCenter[chanI];
+			slope = difference < 0 ? aNegativeSlope[chanI] :
+				aPositiveSlope[chanI];
+			volts[chanI] = bits == LJM_DUMMY_VALUE ? LJM_DUMMY_VALUE :
+				difference * slope + aOffset[chanI];
+		}
+	}
+}
+
+void PrintDeviceCalibration(const DeviceCalibration * cal)
+{
+	int i;
+	const DeviceCalibrationT7 * t7 = T7Calibration(cal);
+	const DeviceCalibrationT4 * t4 = T4Calibration(cal);
+
+	printf("%s %d calibration:\n", NumberToDeviceType(cal->deviceType),
+		cal->serialNumber);
+	if (cal->deviceType == LJM_dtT4) {
+		for (i = 0; i < 4; i++) {
+			printf("    HV[%d]: Slope %+.10f, Offset %+f\n", i,
+				t4->HV[i].Slope, t4->HV[i].Offset);
+		}
+		printf("    LV:    Slope %+.10f, Offset %+f\n", t4->LV.Slope,
+			t4->LV.Offset);
+	}
+	else {
+		for (i = 0; i < 4; i++) {
+			printf("    HS[%d]: PSlope %+.10f, NSlope %+.10f, Center %+f\n",
+				i, t7->HS[i].PSlope, t7->HS[i].NSlope, t7->HS[i].Center);
+		}
+	}
+}
+
+#endif // #define LJM_CALIBRATION_UTILITIES
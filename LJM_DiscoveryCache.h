@@ -0,0 +1,589 @@
+/**
+ * Name: LJM_DiscoveryCache.h
+ * Desc: Provides a device discovery cache. The results of
+ *       LJM_ListAllExtended (device type, connection type, serial number, IP
+ *       address and the bytes of the queried registers) are saved to a file so
+ *       that the next program start can open the known devices directly, in
+ *       parallel, instead of waiting for a full discovery. The cache can then be
+ *       refreshed in a background thread while the devices are already in use.
+ * Note: Programs that include this file must link with pthread on Linux and
+ *       Mac OS X (see LJM_ThreadUtilities.h).
+ *       A refresh replaces the cached devices with the devices found, so a
+ *       device that is no longer found is dropped from the cache.
+**/
+
+#ifndef LJM_DISCOVERY_CACHE
+#define LJM_DISCOVERY_CACHE
+
+#include "LJM_ThreadUtilities.h"
+
+enum { MAX_DISCOVERY_ADDRESSES = 8 };
+enum { MAX_DISCOVERY_QUERY_BYTES = 128 };
+enum { MAX_DISCOVERY_PATH_SIZE = 256 };
+
+typedef struct CachedDevice {
+	int deviceType;
+	int connectionType;
+	int serialNumber;
+	int ipAddress;
+
+	// The raw bytes of each queried register, in the order of the cache's
+	// aNames
+	unsigned char aQueryBytes[MAX_DISCOVERY_QUERY_BYTES];
+} CachedDevice;
+
+typedef struct DiscoveryCache {
+	char filePath[MAX_DISCOVERY_PATH_SIZE];
+
+	// The registers queried with LJM_ListAllExtended
+	int numAddresses;
+	const char * aNames[MAX_DISCOVERY_ADDRESSES];
+	int aAddresses[MAX_DISCOVERY_ADDRESSES];
+	int aTypes[MAX_DISCOVERY_ADDRESSES];
+	int aNumRegs[MAX_DISCOVERY_ADDRESSES];
+	int numQueryBytes;
+
+	// Protected by mutex, since a refresh may run in the background
+	int numDevices;
+	CachedDevice aDevices[LJM_LIST_ALL_SIZE];
+	long updatedTime;
+	Mutex mutex;
+
+	// The background refresh
+	Thread refreshThread;
+	int refreshRunning;
+	int refreshDeviceType;
+	int refreshConnectionType;
+	int refreshErr;
+	double refreshMS;
+} DiscoveryCache;
+
+/**
+ * Desc: Prepares cache to query the numAddresses registers of aNames and to be
+ *       saved at filePath. The cache starts out empty. aNames must stay valid
+ *       while cache is used. Exits the program if the registers do not fit in
+ *       MAX_DISCOVERY_ADDRESSES/MAX_DISCOVERY_QUERY_BYTES.
+ * Retr: the LJM error code, which is LJME_NOERROR on success
+**/
+int InitDiscoveryCache(DiscoveryCache * cache, const char * filePath,
+	int numAddresses, const char ** aNames);
+
+/**
+ * Desc: Waits for any background refresh and releases the resources of cache.
+**/
+void CleanDiscoveryCache(DiscoveryCache * cache);
+
+/**
+ * Desc: Loads the devices saved in the cache file.
+ * Retr: the number of devices loaded. 0 if the file does not exist, cannot be
+ *       parsed or was saved with a different list of registers.
+**/
+int LoadDiscoveryCache(DiscoveryCache * cache);
+
+/**
+ * Desc: Saves the cached devices to the cache file.
+ * Retr: 0 on success, non-zero if the file could not be written
+**/
+int SaveDiscoveryCache(DiscoveryCache * cache);
+
+/**
+ * Desc: Calls LJM_ListAllExtended for deviceType and connectionType, replaces
+ *       the cached devices with the results, and saves the cache file.
+ * Retr: the LJM error code, which is LJME_NOERROR on success
+**/
+int RefreshDiscoveryCache(DiscoveryCache * cache, int deviceType,
+	int connectionType);
+
+/**
+ * Desc: Starts RefreshDiscoveryCache in a background thread. Does nothing if a
+ *       refresh is already running.
+ * Retr: 0 on success, non-zero if the thread could not be started
+**/
+int StartDiscoveryRefresh(DiscoveryCache * cache, int deviceType,
+	int connectionType);
+
+/**
+ * Desc: Waits for the background refresh started by StartDiscoveryRefresh.
+ * Retr: the LJM error code of the refresh, or LJME_NOERROR if no refresh was
+ *       started
+**/
+int WaitForDiscoveryRefresh(DiscoveryCache * cache);
+
+/**
+ * Desc: Copies up to maxDevices cached devices into aDevices.
+ * Retr: the number of devices copied
+**/
+int GetCachedDevices(DiscoveryCache * cache, int maxDevices,
+	CachedDevice * aDevices);
+
+/**
+ * Desc: Opens each cached device in its own thread, using the cached
+ *       connection type and IP address (or serial number for USB) so no
+ *       discovery is needed. A device with more than one cached connection is
+ *       opened once, using its first cached connection. If that fails, the
+ *       device is opened by serial number with LJM_ctANY.
+ * Para: aHandles, receives the handles of the devices opened.
+ * Retr: the number of devices opened
+**/
+int OpenCachedDevices(DiscoveryCache * cache, int maxHandles, int * aHandles);
+
+/**
+ * Desc: Prints the cached devices and their queried register values.
+**/
+void PrintCachedDevices(DiscoveryCache * cache);
+
+
+// Source
+
+static const char * DISCOVERY_CACHE_FILE_ID = "LJM_DISCOVERY_CACHE 1";
+
+int InitDiscoveryCache(DiscoveryCache * cache, const char * filePath,
+	int numAddresses, const char ** aNames)
+{
+	int err, i;
+
+	memset(cache, 0, sizeof(DiscoveryCache));
+
+	if (numAddresses > MAX_DISCOVERY_ADDRESSES) {
+		printf("InitDiscoveryCache: %d addresses exceeds "
+			"MAX_DISCOVERY_ADDRESSES (%d)\n", numAddresses,
+			MAX_DISCOVERY_ADDRESSES);
+		WaitForUserIfWindows();
+		exit(1);
+	}
+
+	strncpy(cache->filePath, filePath, MAX_DISCOVERY_PATH_SIZE - 1);
+	cache->numAddresses = numAddresses;
+	for (i = 0; i < numAddresses; i++) {
+		cache->aNames[i] = aNames[i];
+	}
+
+	if (numAddresses > 0) {
+		err = LJM_NamesToAddresses(numAddresses, aNames, cache->aAddresses,
+			cache->aTypes);
+		PrintErrorIfError(err, "InitDiscoveryCache: LJM_NamesToAddresses");
+		if (err != LJME_NOERROR) {
+			return err;
+		}
+	}
+
+	for (i = 0; i < numAddresses; i++) {
+		if (cache->aTypes[i] == LJM_STRING) {
+			cache->aNumRegs[i] = LJM_STRING_ALLOCATION_SIZE /
+				LJM_BYTES_PER_REGISTER;
+		}
+		else if (cache->aTypes[i] == LJM_UINT16) {
+			cache->aNumRegs[i] = 1;
+		}
+		else {
+			cache->aNumRegs[i] = 2;
+		}
+		cache->numQueryBytes += cache->aNumRegs[i] * LJM_BYTES_PER_REGISTER;
+	}
+
+	if (cache->numQueryBytes > MAX_DISCOVERY_QUERY_BYTES) {
+		printf("InitDiscoveryCache: %d query bytes exceeds "
+			"MAX_DISCOVERY_QUERY_BYTES (%d)\n", cache->numQueryBytes,
+			MAX_DISCOVERY_QUERY_BYTES);
+		WaitForUserIfWindows();
+		exit(1);
+	}
+
+	InitMutex(&cache->mutex);
+
+	return LJME_NOERROR;
+}
+
+void CleanDiscoveryCache(DiscoveryCache * cache)
+{
+	WaitForDiscoveryRefresh(cache);
+	DestroyMutex(&cache->mutex);
+}
+
+int LoadDiscoveryCache(DiscoveryCache * cache)
+{
+	FILE * file;
+	char line[MAX_DISCOVERY_PATH_SIZE];
+	char name[LJM_MAX_NAME_SIZE];
+	int numAddresses, numDevices, i, byteI;
+	unsigned int byte;
+	long updatedTime;
+	CachedDevice device;
+	CachedDevice * aDevices;
+	int numLoaded = 0;
+
+	file = fopen(cache->filePath, "r");
+	if (file == NULL) {
+		return 0;
+	}
+
+	// The header must match this cache's registers
+	if (fgets(line, sizeof(line), file) == NULL ||
+		strncmp(line, DISCOVERY_CACHE_FILE_ID,
+			strlen(DISCOVERY_CACHE_FILE_ID)) != 0 ||
+		fscanf(file, " REGISTERS %d", &numAddresses) != 1 ||
+		numAddresses != cache->numAddresses)
+	{
+		fclose(file);
+		return 0;
+	}
+	for (i = 0; i < numAddresses; i++) {
+		if (fscanf(file, " %255s", name) != 1 ||
+			strcmp(name, cache->aNames[i]) != 0)
+		{
+			fclose(file);
+			return 0;
+		}
+	}
+	if (fscanf(file, " UPDATED %ld DEVICES %d", &updatedTime,
+		&numDevices) != 2 || numDevices < 0 ||
+		numDevices > LJM_LIST_ALL_SIZE)
+	{
+		fclose(file);
+		return 0;
+	}
+
+	aDevices = malloc(sizeof(CachedDevice) * LJM_LIST_ALL_SIZE);
+	for (i = 0; i < numDevices; i++) {
+		memset(&device, 0, sizeof(CachedDevice));
+		if (fscanf(file, " %d %d %d %d", &device.deviceType,
+			&device.connectionType, &device.serialNumber,
+			&device.ipAddress) != 4)
+		{
+			break;
+		}
+		for (byteI = 0; byteI < cache->numQueryBytes; byteI++) {
+			if (fscanf(file, " %2x", &byte) != 1) {
+				break;
+			}
+			device.aQueryBytes[byteI] = (unsigned char)byte;
+		}
+		if (byteI != cache->numQueryBytes) {
+			break;
+		}
+		aDevices[numLoaded++] = device;
+	}
+	fclose(file);
+
+	if (numLoaded != numDevices) {
+		printf("LoadDiscoveryCache: %s is incomplete, ignoring it\n",
+			cache->filePath);
+		free(aDevices);
+		return 0;
+	}
+
+	LockMutex(&cache->mutex);
+	memcpy(cache->aDevices, aDevices, sizeof(CachedDevice) * numLoaded);
+	cache->numDevices = numLoaded;
+	cache->updatedTime = updatedTime;
+	UnlockMutex(&cache->mutex);
+
+	free(aDevices);
+
+	return numLoaded;
+}
+
+int SaveDiscoveryCache(DiscoveryCache * cache)
+{
+	FILE * file;
+	int i, byteI;
+	const CachedDevice * device;
+
+	file = fopen(cache->filePath, "w");
+	if (file == NULL) {
+		printf("SaveDiscoveryCache: could not open %s for writing\n",
+			cache->filePath);
+		return 1;
+	}
+
+	LockMutex(&cache->mutex);
+
+	fprintf(file, "%s\n", DISCOVERY_CACHE_FILE_ID);
+	fprintf(file, "REGISTERS %d", cache->numAddresses);
+	for (i = 0; i < cache->numAddresses; i++) {
+		fprintf(file, " %s", cache->aNames[i]);
+	}
+	fprintf(file, "\nUPDATED %ld\nDEVICES %d\n", cache->updatedTime,
+		cache->numDevices);
+
+	for (i = 0; i < cache->numDevices; i++) {
+		device = &cache->aDevices[i];
+		fprintf(file, "%d %d %d %d", device->deviceType,
+			device->connectionType, device->serialNumber, device->ipAddress);
+		for (byteI = 0; byteI < cache->numQueryBytes; byteI++) {
+			fprintf(file, " %02x", device->aQueryBytes[byteI]);
+		}
+		fprintf(file, "\n");
+	}
+
+	UnlockMutex(&cache->mutex);
+
+	if (fclose(file) != 0) {
+		printf("SaveDiscoveryCache: error writing %s\n", cache->filePath);
+		return 1;
+	}
+
+	return 0;
+}
+
+int RefreshDiscoveryCache(DiscoveryCache * cache, int deviceType,
+	int connectionType)
+{
+	int err, i;
+	int numFound = 0;
+	int aDeviceTypes[LJM_LIST_ALL_SIZE];
+	int aConnectionTypes[LJM_LIST_ALL_SIZE];
+	int aSerialNumbers[LJM_LIST_ALL_SIZE];
+	int aIPAddresses[LJM_LIST_ALL_SIZE];
+	unsigned char * aBytes;
+	CachedDevice * device;
+
+	// At least one byte, in case no registers are queried
+	aBytes = malloc(cache->numQueryBytes * LJM_LIST_ALL_SIZE + 1);
+
+	err = LJM_ListAllExtended(deviceType, connectionType, cache->numAddresses,
+		cache->aAddresses, cache->aNumRegs, LJM_LIST_ALL_SIZE, &numFound,
+		aDeviceTypes, aConnectionTypes, aSerialNumbers, aIPAddresses, aBytes);
+	PrintErrorIfError(err,
+		"RefreshDiscoveryCache: LJM_ListAllExtended with device type: %s, "
+		"connection type: %s", NumberToDeviceType(deviceType),
+		NumberToConnectionType(connectionType));
+	if (err != LJME_NOERROR) {
+		free(aBytes);
+		return err;
+	}
+
+	LockMutex(&cache->mutex);
+	for (i = 0; i < numFound; i++) {
+		device = &cache->aDevices[i];
+		device->deviceType = aDeviceTypes[i];
+		device->connectionType = aConnectionTypes[i];
+		device->serialNumber = aSerialNumbers[i];
+		device->ipAddress = aIPAddresses[i];
+		memcpy(device->aQueryBytes, aBytes + i * cache->numQueryBytes,
+			cache->numQueryBytes);
+	}
+	cache->numDevices = numFound;
+	cache->updatedTime = (long)time(NULL);
+	UnlockMutex(&cache->mutex);
+
+	free(aBytes);
+
+	SaveDiscoveryCache(cache);
+
+	return LJME_NOERROR;
+}
+
+// Thread function for StartDiscoveryRefresh
+void _DiscoveryRefreshThread(void * cachePtr)
+{
+	DiscoveryCache * cache = (DiscoveryCache *)cachePtr;
+	LJM_LONG_LONG_RETURN start = LJM_GetHostTick();
+
+	cache->refreshErr = RefreshDiscoveryCache(cache,
+		cache->refreshDeviceType, cache->refreshConnectionType);
+	cache->refreshMS = (LJM_GetHostTick() - start) / 1000.0;
+}
+
+int StartDiscoveryRefresh(DiscoveryCache * cache, int deviceType,
+	int connectionType)
+{
+	if (cache->refreshRunning) {
+		return 0;
+	}
+
+	cache->refreshDeviceType = deviceType;
+	cache->refreshConnectionType = connectionType;
+	cache->refreshErr = LJME_NOERROR;
+	if (StartThread(&cache->refreshThread, _DiscoveryRefreshThread, cache)
+		!= 0)
+	{
+		printf("StartDiscoveryRefresh: could not start the refresh thread\n");
+		return 1;
+	}
+	cache->refreshRunning = 1;
+
+	return 0;
+}
+
+int WaitForDiscoveryRefresh(DiscoveryCache * cache)
+{
+	if (!cache->refreshRunning) {
+		return LJME_NOERROR;
+	}
+
+	JoinThread(cache->refreshThread);
+	cache->refreshRunning = 0;
+
+	return cache->refreshErr;
+}
+
+int GetCachedDevices(DiscoveryCache * cache, int maxDevices,
+	CachedDevice * aDevices)
+{
+	int numDevices;
+
+	LockMutex(&cache->mutex);
+	numDevices = cache->numDevices;
+	if (numDevices > maxDevices) {
+		numDevices = maxDevices;
+	}
+	memcpy(aDevices, cache->aDevices, sizeof(CachedDevice) * numDevices);
+	UnlockMutex(&cache->mutex);
+
+	return numDevices;
+}
+
+typedef struct _CachedOpen {
+	CachedDevice device;
+	Thread thread;
+	int threadStarted;
+	int handle;
+	int err;
+} _CachedOpen;
+
+// Opens one cached device. Thread function for OpenCachedDevices.
+void _OpenCachedDevice(void * openPtr)
+{
+	_CachedOpen * cachedOpen = (_CachedOpen *)openPtr;
+	char identifier[LJM_MAX_NAME_SIZE];
+	char serialString[LJM_MAX_NAME_SIZE];
+
+	sprintf(serialString, "%d", cachedOpen->device.serialNumber);
+	if (IsNetwork(cachedOpen->device.connectionType)) {
+		LJM_NumberToIP(cachedOpen->device.ipAddress, identifier);
+	}
+	else {
+		strcpy(identifier, serialString);
+	}
+
+	cachedOpen->err = LJM_Open(cachedOpen->device.deviceType,
+		cachedOpen->device.connectionType, identifier, &cachedOpen->handle);
+	if (cachedOpen->err != LJME_NOERROR) {
+		// The device may have a new IP address or connection
+		cachedOpen->err = LJM_Open(cachedOpen->device.deviceType, LJM_ctANY,
+			serialString, &cachedOpen->handle);
+	}
+}
+
+int OpenCachedDevices(DiscoveryCache * cache, int maxHandles, int * aHandles)
+{
+	int numDevices, numOpens, i, openI;
+	int numOpened = 0;
+	CachedDevice * aDevices;
+	_CachedOpen * aOpens;
+	char errorString[LJM_MAX_NAME_SIZE];
+
+	aDevices = malloc(sizeof(CachedDevice) * LJM_LIST_ALL_SIZE);
+	aOpens = malloc(sizeof(_CachedOpen) * LJM_LIST_ALL_SIZE);
+
+	numDevices = GetCachedDevices(cache, LJM_LIST_ALL_SIZE, aDevices);
+
+	// One open per serial number, using the first cached connection
+	numOpens = 0;
+	for (i = 0; i < numDevices && numOpens < maxHandles; i++) {
+		for (openI = 0; openI < numOpens; openI++) {
+			if (aOpens[openI].device.serialNumber == aDevices[i].serialNumber) {
+				break;
+			}
+		}
+		if (openI == numOpens) {
+			memset(&aOpens[numOpens], 0, sizeof(_CachedOpen));
+			aOpens[numOpens].device = aDevices[i];
+			numOpens++;
+		}
+	}
+
+	for (openI = 0; openI < numOpens; openI++) {
+		aOpens[openI].threadStarted = (StartThread(&aOpens[openI].thread,
+			_OpenCachedDevice, &aOpens[openI]) == 0);
+		if (!aOpens[openI].threadStarted) {
+			_OpenCachedDevice(&aOpens[openI]);
+		}
+	}
+
+	for (openI = 0; openI < numOpens; openI++) {
+		if (aOpens[openI].threadStarted) {
+			JoinThread(aOpens[openI].thread);
+		}
+
+		if (aOpens[openI].err == LJME_NOERROR) {
+			aHandles[numOpened++] = aOpens[openI].handle;
+		}
+		else {
+			LJM_ErrorToString(aOpens[openI].err, errorString);
+			printf("OpenCachedDevices: could not open %s %d: %s\n",
+				NumberToDeviceType(aOpens[openI].device.deviceType),
+				aOpens[openI].device.serialNumber, errorString);
+		}
+	}
+
+	free(aOpens);
+	free(aDevices);
+
+	return numOpened;
+}
+
+void PrintCachedDevices(DiscoveryCache * cache)
+{
+	int i, addrI, byteI, numDevices;
+	int byteOffset;
+	float float32;
+	unsigned int uint32;
+	char string[LJM_STRING_ALLOCATION_SIZE + 1];
+	char IPv4String[LJM_IPv4_STRING_SIZE];
+	CachedDevice * aDevices = malloc(sizeof(CachedDevice) * LJM_LIST_ALL_SIZE);
+	const CachedDevice * device;
+
+	numDevices = GetCachedDevices(cache, LJM_LIST_ALL_SIZE, aDevices);
+
+	printf("%d cached device connections:\n", numDevices);
+	for (i = 0; i < numDevices; i++) {
+		device = &aDevices[i];
+		LJM_NumberToIP(device->ipAddress, IPv4String);
+		printf("    [%3d] - %s, %s, serial number: %d, IP address: %s\n",
+			i, NumberToDeviceType(device->deviceType),
+			NumberToConnectionType(device->connectionType),
+			device->serialNumber, IPv4String);
+
+		byteOffset = 0;
+		for (addrI = 0; addrI < cache->numAddresses; addrI++) {
+			printf("            * %30s: ", cache->aNames[addrI]);
+			if (cache->aTypes[addrI] == LJM_STRING) {
+				memcpy(string, device->aQueryBytes + byteOffset,
+					LJM_STRING_ALLOCATION_SIZE);
+				string[LJM_STRING_ALLOCATION_SIZE] = '\0';
+				printf("%s", string);
+			}
+			else if (cache->aTypes[addrI] == LJM_FLOAT32) {
+				LJM_ByteArrayToFLOAT32(
+					(const char *)device->aQueryBytes + byteOffset, 0, 1,
+					&float32);
+				printf("%0.04f", float32);
+			}
+			else if (cache->aTypes[addrI] == LJM_UINT16) {
+				printf("%u", (device->aQueryBytes[byteOffset] << 8) |
+					device->aQueryBytes[byteOffset + 1]);
+			}
+			else {
+				uint32 = 0;
+				for (byteI = 0; byteI < 4; byteI++) {
+					uint32 = (uint32 << 8) |
+						device->aQueryBytes[byteOffset + byteI];
+				}
+				if (cache->aTypes[addrI] == LJM_INT32) {
+					printf("%d", (int)uint32);
+				}
+				else {
+					printf("%u", uint32);
+				}
+			}
+			printf("\n");
+			byteOffset += cache->aNumRegs[addrI] * LJM_BYTES_PER_REGISTER;
+		}
+	}
+
+	free(aDevices);
+}
+
+#endif // #define LJM_DISCOVERY_CACHE
@@ -0,0 +1,255 @@
+/**
+ * Name: LJM_FlashUtilities.h
+ * Desc: Provides reads of any range of internal flash with as few packets as
+ *       possible. Each read of INTERNAL_FLASH_READ needs a write of
+ *       INTERNAL_FLASH_READ_POINTER before it, so ReadFlashRegion interleaves
+ *       the pointer writes and reads and packs as many pairs into each
+ *       LJM_eAddresses call as fit in one packet of the connection.
+ *       ReadFlashRegionCached also caches the values on disk by serial number
+ *       and firmware version, so a device whose region is cached is validated
+ *       with a single FIRMWARE_VERSION read.
+**/
+
+#ifndef LJM_FLASH_UTILITIES
+#define LJM_FLASH_UTILITIES
+
+#include "LJM_Utilities.h"
+
+static const int FLASH_PTR_ADDRESS = 61810;  // INTERNAL_FLASH_READ_POINTER
+static const int FLASH_READ_ADDRESS = 61812; // INTERNAL_FLASH_READ
+
+// The maximum number of 32-bit values read by one INTERNAL_FLASH_READ frame
+enum { FLASH_MAX_VALUES_PER_READ = 13 };
+
+// The maximum number of values of one region
+enum { FLASH_MAX_REGION_VALUES = 1024 };
+
+// Modbus Feedback packet sizes: the header of a command or response, and the
+// command bytes of one pointer write (type, address, count, UINT32) and read
+// (type, address, count) pair
+enum { FLASH_PACKET_HEADER_BYTES = 8 };
+enum { FLASH_PAIR_COMMAND_BYTES = 12 };
+
+// The maximum length of what ReadFlashRegionCached appends to cacheDir:
+// "/ljm_flash_", the serial number, "_", the address in hex, then ".txt"
+enum { FLASH_CACHE_FILE_NAME_MAX_LENGTH = 35 };
+
+/**
+ * Desc: Reads numValues 32-bit values of internal flash, starting at
+ *       flashAddress.
+ * Para: type, LJM_FLOAT32 or LJM_UINT32
+ *       aValues, output of numValues values
+ *       numRoundTrips, optional output of the number of LJM_eAddresses calls
+ * Retr: the LJM error code, which is LJME_NOERROR on success
+**/
+int ReadFlashRegion(int handle, int flashAddress, int numValues, int type,
+	double * aValues, int * numRoundTrips);
+
+/**
+ * Desc: Like ReadFlashRegion, but first looks for the region in the cache file
+ *       of the device in cacheDir. The cache file is only used if it was
+ *       written for the same serial number, firmware version, address, count
+ *       and type. Otherwise the region is read from the device and the cache
+ *       file is rewritten.
+ * Para: cacheDir, the directory of the cache files. Must be shorter than
+ *       LJM_MAX_NAME_SIZE - FLASH_CACHE_FILE_NAME_MAX_LENGTH.
+ *       numRoundTrips, optional output of the number of round trips, which is
+ *       1 when the cache is used
+ * Retr: the LJM error code, which is LJME_NOERROR on success
+**/
+int ReadFlashRegionCached(int handle, const char * cacheDir, int flashAddress,
+	int numValues, int type, double * aValues, int * numRoundTrips);
+
+
+// Source
+
+int ReadFlashRegion(int handle, int flashAddress, int numValues, int type,
+	double * aValues, int * numRoundTrips)
+{
+	int err, valueI, numFrames, numPairs, readValues;
+	int commandBytes, responseBytes;
+	int deviceType, connectionType, serialNumber, ipAddress, port,
+		maxBytesPerMB;
+	int errorAddress = INITIAL_ERR_ADDRESS;
+
+	// A pointer write and a read per pair
+	enum { MAX_FRAMES = 2 * (FLASH_MAX_REGION_VALUES /
+		FLASH_MAX_VALUES_PER_READ + 1) };
+	int aAddresses[MAX_FRAMES];
+	int aTypes[MAX_FRAMES];
+	int aWrites[MAX_FRAMES];
+	int aNumValues[MAX_FRAMES];
+	double aFrameValues[MAX_FRAMES + FLASH_MAX_REGION_VALUES];
+	int frameValueI, readValueI;
+
+	if (numRoundTrips) {
+		*numRoundTrips = 0;
+	}
+	if (numValues > FLASH_MAX_REGION_VALUES) {
+		printf("ReadFlashRegion: numValues must be at most %d, got %d\n",
+			FLASH_MAX_REGION_VALUES, numValues);
+		LJM_CloseAll();
+		exit(1);
+	}
+
+	err = LJM_GetHandleInfo(handle, &deviceType, &connectionType,
+		&serialNumber, &ipAddress, &port, &maxBytesPerMB);
+	if (err != LJME_NOERROR) {
+		return err;
+	}
+
+	valueI = 0;
+	while (valueI < numValues) {
+		// Add pairs while both the command and the response fit in a packet
+		numFrames = 0;
+		numPairs = 0;
+		frameValueI = 0;
+		readValueI = valueI;
+		commandBytes = FLASH_PACKET_HEADER_BYTES;
+		responseBytes = FLASH_PACKET_HEADER_BYTES;
+		while (readValueI < numValues) {
+			readValues = numValues - readValueI;
+			if (readValues > FLASH_MAX_VALUES_PER_READ) {
+				readValues = FLASH_MAX_VALUES_PER_READ;
+			}
+			if (numPairs > 0 &&
+				(commandBytes + FLASH_PAIR_COMMAND_BYTES > maxBytesPerMB ||
+				responseBytes + 4 * readValues > maxBytesPerMB))
+			{
+				break;
+			}
+			commandBytes += FLASH_PAIR_COMMAND_BYTES;
+			responseBytes += 4 * readValues;
+
+			aAddresses[numFrames] = FLASH_PTR_ADDRESS;
+			aTypes[numFrames] = LJM_UINT32;
+			aWrites[numFrames] = LJM_WRITE;
+			aNumValues[numFrames] = 1;
+			aFrameValues[frameValueI++] = flashAddress + readValueI * 4;
+			numFrames++;
+
+			aAddresses[numFrames] = FLASH_READ_ADDRESS;
+			aTypes[numFrames] = type;
+			aWrites[numFrames] = LJM_READ;
+			aNumValues[numFrames] = readValues;
+			frameValueI += readValues;
+			numFrames++;
+
+			readValueI += readValues;
+			numPairs++;
+		}
+
+		err = LJM_eAddresses(handle, numFrames, aAddresses, aTypes, aWrites,
+			aNumValues, aFrameValues, &errorAddress);
+		if (numRoundTrips) {
+			(*numRoundTrips)++;
+		}
+		if (err != LJME_NOERROR) {
+			return err;
+		}
+
+		// Skip the pointer value before each read's values
+		frameValueI = 0;
+		while (valueI < readValueI) {
+			frameValueI++;
+			readValues = readValueI - valueI;
+			if (readValues > FLASH_MAX_VALUES_PER_READ) {
+				readValues = FLASH_MAX_VALUES_PER_READ;
+			}
+			memcpy(aValues + valueI, aFrameValues + frameValueI,
+				sizeof(double) * readValues);
+			frameValueI += readValues;
+			valueI += readValues;
+		}
+	}
+
+	return LJME_NOERROR;
+}
+
+int ReadFlashRegionCached(int handle, const char * cacheDir, int flashAddress,
+	int numValues, int type, double * aValues, int * numRoundTrips)
+{
+	int err, valueI;
+	int deviceType, connectionType, serialNumber, ipAddress, port,
+		maxBytesPerMB;
+	int fileSerial, fileAddress, fileNumValues, fileType;
+	double firmwareVersion, fileFirmwareVersion;
+	char path[LJM_MAX_NAME_SIZE];
+	int cached = 0;
+	FILE * file;
+
+	if (strlen(cacheDir) >=
+		LJM_MAX_NAME_SIZE - FLASH_CACHE_FILE_NAME_MAX_LENGTH)
+	{
+		printf("ReadFlashRegionCached: cacheDir must be shorter than %d "
+			"characters, got %s\n",
+			LJM_MAX_NAME_SIZE - FLASH_CACHE_FILE_NAME_MAX_LENGTH, cacheDir);
+		LJM_CloseAll();
+		exit(1);
+	}
+
+	err = LJM_GetHandleInfo(handle, &deviceType, &connectionType,
+		&serialNumber, &ipAddress, &port, &maxBytesPerMB);
+	if (err != LJME_NOERROR) {
+		return err;
+	}
+
+	err = LJM_eReadName(handle, "FIRMWARE_VERSION", &firmwareVersion);
+	if (err != LJME_NOERROR) {
+		return err;
+	}
+
+	sprintf(path, "%s/ljm_flash_%d_%X.txt", cacheDir, serialNumber,
+		flashAddress);
+	file = fopen(path, "r");
+	if (file != NULL) {
+		if (fscanf(file, "%d %lf %X %d %d", &fileSerial, &fileFirmwareVersion,
+			(unsigned int *)&fileAddress, &fileNumValues, &fileType) == 5 &&
+			fileSerial == serialNumber &&
+			EqualFloats(fileFirmwareVersion, firmwareVersion, 0.00001) &&
+			fileAddress == flashAddress && fileNumValues == numValues &&
+			fileType == type)
+		{
+			for (valueI = 0; valueI < numValues; valueI++) {
+				if (fscanf(file, "%lf", &aValues[valueI]) != 1) {
+					break;
+				}
+			}
+			cached = (valueI == numValues);
+		}
+		fclose(file);
+	}
+
+	if (cached) {
+		if (numRoundTrips) {
+			*numRoundTrips = 1;
+		}
+		return LJME_NOERROR;
+	}
+
+	err = ReadFlashRegion(handle, flashAddress, numValues, type, aValues,
+		numRoundTrips);
+	if (numRoundTrips) {
+		(*numRoundTrips)++;
+	}
+	if (err != LJME_NOERROR) {
+		return err;
+	}
+
+	file = fopen(path, "w");
+	if (file == NULL) {
+		printf("ReadFlashRegionCached: could not write %s\n", path);
+		return LJME_NOERROR;
+	}
+	fprintf(file, "%d %.4f %X %d %d\n", serialNumber, firmwareVersion,
+		flashAddress, numValues, type);
+	for (valueI = 0; valueI < numValues; valueI++) {
+		// 17 significant digits restore a double exactly
+		fprintf(file, "%.17g\n", aValues[valueI]);
+	}
+	fclose(file);
+
+	return LJME_NOERROR;
+}
+
+#endif // #define LJM_FLASH_UTILITIES
@@ -0,0 +1,335 @@
+/**
+ * Name: LJM_I2CUtilities.h
+ * Desc: Provides an I2C driver layer that performs each I2C transaction in a
+ *       single LJM_eNames call: the configuration, I2C_DATA_TX, I2C_GO,
+ *       I2C_DATA_RX and I2C_ACKS frames are all sent together. Configuration
+ *       registers (pins, speed throttle, options, slave address and byte
+ *       counts) are only written when they differ from the values last
+ *       written, and several transactions can be queued so that they are
+ *       executed back to back by one LJM_eNames call.
+ * Note: The device performs the frames of a packet in order, so queued
+ *       transactions run in the order they were queued. LJM splits the
+ *       LJM_eNames call into multiple packets if it does not fit in one.
+ *       If the device may have been reconfigured or rebooted since the
+ *       configuration was last written, call InvalidateI2CBus.
+**/
+
+#ifndef LJM_I2C_UTILITIES
+#define LJM_I2C_UTILITIES
+
+#include "LJM_Utilities.h"
+
+// The maximum number of transactions that can be queued on one I2CBus
+enum { I2C_MAX_TRANSACTIONS = 16 };
+
+// The maximum number of TX or RX bytes of one transaction
+enum { I2C_MAX_DATA_BYTES = 64 };
+
+// Configuration frames (7), I2C_DATA_TX, I2C_GO, I2C_DATA_RX and I2C_ACKS
+enum { I2C_MAX_FRAMES_PER_TRANSACTION = 11 };
+
+enum { I2C_MAX_FRAMES =
+	I2C_MAX_TRANSACTIONS * I2C_MAX_FRAMES_PER_TRANSACTION };
+enum { I2C_MAX_VALUES = I2C_MAX_TRANSACTIONS *
+	(I2C_MAX_FRAMES_PER_TRANSACTION + 2 * I2C_MAX_DATA_BYTES) };
+
+// The configuration registers, in the order they are written
+enum {
+	I2C_CONFIG_SDA_DIONUM,
+	I2C_CONFIG_SCL_DIONUM,
+	I2C_CONFIG_SPEED_THROTTLE,
+	I2C_CONFIG_OPTIONS,
+	I2C_CONFIG_SLAVE_ADDRESS,
+	I2C_CONFIG_NUM_BYTES_TX,
+	I2C_CONFIG_NUM_BYTES_RX,
+	I2C_NUM_CONFIG_REGISTERS
+};
+
+static const char * I2C_CONFIG_NAMES[I2C_NUM_CONFIG_REGISTERS] = {
+	"I2C_SDA_DIONUM",
+	"I2C_SCL_DIONUM",
+	"I2C_SPEED_THROTTLE",
+	"I2C_OPTIONS",
+	"I2C_SLAVE_ADDRESS",
+	"I2C_NUM_BYTES_TX",
+	"I2C_NUM_BYTES_RX"
+};
+
+typedef struct I2CTransaction {
+	int slaveAddress;
+	int numTX;
+	unsigned char aTX[I2C_MAX_DATA_BYTES];
+	int numRX;
+
+	// Outputs, written by ExecuteI2CTransactions. Either may be NULL.
+	unsigned char * aRX;
+	unsigned int * acks;
+
+	// Where this transaction's I2C_DATA_RX and I2C_ACKS values are in
+	// I2CBus.aValues
+	int rxValueIndex;
+	int acksValueIndex;
+} I2CTransaction;
+
+typedef struct I2CBus {
+	int handle;
+
+	// The requested values and the values last written to the device, by
+	// I2C_CONFIG_*. A written value of -1 means it is not known.
+	int aConfig[I2C_NUM_CONFIG_REGISTERS];
+	int aWrittenConfig[I2C_NUM_CONFIG_REGISTERS];
+
+	int numQueued;
+	I2CTransaction aQueue[I2C_MAX_TRANSACTIONS];
+
+	// Reused LJM_eNames arrays
+	const char * aNames[I2C_MAX_FRAMES];
+	int aWrites[I2C_MAX_FRAMES];
+	int aNumValues[I2C_MAX_FRAMES];
+	double aValues[I2C_MAX_VALUES];
+
+	// Statistics
+	int numTransactions;
+	int numCalls;
+	int numConfigFramesWritten;
+	int numConfigFramesSkipped;
+} I2CBus;
+
+/**
+ * Desc: Initializes bus for handle. Nothing is written to the device until the
+ *       first transaction is executed.
+ * Para: sdaDIONum, sclDIONum, the DIO numbers of the SDA and SCL lines
+ *       speedThrottle, the I2C_SPEED_THROTTLE value. 0 is the fastest.
+ *       options, the I2C_OPTIONS value
+**/
+void InitI2CBus(I2CBus * bus, int handle, int sdaDIONum, int sclDIONum,
+	int speedThrottle, int options);
+
+/**
+ * Desc: Forgets the configuration values last written so that all of them are
+ *       written with the next transaction.
+**/
+void InvalidateI2CBus(I2CBus * bus);
+
+/**
+ * Desc: Queues a transaction that writes numTX bytes of aTX to slaveAddress,
+ *       then reads numRX bytes into aRX. If the queue is full, the queued
+ *       transactions are executed first.
+ * Para: aTX, copied, so it may be reused once this returns
+ *       aRX, where the received bytes are stored by ExecuteI2CTransactions.
+ *           It must remain valid until then.
+ *       acks, optional (may be NULL) output of the I2C_ACKS value. It must
+ *           remain valid until ExecuteI2CTransactions.
+ * Retr: the LJM error code of executing the full queue, or LJME_NOERROR
+**/
+int QueueI2CTransaction(I2CBus * bus, int slaveAddress, int numTX,
+	const unsigned char * aTX, int numRX, unsigned char * aRX,
+	unsigned int * acks);
+
+/**
+ * Desc: Executes all queued transactions with a single LJM_eNames call and
+ *       stores their received bytes and ACKs, then empties the queue.
+ * Retr: the LJM error code, which is LJME_NOERROR on success
+ * Note: On error, the configuration last written is forgotten, since it is not
+ *       known which frames the device performed.
+**/
+int ExecuteI2CTransactions(I2CBus * bus);
+
+/**
+ * Desc: Queues one transaction and executes the queue.
+ * Retr: the LJM error code, which is LJME_NOERROR on success
+**/
+int I2CTransfer(I2CBus * bus, int slaveAddress, int numTX,
+	const unsigned char * aTX, int numRX, unsigned char * aRX,
+	unsigned int * acks);
+void I2CTransferOrDie(I2CBus * bus, int slaveAddress, int numTX,
+	const unsigned char * aTX, int numRX, unsigned char * aRX,
+	unsigned int * acks);
+
+/**
+ * Desc: Prints the number of transactions, LJM_eNames calls and configuration
+ *       frames written versus skipped by bus
+**/
+void PrintI2CBusStatistics(const I2CBus * bus);
+
+
+// Source
+
+void InitI2CBus(I2CBus * bus, int handle, int sdaDIONum, int sclDIONum,
+	int speedThrottle, int options)
+{
+	memset(bus, 0, sizeof(I2CBus));
+	bus->handle = handle;
+	bus->aConfig[I2C_CONFIG_SDA_DIONUM] = sdaDIONum;
+	bus->aConfig[I2C_CONFIG_SCL_DIONUM] = sclDIONum;
+	bus->aConfig[I2C_CONFIG_SPEED_THROTTLE] = speedThrottle;
+	bus->aConfig[I2C_CONFIG_OPTIONS] = options;
+	InvalidateI2CBus(bus);
+}
+
+void InvalidateI2CBus(I2CBus * bus)
+{
+	int i;
+	for (i = 0; i < I2C_NUM_CONFIG_REGISTERS; i++) {
+		bus->aWrittenConfig[i] = -1;
+	}
+}
+
+int QueueI2CTransaction(I2CBus * bus, int slaveAddress, int numTX,
+	const unsigned char * aTX, int numRX, unsigned char * aRX,
+	unsigned int * acks)
+{
+	int err = LJME_NOERROR;
+	I2CTransaction * transaction;
+
+	if (numTX < 0 || numTX > I2C_MAX_DATA_BYTES || numRX < 0 ||
+		numRX > I2C_MAX_DATA_BYTES)
+	{
+		printf("QueueI2CTransaction: numTX and numRX must be 0 to %d, "
+			"got %d and %d\n", I2C_MAX_DATA_BYTES, numTX, numRX);
+		LJM_CloseAll();
+		exit(1);
+	}
+
+	if (bus->numQueued == I2C_MAX_TRANSACTIONS) {
+		err = ExecuteI2CTransactions(bus);
+	}
+
+	transaction = &bus->aQueue[bus->numQueued++];
+	transaction->slaveAddress = slaveAddress;
+	transaction->numTX = numTX;
+	if (numTX > 0) {
+		memcpy(transaction->aTX, aTX, numTX);
+	}
+	transaction->numRX = numRX;
+	transaction->aRX = aRX;
+	transaction->acks = acks;
+
+	return err;
+}
+
+// Adds one frame to the LJM_eNames arrays of bus
+void _AddI2CFrame(I2CBus * bus, int * numFrames, int * numValues,
+	const char * name, int write, int frameNumValues)
+{
+	bus->aNames[*numFrames] = name;
+	bus->aWrites[*numFrames] = write;
+	bus->aNumValues[*numFrames] = frameNumValues;
+	(*numFrames)++;
+	*numValues += frameNumValues;
+}
+
+int ExecuteI2CTransactions(I2CBus * bus)
+{
+	int i, t, err;
+	int numFrames = 0;
+	int numValues = 0;
+	int errorAddress = INITIAL_ERR_ADDRESS;
+	int aConfig[I2C_NUM_CONFIG_REGISTERS];
+	I2CTransaction * transaction;
+
+	if (bus->numQueued == 0) {
+		return LJME_NOERROR;
+	}
+
+	memcpy(aConfig, bus->aConfig, sizeof(aConfig));
+
+	for (t = 0; t < bus->numQueued; t++) {
+		transaction = &bus->aQueue[t];
+		aConfig[I2C_CONFIG_SLAVE_ADDRESS] = transaction->slaveAddress;
+		aConfig[I2C_CONFIG_NUM_BYTES_TX] = transaction->numTX;
+		aConfig[I2C_CONFIG_NUM_BYTES_RX] = transaction->numRX;
+
+		// Only write the configuration that has changed since it was last
+		// written, including by an earlier transaction of this call
+		for (i = 0; i < I2C_NUM_CONFIG_REGISTERS; i++) {
+			if (aConfig[i] == bus->aWrittenConfig[i]) {
+				bus->numConfigFramesSkipped++;
+				continue;
+			}
+			bus->aValues[numValues] = aConfig[i];
+			_AddI2CFrame(bus, &numFrames, &numValues, I2C_CONFIG_NAMES[i],
+				LJM_WRITE, 1);
+			bus->aWrittenConfig[i] = aConfig[i];
+			bus->numConfigFramesWritten++;
+		}
+
+		if (transaction->numTX > 0) {
+			for (i = 0; i < transaction->numTX; i++) {
+				bus->aValues[numValues + i] = transaction->aTX[i];
+			}
+			_AddI2CFrame(bus, &numFrames, &numValues, "I2C_DATA_TX",
+				LJM_WRITE, transaction->numTX);
+		}
+
+		bus->aValues[numValues] = 1;
+		_AddI2CFrame(bus, &numFrames, &numValues, "I2C_GO", LJM_WRITE, 1);
+
+		transaction->rxValueIndex = numValues;
+		if (transaction->numRX > 0) {
+			_AddI2CFrame(bus, &numFrames, &numValues, "I2C_DATA_RX",
+				LJM_READ, transaction->numRX);
+		}
+
+		transaction->acksValueIndex = numValues;
+		_AddI2CFrame(bus, &numFrames, &numValues, "I2C_ACKS", LJM_READ, 1);
+	}
+
+	err = LJM_eNames(bus->handle, numFrames, bus->aNames, bus->aWrites,
+		bus->aNumValues, bus->aValues, &errorAddress);
+	bus->numCalls++;
+	if (err != LJME_NOERROR) {
+		InvalidateI2CBus(bus);
+		bus->numQueued = 0;
+		return err;
+	}
+
+	for (t = 0; t < bus->numQueued; t++) {
+		transaction = &bus->aQueue[t];
+		if (transaction->aRX) {
+			for (i = 0; i < transaction->numRX; i++) {
+				transaction->aRX[i] = (unsigned char)
+					bus->aValues[transaction->rxValueIndex + i];
+			}
+		}
+		if (transaction->acks) {
+			*transaction->acks =
+				(unsigned int)bus->aValues[transaction->acksValueIndex];
+		}
+	}
+
+	bus->numTransactions += bus->numQueued;
+	bus->numQueued = 0;
+
+	return LJME_NOERROR;
+}
+
+int I2CTransfer(I2CBus * bus, int slaveAddress, int numTX,
+	const unsigned char * aTX, int numRX, unsigned char * aRX,
+	unsigned int * acks)
+{
+	int err = QueueI2CTransaction(bus, slaveAddress, numTX, aTX, numRX, aRX,
+		acks);
+	if (err != LJME_NOERROR) {
+		return err;
+	}
+	return ExecuteI2CTransactions(bus);
+}
+
+void I2CTransferOrDie(I2CBus * bus, int slaveAddress, int numTX,
+	const unsigned char * aTX, int numRX, unsigned char * aRX,
+	unsigned int * acks)
+{
+	int err = I2CTransfer(bus, slaveAddress, numTX, aTX, numRX, aRX, acks);
+	ErrorCheck(err, "I2CTransfer(slave address %d)", slaveAddress);
+}
+
+void PrintI2CBusStatistics(const I2CBus * bus)
+{
+	printf("I2C: %d transactions in %d LJM_eNames calls, "
+		"%d configuration frames written, %d skipped\n",
+		bus->numTransactions, bus->numCalls, bus->numConfigFramesWritten,
+		bus->numConfigFramesSkipped);
+}
+
+#endif // #define LJM_I2C_UTILITIES
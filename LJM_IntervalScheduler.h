@@ -0,0 +1,309 @@
+/**
+ * Name: LJM_IntervalScheduler.h
+ * Desc: Runs several groups of registers at different rates from one LabJack
+ *       using a single LJM_StartInterval loop. The interval runs at the
+ *       greatest common divisor of the group periods; on each interval, every
+ *       group that is due is merged into one LJM_eNames call so the groups
+ *       never contend for the device.
+ * Note: LJM_WaitForNextInterval schedules each interval from the start of the
+ *       interval loop rather than from when it returns, so the loop does not
+ *       drift. When intervals are skipped, the tick count is advanced by the
+ *       number of skipped intervals to keep every group aligned to its period,
+ *       and a group that missed one or more of its periods runs once on the
+ *       next interval.
+**/
+
+#ifndef LJM_INTERVAL_SCHEDULER
+#define LJM_INTERVAL_SCHEDULER
+
+#include "LJM_Utilities.h"
+
+// The maximum number of groups and of frames across all groups
+enum { MAX_SCHEDULED_GROUPS = 8 };
+enum { MAX_SCHEDULED_FRAMES = 32 };
+
+typedef struct ScheduledGroup {
+	const char * description;
+	int periodUS;
+	int numFrames;
+	const char ** aNames;
+	const int * aWrites; // LJM_READ or LJM_WRITE for each frame
+	double * aValues; // Values to write, or the values read
+
+	// Managed by the scheduler
+	int periodTicks;
+	unsigned long nextDueTick;
+	unsigned long numRuns;
+	unsigned long numMissedPeriods;
+} ScheduledGroup;
+
+typedef struct Scheduler {
+	int handle;
+	int intervalHandle;
+	int baseUS;
+	int numGroups;
+	ScheduledGroup * groups;
+
+	unsigned long tick;
+	LJM_LONG_LONG_RETURN startTime;
+
+	// Statistics
+	unsigned long numIntervals;
+	unsigned long numOverruns;
+	unsigned long numSkippedIntervals;
+	unsigned long numCalls;
+	unsigned long numFramesSent;
+	LJM_LONG_LONG_RETURN minLatenessUS;
+	LJM_LONG_LONG_RETURN maxLatenessUS;
+	double totalLatenessUS;
+	LJM_LONG_LONG_RETURN maxCallUS;
+} Scheduler;
+
+/**
+ * Desc: Prepares scheduler to run groups on handle, timed by the LJM interval
+ *       intervalHandle. The base interval is the greatest common divisor of
+ *       the group periods.
+**/
+void InitScheduler(Scheduler * scheduler, int handle, int intervalHandle,
+	int numGroups, ScheduledGroup * groups);
+
+/**
+ * Desc: Starts the interval and sends every group once.
+**/
+void StartScheduler(Scheduler * scheduler);
+
+/**
+ * Desc: Waits for the next interval, then sends every group that is due in a
+ *       single LJM_eNames call.
+ * Para: aRanGroups, set to 1 for each group that ran and 0 otherwise. May be
+ *       NULL.
+**/
+void RunSchedulerInterval(Scheduler * scheduler, int * aRanGroups);
+
+/**
+ * Desc: Stops the interval.
+**/
+void StopScheduler(Scheduler * scheduler);
+
+/**
+ * Desc: Prints the per-group run counts, overruns and jitter statistics.
+**/
+void PrintSchedulerStatistics(const Scheduler * scheduler);
+
+
+// Source
+
+int _GreatestCommonDivisor(int a, int b)
+{
+	int remainder;
+	while (b != 0) {
+		remainder = a % b;
+		a = b;
+		b = remainder;
+	}
+	return a;
+}
+
+void InitScheduler(Scheduler * scheduler, int handle, int intervalHandle,
+	int numGroups, ScheduledGroup * groups)
+{
+	int i;
+	int totalFrames = 0;
+
+	if (numGroups > MAX_SCHEDULED_GROUPS) {
+		printf("InitScheduler: %d groups exceeds MAX_SCHEDULED_GROUPS (%d)\n",
+			numGroups, MAX_SCHEDULED_GROUPS);
+		LJM_CloseAll();
+		exit(1);
+	}
+
+	memset(scheduler, 0, sizeof(Scheduler));
+	scheduler->handle = handle;
+	scheduler->intervalHandle = intervalHandle;
+	scheduler->numGroups = numGroups;
+	scheduler->groups = groups;
+
+	for (i = 0; i < numGroups; i++) {
+		if (groups[i].periodUS <= 0) {
+			printf("InitScheduler: %s has an invalid period of %d us\n",
+				groups[i].description, groups[i].periodUS);
+			LJM_CloseAll();
+			exit(1);
+		}
+		scheduler->baseUS = _GreatestCommonDivisor(groups[i].periodUS,
+			scheduler->baseUS);
+		totalFrames += groups[i].numFrames;
+	}
+
+	if (totalFrames > MAX_SCHEDULED_FRAMES) {
+		printf("InitScheduler: %d frames exceeds MAX_SCHEDULED_FRAMES (%d)\n",
+			totalFrames, MAX_SCHEDULED_FRAMES);
+		LJM_CloseAll();
+		exit(1);
+	}
+
+	for (i = 0; i < numGroups; i++) {
+		groups[i].periodTicks = groups[i].periodUS / scheduler->baseUS;
+		groups[i].nextDueTick = 0;
+		groups[i].numRuns = 0;
+		groups[i].numMissedPeriods = 0;
+	}
+}
+
+// Sends every due group in one LJM_eNames call and schedules its next run
+void _SendDueGroups(Scheduler * scheduler, int * aRanGroups)
+{
+	int err, i, frame;
+	int numFrames = 0;
+	int errorAddress = INITIAL_ERR_ADDRESS;
+	unsigned long tick = scheduler->tick;
+	unsigned long missed;
+	LJM_LONG_LONG_RETURN callStart, callUS;
+	ScheduledGroup * group;
+
+	const char * aNames[MAX_SCHEDULED_FRAMES];
+	int aWrites[MAX_SCHEDULED_FRAMES];
+	int aNumValues[MAX_SCHEDULED_FRAMES];
+	double aValues[MAX_SCHEDULED_FRAMES];
+	int aDue[MAX_SCHEDULED_GROUPS];
+
+	for (i = 0; i < scheduler->numGroups; i++) {
+		group = &scheduler->groups[i];
+		aDue[i] = (tick >= group->nextDueTick);
+		if (aRanGroups) {
+			aRanGroups[i] = aDue[i];
+		}
+		if (!aDue[i]) {
+			continue;
+		}
+		for (frame = 0; frame < group->numFrames; frame++) {
+			aNames[numFrames] = group->aNames[frame];
+			aWrites[numFrames] = group->aWrites[frame];
+			aNumValues[numFrames] = 1;
+			aValues[numFrames] = group->aValues[frame];
+			numFrames++;
+		}
+	}
+
+	if (numFrames == 0) {
+		return;
+	}
+
+	callStart = LJM_GetHostTick();
+	err = LJM_eNames(scheduler->handle, numFrames, aNames, aWrites,
+		aNumValues, aValues, &errorAddress);
+	ErrorCheckWithAddress(err, errorAddress, "LJM_eNames");
+	callUS = LJM_GetHostTick() - callStart;
+	if (callUS > scheduler->maxCallUS) {
+		scheduler->maxCallUS = callUS;
+	}
+	scheduler->numCalls++;
+	scheduler->numFramesSent += numFrames;
+
+	numFrames = 0;
+	for (i = 0; i < scheduler->numGroups; i++) {
+		group = &scheduler->groups[i];
+		if (!aDue[i]) {
+			continue;
+		}
+		for (frame = 0; frame < group->numFrames; frame++) {
+			if (group->aWrites[frame] == LJM_READ) {
+				group->aValues[frame] = aValues[numFrames];
+			}
+			numFrames++;
+		}
+		group->numRuns++;
+
+		// Keep the group aligned to multiples of its period. If intervals were
+		// skipped past one or more of its due ticks, it ran once for all of
+		// them.
+		if (tick > group->nextDueTick) {
+			missed = (tick - group->nextDueTick) / group->periodTicks;
+			group->numMissedPeriods += missed;
+		}
+		group->nextDueTick = tick - (tick % group->periodTicks) +
+			group->periodTicks;
+	}
+}
+
+void StartScheduler(Scheduler * scheduler)
+{
+	int err = LJM_StartInterval(scheduler->intervalHandle,
+		scheduler->baseUS);
+	ErrorCheck(err, "LJM_StartInterval");
+
+	scheduler->startTime = LJM_GetHostTick();
+	scheduler->tick = 0;
+	scheduler->minLatenessUS = 0;
+	scheduler->maxLatenessUS = 0;
+
+	_SendDueGroups(scheduler, NULL);
+}
+
+void RunSchedulerInterval(Scheduler * scheduler, int * aRanGroups)
+{
+	int err, skippedIntervals;
+	LJM_LONG_LONG_RETURN idealTime, latenessUS;
+
+	err = LJM_WaitForNextInterval(scheduler->intervalHandle,
+		&skippedIntervals);
+	ErrorCheck(err, "LJM_WaitForNextInterval");
+
+	scheduler->tick += 1 + skippedIntervals;
+	scheduler->numIntervals++;
+	if (skippedIntervals > 0) {
+		scheduler->numOverruns++;
+		scheduler->numSkippedIntervals += skippedIntervals;
+	}
+
+	// Lateness relative to the ideal start of this interval
+	idealTime = scheduler->startTime +
+		(LJM_LONG_LONG_RETURN)scheduler->tick * scheduler->baseUS;
+	latenessUS = LJM_GetHostTick() - idealTime;
+	if (scheduler->numIntervals == 1 || latenessUS < scheduler->minLatenessUS) {
+		scheduler->minLatenessUS = latenessUS;
+	}
+	if (scheduler->numIntervals == 1 || latenessUS > scheduler->maxLatenessUS) {
+		scheduler->maxLatenessUS = latenessUS;
+	}
+	scheduler->totalLatenessUS += (double)latenessUS;
+
+	_SendDueGroups(scheduler, aRanGroups);
+}
+
+void StopScheduler(Scheduler * scheduler)
+{
+	int err = LJM_CleanInterval(scheduler->intervalHandle);
+	PrintErrorIfError(err, "LJM_CleanInterval");
+}
+
+void PrintSchedulerStatistics(const Scheduler * scheduler)
+{
+	int i;
+	const ScheduledGroup * group;
+
+	printf("Scheduler statistics:\n");
+	printf("    base interval: %d us, intervals run: %lu\n", scheduler->baseUS,
+		scheduler->numIntervals);
+	printf("    overruns: %lu, skipped intervals: %lu\n",
+		scheduler->numOverruns, scheduler->numSkippedIntervals);
+	printf("    LJM_eNames calls: %lu, frames sent: %lu, "
+		"longest call: %.3f ms\n", scheduler->numCalls,
+		scheduler->numFramesSent, scheduler->maxCallUS / 1000.0);
+	if (scheduler->numIntervals > 0) {
+		printf("    interval lateness: min %.3f ms, mean %.3f ms, "
+			"max %.3f ms, jitter (max - min) %.3f ms\n",
+			scheduler->minLatenessUS / 1000.0,
+			scheduler->totalLatenessUS / scheduler->numIntervals / 1000.0,
+			scheduler->maxLatenessUS / 1000.0,
+			(scheduler->maxLatenessUS - scheduler->minLatenessUS) / 1000.0);
+	}
+
+	for (i = 0; i < scheduler->numGroups; i++) {
+		group = &scheduler->groups[i];
+		printf("    %s: %lu runs, %lu missed periods\n", group->description,
+			group->numRuns, group->numMissedPeriods);
+	}
+}
+
+#endif // #define LJM_INTERVAL_SCHEDULER
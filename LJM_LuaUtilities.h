@@ -0,0 +1,730 @@
+/**
+ * Name: LJM_LuaUtilities.h
+ * Desc: Provides helper functions for deploying Lua scripts to LabJack devices.
+ *       DeployLuaScript minifies a script, uploads it to LUA_SOURCE_WRITE in
+ *       chunks that each fit in one packet, runs it and verifies that the
+ *       device started the uploaded script by reading back a deploy nonce line
+ *       that the script prints when it starts.
+ *       DeployLuaScriptToDevices does the same for several devices in
+ *       parallel.
+ *       A LuaDebugReader drains Lua debug output (what a script prints) in a
+ *       background thread and passes it on one line at a time.
+ * Note: Programs that include this file must link with pthread on Linux and
+ *       Mac OS X (see LJM_ThreadUtilities.h).
+**/
+
+#ifndef LJM_LUA_UTILITIES
+#define LJM_LUA_UTILITIES
+
+#include "LJM_ThreadUtilities.h"
+
+// Returned by DeployLuaScript when the script was uploaded and started, but
+// the nonce line was not read back before LUA_DEPLOY_VERIFY_TIMEOUT_MS
+enum { LUA_DEPLOY_NOT_VERIFIED = -1 };
+
+enum { LUA_STOP_TIMEOUT_MS = 2000 };
+enum { LUA_DEPLOY_VERIFY_TIMEOUT_MS = 3000 };
+
+// The first line the deployed script prints, followed by the deploy nonce
+static const char * LUA_DEPLOY_NONCE_PREFIX = "LUA_DEPLOY_NONCE ";
+
+/**
+ * Desc: Returns a copy of luaScript without comments, indentation, trailing
+ *       whitespace or blank lines, and with runs of spaces reduced to one
+ *       space. String literals are copied unchanged.
+ * Note: The caller must free the returned string.
+**/
+char * MinifyLuaScript(const char * luaScript);
+
+/**
+ * Desc: Returns the CRC-32 of the numBytes of aBytes.
+**/
+unsigned int LuaScriptChecksum(const char * aBytes, int numBytes);
+
+/**
+ * Desc: Stops the running Lua script. LUA_RUN is written to 0, polled until
+ *       the Lua VM has shut down, then written to 0 again.
+ * Retr: the LJM error code, which is LJME_NOERROR on success
+**/
+int StopLuaScript(int handle);
+
+/**
+ * Desc: Reads and discards any Lua debug output waiting on the device.
+ * Retr: the LJM error code, which is LJME_NOERROR on success
+**/
+int DiscardLuaDebugData(int handle);
+
+/**
+ * Desc: Writes LUA_SOURCE_SIZE, then writes the scriptLength bytes of
+ *       luaScript to LUA_SOURCE_WRITE in chunks that each fit in one packet of
+ *       the connection. scriptLength should include the null terminator.
+ * Retr: the LJM error code, which is LJME_NOERROR on success
+**/
+int UploadLuaScript(int handle, const char * luaScript, int scriptLength);
+
+/**
+ * Desc: Stops the running script, then minifies, uploads and runs luaScript
+ *       with debug output enabled. A line that prints LUA_DEPLOY_NONCE_PREFIX
+ *       and a deploy nonce is added to the start of the script, and the
+ *       deploy is verified by reading that line back from LUA_DEBUG_DATA.
+ *       Debug output read while verifying is discarded.
+ * Note: The nonce is the LuaScriptChecksum of the minified script followed by
+ *       the host tick of the deploy. It is computed by the host, not by the
+ *       device, so reading it back shows that the device compiled and started
+ *       this deploy of the script rather than an earlier one. It does not
+ *       prove that every byte of the source arrived unchanged.
+ * Para: uploadedBytes, receives the number of bytes uploaded. May be NULL.
+ * Retr: the LJM error code, LJME_NOERROR when the deploy was verified, or
+ *       LUA_DEPLOY_NOT_VERIFIED
+**/
+int DeployLuaScript(int handle, const char * luaScript, int * uploadedBytes);
+
+/**
+ * Desc: Calls DeployLuaScript for each of the numHandles devices of aHandles,
+ *       each in its own thread.
+ * Para: aErrors, receives the result of DeployLuaScript for each device.
+ * Retr: the number of devices with a verified deploy
+**/
+int DeployLuaScriptToDevices(int numHandles, const int * aHandles,
+	const char * luaScript, int * aErrors);
+
+enum { LUA_DEBUG_READ_BYTES = 1024 };
+enum { LUA_DEBUG_MAX_LINE_LENGTH = 1024 };
+enum { LUA_DEBUG_MIN_POLL_MS = 5 };
+enum { LUA_DEBUG_MAX_POLL_MS = 500 };
+
+/**
+ * Desc: Called by a LuaDebugReader, from its thread, for each line of Lua debug
+ *       output. line does not include the newline.
+**/
+typedef void (*LuaDebugLineCallback)(const char * line, void * userData);
+
+typedef struct LuaDebugReader {
+	int handle;
+	LuaDebugLineCallback callback;
+	void * userData;
+	int logLevel;
+
+	Thread thread;
+	volatile int stopRequested;
+
+	// Reused for every read, so no memory is allocated while running
+	char aReadBuffer[LUA_DEBUG_READ_BYTES];
+	char aLine[LUA_DEBUG_MAX_LINE_LENGTH + 1];
+	int lineLength;
+
+	// The current poll interval, which adapts to the output rate
+	int pollMS;
+
+	// Statistics
+	unsigned long numPolls;
+	unsigned long numBytes;
+	unsigned long numLines;
+	unsigned long numSplitLines;
+	unsigned long numErrors;
+	int lastErr;
+} LuaDebugReader;
+
+/**
+ * Desc: Starts a thread that reads LUA_DEBUG_DATA from handle and calls
+ *       callback for each complete line. While output is arriving, the poll
+ *       interval is halved down to LUA_DEBUG_MIN_POLL_MS so the device's debug
+ *       buffer does not fill between polls; while there is no output, it grows
+ *       up to LUA_DEBUG_MAX_POLL_MS.
+ * Para: callback, may be NULL.
+ *       logLevel, if non-zero, each line is also passed to LJM_Log with this
+ *       level, such as LJM_DEBUG.
+ * Retr: 0 on success, non-zero if the thread could not be started
+**/
+int StartLuaDebugReader(LuaDebugReader * reader, int handle,
+	LuaDebugLineCallback callback, void * userData, int logLevel);
+
+/**
+ * Desc: Stops the reader's thread. Any incomplete last line is passed to the
+ *       callback.
+**/
+void StopLuaDebugReader(LuaDebugReader * reader);
+
+/**
+ * Desc: Prints the number of polls, bytes, lines and errors of reader.
+**/
+void PrintLuaDebugReaderStatistics(const LuaDebugReader * reader);
+
+
+// Source
+
+// Returns the length of the long bracket that starts at s, such as 2 for "[["
+// or 4 for "[==[", or 0 if s does not start a long bracket
+int _LuaLongBracketLength(const char * s)
+{
+	int length = 1;
+	if (s[0] != '[') {
+		return 0;
+	}
+	while (s[length] == '=') {
+		length++;
+	}
+	if (s[length] != '[') {
+		return 0;
+	}
+	return length + 1;
+}
+
+// Returns a pointer to the character after the long bracket closing the one
+// of bracketLength that s is inside of, or to the end of s if it is not closed
+const char * _LuaSkipLongBracket(const char * s, int bracketLength)
+{
+	int numEquals = bracketLength - 2;
+	int i;
+	for (; *s != '\0'; s++) {
+		if (*s != ']') {
+			continue;
+		}
+		for (i = 0; i < numEquals && s[1 + i] == '='; i++) {}
+		if (i == numEquals && s[1 + numEquals] == ']') {
+			return s + bracketLength;
+		}
+	}
+	return s;
+}
+
+// Returns 1 if a space between a and b can be removed
+int _LuaSpaceIsRemovable(char a, char b)
+{
+	const char * SEPARATORS = "(){}[],;";
+
+	// "[ [" and "] ]" would join into the start or end of a long bracket
+	if ((a == '[' && b == '[') || (a == ']' && b == ']')) {
+		return 0;
+	}
+	if (strchr(SEPARATORS, a) != NULL || strchr(SEPARATORS, b) != NULL) {
+		return 1;
+	}
+	// "a = b" -> "a=b", but not when it could join into ==, <=, >= or ~=
+	if ((a == '=' && b != '=') || (b == '=' && strchr("=<>~", a) == NULL)) {
+		return 1;
+	}
+	return 0;
+}
+
+char * MinifyLuaScript(const char * luaScript)
+{
+	// Add 2 for a final newline and the null terminator
+	char * out = malloc(strlen(luaScript) + 2);
+	int outLength = 0;
+	int pendingSpace = 0;
+	int bracketLength;
+	const char * s = luaScript;
+	const char * end;
+	char quote;
+
+	if (out == NULL) {
+		printf("MinifyLuaScript: could not allocate %d bytes\n",
+			(int)strlen(luaScript) + 2);
+		LJM_CloseAll();
+		exit(1);
+	}
+
+	while (*s != '\0') {
+		if (s[0] == '-' && s[1] == '-') {
+			// Comment
+			bracketLength = _LuaLongBracketLength(s + 2);
+			if (bracketLength > 0) {
+				s = _LuaSkipLongBracket(s + 2 + bracketLength, bracketLength);
+				// A block comment may separate two tokens
+				pendingSpace = 1;
+			}
+			else {
+				while (*s != '\0' && *s != '\n') {
+					s++;
+				}
+			}
+			continue;
+		}
+
+		if (*s == ' ' || *s == '\t' || *s == '\r') {
+			pendingSpace = 1;
+			s++;
+			continue;
+		}
+
+		if (*s == '\n') {
+			// Drop trailing whitespace and blank lines
+			if (outLength > 0 && out[outLength - 1] != '\n') {
+				out[outLength++] = '\n';
+			}
+			pendingSpace = 0;
+			s++;
+			continue;
+		}
+
+		if (pendingSpace) {
+			if (outLength > 0 && out[outLength - 1] != '\n' &&
+				!_LuaSpaceIsRemovable(out[outLength - 1], *s))
+			{
+				out[outLength++] = ' ';
+			}
+			pendingSpace = 0;
+		}
+
+		bracketLength = _LuaLongBracketLength(s);
+		if (bracketLength > 0) {
+			// Long string, copied unchanged
+			end = _LuaSkipLongBracket(s + bracketLength, bracketLength);
+			memcpy(out + outLength, s, end - s);
+			outLength += end - s;
+			s = end;
+			continue;
+		}
+
+		if (*s == '"' || *s == '\'') {
+			// Quoted string, copied unchanged
+			quote = *s;
+			out[outLength++] = *s++;
+			while (*s != '\0' && *s != quote && *s != '\n') {
+				if (*s == '\\' && s[1] != '\0') {
+					out[outLength++] = *s++;
+				}
+				out[outLength++] = *s++;
+			}
+			if (*s == quote) {
+				out[outLength++] = *s++;
+			}
+			continue;
+		}
+
+		out[outLength++] = *s++;
+	}
+
+	if (outLength > 0 && out[outLength - 1] != '\n') {
+		out[outLength++] = '\n';
+	}
+	out[outLength] = '\0';
+
+	return out;
+}
+
+unsigned int LuaScriptChecksum(const char * aBytes, int numBytes)
+{
+	unsigned int crc = 0xFFFFFFFF;
+	int i, bit;
+	for (i = 0; i < numBytes; i++) {
+		crc ^= (unsigned char)aBytes[i];
+		for (bit = 0; bit < 8; bit++) {
+			crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+		}
+	}
+	return ~crc;
+}
+
+int StopLuaScript(int handle)
+{
+	double luaRun = 1;
+	int waitedMS = 0;
+	int err = LJM_eWriteName(handle, "LUA_RUN", 0);
+	PrintErrorIfError(err, "StopLuaScript: LJM_eWriteName(LUA_RUN, 0)");
+	if (err != LJME_NOERROR) {
+		return err;
+	}
+
+	// Wait for the Lua VM to shut down instead of sleeping for the longest
+	// time any firmware version needs
+	while (waitedMS < LUA_STOP_TIMEOUT_MS) {
+		err = LJM_eReadName(handle, "LUA_RUN", &luaRun);
+		PrintErrorIfError(err, "StopLuaScript: LJM_eReadName(LUA_RUN)");
+		if (err != LJME_NOERROR) {
+			return err;
+		}
+		if ((int)luaRun == 0) {
+			break;
+		}
+		MillisecondSleep(10);
+		waitedMS += 10;
+	}
+
+	err = LJM_eWriteName(handle, "LUA_RUN", 0);
+	PrintErrorIfError(err, "StopLuaScript: LJM_eWriteName(LUA_RUN, 0)");
+	return err;
+}
+
+int DiscardLuaDebugData(int handle)
+{
+	double numBytes = 0;
+	char * aBytes;
+	int errorAddress = INITIAL_ERR_ADDRESS;
+	int err = LJM_eReadName(handle, "LUA_DEBUG_NUM_BYTES", &numBytes);
+	PrintErrorIfError(err, "LJM_eReadName(%d, LUA_DEBUG_NUM_BYTES, ...)",
+		handle);
+	if (err != LJME_NOERROR || (int)numBytes == 0) {
+		return err;
+	}
+
+	aBytes = malloc((int)numBytes);
+	if (aBytes == NULL) {
+		printf("DiscardLuaDebugData: could not allocate %d bytes\n",
+			(int)numBytes);
+		LJM_CloseAll();
+		exit(1);
+	}
+	err = LJM_eReadNameByteArray(handle, "LUA_DEBUG_DATA", (int)numBytes,
+		aBytes, &errorAddress);
+	PrintErrorWithAddressIfError(err, errorAddress,
+		"LJM_eReadNameByteArray(%d, LUA_DEBUG_DATA, ...)", handle);
+	free(aBytes);
+	return err;
+}
+
+// Bytes of each Modbus feedback command that are not LUA_SOURCE_WRITE data
+enum { LUA_SOURCE_WRITE_OVERHEAD_BYTES = 16 };
+
+int UploadLuaScript(int handle, const char * luaScript, int scriptLength)
+{
+	int err, offset, chunkSize, numBytes;
+	int errorAddress = INITIAL_ERR_ADDRESS;
+	int deviceType, connectionType, serialNumber, ipAddress, port;
+	int maxBytesPerMB;
+
+	err = LJM_GetHandleInfo(handle, &deviceType, &connectionType,
+		&serialNumber, &ipAddress, &port, &maxBytesPerMB);
+	PrintErrorIfError(err, "LJM_GetHandleInfo");
+	if (err != LJME_NOERROR) {
+		return err;
+	}
+	chunkSize = (maxBytesPerMB - LUA_SOURCE_WRITE_OVERHEAD_BYTES) & ~1;
+
+	err = LJM_eWriteName(handle, "LUA_SOURCE_SIZE", scriptLength);
+	PrintErrorIfError(err, "LJM_eWriteName(%d, LUA_SOURCE_SIZE, %d)", handle,
+		scriptLength);
+	if (err != LJME_NOERROR) {
+		return err;
+	}
+
+	// Each write to LUA_SOURCE_WRITE appends to the source
+	for (offset = 0; offset < scriptLength; offset += numBytes) {
+		numBytes = scriptLength - offset;
+		if (numBytes > chunkSize) {
+			numBytes = chunkSize;
+		}
+		err = LJM_eWriteNameByteArray(handle, "LUA_SOURCE_WRITE", numBytes,
+			luaScript + offset, &errorAddress);
+		PrintErrorWithAddressIfError(err, errorAddress,
+			"LJM_eWriteNameByteArray(%d, LUA_SOURCE_WRITE, %d, ...)", handle,
+			numBytes);
+		if (err != LJME_NOERROR) {
+			return err;
+		}
+	}
+
+	return LJME_NOERROR;
+}
+
+// Reads debug output until expectedLine is found or the timeout passes
+int _WaitForLuaDebugLine(int handle, const char * expectedLine)
+{
+	enum { MAX_SEARCHED_BYTES = 1024 };
+	char aSearched[MAX_SEARCHED_BYTES + 1];
+	int numSearched = 0;
+	int waitedMS = 0;
+	int numRead;
+	double numBytes;
+	int errorAddress = INITIAL_ERR_ADDRESS;
+	int err;
+
+	while (waitedMS < LUA_DEPLOY_VERIFY_TIMEOUT_MS) {
+		err = LJM_eReadName(handle, "LUA_DEBUG_NUM_BYTES", &numBytes);
+		PrintErrorIfError(err, "LJM_eReadName(%d, LUA_DEBUG_NUM_BYTES, ...)",
+			handle);
+		if (err != LJME_NOERROR) {
+			return err;
+		}
+
+		numRead = (int)numBytes;
+		if (numRead > MAX_SEARCHED_BYTES - numSearched) {
+			numRead = MAX_SEARCHED_BYTES - numSearched;
+		}
+		if (numRead > 0) {
+			err = LJM_eReadNameByteArray(handle, "LUA_DEBUG_DATA", numRead,
+				aSearched + numSearched, &errorAddress);
+			PrintErrorWithAddressIfError(err, errorAddress,
+				"LJM_eReadNameByteArray(%d, LUA_DEBUG_DATA, ...)", handle);
+			if (err != LJME_NOERROR) {
+				return err;
+			}
+			numSearched += numRead;
+			aSearched[numSearched] = '\0';
+			if (strstr(aSearched, expectedLine) != NULL) {
+				return LJME_NOERROR;
+			}
+			if (numSearched == MAX_SEARCHED_BYTES) {
+				break;
+			}
+		}
+
+		MillisecondSleep(20);
+		waitedMS += 20;
+	}
+
+	return LUA_DEPLOY_NOT_VERIFIED;
+}
+
+int DeployLuaScript(int handle, const char * luaScript, int * uploadedBytes)
+{
+	int err, scriptLength;
+	char * minified;
+	char * deployed;
+	char nonceLine[64];
+	unsigned int checksum;
+
+	minified = MinifyLuaScript(luaScript);
+	checksum = LuaScriptChecksum(minified, (int)strlen(minified));
+	sprintf(nonceLine, "%s%08x-%08x", LUA_DEPLOY_NONCE_PREFIX, checksum,
+		(unsigned int)LJM_GetHostTick());
+
+	// print("LUA_DEPLOY_NONCE xxxxxxxx-xxxxxxxx") + '\n' + minified + '\0'
+	deployed = malloc(strlen(nonceLine) + strlen(minified) + 16);
+	if (deployed == NULL) {
+		printf("DeployLuaScript: could not allocate %d bytes\n",
+			(int)(strlen(nonceLine) + strlen(minified) + 16));
+		LJM_CloseAll();
+		exit(1);
+	}
+	sprintf(deployed, "print(\"%s\")\n%s", nonceLine, minified);
+	free(minified);
+	scriptLength = (int)strlen(deployed) + 1;
+	if (uploadedBytes) {
+		*uploadedBytes = scriptLength;
+	}
+
+	err = StopLuaScript(handle);
+	if (err == LJME_NOERROR) {
+		err = DiscardLuaDebugData(handle);
+	}
+	if (err == LJME_NOERROR) {
+		err = UploadLuaScript(handle, deployed, scriptLength);
+	}
+	free(deployed);
+	if (err != LJME_NOERROR) {
+		return err;
+	}
+
+	err = LJM_eWriteName(handle, "LUA_DEBUG_ENABLE", 1);
+	if (err == LJME_NOERROR) {
+		err = LJM_eWriteName(handle, "LUA_DEBUG_ENABLE_DEFAULT", 1);
+	}
+	if (err == LJME_NOERROR) {
+		err = LJM_eWriteName(handle, "LUA_RUN", 1);
+	}
+	PrintErrorIfError(err, "DeployLuaScript: starting the script");
+	if (err != LJME_NOERROR) {
+		return err;
+	}
+
+	return _WaitForLuaDebugLine(handle, nonceLine);
+}
+
+typedef struct _LuaDeploy {
+	int handle;
+	const char * luaScript;
+	int err;
+} _LuaDeploy;
+
+// Thread function for DeployLuaScriptToDevices
+void _DeployLuaScriptThread(void * deployPtr)
+{
+	_LuaDeploy * deploy = (_LuaDeploy *)deployPtr;
+	deploy->err = DeployLuaScript(deploy->handle, deploy->luaScript, NULL);
+}
+
+int DeployLuaScriptToDevices(int numHandles, const int * aHandles,
+	const char * luaScript, int * aErrors)
+{
+	int i;
+	int numVerified = 0;
+	_LuaDeploy * aDeploys = malloc(sizeof(_LuaDeploy) * numHandles);
+	Thread * aThreads = malloc(sizeof(Thread) * numHandles);
+	int * aStarted = malloc(sizeof(int) * numHandles);
+
+	if (aDeploys == NULL || aThreads == NULL || aStarted == NULL) {
+		printf("DeployLuaScriptToDevices: could not allocate %d deploys\n",
+			numHandles);
+		LJM_CloseAll();
+		exit(1);
+	}
+
+	for (i = 0; i < numHandles; i++) {
+		aDeploys[i].handle = aHandles[i];
+		aDeploys[i].luaScript = luaScript;
+		aDeploys[i].err = LJME_NOERROR;
+		aStarted[i] = (StartThread(&aThreads[i], _DeployLuaScriptThread,
+			&aDeploys[i]) == 0);
+		if (!aStarted[i]) {
+			_DeployLuaScriptThread(&aDeploys[i]);
+		}
+	}
+
+	for (i = 0; i < numHandles; i++) {
+		if (aStarted[i]) {
+			JoinThread(aThreads[i]);
+		}
+		aErrors[i] = aDeploys[i].err;
+		if (aErrors[i] == LJME_NOERROR) {
+			numVerified++;
+		}
+	}
+
+	free(aStarted);
+	free(aThreads);
+	free(aDeploys);
+
+	return numVerified;
+}
+
+// Passes the line collected so far to the callback and LJM_Log
+void _DispatchLuaDebugLine(LuaDebugReader * reader)
+{
+	reader->aLine[reader->lineLength] = '\0';
+	if (reader->callback) {
+		reader->callback(reader->aLine, reader->userData);
+	}
+	if (reader->logLevel) {
+		LJM_Log(reader->logLevel, reader->aLine);
+	}
+	reader->lineLength = 0;
+	reader->numLines++;
+}
+
+// Splits numBytes of debug output into lines
+void _AddLuaDebugBytes(LuaDebugReader * reader, const char * aBytes,
+	int numBytes)
+{
+	int i;
+	for (i = 0; i < numBytes; i++) {
+		if (aBytes[i] == '\n') {
+			// Drop the \r of \r\n line endings
+			if (reader->lineLength > 0 &&
+				reader->aLine[reader->lineLength - 1] == '\r')
+			{
+				reader->lineLength--;
+			}
+			_DispatchLuaDebugLine(reader);
+		}
+		else {
+			if (reader->lineLength == LUA_DEBUG_MAX_LINE_LENGTH) {
+				_DispatchLuaDebugLine(reader);
+				reader->numSplitLines++;
+			}
+			reader->aLine[reader->lineLength++] = aBytes[i];
+		}
+	}
+}
+
+// Reads all waiting debug output
+// Retr: the number of bytes read, or -1 on error
+int _PollLuaDebugData(LuaDebugReader * reader)
+{
+	double numWaiting = 0;
+	int numRead, numTotal;
+	int errorAddress = INITIAL_ERR_ADDRESS;
+	int err;
+
+	reader->numPolls++;
+	err = LJM_eReadName(reader->handle, "LUA_DEBUG_NUM_BYTES", &numWaiting);
+	numTotal = 0;
+	while (err == LJME_NOERROR && numTotal < (int)numWaiting) {
+		numRead = (int)numWaiting - numTotal;
+		if (numRead > LUA_DEBUG_READ_BYTES) {
+			numRead = LUA_DEBUG_READ_BYTES;
+		}
+		err = LJM_eReadNameByteArray(reader->handle, "LUA_DEBUG_DATA",
+			numRead, reader->aReadBuffer, &errorAddress);
+		if (err == LJME_NOERROR) {
+			_AddLuaDebugBytes(reader, reader->aReadBuffer, numRead);
+			numTotal += numRead;
+		}
+	}
+
+	if (err != LJME_NOERROR) {
+		reader->numErrors++;
+		reader->lastErr = err;
+		return -1;
+	}
+	reader->numBytes += numTotal;
+	return numTotal;
+}
+
+// Thread function for StartLuaDebugReader
+void _LuaDebugReaderThread(void * readerPtr)
+{
+	LuaDebugReader * reader = (LuaDebugReader *)readerPtr;
+	int numRead, sleptMS;
+
+	while (!reader->stopRequested) {
+		numRead = _PollLuaDebugData(reader);
+		if (numRead > 0) {
+			reader->pollMS /= 2;
+			if (reader->pollMS < LUA_DEBUG_MIN_POLL_MS) {
+				reader->pollMS = LUA_DEBUG_MIN_POLL_MS;
+			}
+		}
+		else {
+			// No output, or an error such as while the device reconnects
+			reader->pollMS += reader->pollMS / 2 + 1;
+			if (reader->pollMS > LUA_DEBUG_MAX_POLL_MS) {
+				reader->pollMS = LUA_DEBUG_MAX_POLL_MS;
+			}
+		}
+
+		// Sleep in short steps so that StopLuaDebugReader returns quickly
+		for (sleptMS = 0; sleptMS < reader->pollMS && !reader->stopRequested;
+			sleptMS += LUA_DEBUG_MIN_POLL_MS)
+		{
+			MillisecondSleep(LUA_DEBUG_MIN_POLL_MS);
+		}
+	}
+}
+
+int StartLuaDebugReader(LuaDebugReader * reader, int handle,
+	LuaDebugLineCallback callback, void * userData, int logLevel)
+{
+	memset(reader, 0, sizeof(LuaDebugReader));
+	reader->handle = handle;
+	reader->callback = callback;
+	reader->userData = userData;
+	reader->logLevel = logLevel;
+	reader->pollMS = LUA_DEBUG_MIN_POLL_MS;
+
+	if (StartThread(&reader->thread, _LuaDebugReaderThread, reader) != 0) {
+		printf("StartLuaDebugReader: could not start the reader thread\n");
+		return 1;
+	}
+	return 0;
+}
+
+void StopLuaDebugReader(LuaDebugReader * reader)
+{
+	reader->stopRequested = 1;
+	JoinThread(reader->thread);
+
+	if (reader->lineLength > 0) {
+		_DispatchLuaDebugLine(reader);
+	}
+}
+
+void PrintLuaDebugReaderStatistics(const LuaDebugReader * reader)
+{
+	char errorString[LJM_MAX_NAME_SIZE];
+
+	printf("Lua debug reader: %lu polls, %lu bytes, %lu lines",
+		reader->numPolls, reader->numBytes, reader->numLines);
+	if (reader->numSplitLines > 0) {
+		printf(" (%lu split at %d bytes)", reader->numSplitLines,
+			LUA_DEBUG_MAX_LINE_LENGTH);
+	}
+	printf(", final poll interval: %d ms\n", reader->pollMS);
+	if (reader->numErrors > 0) {
+		LJM_ErrorToString(reader->lastErr, errorString);
+		printf("    %lu errors, last: %s\n", reader->numErrors, errorString);
+	}
+}
+
+#endif // #define LJM_LUA_UTILITIES
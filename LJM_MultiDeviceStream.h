@@ -0,0 +1,762 @@
+/**
+ * Name: LJM_MultiDeviceStream.h
+ * Desc: Provides synchronized stream of the same channels on several devices.
+ *       Each device is read by its own thread. A merge thread places every
+ *       device's scans on a common host timeline and emits frames of
+ *       time-aligned scans from all devices through a lock-free queue.
+ *       SYSTEM_TIMER_20HZ and STREAM_DATA_CAPTURE_16 are added to each
+ *       device's scan list. The scans at which the 20 Hz timer changes give
+ *       each scan's time on the device's clock, and the host tick of each
+ *       read, corrected by the backlog and filtered for the lowest latency,
+ *       maps device time to host time.
+ * Note: Programs that include this file must link with pthread on Linux and
+ *       Mac OS X (see LJM_ThreadUtilities.h).
+ *       Every device streams at the same scan rate. With internal clocks,
+ *       scans are aligned to within about one scan period plus the USB or
+ *       Ethernet latency jitter. A shared external clock or a triggered start
+ *       is more precise; with a triggered start, scans are aligned by their
+ *       index.
+**/
+
+#ifndef LJM_MULTI_DEVICE_STREAM
+#define LJM_MULTI_DEVICE_STREAM
+
+#include <math.h>
+
+#include "LJM_StreamUtilities.h"
+#include "LJM_ThreadUtilities.h"
+
+enum { MAX_MULTI_STREAM_DEVICES = 16 };
+enum { MAX_MULTI_STREAM_CHANNELS = 64 };
+
+// The number of reads each device's queue holds for the merge thread
+enum { MULTI_STREAM_QUEUE_BLOCKS = 16 };
+
+// The number of frames the frame queue holds for the application
+enum { MULTI_STREAM_QUEUE_FRAMES = 16 };
+
+// The number of scansPerRead each device keeps for alignment
+enum { MULTI_STREAM_STAGING_READS = 8 };
+
+// SYSTEM_TIMER_20HZ and STREAM_DATA_CAPTURE_16 are added to each scan list
+enum { MULTI_STREAM_TIMER_CHANNELS = 2 };
+
+// How fast a device's clock may drift from the host's, as a fraction. The
+// lowest-latency host offset of each device is allowed to age by this much.
+static const double MULTI_STREAM_MAX_CLOCK_DRIFT = 0.0001;
+
+// How many seconds of 20 Hz timer changes are needed before the device's scan
+// rate is estimated from them instead of using the rate of LJM_eStreamStart
+static const double MULTI_STREAM_RATE_ESTIMATE_SECONDS = 1;
+
+/**
+ * One read of one device, passed from its read thread to the merge thread
+**/
+typedef struct _MultiStreamBlock {
+	double * aData;
+	int deviceScanBacklog;
+	int LJMScanBacklog;
+	LJM_LONG_LONG_RETURN hostTick;
+	int err;
+} _MultiStreamBlock;
+
+typedef struct _MultiStreamDevice {
+	struct MultiDeviceStream * stream;
+	int handle;
+	Thread thread;
+
+	// The scan rate LJM_eStreamStart returned
+	double scanRate;
+
+	// Written by the read thread, read by the merge thread
+	SPSCQueue queue;
+	_MultiStreamBlock aBlocks[MULTI_STREAM_QUEUE_BLOCKS];
+
+	// The timeline, only used by the merge thread. Device time is in seconds
+	// of SYSTEM_TIMER_20HZ.
+	double numScansReceived;
+	int hasLastTimer;
+	unsigned int lastTimer;
+	int hasTransition;
+	double firstTransitionScan;
+	double firstTransitionTime;
+	double transitionScan;
+	double transitionTime;
+	double estimatedScanRate;
+	int hasHostOffset;
+	double hostOffset;
+	double hostOffsetTime;
+
+	// The scans of the user's channels that have not been merged yet, from
+	// the scan at index stagingStartScan
+	double * aStaging;
+	int numStagedScans;
+	double stagingStartScan;
+
+	// Statistics
+	int numBlocks;
+	int numQueueFullWaits;
+	double numDroppedScans;
+} _MultiStreamDevice;
+
+/**
+ * A frame of numScans time-aligned scans from each device
+**/
+typedef struct MultiDeviceFrame {
+	// The host time in seconds (of LJM_GetHostTick) of the first scan of
+	// the first device
+	double hostTime;
+
+	int numScans;
+
+	// For each device, the stream scan index of its first scan in this frame,
+	// and how many seconds later than hostTime that scan was
+	double aFirstScanIndexes[MAX_MULTI_STREAM_DEVICES];
+	double aTimeOffsets[MAX_MULTI_STREAM_DEVICES];
+
+	// The scans of device deviceI are at
+	// aData + deviceI * numScans * numChannels
+	double * aData;
+} MultiDeviceFrame;
+
+typedef struct MultiDeviceStream {
+	int numDevices;
+	_MultiStreamDevice aDevices[MAX_MULTI_STREAM_DEVICES];
+
+	// The user's channels, followed by the timer channels
+	int numChannels;
+	int aScanList[MAX_MULTI_STREAM_CHANNELS + MULTI_STREAM_TIMER_CHANNELS];
+	double scanRate;
+	int scansPerRead;
+
+	// Options, which may be set between InitMultiDeviceStream and
+	// StartMultiDeviceStream. With useExternalClock, every device is clocked
+	// by CIO3 as in SetupExternalClockStream. A triggerIndex other than 0,
+	// such as 2000 for DIO0, starts every device's stream on an edge of that
+	// DIO.
+	int useExternalClock;
+	int triggerIndex;
+
+	Thread mergeThread;
+	volatile int stopRequested;
+	volatile int err;
+
+	// Written by the merge thread, read by the application
+	SPSCQueue frameQueue;
+	MultiDeviceFrame aFrames[MULTI_STREAM_QUEUE_FRAMES];
+
+	// Merge state
+	int hasNextScan;
+	double nextScan;
+
+	// Statistics
+	int numFrames;
+	int numFrameQueueFullWaits;
+	double numUnalignedScans;
+} MultiDeviceStream;
+
+/**
+ * Desc: Initializes stream for numDevices open devices of aHandles, which
+ *       will all stream the numChannels channels of aScanList at scanRate.
+ *       Exits if numDevices or numChannels is too large or memory cannot be
+ *       allocated.
+**/
+void InitMultiDeviceStream(MultiDeviceStream * stream, int numDevices,
+	const int * aHandles, int numChannels, const int * aScanList,
+	double scanRate, int scansPerRead);
+
+/**
+ * Desc: Configures the clock and trigger of each device, starts stream on
+ *       each device and starts the read and merge threads.
+ * Retr: the LJM error code. On error, no device is left streaming.
+**/
+int StartMultiDeviceStream(MultiDeviceStream * stream);
+
+/**
+ * Desc: Waits up to timeoutMS for the next frame.
+ * Retr: the frame, which is valid until ReleaseMultiDeviceFrame, or NULL if
+ *       there was no frame in time or a device's stream failed, in which case
+ *       stream->err is the LJM error code
+**/
+const MultiDeviceFrame * GetMultiDeviceFrame(MultiDeviceStream * stream,
+	int timeoutMS);
+
+/**
+ * Desc: Returns the frame of the last GetMultiDeviceFrame to the merge thread
+**/
+void ReleaseMultiDeviceFrame(MultiDeviceStream * stream);
+
+/**
+ * Desc: Returns the value of channel of scanI of deviceI in frame
+**/
+double MultiDeviceFrameValue(const MultiDeviceStream * stream,
+	const MultiDeviceFrame * frame, int deviceI, int scanI, int channel);
+
+/**
+ * Desc: Stops the threads and the stream of each device
+ * Retr: the first LJM error code of LJM_eStreamStop
+**/
+int StopMultiDeviceStream(MultiDeviceStream * stream);
+
+/**
+ * Desc: Frees the buffers of stream
+**/
+void FreeMultiDeviceStream(MultiDeviceStream * stream);
+
+/**
+ * Desc: Prints the frames, alignment and per-device timeline of stream
+**/
+void PrintMultiDeviceStreamStatistics(const MultiDeviceStream * stream);
+
+
+// Source
+
+// The number of the user's channels of stream
+int _MultiStreamUserChannels(const MultiDeviceStream * stream)
+{
+	return stream->numChannels - MULTI_STREAM_TIMER_CHANNELS;
+}
+
+void InitMultiDeviceStream(MultiDeviceStream * stream, int numDevices,
+	const int * aHandles, int numChannels, const int * aScanList,
+	double scanRate, int scansPerRead)
+{
+	int i, slot, err;
+	_MultiStreamDevice * device;
+	const char * TIMER_NAMES[MULTI_STREAM_TIMER_CHANNELS] =
+		{"SYSTEM_TIMER_20HZ", "STREAM_DATA_CAPTURE_16"};
+
+	if (numDevices < 1 || numDevices > MAX_MULTI_STREAM_DEVICES ||
+		numChannels < 1 || numChannels > MAX_MULTI_STREAM_CHANNELS)
+	{
+		printf("InitMultiDeviceStream: numDevices must be 1 to %d and "
+			"numChannels 1 to %d\n", MAX_MULTI_STREAM_DEVICES,
+			MAX_MULTI_STREAM_CHANNELS);
+		LJM_CloseAll();
+		exit(1);
+	}
+
+	memset(stream, 0, sizeof(MultiDeviceStream));
+	stream->numDevices = numDevices;
+	stream->numChannels = numChannels + MULTI_STREAM_TIMER_CHANNELS;
+	memcpy(stream->aScanList, aScanList, sizeof(int) * numChannels);
+	err = LJM_NamesToAddresses(MULTI_STREAM_TIMER_CHANNELS, TIMER_NAMES,
+		stream->aScanList + numChannels, NULL);
+	ErrorCheck(err, "InitMultiDeviceStream: LJM_NamesToAddresses");
+	stream->scanRate = scanRate;
+	stream->scansPerRead = scansPerRead;
+
+	for (i = 0; i < numDevices; i++) {
+		device = &stream->aDevices[i];
+		device->stream = stream;
+		device->handle = aHandles[i];
+		InitSPSCQueue(&device->queue, MULTI_STREAM_QUEUE_BLOCKS);
+		for (slot = 0; slot < MULTI_STREAM_QUEUE_BLOCKS; slot++) {
+			device->aBlocks[slot].aData = (double *)malloc(
+				sizeof(double) * scansPerRead * stream->numChannels);
+			if (device->aBlocks[slot].aData == NULL) {
+				printf("InitMultiDeviceStream: could not allocate blocks\n");
+				LJM_CloseAll();
+				exit(1);
+			}
+		}
+		device->aStaging = (double *)malloc(sizeof(double) *
+			MULTI_STREAM_STAGING_READS * scansPerRead * numChannels);
+		if (device->aStaging == NULL) {
+			printf("InitMultiDeviceStream: could not allocate staging\n");
+			LJM_CloseAll();
+			exit(1);
+		}
+	}
+
+	InitSPSCQueue(&stream->frameQueue, MULTI_STREAM_QUEUE_FRAMES);
+	for (slot = 0; slot < MULTI_STREAM_QUEUE_FRAMES; slot++) {
+		stream->aFrames[slot].numScans = scansPerRead;
+		stream->aFrames[slot].aData = (double *)malloc(sizeof(double) *
+			numDevices * scansPerRead * numChannels);
+		if (stream->aFrames[slot].aData == NULL) {
+			printf("InitMultiDeviceStream: could not allocate frames\n");
+			LJM_CloseAll();
+			exit(1);
+		}
+	}
+}
+
+void FreeMultiDeviceStream(MultiDeviceStream * stream)
+{
+	int i, slot;
+	for (i = 0; i < stream->numDevices; i++) {
+		for (slot = 0; slot < MULTI_STREAM_QUEUE_BLOCKS; slot++) {
+			free(stream->aDevices[i].aBlocks[slot].aData);
+		}
+		free(stream->aDevices[i].aStaging);
+	}
+	for (slot = 0; slot < MULTI_STREAM_QUEUE_FRAMES; slot++) {
+		free(stream->aFrames[slot].aData);
+	}
+	stream->numDevices = 0;
+}
+
+// Returns the time of scan on the clock of device
+double _MultiStreamDeviceTime(const _MultiStreamDevice * device, double scan)
+{
+	return device->transitionTime +
+		(scan - device->transitionScan) / device->estimatedScanRate;
+}
+
+// Returns the host time of scan of device
+double _MultiStreamHostTime(const _MultiStreamDevice * device, double scan)
+{
+	return _MultiStreamDeviceTime(device, scan) + device->hostOffset;
+}
+
+// Returns the scan of device at hostTime, which may be fractional
+double _MultiStreamScanAtHostTime(const _MultiStreamDevice * device,
+	double hostTime)
+{
+	return device->transitionScan + (hostTime - device->hostOffset -
+		device->transitionTime) * device->estimatedScanRate;
+}
+
+// Returns 1 if the timeline of device can place its scans in host time
+int _MultiStreamHasTimeline(const _MultiStreamDevice * device)
+{
+	return device->hasTransition && device->hasHostOffset;
+}
+
+// Updates the timeline of device with block and appends the scans of the
+// user's channels to its staging
+void _AddMultiStreamBlock(MultiDeviceStream * stream,
+	_MultiStreamDevice * device, const _MultiStreamBlock * block)
+{
+	int scanI, numDrop;
+	unsigned int timer;
+	double scan, lastCollectedScan, hostTime, offset, span;
+	const double * aScan;
+	const int numChannels = stream->numChannels;
+	const int numUserChannels = _MultiStreamUserChannels(stream);
+	const int capacity = MULTI_STREAM_STAGING_READS * stream->scansPerRead;
+
+	device->numBlocks++;
+
+	// The scans at which the 20 Hz timer changes are at a known device time
+	for (scanI = 0; scanI < stream->scansPerRead; scanI++) {
+		aScan = block->aData + scanI * numChannels;
+		if (aScan[numUserChannels] == LJM_DUMMY_VALUE ||
+			aScan[numUserChannels + 1] == LJM_DUMMY_VALUE)
+		{
+			device->hasLastTimer = 0;
+			continue;
+		}
+
+		// STREAM_DATA_CAPTURE_16 is the upper 16 bits of SYSTEM_TIMER_20HZ
+		timer = ((unsigned int)aScan[numUserChannels + 1] << 16) +
+			(unsigned int)aScan[numUserChannels];
+		scan = device->numScansReceived + scanI;
+		if (device->hasLastTimer && timer != device->lastTimer) {
+			device->transitionScan = scan;
+			device->transitionTime = timer / 20.0;
+			if (!device->hasTransition) {
+				device->hasTransition = 1;
+				device->firstTransitionScan = scan;
+				device->firstTransitionTime = device->transitionTime;
+			}
+		}
+		device->lastTimer = timer;
+		device->hasLastTimer = 1;
+	}
+	device->numScansReceived += stream->scansPerRead;
+
+	if (device->hasTransition) {
+		span = device->transitionTime - device->firstTransitionTime;
+		device->estimatedScanRate = device->scanRate;
+		if (span >= MULTI_STREAM_RATE_ESTIMATE_SECONDS) {
+			device->estimatedScanRate = (device->transitionScan -
+				device->firstTransitionScan) / span;
+		}
+
+		// The newest scan the device has collected was collected at or before
+		// this read returned, so the lowest offset has the least latency. The
+		// lowest offset ages in case the device's clock is slower than the
+		// host's.
+		lastCollectedScan = device->numScansReceived - 1 +
+			block->deviceScanBacklog + block->LJMScanBacklog;
+		hostTime = block->hostTick / 1000000.0;
+		offset = hostTime - _MultiStreamDeviceTime(device, lastCollectedScan);
+		if (device->hasHostOffset) {
+			device->hostOffset += MULTI_STREAM_MAX_CLOCK_DRIFT *
+				(hostTime - device->hostOffsetTime);
+		}
+		if (!device->hasHostOffset || offset < device->hostOffset) {
+			device->hostOffset = offset;
+		}
+		device->hostOffsetTime = hostTime;
+		device->hasHostOffset = 1;
+	}
+
+	// Make room for the block by dropping the oldest staged scans
+	if (device->numStagedScans + stream->scansPerRead > capacity) {
+		numDrop = device->numStagedScans + stream->scansPerRead - capacity;
+		memmove(device->aStaging, device->aStaging + numDrop * numUserChannels,
+			sizeof(double) * (device->numStagedScans - numDrop) *
+			numUserChannels);
+		device->numStagedScans -= numDrop;
+		device->stagingStartScan += numDrop;
+		device->numDroppedScans += numDrop;
+	}
+
+	for (scanI = 0; scanI < stream->scansPerRead; scanI++) {
+		memcpy(device->aStaging +
+			(device->numStagedScans + scanI) * numUserChannels,
+			block->aData + scanI * numChannels,
+			sizeof(double) * numUserChannels);
+	}
+	device->numStagedScans += stream->scansPerRead;
+}
+
+// Drops the staged scans of device before scan
+void _DropMultiStreamScansBefore(MultiDeviceStream * stream,
+	_MultiStreamDevice * device, double scan)
+{
+	const int numUserChannels = _MultiStreamUserChannels(stream);
+	int numDrop = (int)(scan - device->stagingStartScan);
+
+	if (numDrop <= 0) {
+		return;
+	}
+	if (numDrop > device->numStagedScans) {
+		numDrop = device->numStagedScans;
+	}
+	memmove(device->aStaging, device->aStaging + numDrop * numUserChannels,
+		sizeof(double) * (device->numStagedScans - numDrop) * numUserChannels);
+	device->numStagedScans -= numDrop;
+	device->stagingStartScan += numDrop;
+}
+
+// Moves the blocks each read thread has queued into the staging of its
+// device. Returns 0 if a device's stream failed.
+int _CollectMultiStreamBlocks(MultiDeviceStream * stream)
+{
+	int i, slot;
+	_MultiStreamDevice * device;
+
+	for (i = 0; i < stream->numDevices; i++) {
+		device = &stream->aDevices[i];
+		while ((slot = SPSCQueueReadSlot(&device->queue)) >= 0) {
+			if (device->aBlocks[slot].err != LJME_NOERROR) {
+				AtomicStoreInt(&stream->err, device->aBlocks[slot].err);
+				SPSCQueuePop(&device->queue);
+				return 0;
+			}
+			_AddMultiStreamBlock(stream, device, &device->aBlocks[slot]);
+			SPSCQueuePop(&device->queue);
+		}
+	}
+
+	return 1;
+}
+
+// Emits the next frame if every device has the scans for it. Returns 1 if
+// progress was made.
+int _MergeMultiStreamFrame(MultiDeviceStream * stream)
+{
+	int i, slot;
+	double hostTime, behind;
+	double aFirstScans[MAX_MULTI_STREAM_DEVICES];
+	MultiDeviceFrame * frame;
+	_MultiStreamDevice * device;
+	_MultiStreamDevice * reference = &stream->aDevices[0];
+	const int numScans = stream->scansPerRead;
+	const int numUserChannels = _MultiStreamUserChannels(stream);
+
+	for (i = 0; i < stream->numDevices; i++) {
+		if (!_MultiStreamHasTimeline(&stream->aDevices[i])) {
+			return 0;
+		}
+	}
+
+	if (!stream->hasNextScan || stream->nextScan < reference->stagingStartScan) {
+		stream->nextScan = reference->stagingStartScan;
+		stream->hasNextScan = 1;
+	}
+
+	// The first device is the reference. Each other device's first scan is
+	// its scan nearest in host time, or the same scan with a triggered start.
+	hostTime = _MultiStreamHostTime(reference, stream->nextScan);
+	for (i = 0; i < stream->numDevices; i++) {
+		device = &stream->aDevices[i];
+		if (i == 0 || stream->triggerIndex != 0) {
+			aFirstScans[i] = stream->nextScan;
+		}
+		else {
+			aFirstScans[i] = floor(_MultiStreamScanAtHostTime(device,
+				hostTime) + 0.5);
+		}
+
+		// The device has no scans this early, so skip ahead
+		behind = device->stagingStartScan - aFirstScans[i];
+		if (behind > 0) {
+			stream->nextScan += behind;
+			stream->numUnalignedScans += behind;
+			return 1;
+		}
+
+		if (aFirstScans[i] + numScans >
+			device->stagingStartScan + device->numStagedScans)
+		{
+			return 0;
+		}
+	}
+
+	slot = SPSCQueueWriteSlot(&stream->frameQueue);
+	if (slot < 0) {
+		stream->numFrameQueueFullWaits++;
+		return 0;
+	}
+
+	frame = &stream->aFrames[slot];
+	frame->hostTime = hostTime;
+	for (i = 0; i < stream->numDevices; i++) {
+		device = &stream->aDevices[i];
+		_DropMultiStreamScansBefore(stream, device, aFirstScans[i]);
+		frame->aFirstScanIndexes[i] = aFirstScans[i];
+		frame->aTimeOffsets[i] =
+			_MultiStreamHostTime(device, aFirstScans[i]) - hostTime;
+		memcpy(frame->aData + i * numScans * numUserChannels,
+			device->aStaging, sizeof(double) * numScans * numUserChannels);
+		_DropMultiStreamScansBefore(stream, device, aFirstScans[i] + numScans);
+	}
+	SPSCQueuePush(&stream->frameQueue);
+
+	stream->numFrames++;
+	stream->nextScan += numScans;
+	return 1;
+}
+
+void _MultiStreamMergeThread(void * arg)
+{
+	MultiDeviceStream * stream = (MultiDeviceStream *)arg;
+
+	while (!AtomicLoadInt(&stream->stopRequested)) {
+		if (!_CollectMultiStreamBlocks(stream)) {
+			return;
+		}
+		if (!_MergeMultiStreamFrame(stream)) {
+			MillisecondSleep(1);
+		}
+	}
+}
+
+void _MultiStreamReadThread(void * arg)
+{
+	int slot, err;
+	_MultiStreamBlock * block;
+	_MultiStreamDevice * device = (_MultiStreamDevice *)arg;
+
+	while (!AtomicLoadInt(&device->stream->stopRequested)) {
+		slot = SPSCQueueWriteSlot(&device->queue);
+		if (slot < 0) {
+			device->numQueueFullWaits++;
+			MillisecondSleep(1);
+			continue;
+		}
+
+		block = &device->aBlocks[slot];
+		err = LJM_eStreamRead(device->handle, block->aData,
+			&block->deviceScanBacklog, &block->LJMScanBacklog);
+		block->hostTick = LJM_GetHostTick();
+
+		// Externally clocked and triggered stream return no scans until the
+		// clock or trigger arrives, and then until a whole read is ready.
+		// Sleep until about when it will be, and at least 1 ms, rather than
+		// polling the device.
+		if (err == LJME_NO_SCANS_RETURNED) {
+			VariableStreamSleep(device->stream->scansPerRead,
+				(int)device->scanRate, block->LJMScanBacklog);
+			MillisecondSleep(1);
+			continue;
+		}
+
+		block->err = err;
+		SPSCQueuePush(&device->queue);
+		if (err != LJME_NOERROR) {
+			return;
+		}
+	}
+}
+
+// Configures the clock and trigger of device
+int _ConfigureMultiStreamDevice(MultiDeviceStream * stream,
+	_MultiStreamDevice * device)
+{
+	int err;
+	char name[LJM_MAX_NAME_SIZE];
+	const int dio = stream->triggerIndex - 2000;
+
+	err = LJM_eWriteName(device->handle, "STREAM_TRIGGER_INDEX",
+		stream->triggerIndex);
+	if (err == LJME_NOERROR && stream->triggerIndex != 0) {
+		// 5 enables a rising or falling edge to trigger stream
+		sprintf(name, "DIO%d_EF_ENABLE", dio);
+		err = LJM_eWriteName(device->handle, name, 0);
+		if (err == LJME_NOERROR) {
+			sprintf(name, "DIO%d_EF_INDEX", dio);
+			err = LJM_eWriteName(device->handle, name, 5);
+		}
+		if (err == LJME_NOERROR) {
+			sprintf(name, "DIO%d_EF_ENABLE", dio);
+			err = LJM_eWriteName(device->handle, name, 1);
+		}
+	}
+	if (err == LJME_NOERROR) {
+		err = LJM_eWriteName(device->handle, "STREAM_CLOCK_SOURCE",
+			stream->useExternalClock ? 2 : 0);
+	}
+	if (err == LJME_NOERROR && stream->useExternalClock) {
+		err = LJM_eWriteName(device->handle, "STREAM_EXTERNAL_CLOCK_DIVISOR",
+			1);
+	}
+
+	PrintErrorIfError(err, "StartMultiDeviceStream: configuring handle %d",
+		device->handle);
+	return err;
+}
+
+int StartMultiDeviceStream(MultiDeviceStream * stream)
+{
+	int i, err;
+	int numStarted = 0;
+	_MultiStreamDevice * device;
+
+	// Reads return LJME_NO_SCANS_RETURNED while waiting for the clock or
+	// trigger, so the read threads can still be stopped
+	if (stream->useExternalClock || stream->triggerIndex != 0) {
+		SetConfigValue(LJM_STREAM_SCANS_RETURN,
+			LJM_STREAM_SCANS_RETURN_ALL_OR_NONE);
+		SetConfigValue(LJM_STREAM_RECEIVE_TIMEOUT_MODE,
+			LJM_STREAM_RECEIVE_TIMEOUT_MODE_MANUAL);
+		SetConfigValue(LJM_STREAM_RECEIVE_TIMEOUT_MS, 100);
+	}
+
+	for (i = 0; i < stream->numDevices; i++) {
+		device = &stream->aDevices[i];
+		err = _ConfigureMultiStreamDevice(stream, device);
+		if (err != LJME_NOERROR) {
+			break;
+		}
+
+		device->scanRate = stream->scanRate;
+		err = LJM_eStreamStart(device->handle, stream->scansPerRead,
+			stream->numChannels, stream->aScanList, &device->scanRate);
+		PrintErrorIfError(err, "StartMultiDeviceStream: LJM_eStreamStart(%d)",
+			device->handle);
+		if (err != LJME_NOERROR) {
+			break;
+		}
+		device->estimatedScanRate = device->scanRate;
+		numStarted++;
+	}
+
+	for (i = 0; err == LJME_NOERROR && i < stream->numDevices; i++) {
+		if (StartThread(&stream->aDevices[i].thread, _MultiStreamReadThread,
+			&stream->aDevices[i]) != 0)
+		{
+			printf("StartMultiDeviceStream: could not start a read thread\n");
+			LJM_CloseAll();
+			exit(1);
+		}
+	}
+	if (err == LJME_NOERROR && StartThread(&stream->mergeThread,
+		_MultiStreamMergeThread, stream) != 0)
+	{
+		printf("StartMultiDeviceStream: could not start the merge thread\n");
+		LJM_CloseAll();
+		exit(1);
+	}
+
+	if (err != LJME_NOERROR) {
+		for (i = 0; i < numStarted; i++) {
+			LJM_eStreamStop(stream->aDevices[i].handle);
+		}
+	}
+
+	return err;
+}
+
+const MultiDeviceFrame * GetMultiDeviceFrame(MultiDeviceStream * stream,
+	int timeoutMS)
+{
+	int slot;
+	int waitedMS = 0;
+
+	for (;;) {
+		slot = SPSCQueueReadSlot(&stream->frameQueue);
+		if (slot >= 0) {
+			return &stream->aFrames[slot];
+		}
+		if (AtomicLoadInt(&stream->err) != LJME_NOERROR ||
+			waitedMS >= timeoutMS)
+		{
+			return NULL;
+		}
+		MillisecondSleep(1);
+		waitedMS++;
+	}
+}
+
+void ReleaseMultiDeviceFrame(MultiDeviceStream * stream)
+{
+	SPSCQueuePop(&stream->frameQueue);
+}
+
+double MultiDeviceFrameValue(const MultiDeviceStream * stream,
+	const MultiDeviceFrame * frame, int deviceI, int scanI, int channel)
+{
+	const int numUserChannels = _MultiStreamUserChannels(stream);
+	return frame->aData[(deviceI * frame->numScans + scanI) * numUserChannels +
+		channel];
+}
+
+int StopMultiDeviceStream(MultiDeviceStream * stream)
+{
+	int i, stopErr;
+	int err = LJME_NOERROR;
+
+	AtomicStoreInt(&stream->stopRequested, 1);
+	for (i = 0; i < stream->numDevices; i++) {
+		JoinThread(stream->aDevices[i].thread);
+	}
+	JoinThread(stream->mergeThread);
+
+	for (i = 0; i < stream->numDevices; i++) {
+		stopErr = LJM_eStreamStop(stream->aDevices[i].handle);
+		PrintErrorIfError(stopErr, "StopMultiDeviceStream: LJM_eStreamStop(%d)",
+			stream->aDevices[i].handle);
+		if (err == LJME_NOERROR) {
+			err = stopErr;
+		}
+	}
+
+	return err;
+}
+
+void PrintMultiDeviceStreamStatistics(const MultiDeviceStream * stream)
+{
+	int i;
+	const _MultiStreamDevice * device;
+
+	printf("Multi-device stream: %d devices, %d frames of %d scans, "
+		"%.0f unaligned scans skipped, %d frame queue full waits\n",
+		stream->numDevices, stream->numFrames, stream->scansPerRead,
+		stream->numUnalignedScans, stream->numFrameQueueFullWaits);
+	for (i = 0; i < stream->numDevices; i++) {
+		device = &stream->aDevices[i];
+		printf("    handle %d: %d reads, scan rate %.02f Hz (estimated "
+			"%.03f Hz), host offset %.6f s, %.0f scans dropped, "
+			"%d queue full waits\n", device->handle, device->numBlocks,
+			device->scanRate, device->estimatedScanRate, device->hostOffset,
+			device->numDroppedScans, device->numQueueFullWaits);
+	}
+}
+
+#endif // #define LJM_MULTI_DEVICE_STREAM
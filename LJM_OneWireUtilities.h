@@ -0,0 +1,530 @@
+/**
+ * Name: LJM_OneWireUtilities.h
+ * Desc: Provides 1-Wire bus enumeration and batched temperature reads of
+ *       DS18B20, DS1822 and DS18S20 sensors.
+ *       EnumerateOneWireBus finds every ROM on the bus with the
+ *       ONEWIRE_PATH/ONEWIRE_ROM_BRANCHS_FOUND search and keeps the ROM table
+ *       in the OneWireBus. ReadOneWireTemperatures then starts the conversion
+ *       of all sensors with a single Skip ROM Convert T, waits one conversion
+ *       period and reads every sensor's scratchpad with Match ROM in a single
+ *       LJM_eNames call.
+ *       Each 1-Wire operation sends its configuration, ONEWIRE_DATA_TX,
+ *       ONEWIRE_GO and result frames in one LJM_eNames call, and
+ *       configuration registers are only written when they differ from the
+ *       values last written.
+ * Note: LJM splits an LJM_eNames call into multiple packets if it does not
+ *       fit in one. The device performs the frames in order.
+ *       If the device may have been reconfigured or rebooted since the
+ *       configuration was last written, call InvalidateOneWireBus.
+**/
+
+#ifndef LJM_ONEWIRE_UTILITIES
+#define LJM_ONEWIRE_UTILITIES
+
+#include "LJM_Utilities.h"
+
+// The maximum number of ROMs one OneWireBus can hold
+enum { ONEWIRE_MAX_ROMS = 64 };
+
+// 1-Wire ROM commands (ONEWIRE_FUNCTION)
+enum { ONEWIRE_FUNCTION_SEARCH = 0xF0 };
+enum { ONEWIRE_FUNCTION_SKIP = 0xCC };
+enum { ONEWIRE_FUNCTION_MATCH = 0x55 };
+
+// Temperature sensor commands and family codes
+enum { ONEWIRE_CONVERT_T = 0x44 };
+enum { ONEWIRE_READ_SCRATCHPAD = 0xBE };
+enum { ONEWIRE_SCRATCHPAD_BYTES = 9 };
+enum { ONEWIRE_FAMILY_DS18S20 = 0x10 };
+enum { ONEWIRE_FAMILY_DS1822 = 0x22 };
+enum { ONEWIRE_FAMILY_DS18B20 = 0x28 };
+
+// The 12-bit conversion time of the DS18B20 and DS1822
+enum { ONEWIRE_CONVERSION_MS = 750 };
+
+// The temperature reported for a sensor whose scratchpad could not be read
+static const double ONEWIRE_INVALID_TEMPERATURE = -9999;
+
+// The configuration registers, in the order they are written
+enum {
+	ONEWIRE_CONFIG_DQ_DIONUM,
+	ONEWIRE_CONFIG_DPU_DIONUM,
+	ONEWIRE_CONFIG_OPTIONS,
+	ONEWIRE_CONFIG_FUNCTION,
+	ONEWIRE_CONFIG_NUM_BYTES_TX,
+	ONEWIRE_CONFIG_NUM_BYTES_RX,
+	ONEWIRE_NUM_CONFIG_REGISTERS
+};
+
+static const char * ONEWIRE_CONFIG_NAMES[ONEWIRE_NUM_CONFIG_REGISTERS] = {
+	"ONEWIRE_DQ_DIONUM",
+	"ONEWIRE_DPU_DIONUM",
+	"ONEWIRE_OPTIONS",
+	"ONEWIRE_FUNCTION",
+	"ONEWIRE_NUM_BYTES_TX",
+	"ONEWIRE_NUM_BYTES_RX"
+};
+
+// Per sensor read: ONEWIRE_ROM_MATCH_H/L, ONEWIRE_DATA_TX, ONEWIRE_GO and
+// ONEWIRE_DATA_RX, after the configuration frames
+enum { ONEWIRE_MAX_FRAMES = ONEWIRE_NUM_CONFIG_REGISTERS +
+	ONEWIRE_MAX_ROMS * 5 };
+enum { ONEWIRE_MAX_VALUES = ONEWIRE_NUM_CONFIG_REGISTERS +
+	ONEWIRE_MAX_ROMS * (4 + ONEWIRE_SCRATCHPAD_BYTES) };
+
+// A 64-bit ROM ID. Byte 0 (the low byte of romL) is the family code and
+// byte 7 (the high byte of romH) is the CRC.
+typedef struct OneWireROM {
+	unsigned int romH;
+	unsigned int romL;
+} OneWireROM;
+
+typedef struct OneWireBus {
+	int handle;
+
+	// The requested values and the values last written to the device, by
+	// ONEWIRE_CONFIG_*. A written value of -1 means it is not known.
+	int aConfig[ONEWIRE_NUM_CONFIG_REGISTERS];
+	int aWrittenConfig[ONEWIRE_NUM_CONFIG_REGISTERS];
+
+	// The ROM table found by EnumerateOneWireBus
+	int numROMs;
+	OneWireROM aROMs[ONEWIRE_MAX_ROMS];
+
+	// Reused LJM_eNames arrays
+	const char * aNames[ONEWIRE_MAX_FRAMES];
+	int aWrites[ONEWIRE_MAX_FRAMES];
+	int aNumValues[ONEWIRE_MAX_FRAMES];
+	double aValues[ONEWIRE_MAX_VALUES];
+
+	// Statistics
+	int numSearches;
+	int numConversions;
+	int numSensorReads;
+	int numCRCErrors;
+	int numCalls;
+} OneWireBus;
+
+/**
+ * Desc: Initializes bus for handle. Nothing is written to the device until the
+ *       first operation.
+ * Para: dqDIONum, the DIO number of the 1-Wire data line, such as 8 for EIO0
+ *       dpuDIONum, the DIO number of the dynamic pullup control line
+ *       options, the ONEWIRE_OPTIONS value
+**/
+void InitOneWireBus(OneWireBus * bus, int handle, int dqDIONum, int dpuDIONum,
+	int options);
+
+/**
+ * Desc: Forgets the configuration values last written so that all of them are
+ *       written with the next operation.
+**/
+void InvalidateOneWireBus(OneWireBus * bus);
+
+/**
+ * Desc: Finds every ROM on the bus and stores them in bus->aROMs, replacing
+ *       the previous ROM table. ROMs with an invalid CRC are ignored.
+ * Retr: the LJM error code, which is LJME_NOERROR on success
+**/
+int EnumerateOneWireBus(OneWireBus * bus);
+
+/**
+ * Desc: Starts a temperature conversion on every sensor of the bus with a
+ *       single Skip ROM Convert T.
+ * Retr: the LJM error code, which is LJME_NOERROR on success
+**/
+int StartOneWireConversion(OneWireBus * bus);
+
+/**
+ * Desc: Reads the scratchpad of every temperature sensor in the ROM table with
+ *       a single LJM_eNames call and converts it to degrees C. Call
+ *       StartOneWireConversion at least ONEWIRE_CONVERSION_MS beforehand.
+ * Para: aTemperatures, output of bus->numROMs temperatures, in the order of
+ *       bus->aROMs. ROMs that are not temperature sensors, and scratchpads
+ *       with an invalid CRC, get ONEWIRE_INVALID_TEMPERATURE. A sensor that
+ *       has not finished a conversion since power on reads 85 C.
+ *       numValid, optional output of the number of valid temperatures
+ * Retr: the LJM error code, which is LJME_NOERROR on success
+**/
+int ReadOneWireScratchpads(OneWireBus * bus, double * aTemperatures,
+	int * numValid);
+
+/**
+ * Desc: Starts a conversion, waits ONEWIRE_CONVERSION_MS, then reads every
+ *       sensor. See ReadOneWireScratchpads.
+ * Retr: the LJM error code, which is LJME_NOERROR on success
+**/
+int ReadOneWireTemperatures(OneWireBus * bus, double * aTemperatures,
+	int * numValid);
+
+/**
+ * Desc: Returns whether the family code of rom is a supported temperature
+ *       sensor
+**/
+int IsOneWireTemperatureSensor(const OneWireROM * rom);
+
+/**
+ * Desc: Calculates the Dallas/Maxim CRC-8 of numBytes of aBytes. The CRC of
+ *       data followed by its CRC byte is 0.
+**/
+unsigned char OneWireCRC8(const unsigned char * aBytes, int numBytes);
+
+/**
+ * Desc: Prints the ROM table of bus
+**/
+void PrintOneWireROMs(const OneWireBus * bus);
+
+/**
+ * Desc: Prints the number of searches, conversions, sensor reads, CRC errors
+ *       and LJM_eNames calls of bus
+**/
+void PrintOneWireBusStatistics(const OneWireBus * bus);
+
+
+// Source
+
+void InitOneWireBus(OneWireBus * bus, int handle, int dqDIONum, int dpuDIONum,
+	int options)
+{
+	memset(bus, 0, sizeof(OneWireBus));
+	bus->handle = handle;
+	bus->aConfig[ONEWIRE_CONFIG_DQ_DIONUM] = dqDIONum;
+	bus->aConfig[ONEWIRE_CONFIG_DPU_DIONUM] = dpuDIONum;
+	bus->aConfig[ONEWIRE_CONFIG_OPTIONS] = options;
+	InvalidateOneWireBus(bus);
+}
+
+void InvalidateOneWireBus(OneWireBus * bus)
+{
+	int i;
+	for (i = 0; i < ONEWIRE_NUM_CONFIG_REGISTERS; i++) {
+		bus->aWrittenConfig[i] = -1;
+	}
+}
+
+// Adds one frame to the LJM_eNames arrays of bus
+void _AddOneWireFrame(OneWireBus * bus, int * numFrames, int * numValues,
+	const char * name, int write, int frameNumValues)
+{
+	bus->aNames[*numFrames] = name;
+	bus->aWrites[*numFrames] = write;
+	bus->aNumValues[*numFrames] = frameNumValues;
+	(*numFrames)++;
+	*numValues += frameNumValues;
+}
+
+// Adds a write frame for each configuration register that differs from the
+// value last written
+void _AddOneWireConfigFrames(OneWireBus * bus, int * numFrames,
+	int * numValues, int function, int numTX, int numRX)
+{
+	int i;
+
+	bus->aConfig[ONEWIRE_CONFIG_FUNCTION] = function;
+	bus->aConfig[ONEWIRE_CONFIG_NUM_BYTES_TX] = numTX;
+	bus->aConfig[ONEWIRE_CONFIG_NUM_BYTES_RX] = numRX;
+
+	for (i = 0; i < ONEWIRE_NUM_CONFIG_REGISTERS; i++) {
+		if (bus->aConfig[i] == bus->aWrittenConfig[i]) {
+			continue;
+		}
+		bus->aValues[*numValues] = bus->aConfig[i];
+		_AddOneWireFrame(bus, numFrames, numValues, ONEWIRE_CONFIG_NAMES[i],
+			LJM_WRITE, 1);
+		bus->aWrittenConfig[i] = bus->aConfig[i];
+	}
+}
+
+// Performs the LJM_eNames call with the frames added to bus
+int _ExecuteOneWireFrames(OneWireBus * bus, int numFrames)
+{
+	int errorAddress = INITIAL_ERR_ADDRESS;
+	int err = LJM_eNames(bus->handle, numFrames, bus->aNames, bus->aWrites,
+		bus->aNumValues, bus->aValues, &errorAddress);
+	bus->numCalls++;
+	if (err != LJME_NOERROR) {
+		InvalidateOneWireBus(bus);
+	}
+	return err;
+}
+
+// Bit n of a 64-bit value split into high and low 32-bit halves
+int _GetOneWireBit(unsigned int valueH, unsigned int valueL, int n)
+{
+	if (n >= 32) {
+		return (valueH >> (n - 32)) & 1;
+	}
+	return (valueL >> n) & 1;
+}
+
+// Gets the 8 bytes of rom, low byte first
+void _GetOneWireROMBytes(const OneWireROM * rom, unsigned char aBytes[8])
+{
+	int i;
+	for (i = 0; i < 4; i++) {
+		aBytes[i] = (unsigned char)(rom->romL >> (8 * i));
+		aBytes[i + 4] = (unsigned char)(rom->romH >> (8 * i));
+	}
+}
+
+// Performs one ROM search along pathH/pathL
+int _SearchOneWire(OneWireBus * bus, unsigned int pathH, unsigned int pathL,
+	OneWireROM * rom, unsigned int * branchesH, unsigned int * branchesL)
+{
+	int err, resultIndex;
+	int numFrames = 0;
+	int numValues = 0;
+
+	_AddOneWireConfigFrames(bus, &numFrames, &numValues,
+		ONEWIRE_FUNCTION_SEARCH, 0, 0);
+
+	bus->aValues[numValues] = pathH;
+	_AddOneWireFrame(bus, &numFrames, &numValues, "ONEWIRE_PATH_H", LJM_WRITE,
+		1);
+	bus->aValues[numValues] = pathL;
+	_AddOneWireFrame(bus, &numFrames, &numValues, "ONEWIRE_PATH_L", LJM_WRITE,
+		1);
+	bus->aValues[numValues] = 1;
+	_AddOneWireFrame(bus, &numFrames, &numValues, "ONEWIRE_GO", LJM_WRITE, 1);
+
+	resultIndex = numValues;
+	_AddOneWireFrame(bus, &numFrames, &numValues, "ONEWIRE_SEARCH_RESULT_H",
+		LJM_READ, 1);
+	_AddOneWireFrame(bus, &numFrames, &numValues, "ONEWIRE_SEARCH_RESULT_L",
+		LJM_READ, 1);
+	_AddOneWireFrame(bus, &numFrames, &numValues,
+		"ONEWIRE_ROM_BRANCHS_FOUND_H", LJM_READ, 1);
+	_AddOneWireFrame(bus, &numFrames, &numValues,
+		"ONEWIRE_ROM_BRANCHS_FOUND_L", LJM_READ, 1);
+
+	err = _ExecuteOneWireFrames(bus, numFrames);
+	bus->numSearches++;
+	if (err != LJME_NOERROR) {
+		return err;
+	}
+
+	rom->romH = (unsigned int)bus->aValues[resultIndex];
+	rom->romL = (unsigned int)bus->aValues[resultIndex + 1];
+	*branchesH = (unsigned int)bus->aValues[resultIndex + 2];
+	*branchesL = (unsigned int)bus->aValues[resultIndex + 3];
+
+	return LJME_NOERROR;
+}
+
+int EnumerateOneWireBus(OneWireBus * bus)
+{
+	int i, bit, err, numSearches;
+	unsigned int pathH = 0;
+	unsigned int pathL = 0;
+	unsigned int branchesH, branchesL;
+	unsigned char aROMBytes[8];
+	OneWireROM rom;
+
+	bus->numROMs = 0;
+
+	// Depth-first search of the ROM tree. Each search takes the 0 branch at
+	// every branch not selected by the path, so the next path takes the 1
+	// branch at the last branch where this search took the 0 branch.
+	for (numSearches = 0; numSearches < ONEWIRE_MAX_ROMS; numSearches++) {
+		err = _SearchOneWire(bus, pathH, pathL, &rom, &branchesH, &branchesL);
+		if (err != LJME_NOERROR) {
+			return err;
+		}
+
+		_GetOneWireROMBytes(&rom, aROMBytes);
+		if ((rom.romH != 0 || rom.romL != 0) &&
+			OneWireCRC8(aROMBytes, 8) == 0)
+		{
+			for (i = 0; i < bus->numROMs; i++) {
+				if (bus->aROMs[i].romH == rom.romH &&
+					bus->aROMs[i].romL == rom.romL)
+				{
+					break;
+				}
+			}
+			if (i == bus->numROMs) {
+				bus->aROMs[bus->numROMs++] = rom;
+			}
+		}
+
+		for (bit = 63; bit >= 0; bit--) {
+			if (_GetOneWireBit(branchesH, branchesL, bit) &&
+				!_GetOneWireBit(pathH, pathL, bit))
+			{
+				break;
+			}
+		}
+		if (bit < 0) {
+			break;
+		}
+
+		// Keep the branches taken before bit, take the 1 branch at bit and
+		// the 0 branch after it
+		if (bit >= 32) {
+			pathH = (pathH & ((1u << (bit - 32)) - 1)) | (1u << (bit - 32));
+		}
+		else {
+			pathH = 0;
+			pathL = (pathL & ((1u << bit) - 1)) | (1u << bit);
+		}
+	}
+
+	return LJME_NOERROR;
+}
+
+int StartOneWireConversion(OneWireBus * bus)
+{
+	int numFrames = 0;
+	int numValues = 0;
+
+	_AddOneWireConfigFrames(bus, &numFrames, &numValues,
+		ONEWIRE_FUNCTION_SKIP, 1, 0);
+
+	bus->aValues[numValues] = ONEWIRE_CONVERT_T;
+	_AddOneWireFrame(bus, &numFrames, &numValues, "ONEWIRE_DATA_TX", LJM_WRITE,
+		1);
+	bus->aValues[numValues] = 1;
+	_AddOneWireFrame(bus, &numFrames, &numValues, "ONEWIRE_GO", LJM_WRITE, 1);
+
+	bus->numConversions++;
+	return _ExecuteOneWireFrames(bus, numFrames);
+}
+
+int ReadOneWireScratchpads(OneWireBus * bus, double * aTemperatures,
+	int * numValid)
+{
+	int i, r, err;
+	int numFrames = 0;
+	int numValues = 0;
+	int numSensors = 0;
+	int aRXIndexes[ONEWIRE_MAX_ROMS];
+	unsigned char aScratchpad[ONEWIRE_SCRATCHPAD_BYTES];
+	short raw;
+
+	if (numValid) {
+		*numValid = 0;
+	}
+
+	// Written once, since every read uses the same function and byte counts
+	_AddOneWireConfigFrames(bus, &numFrames, &numValues,
+		ONEWIRE_FUNCTION_MATCH, 1, ONEWIRE_SCRATCHPAD_BYTES);
+
+	for (r = 0; r < bus->numROMs; r++) {
+		aRXIndexes[r] = -1;
+		if (!IsOneWireTemperatureSensor(&bus->aROMs[r])) {
+			continue;
+		}
+
+		bus->aValues[numValues] = bus->aROMs[r].romH;
+		_AddOneWireFrame(bus, &numFrames, &numValues, "ONEWIRE_ROM_MATCH_H",
+			LJM_WRITE, 1);
+		bus->aValues[numValues] = bus->aROMs[r].romL;
+		_AddOneWireFrame(bus, &numFrames, &numValues, "ONEWIRE_ROM_MATCH_L",
+			LJM_WRITE, 1);
+		bus->aValues[numValues] = ONEWIRE_READ_SCRATCHPAD;
+		_AddOneWireFrame(bus, &numFrames, &numValues, "ONEWIRE_DATA_TX",
+			LJM_WRITE, 1);
+		bus->aValues[numValues] = 1;
+		_AddOneWireFrame(bus, &numFrames, &numValues, "ONEWIRE_GO", LJM_WRITE,
+			1);
+		aRXIndexes[r] = numValues;
+		_AddOneWireFrame(bus, &numFrames, &numValues, "ONEWIRE_DATA_RX",
+			LJM_READ, ONEWIRE_SCRATCHPAD_BYTES);
+		numSensors++;
+	}
+
+	if (numSensors > 0) {
+		err = _ExecuteOneWireFrames(bus, numFrames);
+		if (err != LJME_NOERROR) {
+			return err;
+		}
+	}
+
+	for (r = 0; r < bus->numROMs; r++) {
+		aTemperatures[r] = ONEWIRE_INVALID_TEMPERATURE;
+		if (aRXIndexes[r] < 0) {
+			continue;
+		}
+
+		bus->numSensorReads++;
+		for (i = 0; i < ONEWIRE_SCRATCHPAD_BYTES; i++) {
+			aScratchpad[i] = (unsigned char)bus->aValues[aRXIndexes[r] + i];
+		}
+		if (OneWireCRC8(aScratchpad, ONEWIRE_SCRATCHPAD_BYTES) != 0) {
+			// Also the case when a sensor does not respond, since all
+			// bytes read as 0xFF
+			bus->numCRCErrors++;
+			continue;
+		}
+
+		raw = (short)(aScratchpad[0] | (aScratchpad[1] << 8));
+		if ((bus->aROMs[r].romL & 0xFF) == ONEWIRE_FAMILY_DS18S20) {
+			aTemperatures[r] = raw * 0.5;
+		}
+		else {
+			aTemperatures[r] = raw * 0.0625;
+		}
+		if (numValid) {
+			(*numValid)++;
+		}
+	}
+
+	return LJME_NOERROR;
+}
+
+int ReadOneWireTemperatures(OneWireBus * bus, double * aTemperatures,
+	int * numValid)
+{
+	int err = StartOneWireConversion(bus);
+	if (err != LJME_NOERROR) {
+		return err;
+	}
+	MillisecondSleep(ONEWIRE_CONVERSION_MS);
+	return ReadOneWireScratchpads(bus, aTemperatures, numValid);
+}
+
+int IsOneWireTemperatureSensor(const OneWireROM * rom)
+{
+	int family = rom->romL & 0xFF;
+	return family == ONEWIRE_FAMILY_DS18S20 ||
+		family == ONEWIRE_FAMILY_DS1822 ||
+		family == ONEWIRE_FAMILY_DS18B20;
+}
+
+unsigned char OneWireCRC8(const unsigned char * aBytes, int numBytes)
+{
+	int i, bit;
+	unsigned char crc = 0;
+	for (i = 0; i < numBytes; i++) {
+		crc ^= aBytes[i];
+		for (bit = 0; bit < 8; bit++) {
+			if (crc & 1) {
+				crc = (crc >> 1) ^ 0x8C;
+			}
+			else {
+				crc >>= 1;
+			}
+		}
+	}
+	return crc;
+}
+
+void PrintOneWireROMs(const OneWireBus * bus)
+{
+	int r;
+	printf("%d 1-Wire ROMs found:\n", bus->numROMs);
+	for (r = 0; r < bus->numROMs; r++) {
+		printf("  %2d: 0x%08X%08X (family 0x%02X)\n", r, bus->aROMs[r].romH,
+			bus->aROMs[r].romL, bus->aROMs[r].romL & 0xFF);
+	}
+}
+
+void PrintOneWireBusStatistics(const OneWireBus * bus)
+{
+	printf("1-Wire: %d searches, %d conversions, %d sensor reads, "
+		"%d CRC errors, %d LJM_eNames calls\n", bus->numSearches,
+		bus->numConversions, bus->numSensorReads, bus->numCRCErrors,
+		bus->numCalls);
+}
+
+#endif // #define LJM_ONEWIRE_UTILITIES
@@ -0,0 +1,406 @@
+/**
+ * Name: LJM_RegisterShadow.h
+ * Desc: Provides a host-side shadow (cache) of device configuration registers
+ *       so that repeated configuration writes and reads can skip round trips
+ *       when the device already holds the requested values.
+ * Note: Only shadow registers whose value changes only when the host writes
+ *       them, such as STREAM_SETTLING_US, AIN_ALL_RANGE or DIO_INHIBIT. Do not
+ *       shadow inputs (AIN0, FIO_STATE, etc.) or registers that have side
+ *       effects when written (SYSTEM_REBOOT, I2C_GO, etc.).
+ *       Writing an "ALL" register such as AIN_ALL_RANGE does not update the
+ *       shadowed values of the individual registers it affects (such as
+ *       AIN0_RANGE), so avoid shadowing both forms of the same setting.
+**/
+
+#ifndef LJM_REGISTER_SHADOW
+#define LJM_REGISTER_SHADOW
+
+#include "LJM_Utilities.h"
+
+// The maximum number of registers that one RegisterShadow can hold
+enum { MAX_SHADOW_REGISTERS = 64 };
+
+// The maximum number of RegisterShadows that can be tracked for reconnects
+enum { MAX_REGISTER_SHADOWS = 16 };
+
+// The address of SYSTEM_REBOOT. Writing it invalidates the shadow.
+static const int SYSTEM_REBOOT_ADDRESS = 61998;
+
+typedef struct ShadowRegister {
+	int address;
+	int type;
+	double value;
+} ShadowRegister;
+
+typedef struct RegisterShadow {
+	int handle;
+	int numRegisters;
+	ShadowRegister registers[MAX_SHADOW_REGISTERS];
+
+	// Set by the device reconnect callback, which runs in an LJM thread.
+	// The shadow is cleared the next time it is used.
+	volatile int invalidated;
+
+	// Statistics
+	int numFramesWritten;
+	int numFramesSkipped;
+	int numFramesRead;
+	int numFramesCached;
+} RegisterShadow;
+
+/**
+ * Desc: Initializes shadow for handle and registers a device reconnect
+ *       callback that invalidates shadow whenever the device reconnects, such
+ *       as after a reboot or a cable being unplugged.
+ * Note: LJM allows one reconnect callback per handle. If the application needs
+ *       its own reconnect callback, it should call
+ *       InvalidateRegisterShadowsForHandle from that callback.
+**/
+void InitRegisterShadow(RegisterShadow * shadow, int handle);
+
+/**
+ * Desc: Stops tracking shadow for reconnects. Call before the handle is
+ *       closed or shadow goes out of scope.
+**/
+void CleanRegisterShadow(RegisterShadow * shadow);
+
+/**
+ * Desc: Forgets all shadowed values so that the next write or read of each
+ *       register goes to the device.
+**/
+void InvalidateRegisterShadow(RegisterShadow * shadow);
+
+/**
+ * Desc: Invalidates every RegisterShadow that was initialized with handle.
+ *       This is the device reconnect callback registered by
+ *       InitRegisterShadow.
+**/
+void InvalidateRegisterShadowsForHandle(int handle);
+
+/**
+ * Desc: Writes the frames of aNames/aValues whose values differ from the
+ *       shadowed values, using a single LJM_eWriteNames call. Frames that
+ *       already hold the requested value are skipped. If every frame is
+ *       skipped, no communication is performed.
+ * Para: shadow, the RegisterShadow of the device to write to
+ *       numFrames, the number of names in aNames and values in aValues
+ *       aNames, the configuration register names to write
+ *       aValues, the values to write
+ *       numWritten, optional output of how many frames were actually written
+ * Retr: the LJM error code, which is LJME_NOERROR on success
+ * Note: Writing SYSTEM_REBOOT invalidates shadow.
+**/
+int ShadowWriteNames(RegisterShadow * shadow, int numFrames,
+	const char ** aNames, const double * aValues, int * numWritten);
+void ShadowWriteNamesOrDie(RegisterShadow * shadow, int numFrames,
+	const char ** aNames, const double * aValues);
+void ShadowWriteNameOrDie(RegisterShadow * shadow, const char * name,
+	double value);
+
+/**
+ * Desc: Reads the frames of aNames into aValues. Shadowed values are returned
+ *       from shadow and the remaining frames are read from the device using a
+ *       single LJM_eReadNames call, then added to shadow.
+ * Retr: the LJM error code, which is LJME_NOERROR on success
+**/
+int ShadowReadNames(RegisterShadow * shadow, int numFrames,
+	const char ** aNames, double * aValues);
+void ShadowReadNamesOrDie(RegisterShadow * shadow, int numFrames,
+	const char ** aNames, double * aValues);
+double ShadowGet(RegisterShadow * shadow, const char * name);
+
+/**
+ * Desc: Prints how many frames were written/read versus skipped by shadow
+**/
+void PrintRegisterShadowStatistics(const RegisterShadow * shadow);
+
+
+// Source
+
+static RegisterShadow * REGISTER_SHADOWS[MAX_REGISTER_SHADOWS] = {0};
+
+void InitRegisterShadow(RegisterShadow * shadow, int handle)
+{
+	int i, err;
+
+	memset(shadow, 0, sizeof(RegisterShadow));
+	shadow->handle = handle;
+
+	for (i = 0; i < MAX_REGISTER_SHADOWS; i++) {
+		if (REGISTER_SHADOWS[i] == NULL) {
+			REGISTER_SHADOWS[i] = shadow;
+			break;
+		}
+	}
+	if (i == MAX_REGISTER_SHADOWS) {
+		printf("InitRegisterShadow: more than %d shadows are in use\n",
+			MAX_REGISTER_SHADOWS);
+		LJM_CloseAll();
+		exit(1);
+	}
+
+	err = LJM_RegisterDeviceReconnectCallback(handle,
+		&InvalidateRegisterShadowsForHandle);
+	ErrorCheck(err, "InitRegisterShadow: LJM_RegisterDeviceReconnectCallback");
+}
+
+void CleanRegisterShadow(RegisterShadow * shadow)
+{
+	int i;
+	for (i = 0; i < MAX_REGISTER_SHADOWS; i++) {
+		if (REGISTER_SHADOWS[i] == shadow) {
+			REGISTER_SHADOWS[i] = NULL;
+		}
+	}
+}
+
+void InvalidateRegisterShadow(RegisterShadow * shadow)
+{
+	shadow->numRegisters = 0;
+	shadow->invalidated = 0;
+}
+
+void InvalidateRegisterShadowsForHandle(int handle)
+{
+	int i;
+	for (i = 0; i < MAX_REGISTER_SHADOWS; i++) {
+		if (REGISTER_SHADOWS[i] != NULL &&
+			REGISTER_SHADOWS[i]->handle == handle)
+		{
+			REGISTER_SHADOWS[i]->invalidated = 1;
+		}
+	}
+}
+
+// Clears shadow if the reconnect callback has invalidated it
+void _CheckRegisterShadowInvalidated(RegisterShadow * shadow)
+{
+	if (shadow->invalidated) {
+		InvalidateRegisterShadow(shadow);
+	}
+}
+
+// Returns the ShadowRegister for address, or NULL if it is not shadowed
+ShadowRegister * _FindShadowRegister(RegisterShadow * shadow, int address)
+{
+	int i;
+	for (i = 0; i < shadow->numRegisters; i++) {
+		if (shadow->registers[i].address == address) {
+			return &shadow->registers[i];
+		}
+	}
+	return NULL;
+}
+
+// Adds or updates the shadowed value of address. If shadow is full, the value
+// is not shadowed, which only costs a round trip later.
+void _SetShadowRegister(RegisterShadow * shadow, int address, int type,
+	double value)
+{
+	ShadowRegister * reg = _FindShadowRegister(shadow, address);
+	if (reg == NULL) {
+		if (shadow->numRegisters == MAX_SHADOW_REGISTERS) {
+			return;
+		}
+		reg = &shadow->registers[shadow->numRegisters++];
+		reg->address = address;
+		reg->type = type;
+	}
+	reg->value = value;
+}
+
+// Compares the way the device would store the value, so that a FLOAT32 read
+// back from the device matches the double that was written
+int _ShadowValuesEqual(int type, double v1, double v2)
+{
+	if (type == LJM_FLOAT32) {
+		return (float)v1 == (float)v2;
+	}
+	return v1 == v2;
+}
+
+int ShadowWriteNames(RegisterShadow * shadow, int numFrames,
+	const char ** aNames, const double * aValues, int * numWritten)
+{
+	int err, i;
+	int numToWrite = 0;
+	int errorAddress = INITIAL_ERR_ADDRESS;
+	int isReboot = 0;
+	int * aAddresses = malloc(sizeof(int) * numFrames);
+	int * aTypes = malloc(sizeof(int) * numFrames);
+	const char ** aWriteNames = malloc(sizeof(const char *) * numFrames);
+	double * aWriteValues = malloc(sizeof(double) * numFrames);
+	ShadowRegister * reg;
+
+	if (aAddresses == NULL || aTypes == NULL || aWriteNames == NULL ||
+		aWriteValues == NULL)
+	{
+		printf("ShadowWriteNames: could not allocate %d frames\n", numFrames);
+		LJM_CloseAll();
+		exit(1);
+	}
+
+	_CheckRegisterShadowInvalidated(shadow);
+
+	err = LJM_NamesToAddresses(numFrames, aNames, aAddresses, aTypes);
+	PrintErrorIfError(err, "ShadowWriteNames: LJM_NamesToAddresses");
+
+	for (i = 0; err == LJME_NOERROR && i < numFrames; i++) {
+		reg = _FindShadowRegister(shadow, aAddresses[i]);
+		if (reg != NULL && _ShadowValuesEqual(aTypes[i], reg->value,
+			aValues[i]))
+		{
+			continue;
+		}
+		if (aAddresses[i] == SYSTEM_REBOOT_ADDRESS) {
+			isReboot = 1;
+		}
+		aWriteNames[numToWrite] = aNames[i];
+		aWriteValues[numToWrite] = aValues[i];
+		++numToWrite;
+	}
+
+	if (err == LJME_NOERROR && numToWrite > 0) {
+		err = WriteNames(shadow->handle, numToWrite, aWriteNames, aWriteValues,
+			&errorAddress);
+	}
+
+	if (err == LJME_NOERROR) {
+		for (i = 0; i < numFrames; i++) {
+			_SetShadowRegister(shadow, aAddresses[i], aTypes[i], aValues[i]);
+		}
+		shadow->numFramesWritten += numToWrite;
+		shadow->numFramesSkipped += numFrames - numToWrite;
+	}
+
+	// After an error, which frames were written is unknown. After a reboot,
+	// the device has its power-up defaults.
+	if (err != LJME_NOERROR || isReboot) {
+		InvalidateRegisterShadow(shadow);
+	}
+
+	if (numWritten != NULL) {
+		*numWritten = (err == LJME_NOERROR) ? numToWrite : 0;
+	}
+
+	free(aWriteValues);
+	free(aWriteNames);
+	free(aTypes);
+	free(aAddresses);
+
+	return err;
+}
+
+void ShadowWriteNamesOrDie(RegisterShadow * shadow, int numFrames,
+	const char ** aNames, const double * aValues)
+{
+	int err = ShadowWriteNames(shadow, numFrames, aNames, aValues, NULL);
+	if (err) {
+		WaitForUserIfWindows();
+		LJM_CloseAll();
+		exit(err);
+	}
+}
+
+void ShadowWriteNameOrDie(RegisterShadow * shadow, const char * name,
+	double value)
+{
+	ShadowWriteNamesOrDie(shadow, 1, &name, &value);
+}
+
+int ShadowReadNames(RegisterShadow * shadow, int numFrames,
+	const char ** aNames, double * aValues)
+{
+	int err, i;
+	int numToRead = 0;
+	int errorAddress = INITIAL_ERR_ADDRESS;
+	int * aAddresses = malloc(sizeof(int) * numFrames);
+	int * aTypes = malloc(sizeof(int) * numFrames);
+	int * aFrameIndexes = malloc(sizeof(int) * numFrames);
+	const char ** aReadNames = malloc(sizeof(const char *) * numFrames);
+	double * aReadValues = malloc(sizeof(double) * numFrames);
+	ShadowRegister * reg;
+
+	if (aAddresses == NULL || aTypes == NULL || aFrameIndexes == NULL ||
+		aReadNames == NULL || aReadValues == NULL)
+	{
+		printf("ShadowReadNames: could not allocate %d frames\n", numFrames);
+		LJM_CloseAll();
+		exit(1);
+	}
+
+	_CheckRegisterShadowInvalidated(shadow);
+
+	err = LJM_NamesToAddresses(numFrames, aNames, aAddresses, aTypes);
+	PrintErrorIfError(err, "ShadowReadNames: LJM_NamesToAddresses");
+
+	for (i = 0; err == LJME_NOERROR && i < numFrames; i++) {
+		reg = _FindShadowRegister(shadow, aAddresses[i]);
+		if (reg != NULL) {
+			aValues[i] = reg->value;
+			continue;
+		}
+		aFrameIndexes[numToRead] = i;
+		aReadNames[numToRead] = aNames[i];
+		++numToRead;
+	}
+
+	if (err == LJME_NOERROR && numToRead > 0) {
+		err = LJM_eReadNames(shadow->handle, numToRead, aReadNames,
+			aReadValues, &errorAddress);
+		PrintErrorWithAddressIfError(err, errorAddress,
+			"ShadowReadNames: LJM_eReadNames(Handle=%d, NumFrames=%d, aNames=[%s, ...], ...)",
+			shadow->handle, numToRead, aReadNames[0]);
+	}
+
+	if (err == LJME_NOERROR) {
+		for (i = 0; i < numToRead; i++) {
+			aValues[aFrameIndexes[i]] = aReadValues[i];
+			_SetShadowRegister(shadow, aAddresses[aFrameIndexes[i]],
+				aTypes[aFrameIndexes[i]], aReadValues[i]);
+		}
+		shadow->numFramesRead += numToRead;
+		shadow->numFramesCached += numFrames - numToRead;
+	}
+
+	free(aReadValues);
+	free(aReadNames);
+	free(aFrameIndexes);
+	free(aTypes);
+	free(aAddresses);
+
+	return err;
+}
+
+void ShadowReadNamesOrDie(RegisterShadow * shadow, int numFrames,
+	const char ** aNames, double * aValues)
+{
+	int err = ShadowReadNames(shadow, numFrames, aNames, aValues);
+	if (err) {
+		WaitForUserIfWindows();
+		LJM_CloseAll();
+		exit(err);
+	}
+}
+
+double ShadowGet(RegisterShadow * shadow, const char * name)
+{
+	double value = 0;
+	int err = ShadowReadNames(shadow, 1, &name, &value);
+	if (err != LJME_NOERROR) {
+		CouldNotRead(err, name);
+	}
+	return value;
+}
+
+void PrintRegisterShadowStatistics(const RegisterShadow * shadow)
+{
+	printf("Register shadow for handle %d (%d registers shadowed):\n",
+		shadow->handle, shadow->numRegisters);
+	printf("    frames written: %d, write frames skipped: %d\n",
+		shadow->numFramesWritten, shadow->numFramesSkipped);
+	printf("    frames read: %d, read frames from shadow: %d\n",
+		shadow->numFramesRead, shadow->numFramesCached);
+}
+
+#endif // #define LJM_REGISTER_SHADOW
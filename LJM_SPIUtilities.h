@@ -0,0 +1,296 @@
+/**
+ * Name: LJM_SPIUtilities.h
+ * Desc: Provides bulk SPI transfers of any length. SPITransfer splits the TX
+ *       buffer into chunks no larger than the device's SPI buffer and no
+ *       larger than fits in one packet, and sends each chunk's configuration,
+ *       SPI_DATA_TX, SPI_GO and SPI_DATA_RX frames in a single LJM_eNames
+ *       call. The received bytes are returned as one contiguous buffer.
+ *       Configuration registers are only written when they differ from the
+ *       values last written.
+ * Note: When a transfer is split into several chunks, chip select is driven
+ *       by SPITransfer instead of by the device so that it stays asserted
+ *       (low) from the first chunk to the last. This requires the default
+ *       active-low chip select.
+ *       If the device may have been reconfigured or rebooted since the
+ *       configuration was last written, call InvalidateSPIBus.
+**/
+
+#ifndef LJM_SPI_UTILITIES
+#define LJM_SPI_UTILITIES
+
+#include "LJM_Utilities.h"
+
+// The maximum number of bytes the device transfers per SPI_GO
+enum { SPI_MAX_CHUNK_BYTES = 56 };
+
+// The bytes of a packet used by everything other than the SPI data: the
+// Modbus header, the SPI_NUM_BYTES, SPI_GO and chip select frames, and the
+// SPI_DATA_TX and SPI_DATA_RX frame headers
+enum { SPI_PACKET_OVERHEAD_BYTES = 36 };
+
+// SPI_OPTIONS bit 0: the device does not drive chip select
+enum { SPI_OPTION_DISABLE_CS = 1 };
+
+// The configuration registers, in the order they are written
+enum {
+	SPI_CONFIG_CS_DIONUM,
+	SPI_CONFIG_CLK_DIONUM,
+	SPI_CONFIG_MISO_DIONUM,
+	SPI_CONFIG_MOSI_DIONUM,
+	SPI_CONFIG_MODE,
+	SPI_CONFIG_SPEED_THROTTLE,
+	SPI_CONFIG_OPTIONS,
+	SPI_CONFIG_NUM_BYTES,
+	SPI_NUM_CONFIG_REGISTERS
+};
+
+static const char * SPI_CONFIG_NAMES[SPI_NUM_CONFIG_REGISTERS] = {
+	"SPI_CS_DIONUM",
+	"SPI_CLK_DIONUM",
+	"SPI_MISO_DIONUM",
+	"SPI_MOSI_DIONUM",
+	"SPI_MODE",
+	"SPI_SPEED_THROTTLE",
+	"SPI_OPTIONS",
+	"SPI_NUM_BYTES"
+};
+
+// Configuration frames, chip select low, SPI_DATA_TX, SPI_GO, SPI_DATA_RX and
+// chip select high
+enum { SPI_MAX_FRAMES = SPI_NUM_CONFIG_REGISTERS + 5 };
+enum { SPI_MAX_VALUES = SPI_MAX_FRAMES + 2 * SPI_MAX_CHUNK_BYTES };
+
+typedef struct SPIBus {
+	int handle;
+
+	// The number of bytes sent with each SPI_GO
+	int chunkBytes;
+
+	// The requested values and the values last written to the device, by
+	// SPI_CONFIG_*. A written value of -1 means it is not known.
+	int aConfig[SPI_NUM_CONFIG_REGISTERS];
+	int aWrittenConfig[SPI_NUM_CONFIG_REGISTERS];
+
+	// The name of the chip select line, such as "DIO1"
+	char csName[LJM_MAX_NAME_SIZE];
+
+	// Reused LJM_eNames arrays
+	const char * aNames[SPI_MAX_FRAMES];
+	int aWrites[SPI_MAX_FRAMES];
+	int aNumValues[SPI_MAX_FRAMES];
+	double aValues[SPI_MAX_VALUES];
+
+	// Statistics
+	int numTransfers;
+	int numChunks;
+	double numBytes;
+	double transferSeconds;
+} SPIBus;
+
+/**
+ * Desc: Initializes bus for handle and chooses the chunk size from the
+ *       connection's maximum packet size. Nothing is written to the device
+ *       until the first transfer.
+ * Para: csDIONum, clkDIONum, misoDIONum, mosiDIONum, the DIO numbers of the
+ *           SPI lines
+ *       mode, the SPI_MODE value (bit 0: CPHA, bit 1: CPOL)
+ *       speedThrottle, the SPI_SPEED_THROTTLE value. 0 is the fastest.
+ *       options, the SPI_OPTIONS value
+**/
+void InitSPIBus(SPIBus * bus, int handle, int csDIONum, int clkDIONum,
+	int misoDIONum, int mosiDIONum, int mode, int speedThrottle, int options);
+
+/**
+ * Desc: Forgets the configuration values last written so that all of them are
+ *       written with the next transfer.
+**/
+void InvalidateSPIBus(SPIBus * bus);
+
+/**
+ * Desc: Sends numBytes of aTX and receives numBytes into aRX, splitting the
+ *       transfer into chunks of bus->chunkBytes.
+ * Para: aTX, the bytes to send, or NULL to send zeros
+ *       aRX, where to store the received bytes, or NULL
+ * Retr: the LJM error code, which is LJME_NOERROR on success
+ * Note: On error, the configuration last written is forgotten, since it is not
+ *       known which frames the device performed. A split transfer also tries
+ *       to write CS high so the slave is not left selected.
+**/
+int SPITransfer(SPIBus * bus, int numBytes, const unsigned char * aTX,
+	unsigned char * aRX);
+void SPITransferOrDie(SPIBus * bus, int numBytes, const unsigned char * aTX,
+	unsigned char * aRX);
+
+/**
+ * Desc: Prints the number of transfers, chunks and bytes of bus, and the
+ *       throughput of its transfers
+**/
+void PrintSPIBusStatistics(const SPIBus * bus);
+
+
+// Source
+
+void InitSPIBus(SPIBus * bus, int handle, int csDIONum, int clkDIONum,
+	int misoDIONum, int mosiDIONum, int mode, int speedThrottle, int options)
+{
+	int err;
+	int deviceType, connectionType, serialNumber, ipAddress, port,
+		maxBytesPerMB;
+
+	memset(bus, 0, sizeof(SPIBus));
+	bus->handle = handle;
+	bus->aConfig[SPI_CONFIG_CS_DIONUM] = csDIONum;
+	bus->aConfig[SPI_CONFIG_CLK_DIONUM] = clkDIONum;
+	bus->aConfig[SPI_CONFIG_MISO_DIONUM] = misoDIONum;
+	bus->aConfig[SPI_CONFIG_MOSI_DIONUM] = mosiDIONum;
+	bus->aConfig[SPI_CONFIG_MODE] = mode;
+	bus->aConfig[SPI_CONFIG_SPEED_THROTTLE] = speedThrottle;
+	bus->aConfig[SPI_CONFIG_OPTIONS] = options;
+	sprintf(bus->csName, "DIO%d", csDIONum);
+	InvalidateSPIBus(bus);
+
+	err = LJM_GetHandleInfo(handle, &deviceType, &connectionType,
+		&serialNumber, &ipAddress, &port, &maxBytesPerMB);
+	ErrorCheck(err, "InitSPIBus: LJM_GetHandleInfo");
+
+	// Both the TX bytes of the command and the RX bytes of the response must
+	// fit in one packet. Byte arrays are sent as whole registers, so keep the
+	// chunk size even.
+	bus->chunkBytes = maxBytesPerMB - SPI_PACKET_OVERHEAD_BYTES;
+	if (bus->chunkBytes > SPI_MAX_CHUNK_BYTES) {
+		bus->chunkBytes = SPI_MAX_CHUNK_BYTES;
+	}
+	bus->chunkBytes &= ~1;
+	if (bus->chunkBytes < 2) {
+		bus->chunkBytes = 2;
+	}
+}
+
+void InvalidateSPIBus(SPIBus * bus)
+{
+	int i;
+	for (i = 0; i < SPI_NUM_CONFIG_REGISTERS; i++) {
+		bus->aWrittenConfig[i] = -1;
+	}
+}
+
+// Adds one frame to the LJM_eNames arrays of bus
+void _AddSPIFrame(SPIBus * bus, int * numFrames, int * numValues,
+	const char * name, int write, int frameNumValues)
+{
+	bus->aNames[*numFrames] = name;
+	bus->aWrites[*numFrames] = write;
+	bus->aNumValues[*numFrames] = frameNumValues;
+	(*numFrames)++;
+	*numValues += frameNumValues;
+}
+
+int SPITransfer(SPIBus * bus, int numBytes, const unsigned char * aTX,
+	unsigned char * aRX)
+{
+	int i, err, offset, chunkBytes, rxValueIndex;
+	int numFrames, numValues;
+	int errorAddress = INITIAL_ERR_ADDRESS;
+	int aConfig[SPI_NUM_CONFIG_REGISTERS];
+	int split = (numBytes > bus->chunkBytes);
+	LJM_LONG_LONG_RETURN start = LJM_GetHostTick();
+
+	memcpy(aConfig, bus->aConfig, sizeof(aConfig));
+	if (split) {
+		aConfig[SPI_CONFIG_OPTIONS] |= SPI_OPTION_DISABLE_CS;
+	}
+
+	for (offset = 0; offset < numBytes; offset += chunkBytes) {
+		chunkBytes = numBytes - offset;
+		if (chunkBytes > bus->chunkBytes) {
+			chunkBytes = bus->chunkBytes;
+		}
+		aConfig[SPI_CONFIG_NUM_BYTES] = chunkBytes;
+
+		numFrames = 0;
+		numValues = 0;
+
+		// Only write the configuration that has changed, which is usually
+		// just SPI_NUM_BYTES of the last chunk
+		for (i = 0; i < SPI_NUM_CONFIG_REGISTERS; i++) {
+			if (aConfig[i] == bus->aWrittenConfig[i]) {
+				continue;
+			}
+			bus->aValues[numValues] = aConfig[i];
+			_AddSPIFrame(bus, &numFrames, &numValues, SPI_CONFIG_NAMES[i],
+				LJM_WRITE, 1);
+			bus->aWrittenConfig[i] = aConfig[i];
+		}
+
+		if (split && offset == 0) {
+			bus->aValues[numValues] = 0;
+			_AddSPIFrame(bus, &numFrames, &numValues, bus->csName, LJM_WRITE,
+				1);
+		}
+
+		for (i = 0; i < chunkBytes; i++) {
+			bus->aValues[numValues + i] = aTX ? aTX[offset + i] : 0;
+		}
+		_AddSPIFrame(bus, &numFrames, &numValues, "SPI_DATA_TX", LJM_WRITE,
+			chunkBytes);
+
+		bus->aValues[numValues] = 1;
+		_AddSPIFrame(bus, &numFrames, &numValues, "SPI_GO", LJM_WRITE, 1);
+
+		rxValueIndex = numValues;
+		_AddSPIFrame(bus, &numFrames, &numValues, "SPI_DATA_RX", LJM_READ,
+			chunkBytes);
+
+		if (split && offset + chunkBytes == numBytes) {
+			bus->aValues[numValues] = 1;
+			_AddSPIFrame(bus, &numFrames, &numValues, bus->csName, LJM_WRITE,
+				1);
+		}
+
+		err = LJM_eNames(bus->handle, numFrames, bus->aNames, bus->aWrites,
+			bus->aNumValues, bus->aValues, &errorAddress);
+		if (err != LJME_NOERROR) {
+			InvalidateSPIBus(bus);
+			if (split) {
+				// Deselect the slave, which may have been left selected by
+				// this or an earlier chunk. The error of the transfer is more
+				// useful than the error of this write, if any.
+				LJM_eWriteName(bus->handle, bus->csName, 1);
+			}
+			return err;
+		}
+		bus->numChunks++;
+
+		if (aRX) {
+			for (i = 0; i < chunkBytes; i++) {
+				aRX[offset + i] =
+					(unsigned char)bus->aValues[rxValueIndex + i];
+			}
+		}
+	}
+
+	bus->numTransfers++;
+	bus->numBytes += numBytes;
+	bus->transferSeconds += (LJM_GetHostTick() - start) / 1000000.0;
+
+	return LJME_NOERROR;
+}
+
+void SPITransferOrDie(SPIBus * bus, int numBytes, const unsigned char * aTX,
+	unsigned char * aRX)
+{
+	int err = SPITransfer(bus, numBytes, aTX, aRX);
+	ErrorCheck(err, "SPITransfer(%d bytes)", numBytes);
+}
+
+void PrintSPIBusStatistics(const SPIBus * bus)
+{
+	printf("SPI: %d transfers, %d chunks of up to %d bytes, %.0f bytes",
+		bus->numTransfers, bus->numChunks, bus->chunkBytes, bus->numBytes);
+	if (bus->transferSeconds > 0) {
+		printf(", %.2f KB/s", bus->numBytes / 1024 / bus->transferSeconds);
+	}
+	printf("\n");
+}
+
+#endif // #define LJM_SPI_UTILITIES
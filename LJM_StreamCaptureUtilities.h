@@ -0,0 +1,714 @@
+/**
+ * Name: LJM_StreamCaptureUtilities.h
+ * Desc: Provides stream captures that are too large to hold as doubles.
+ *       LJM_StreamBurst needs one double per sample for the whole burst, so a
+ *       capture of 10 million samples needs 80 MB before it can be converted
+ *       or saved. StreamBurstToBuffer and StreamBurstToFile instead perform
+ *       the burst with STREAM_NUM_SCANS and LJM_eStreamRead, converting each
+ *       read to float32 directly into a caller-provided buffer or appending it
+ *       to a file, so only one read is held as doubles at a time.
+ *       VerifyCapture checks a capture against expected channel values using
+ *       several threads.
+ *       PreTriggerCapture keeps a ring of the last scans of a free-running
+ *       stream, evaluates a level, edge or DIO mask trigger on each read and
+ *       provides windows of pre-trigger and post-trigger scans from the ring
+ *       without copying them.
+ * Note: On Linux and Mac OS X, programs that include this file must link with
+ *       pthread (see the link_libs of the SConstruct file).
+**/
+
+#ifndef LJM_STREAM_CAPTURE_UTILITIES
+#define LJM_STREAM_CAPTURE_UTILITIES
+
+#include "LJM_Utilities.h"
+#include "LJM_ThreadUtilities.h"
+
+#ifdef __linux__
+	#include <sys/mman.h>
+#endif
+
+// The error LJM_eStreamRead returns once STREAM_NUM_SCANS scans have been read
+enum { CAPTURE_STREAM_BURST_COMPLETE = 2944 };
+
+// Returned by StreamBurstToFile if the file could not be written
+enum { CAPTURE_FILE_ERROR = -1 };
+
+// The number of LJM_eStreamRead calls per second of a burst
+enum { CAPTURE_READS_PER_SECOND = 10 };
+
+// The maximum number of threads of VerifyCapture
+enum { CAPTURE_MAX_THREADS = 64 };
+
+// Huge page buffers are rounded up to a multiple of this, the default huge
+// page size of x86-64 Linux, since munmap needs whole huge pages
+enum { CAPTURE_HUGE_PAGE_BYTES = 2 * 1024 * 1024 };
+
+/**
+ * Desc: Allocates a buffer of numSamples float32 samples. If useHugePages is
+ *       non-zero and the system supports it (Linux with MAP_HUGETLB and
+ *       reserved huge pages), the buffer is backed by huge pages, which
+ *       reduces TLB misses for very large captures.
+ * Para: usedHugePages, output of whether the buffer uses huge pages, which
+ *       must be passed to FreeCaptureBuffer
+ * Retr: the buffer, or NULL if it could not be allocated
+**/
+float * AllocateCaptureBuffer(size_t numSamples, int useHugePages,
+	int * usedHugePages);
+
+/**
+ * Desc: Frees a buffer of AllocateCaptureBuffer
+**/
+void FreeCaptureBuffer(float * aSamples, size_t numSamples,
+	int usedHugePages);
+
+/**
+ * Desc: Performs a stream burst of numScans scans, like LJM_StreamBurst, into
+ *       aSamples, which must hold numScans * numChannels samples.
+ * Para: scanRate, input of the desired scan rate and output of the actual one
+ *       numScansCaptured, optional output of the number of scans captured,
+ *       which is less than numScans only on error
+ * Retr: the LJM error code, which is LJME_NOERROR on success
+**/
+int StreamBurstToBuffer(int handle, int numChannels, const int * aScanList,
+	double * scanRate, int numScans, float * aSamples, int * numScansCaptured);
+
+/**
+ * Desc: Performs a stream burst of numScans scans and appends each read to
+ *       file as native-endian float32 samples, in scan order.
+ * Retr: the LJM error code, which is LJME_NOERROR on success, or
+ *       CAPTURE_FILE_ERROR if file could not be written
+**/
+int StreamBurstToFile(int handle, int numChannels, const int * aScanList,
+	double * scanRate, int numScans, FILE * file, int * numScansCaptured);
+
+/**
+ * Desc: Converts numSamples doubles in aSamples to float32 in place, so that a
+ *       buffer from LJM_StreamBurst can be shrunk to half its size.
+ * Retr: aSamples as float32 samples
+**/
+float * ConvertSamplesToFloat32InPlace(double * aSamples, size_t numSamples);
+
+/**
+ * Desc: Checks that each sample of numScans scans is within aDeltas of
+ *       aExpected for its channel, like VerifyChannelData of
+ *       stream_burst_test.c, splitting the scans among numThreads threads.
+ *       The first mismatch of each thread's scans is printed.
+ * Retr: the number of mismatched samples
+**/
+size_t VerifyCapture(const float * aSamples, int numScans, int numChannels,
+	const double * aExpected, const double * aDeltas, int numThreads);
+
+typedef enum {
+	// The channel crosses level upwards or downwards
+	TRIGGER_RISING_EDGE,
+	TRIGGER_FALLING_EDGE,
+
+	// The channel is at or above, or at or below, level
+	TRIGGER_ABOVE_LEVEL,
+	TRIGGER_BELOW_LEVEL,
+
+	// The bits of mask of a DIO state channel, such as FIO_STATE, change to
+	// the bits of match
+	TRIGGER_DIO_MASK
+} StreamTriggerType;
+
+typedef struct StreamTrigger {
+	StreamTriggerType type;
+
+	// The scan index of the channel the trigger is evaluated on
+	int channel;
+
+	double level;
+	unsigned int mask;
+	unsigned int match;
+} StreamTrigger;
+
+typedef enum {
+	_CAPTURE_ARMED,
+	_CAPTURE_TRIGGERED,
+	_CAPTURE_READY
+} _PreTriggerState;
+
+/**
+ * A window of scans around a trigger. The scans are in the ring of the
+ * PreTriggerCapture, so they are not copied, and are in up to two parts
+ * because the window may wrap around the end of the ring.
+**/
+typedef struct CaptureWindow {
+	const double * aFirstScans;
+	int numFirstScans;
+	const double * aSecondScans;
+	int numSecondScans;
+
+	// The index of the trigger scan within the window, which is the number
+	// of pre-trigger scans
+	int triggerScan;
+} CaptureWindow;
+
+typedef struct PreTriggerCapture {
+	int numChannels;
+	int scansPerRead;
+	int numPreScans;
+	int numPostScans;
+	StreamTrigger trigger;
+
+	// The ring of the last ringScans scans. Each LJM_eStreamRead writes
+	// directly into the ring, so ringScans is a multiple of scansPerRead.
+	double * aRing;
+	int ringScans;
+	int writeScan;
+	int numScansSeen;
+
+	// The trigger state, and the ring indexes of the trigger scan, the last
+	// scan of a ready window and the next scan to evaluate
+	_PreTriggerState state;
+	int triggerScan;
+	int numPostScansSeen;
+	int windowEndScan;
+	int nextScan;
+	int numPendingScans;
+
+	// The trigger channel's previous value, for edges
+	int hasPreviousValue;
+	double previousValue;
+
+	// Statistics
+	int numReads;
+	int numWindows;
+} PreTriggerCapture;
+
+/**
+ * Desc: Allocates the ring of capture for windows of numPreScans scans before
+ *       and numPostScans scans from a trigger scan, including it. Exits if
+ *       the ring cannot be allocated.
+**/
+void InitPreTriggerCapture(PreTriggerCapture * capture, int numChannels,
+	int scansPerRead, int numPreScans, int numPostScans,
+	const StreamTrigger * trigger);
+
+/**
+ * Desc: Frees the ring of capture
+**/
+void FreePreTriggerCapture(PreTriggerCapture * capture);
+
+/**
+ * Desc: Performs one LJM_eStreamRead of the stream of handle, which must have
+ *       been started with the capture's channels and scansPerRead, into the
+ *       ring, and evaluates the trigger on the new scans. Call
+ *       GetCaptureWindow until it returns 0 after each read.
+ *       The trigger is not armed until numPreScans scans have been read, so
+ *       that every window is complete.
+ * Retr: the LJM error code of LJM_eStreamRead
+**/
+int PreTriggerCaptureRead(PreTriggerCapture * capture, int handle,
+	int * deviceScanBacklog, int * LJMScanBacklog);
+
+/**
+ * Desc: Gets the next complete window of the last read and re-arms the
+ *       trigger. The window is valid until the next PreTriggerCaptureRead.
+ * Retr: 1 if window was set, 0 if there is no complete window
+**/
+int GetCaptureWindow(PreTriggerCapture * capture, CaptureWindow * window);
+
+/**
+ * Desc: Returns the value of channel of the scan at scanI of window
+**/
+double CaptureWindowValue(const CaptureWindow * window, int numChannels,
+	int scanI, int channel);
+
+/**
+ * Desc: Prints the number of reads and windows of capture
+**/
+void PrintPreTriggerCaptureStatistics(const PreTriggerCapture * capture);
+
+
+// Source
+
+// Returns the size of the mapping of a huge page buffer of numSamples
+size_t _CaptureHugePageBytes(size_t numSamples)
+{
+	size_t numBytes = numSamples * sizeof(float);
+	return (numBytes + CAPTURE_HUGE_PAGE_BYTES - 1) /
+		CAPTURE_HUGE_PAGE_BYTES * CAPTURE_HUGE_PAGE_BYTES;
+}
+
+float * AllocateCaptureBuffer(size_t numSamples, int useHugePages,
+	int * usedHugePages)
+{
+	float * aSamples;
+
+	*usedHugePages = 0;
+
+#ifdef MAP_HUGETLB
+	if (useHugePages) {
+		aSamples = (float *)mmap(NULL, _CaptureHugePageBytes(numSamples),
+			PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+			-1, 0);
+		if (aSamples != MAP_FAILED) {
+			*usedHugePages = 1;
+			return aSamples;
+		}
+		printf("AllocateCaptureBuffer: huge pages are not available, using "
+			"normal pages\n");
+	}
+#endif
+
+	aSamples = (float *)malloc(numSamples * sizeof(float));
+	return aSamples;
+}
+
+void FreeCaptureBuffer(float * aSamples, size_t numSamples,
+	int usedHugePages)
+{
+#ifdef MAP_HUGETLB
+	if (usedHugePages) {
+		munmap(aSamples, _CaptureHugePageBytes(numSamples));
+		return;
+	}
+#endif
+
+	free(aSamples);
+}
+
+// Performs the burst of StreamBurstToBuffer if aSamples is not NULL, or of
+// StreamBurstToFile otherwise
+int _StreamBurstCapture(int handle, int numChannels, const int * aScanList,
+	double * scanRate, int numScans, float * aSamples, FILE * file,
+	int * numScansCaptured)
+{
+	int err, stopErr, scansPerRead, scansToCopy;
+	int deviceScanBacklog, LJMScanBacklog;
+	int captured = 0;
+	size_t sampleI, numSamples;
+	double * aRead;
+	float * aReadFloats = NULL;
+	float * destination;
+
+	if (numScansCaptured) {
+		*numScansCaptured = 0;
+	}
+
+	scansPerRead = (int)(*scanRate / CAPTURE_READS_PER_SECOND);
+	if (scansPerRead < 1) {
+		scansPerRead = 1;
+	}
+	if (scansPerRead > numScans) {
+		scansPerRead = numScans;
+	}
+
+	aRead = (double *)malloc(sizeof(double) * scansPerRead * numChannels);
+	if (aSamples == NULL) {
+		aReadFloats = (float *)malloc(
+			sizeof(float) * scansPerRead * numChannels);
+	}
+	if (aRead == NULL || (aSamples == NULL && aReadFloats == NULL)) {
+		printf("_StreamBurstCapture: could not allocate %d scans\n",
+			scansPerRead);
+		LJM_CloseAll();
+		exit(1);
+	}
+
+	err = LJM_eWriteName(handle, "STREAM_NUM_SCANS", numScans);
+	if (err == LJME_NOERROR) {
+		err = LJM_eStreamStart(handle, scansPerRead, numChannels, aScanList,
+			scanRate);
+	}
+	if (err != LJME_NOERROR) {
+		free(aRead);
+		free(aReadFloats);
+		return err;
+	}
+
+	while (captured < numScans) {
+		err = LJM_eStreamRead(handle, aRead, &deviceScanBacklog,
+			&LJMScanBacklog);
+		if (err == CAPTURE_STREAM_BURST_COMPLETE) {
+			err = LJME_NOERROR;
+			break;
+		}
+		if (err != LJME_NOERROR) {
+			break;
+		}
+
+		// The last read is padded with LJM_DUMMY_VALUE past numScans
+		scansToCopy = numScans - captured;
+		if (scansToCopy > scansPerRead) {
+			scansToCopy = scansPerRead;
+		}
+		numSamples = (size_t)scansToCopy * numChannels;
+
+		if (aSamples) {
+			destination = aSamples + (size_t)captured * numChannels;
+		}
+		else {
+			destination = aReadFloats;
+		}
+		for (sampleI = 0; sampleI < numSamples; sampleI++) {
+			destination[sampleI] = (float)aRead[sampleI];
+		}
+		if (file && fwrite(destination, sizeof(float), numSamples, file) !=
+			numSamples)
+		{
+			printf("_StreamBurstCapture: could not write the capture file\n");
+			err = CAPTURE_FILE_ERROR;
+			break;
+		}
+
+		captured += scansToCopy;
+	}
+
+	stopErr = LJM_eStreamStop(handle);
+	if (err == LJME_NOERROR) {
+		err = stopErr;
+	}
+
+	// Let later streams run continuously
+	stopErr = LJM_eWriteName(handle, "STREAM_NUM_SCANS", 0);
+	if (err == LJME_NOERROR) {
+		err = stopErr;
+	}
+
+	if (numScansCaptured) {
+		*numScansCaptured = captured;
+	}
+
+	free(aRead);
+	free(aReadFloats);
+	return err;
+}
+
+int StreamBurstToBuffer(int handle, int numChannels, const int * aScanList,
+	double * scanRate, int numScans, float * aSamples, int * numScansCaptured)
+{
+	return _StreamBurstCapture(handle, numChannels, aScanList, scanRate,
+		numScans, aSamples, NULL, numScansCaptured);
+}
+
+int StreamBurstToFile(int handle, int numChannels, const int * aScanList,
+	double * scanRate, int numScans, FILE * file, int * numScansCaptured)
+{
+	return _StreamBurstCapture(handle, numChannels, aScanList, scanRate,
+		numScans, NULL, file, numScansCaptured);
+}
+
+float * ConvertSamplesToFloat32InPlace(double * aSamples, size_t numSamples)
+{
+	size_t i;
+	double value;
+	float converted;
+	unsigned char * bytes = (unsigned char *)aSamples;
+
+	// Float i is written over bytes of doubles that have already been read,
+	// since 4 * i <= 8 * i. memcpy avoids aliasing a double as a float.
+	for (i = 0; i < numSamples; i++) {
+		memcpy(&value, bytes + i * sizeof(double), sizeof(double));
+		converted = (float)value;
+		memcpy(bytes + i * sizeof(float), &converted, sizeof(float));
+	}
+
+	return (float *)aSamples;
+}
+
+typedef struct _CaptureVerifyChunk {
+	const float * aSamples;
+	int firstScan;
+	int numScans;
+	int numChannels;
+	const double * aExpected;
+	const double * aDeltas;
+
+	size_t numMismatches;
+} _CaptureVerifyChunk;
+
+void _VerifyCaptureChunk(void * arg)
+{
+	_CaptureVerifyChunk * chunk = (_CaptureVerifyChunk *)arg;
+	int scanI, chanI, pass;
+	double actual, expected, delta;
+	const float * scan;
+
+	chunk->numMismatches = 0;
+	for (scanI = chunk->firstScan;
+		scanI < chunk->firstScan + chunk->numScans; scanI++)
+	{
+		scan = chunk->aSamples + (size_t)scanI * chunk->numChannels;
+		for (chanI = 0; chanI < chunk->numChannels; chanI++) {
+			actual = scan[chanI];
+			expected = chunk->aExpected[chanI];
+			delta = chunk->aDeltas[chanI];
+
+			// Compare as float32, the precision of the capture
+			if (delta == 0) {
+				pass = (actual == (float)expected);
+			}
+			else {
+				pass = EqualFloats(expected, actual, delta);
+			}
+
+			if (!pass) {
+				if (chunk->numMismatches == 0) {
+					printf("VerifyCapture - scan %d: expected chan[%d] %f "
+						"within delta %f, but was %f\n", scanI, chanI,
+						expected, delta, actual);
+				}
+				chunk->numMismatches++;
+			}
+		}
+	}
+}
+
+size_t VerifyCapture(const float * aSamples, int numScans, int numChannels,
+	const double * aExpected, const double * aDeltas, int numThreads)
+{
+	_CaptureVerifyChunk aChunks[CAPTURE_MAX_THREADS];
+	Thread aThreads[CAPTURE_MAX_THREADS];
+	int aStarted[CAPTURE_MAX_THREADS];
+	int i, scansPerChunk;
+	size_t numMismatches = 0;
+
+	if (numThreads < 1) {
+		numThreads = 1;
+	}
+	if (numThreads > CAPTURE_MAX_THREADS) {
+		numThreads = CAPTURE_MAX_THREADS;
+	}
+	if (numThreads > numScans) {
+		numThreads = numScans > 0 ? numScans : 1;
+	}
+	scansPerChunk = (numScans + numThreads - 1) / numThreads;
+
+	for (i = 0; i < numThreads; i++) {
+		aChunks[i].aSamples = aSamples;
+		aChunks[i].firstScan = i * scansPerChunk;
+		aChunks[i].numScans = numScans - aChunks[i].firstScan;
+		if (aChunks[i].numScans > scansPerChunk) {
+			aChunks[i].numScans = scansPerChunk;
+		}
+		if (aChunks[i].numScans < 0) {
+			aChunks[i].numScans = 0;
+		}
+		aChunks[i].numChannels = numChannels;
+		aChunks[i].aExpected = aExpected;
+		aChunks[i].aDeltas = aDeltas;
+
+		// The last chunk is verified by this thread
+		aStarted[i] = 0;
+		if (i < numThreads - 1) {
+			aStarted[i] = (StartThread(&aThreads[i], _VerifyCaptureChunk,
+				&aChunks[i]) == 0);
+		}
+		if (!aStarted[i]) {
+			_VerifyCaptureChunk(&aChunks[i]);
+		}
+	}
+
+	for (i = 0; i < numThreads; i++) {
+		if (aStarted[i]) {
+			JoinThread(aThreads[i]);
+		}
+		numMismatches += aChunks[i].numMismatches;
+	}
+
+	return numMismatches;
+}
+
+void InitPreTriggerCapture(PreTriggerCapture * capture, int numChannels,
+	int scansPerRead, int numPreScans, int numPostScans,
+	const StreamTrigger * trigger)
+{
+	int minRingScans;
+
+	if (scansPerRead < 1 || numPreScans < 0 || numPostScans < 1 ||
+		trigger->channel < 0 || trigger->channel >= numChannels)
+	{
+		printf("InitPreTriggerCapture: invalid scansPerRead %d, "
+			"numPreScans %d, numPostScans %d or trigger channel %d\n",
+			scansPerRead, numPreScans, numPostScans, trigger->channel);
+		LJM_CloseAll();
+		exit(1);
+	}
+
+	memset(capture, 0, sizeof(PreTriggerCapture));
+	capture->numChannels = numChannels;
+	capture->scansPerRead = scansPerRead;
+	capture->numPreScans = numPreScans;
+	capture->numPostScans = numPostScans;
+	capture->trigger = *trigger;
+
+	// A window ends in the latest read, which may have up to scansPerRead - 1
+	// scans after it, and the next read overwrites the oldest scansPerRead
+	// scans, so those must not be part of the window
+	minRingScans = numPreScans + numPostScans + 2 * scansPerRead;
+	capture->ringScans = (minRingScans + scansPerRead - 1) / scansPerRead *
+		scansPerRead;
+	capture->aRing = (double *)malloc(
+		sizeof(double) * capture->ringScans * numChannels);
+	if (capture->aRing == NULL) {
+		printf("InitPreTriggerCapture: could not allocate %d scans\n",
+			capture->ringScans);
+		LJM_CloseAll();
+		exit(1);
+	}
+
+	capture->state = _CAPTURE_ARMED;
+}
+
+void FreePreTriggerCapture(PreTriggerCapture * capture)
+{
+	free(capture->aRing);
+	capture->aRing = NULL;
+}
+
+// Returns 1 if value, the trigger channel's value of the next scan, fires
+// the trigger
+int _StreamTriggerFires(const PreTriggerCapture * capture, double value)
+{
+	const StreamTrigger * trigger = &capture->trigger;
+	const double previous = capture->previousValue;
+	const int hasPrevious = capture->hasPreviousValue;
+	const unsigned int match = trigger->match & trigger->mask;
+
+	if (value == LJM_DUMMY_VALUE) {
+		return 0;
+	}
+
+	switch (trigger->type) {
+	case TRIGGER_RISING_EDGE:
+		return hasPrevious && previous < trigger->level &&
+			value >= trigger->level;
+	case TRIGGER_FALLING_EDGE:
+		return hasPrevious && previous > trigger->level &&
+			value <= trigger->level;
+	case TRIGGER_ABOVE_LEVEL:
+		return value >= trigger->level;
+	case TRIGGER_BELOW_LEVEL:
+		return value <= trigger->level;
+	case TRIGGER_DIO_MASK:
+		return ((unsigned int)value & trigger->mask) == match &&
+			(!hasPrevious ||
+			((unsigned int)previous & trigger->mask) != match);
+	}
+
+	return 0;
+}
+
+// Evaluates the pending scans until there are none or a window is ready
+void _EvaluatePreTriggerScans(PreTriggerCapture * capture)
+{
+	int scan;
+	double value;
+
+	while (capture->numPendingScans > 0 &&
+		capture->state != _CAPTURE_READY)
+	{
+		scan = capture->nextScan;
+		value = capture->aRing[(size_t)scan * capture->numChannels +
+			capture->trigger.channel];
+
+		if (capture->state == _CAPTURE_ARMED &&
+			capture->numScansSeen >= capture->numPreScans &&
+			_StreamTriggerFires(capture, value))
+		{
+			capture->state = _CAPTURE_TRIGGERED;
+			capture->triggerScan = scan;
+			capture->numPostScansSeen = 0;
+		}
+		if (capture->state == _CAPTURE_TRIGGERED) {
+			capture->numPostScansSeen++;
+			if (capture->numPostScansSeen == capture->numPostScans) {
+				capture->state = _CAPTURE_READY;
+				capture->windowEndScan = scan;
+			}
+		}
+
+		capture->hasPreviousValue = (value != LJM_DUMMY_VALUE);
+		capture->previousValue = value;
+		if (capture->numScansSeen < capture->ringScans) {
+			capture->numScansSeen++;
+		}
+		capture->nextScan = (scan + 1) % capture->ringScans;
+		capture->numPendingScans--;
+	}
+}
+
+int PreTriggerCaptureRead(PreTriggerCapture * capture, int handle,
+	int * deviceScanBacklog, int * LJMScanBacklog)
+{
+	int err;
+
+	// Drop the windows of the last read that were not taken
+	while (capture->state == _CAPTURE_READY) {
+		capture->state = _CAPTURE_ARMED;
+		_EvaluatePreTriggerScans(capture);
+	}
+
+	err = LJM_eStreamRead(handle,
+		capture->aRing + (size_t)capture->writeScan * capture->numChannels,
+		deviceScanBacklog, LJMScanBacklog);
+	capture->numReads++;
+	if (err != LJME_NOERROR) {
+		return err;
+	}
+
+	capture->nextScan = capture->writeScan;
+	capture->numPendingScans = capture->scansPerRead;
+	capture->writeScan = (capture->writeScan + capture->scansPerRead) %
+		capture->ringScans;
+
+	_EvaluatePreTriggerScans(capture);
+
+	return LJME_NOERROR;
+}
+
+int GetCaptureWindow(PreTriggerCapture * capture, CaptureWindow * window)
+{
+	int firstScan;
+	const int numScans = capture->numPreScans + capture->numPostScans;
+
+	if (capture->state != _CAPTURE_READY) {
+		return 0;
+	}
+
+	firstScan = (capture->triggerScan - capture->numPreScans +
+		capture->ringScans) % capture->ringScans;
+	window->aFirstScans = capture->aRing +
+		(size_t)firstScan * capture->numChannels;
+	if (firstScan + numScans <= capture->ringScans) {
+		window->numFirstScans = numScans;
+		window->aSecondScans = NULL;
+		window->numSecondScans = 0;
+	}
+	else {
+		window->numFirstScans = capture->ringScans - firstScan;
+		window->aSecondScans = capture->aRing;
+		window->numSecondScans = numScans - window->numFirstScans;
+	}
+	window->triggerScan = capture->numPreScans;
+	capture->numWindows++;
+
+	// Re-arm, and look for the next trigger in the rest of the last read
+	capture->state = _CAPTURE_ARMED;
+	_EvaluatePreTriggerScans(capture);
+
+	return 1;
+}
+
+double CaptureWindowValue(const CaptureWindow * window, int numChannels,
+	int scanI, int channel)
+{
+	if (scanI < window->numFirstScans) {
+		return window->aFirstScans[(size_t)scanI * numChannels + channel];
+	}
+	return window->aSecondScans[
+		(size_t)(scanI - window->numFirstScans) * numChannels + channel];
+}
+
+void PrintPreTriggerCaptureStatistics(const PreTriggerCapture * capture)
+{
+	printf("PreTriggerCapture: %d reads, %d windows of %d pre-trigger and "
+		"%d post-trigger scans, ring of %d scans\n", capture->numReads,
+		capture->numWindows, capture->numPreScans, capture->numPostScans,
+		capture->ringScans);
+}
+
+#endif // #define LJM_STREAM_CAPTURE_UTILITIES
@@ -0,0 +1,435 @@
+/**
+ * Name: LJM_StreamSupervisor.h
+ * Desc: Provides a stream supervisor that keeps a stream running across
+ *       device disconnects. The supervisor remembers the stream configuration
+ *       (scan list, scan rate, STREAM_* and other configuration registers and
+ *       stream-out buffers). When LJM_eStreamRead fails, such as after a USB
+ *       cable is unplugged or an Ethernet connection drops, it waits for the
+ *       device to reconnect, re-applies the configuration and restarts stream,
+ *       then reports a gap with the measured outage duration so the data can
+ *       be marked as discontinuous.
+ * Note: LJM allows one reconnect callback per handle. If the application needs
+ *       its own reconnect callback, it should call
+ *       NotifyStreamSupervisorsOfReconnect from that callback.
+**/
+
+#ifndef LJM_STREAM_SUPERVISOR
+#define LJM_STREAM_SUPERVISOR
+
+#include "LJM_StreamUtilities.h"
+
+enum { MAX_SUPERVISOR_CHANNELS = 128 };
+enum { MAX_SUPERVISOR_CONFIG_WRITES = 64 };
+
+// The maximum number of StreamSupervisors that can be tracked for reconnects
+enum { MAX_STREAM_SUPERVISORS = 16 };
+
+// How long to wait between attempts to restart stream, unless the device
+// reconnects sooner
+enum { SUPERVISOR_RETRY_MS = 500 };
+
+// Returned by SupervisedStreamRead when stream was restarted after an outage.
+// aData is not filled; the next read returns the first scans after the gap.
+enum { STREAM_SUPERVISOR_GAP = -1 };
+
+// The address of STREAM_OUT0. STREAM_OUT1 is 4801, etc.
+enum { STREAM_SUPERVISOR_OUT0_ADDRESS = 4800 };
+
+/**
+ * A configuration register write that is re-applied before each stream
+ * start. If numValues is greater than 0, aValues is a copy of the values of an
+ * array write, such as to STREAM_OUT0_BUFFER_F32, and value is not used.
+**/
+typedef struct StreamConfigWrite {
+	char name[LJM_MAX_NAME_SIZE];
+	double value;
+	int numValues;
+	double * aValues;
+} StreamConfigWrite;
+
+/**
+ * A discontinuity in supervised stream data
+**/
+typedef struct StreamGap {
+	// From the last successful read to the restart of stream
+	double outageSeconds;
+
+	// Approximately how many scans were not collected during the outage
+	double numScansMissed;
+
+	// The error that started the outage
+	int error;
+
+	int numRestartAttempts;
+} StreamGap;
+
+typedef struct StreamSupervisor {
+	int handle;
+	int numChannels;
+	int aScanList[MAX_SUPERVISOR_CHANNELS];
+	double requestedScanRate;
+	int scansPerRead;
+	int resumeTimeoutMS;
+
+	int numConfigWrites;
+	StreamConfigWrite aConfigWrites[MAX_SUPERVISOR_CONFIG_WRITES];
+
+	// The scan rate of the current stream, as returned by LJM_eStreamStart
+	double scanRate;
+	int isStreaming;
+
+	// Set by the device reconnect callback, which runs in an LJM thread
+	volatile int reconnected;
+
+	LJM_LONG_LONG_RETURN lastReadTick;
+	StreamGap lastGap;
+
+	// Statistics
+	int numReads;
+	int numOutages;
+	int numRestarts;
+	double totalOutageSeconds;
+} StreamSupervisor;
+
+/**
+ * Desc: Initializes supervisor for a stream of handle and registers a device
+ *       reconnect callback for handle. Exits if numChannels is greater than
+ *       MAX_SUPERVISOR_CHANNELS or too many supervisors are in use.
+ * Para: resumeTimeoutMS, how long SupervisedStreamRead keeps trying to restart
+ *           stream after an outage before returning the error, or 0 to keep
+ *           trying indefinitely
+**/
+void InitStreamSupervisor(StreamSupervisor * supervisor, int handle,
+	int numChannels, const int * aScanList, double scanRate, int scansPerRead,
+	int resumeTimeoutMS);
+
+/**
+ * Desc: Frees the configuration of supervisor and stops tracking it for
+ *       reconnects. Call before the handle is closed or supervisor goes out of
+ *       scope.
+**/
+void CleanStreamSupervisor(StreamSupervisor * supervisor);
+
+/**
+ * Desc: Adds a configuration register write, such as STREAM_SETTLING_US or
+ *       AIN0_RANGE, to be applied before each stream start, in the order they
+ *       were added. Exits if MAX_SUPERVISOR_CONFIG_WRITES writes were added.
+**/
+void AddStreamConfigWrite(StreamSupervisor * supervisor, const char * name,
+	double value);
+
+/**
+ * Desc: Adds an array write of numValues values, which are copied, to be
+ *       applied before each stream start.
+**/
+void AddStreamConfigArrayWrite(StreamSupervisor * supervisor,
+	const char * name, int numValues, const double * aValues);
+
+/**
+ * Desc: Adds the configuration writes of a looping FLOAT32 stream-out of
+ *       aValues to targetName on STREAM_OUT#(streamOutIndex). The scan list
+ *       must include STREAM_SUPERVISOR_OUT0_ADDRESS + streamOutIndex.
+ * Retr: the LJM error code of resolving targetName
+**/
+int AddSupervisedStreamOut(StreamSupervisor * supervisor, int streamOutIndex,
+	const char * targetName, int bufferNumBytes, int numValues,
+	const double * aValues);
+
+/**
+ * Desc: Marks every StreamSupervisor of handle as reconnected so that a
+ *       waiting SupervisedStreamRead restarts stream immediately. This is the
+ *       device reconnect callback registered by InitStreamSupervisor.
+**/
+void NotifyStreamSupervisorsOfReconnect(int handle);
+
+/**
+ * Desc: Applies the configuration writes of supervisor and starts stream
+ * Retr: the LJM error code
+**/
+int StartSupervisedStream(StreamSupervisor * supervisor);
+
+/**
+ * Desc: Performs LJM_eStreamRead. If it fails with an error other than
+ *       LJME_NO_SCANS_RETURNED, waits for the device, restarts stream with the
+ *       configuration of supervisor and returns STREAM_SUPERVISOR_GAP with the
+ *       outage in supervisor->lastGap.
+ * Retr: LJME_NOERROR if aData was filled, STREAM_SUPERVISOR_GAP if stream was
+ *       restarted, or the LJM error code if stream could not be restarted
+ *       within resumeTimeoutMS
+**/
+int SupervisedStreamRead(StreamSupervisor * supervisor, double * aData,
+	int * deviceScanBacklog, int * LJMScanBacklog);
+
+/**
+ * Desc: Stops the stream of supervisor
+ * Retr: the LJM error code of LJM_eStreamStop
+**/
+int StopSupervisedStream(StreamSupervisor * supervisor);
+
+/**
+ * Desc: Prints the outages and restarts of supervisor
+**/
+void PrintStreamSupervisorStatistics(const StreamSupervisor * supervisor);
+
+
+// Source
+
+static StreamSupervisor * STREAM_SUPERVISORS[MAX_STREAM_SUPERVISORS] = {0};
+
+void InitStreamSupervisor(StreamSupervisor * supervisor, int handle,
+	int numChannels, const int * aScanList, double scanRate, int scansPerRead,
+	int resumeTimeoutMS)
+{
+	int i, err;
+
+	if (numChannels < 1 || numChannels > MAX_SUPERVISOR_CHANNELS) {
+		printf("InitStreamSupervisor: numChannels must be 1 to %d, not %d\n",
+			MAX_SUPERVISOR_CHANNELS, numChannels);
+		LJM_CloseAll();
+		exit(1);
+	}
+
+	memset(supervisor, 0, sizeof(StreamSupervisor));
+	supervisor->handle = handle;
+	supervisor->numChannels = numChannels;
+	memcpy(supervisor->aScanList, aScanList, sizeof(int) * numChannels);
+	supervisor->requestedScanRate = scanRate;
+	supervisor->scansPerRead = scansPerRead;
+	supervisor->resumeTimeoutMS = resumeTimeoutMS;
+
+	for (i = 0; i < MAX_STREAM_SUPERVISORS; i++) {
+		if (STREAM_SUPERVISORS[i] == NULL) {
+			STREAM_SUPERVISORS[i] = supervisor;
+			break;
+		}
+	}
+	if (i == MAX_STREAM_SUPERVISORS) {
+		printf("InitStreamSupervisor: more than %d supervisors are in use\n",
+			MAX_STREAM_SUPERVISORS);
+		LJM_CloseAll();
+		exit(1);
+	}
+
+	err = LJM_RegisterDeviceReconnectCallback(handle,
+		&NotifyStreamSupervisorsOfReconnect);
+	ErrorCheck(err,
+		"InitStreamSupervisor: LJM_RegisterDeviceReconnectCallback");
+}
+
+void CleanStreamSupervisor(StreamSupervisor * supervisor)
+{
+	int i;
+	for (i = 0; i < MAX_STREAM_SUPERVISORS; i++) {
+		if (STREAM_SUPERVISORS[i] == supervisor) {
+			STREAM_SUPERVISORS[i] = NULL;
+		}
+	}
+
+	for (i = 0; i < supervisor->numConfigWrites; i++) {
+		free(supervisor->aConfigWrites[i].aValues);
+	}
+	supervisor->numConfigWrites = 0;
+}
+
+// Returns the next unused StreamConfigWrite of supervisor
+StreamConfigWrite * _NewStreamConfigWrite(StreamSupervisor * supervisor,
+	const char * name)
+{
+	StreamConfigWrite * write;
+
+	if (supervisor->numConfigWrites == MAX_SUPERVISOR_CONFIG_WRITES) {
+		printf("StreamSupervisor: more than %d configuration writes\n",
+			MAX_SUPERVISOR_CONFIG_WRITES);
+		LJM_CloseAll();
+		exit(1);
+	}
+
+	write = &supervisor->aConfigWrites[supervisor->numConfigWrites++];
+	memset(write, 0, sizeof(StreamConfigWrite));
+	strncpy(write->name, name, LJM_MAX_NAME_SIZE - 1);
+	return write;
+}
+
+void AddStreamConfigWrite(StreamSupervisor * supervisor, const char * name,
+	double value)
+{
+	_NewStreamConfigWrite(supervisor, name)->value = value;
+}
+
+void AddStreamConfigArrayWrite(StreamSupervisor * supervisor,
+	const char * name, int numValues, const double * aValues)
+{
+	StreamConfigWrite * write = _NewStreamConfigWrite(supervisor, name);
+	write->numValues = numValues;
+	write->aValues = (double *)malloc(sizeof(double) * numValues);
+	if (write->aValues == NULL) {
+		printf("StreamSupervisor: could not allocate %d values for %s\n",
+			numValues, name);
+		LJM_CloseAll();
+		exit(1);
+	}
+	memcpy(write->aValues, aValues, sizeof(double) * numValues);
+}
+
+int AddSupervisedStreamOut(StreamSupervisor * supervisor, int streamOutIndex,
+	const char * targetName, int bufferNumBytes, int numValues,
+	const double * aValues)
+{
+	int targetAddress;
+	char name[LJM_MAX_NAME_SIZE];
+
+	int err = LJM_NameToAddress(targetName, &targetAddress, NULL);
+	PrintErrorIfError(err, "AddSupervisedStreamOut: LJM_NameToAddress(%s)",
+		targetName);
+	if (err != LJME_NOERROR) {
+		return err;
+	}
+
+	sprintf(name, "STREAM_OUT%d_TARGET", streamOutIndex);
+	AddStreamConfigWrite(supervisor, name, targetAddress);
+	sprintf(name, "STREAM_OUT%d_BUFFER_ALLOCATE_NUM_BYTES", streamOutIndex);
+	AddStreamConfigWrite(supervisor, name, bufferNumBytes);
+	sprintf(name, "STREAM_OUT%d_ENABLE", streamOutIndex);
+	AddStreamConfigWrite(supervisor, name, 1);
+	sprintf(name, "STREAM_OUT%d_BUFFER_F32", streamOutIndex);
+	AddStreamConfigArrayWrite(supervisor, name, numValues, aValues);
+	sprintf(name, "STREAM_OUT%d_LOOP_NUM_VALUES", streamOutIndex);
+	AddStreamConfigWrite(supervisor, name, numValues);
+	sprintf(name, "STREAM_OUT%d_SET_LOOP", streamOutIndex);
+	AddStreamConfigWrite(supervisor, name, SET_LOOP_USE_NEW_DATA_IMMEDIATELY);
+
+	return LJME_NOERROR;
+}
+
+void NotifyStreamSupervisorsOfReconnect(int handle)
+{
+	int i;
+	for (i = 0; i < MAX_STREAM_SUPERVISORS; i++) {
+		if (STREAM_SUPERVISORS[i] != NULL &&
+			STREAM_SUPERVISORS[i]->handle == handle)
+		{
+			STREAM_SUPERVISORS[i]->reconnected = 1;
+		}
+	}
+}
+
+int StartSupervisedStream(StreamSupervisor * supervisor)
+{
+	int i, err;
+	int errorAddress = INITIAL_ERR_ADDRESS;
+	const StreamConfigWrite * write;
+
+	for (i = 0; i < supervisor->numConfigWrites; i++) {
+		write = &supervisor->aConfigWrites[i];
+		if (write->numValues > 0) {
+			err = LJM_eWriteNameArray(supervisor->handle, write->name,
+				write->numValues, write->aValues, &errorAddress);
+		}
+		else {
+			err = LJM_eWriteName(supervisor->handle, write->name,
+				write->value);
+		}
+		if (err != LJME_NOERROR) {
+			return err;
+		}
+	}
+
+	supervisor->scanRate = supervisor->requestedScanRate;
+	err = LJM_eStreamStart(supervisor->handle, supervisor->scansPerRead,
+		supervisor->numChannels, supervisor->aScanList, &supervisor->scanRate);
+	if (err != LJME_NOERROR) {
+		return err;
+	}
+
+	supervisor->isStreaming = 1;
+	supervisor->lastReadTick = LJM_GetHostTick();
+	return LJME_NOERROR;
+}
+
+// Restarts stream after an outage that started at outageStart.
+// Returns STREAM_SUPERVISOR_GAP, or the last error after resumeTimeoutMS.
+int _ResumeSupervisedStream(StreamSupervisor * supervisor,
+	LJM_LONG_LONG_RETURN outageStart)
+{
+	int err, waitedMS;
+	LJM_LONG_LONG_RETURN resumeStart = LJM_GetHostTick();
+	LJM_LONG_LONG_RETURN now;
+
+	for (;;) {
+		supervisor->reconnected = 0;
+		supervisor->lastGap.numRestartAttempts++;
+
+		// Stream may still be running if the device did not disconnect
+		LJM_eStreamStop(supervisor->handle);
+
+		err = StartSupervisedStream(supervisor);
+		if (err == LJME_NOERROR) {
+			break;
+		}
+
+		now = LJM_GetHostTick();
+		if (supervisor->resumeTimeoutMS > 0 &&
+			(now - resumeStart) / 1000 >= supervisor->resumeTimeoutMS)
+		{
+			return err;
+		}
+
+		for (waitedMS = 0; waitedMS < SUPERVISOR_RETRY_MS &&
+			!supervisor->reconnected; waitedMS += 10)
+		{
+			MillisecondSleep(10);
+		}
+	}
+
+	// StartSupervisedStream set lastReadTick to the restart
+	supervisor->lastGap.outageSeconds =
+		(supervisor->lastReadTick - outageStart) / 1000000.0;
+	supervisor->lastGap.numScansMissed =
+		supervisor->lastGap.outageSeconds * supervisor->scanRate;
+	supervisor->numRestarts++;
+	supervisor->totalOutageSeconds += supervisor->lastGap.outageSeconds;
+
+	return STREAM_SUPERVISOR_GAP;
+}
+
+int SupervisedStreamRead(StreamSupervisor * supervisor, double * aData,
+	int * deviceScanBacklog, int * LJMScanBacklog)
+{
+	int err = LJM_eStreamRead(supervisor->handle, aData, deviceScanBacklog,
+		LJMScanBacklog);
+	supervisor->numReads++;
+
+	if (err == LJME_NOERROR) {
+		supervisor->lastReadTick = LJM_GetHostTick();
+		return LJME_NOERROR;
+	}
+	if (err == LJME_NO_SCANS_RETURNED) {
+		return err;
+	}
+
+	PrintErrorIfError(err,
+		"SupervisedStreamRead: LJM_eStreamRead(Handle=%d), restarting stream",
+		supervisor->handle);
+	supervisor->isStreaming = 0;
+	supervisor->numOutages++;
+	memset(&supervisor->lastGap, 0, sizeof(StreamGap));
+	supervisor->lastGap.error = err;
+
+	return _ResumeSupervisedStream(supervisor, supervisor->lastReadTick);
+}
+
+int StopSupervisedStream(StreamSupervisor * supervisor)
+{
+	supervisor->isStreaming = 0;
+	return LJM_eStreamStop(supervisor->handle);
+}
+
+void PrintStreamSupervisorStatistics(const StreamSupervisor * supervisor)
+{
+	printf("Stream supervisor for handle %d: %d reads, %d outages, "
+		"%d restarts, %.3f s total outage\n", supervisor->handle,
+		supervisor->numReads, supervisor->numOutages, supervisor->numRestarts,
+		supervisor->totalOutageSeconds);
+}
+
+#endif // #define LJM_STREAM_SUPERVISOR
@@ -91,6 +91,218 @@ void SetupExternalClockStream(int handle);
 **/
 void EnableFIO0PulseOut(int handle, int pulseRate, int numPulses);
 
+// ExternalClockMonitor status bits
+enum { CLOCK_STATUS_OK = 0 };
+enum { CLOCK_STATUS_DROPOUT = 0x1 };
+enum { CLOCK_STATUS_DRIFT = 0x2 };
+
+// The number of reads the clock rate regression approximately averages over
+enum { CLOCK_MONITOR_REGRESSION_READS = 50 };
+
+// The number of reads with scans before the clock rate is estimated
+enum { CLOCK_MONITOR_MIN_READS = 8 };
+
+/**
+ * Watches the clock of an externally clocked stream. Each LJM_eStreamRead is
+ * timestamped with LJM_GetHostTick, and the external clock rate is estimated
+ * with a running least-squares regression of the number of scans the device
+ * has collected against host time, so that a dead or drifting clock is
+ * noticed while streaming instead of only by empty reads.
+**/
+typedef struct ExternalClockMonitor {
+	double expectedScanRate;
+	double rateTolerance;
+	double dropoutSeconds;
+
+	// The scans read, and the scans collected by the device, which includes
+	// the backlogs of the last read
+	double numScansRead;
+	double numScansCollected;
+	LJM_LONG_LONG_RETURN lastProgressTick;
+	int hasStarted;
+
+	// The regression of numScansCollected against seconds since
+	// regressionStartTick, weighted to favor recent reads
+	LJM_LONG_LONG_RETURN regressionStartTick;
+	double regressionStartScans;
+	double sumWeights;
+	double sumT;
+	double sumS;
+	double sumTT;
+	double sumTS;
+	int numRegressionReads;
+
+	// The current estimate in Hz, or 0 until CLOCK_MONITOR_MIN_READS reads
+	// with scans
+	double estimatedScanRate;
+
+	// A bitmask of CLOCK_STATUS_DROPOUT and CLOCK_STATUS_DRIFT
+	int status;
+
+	// Counters
+	int numReads;
+	int numEmptyReads;
+	int numDropouts;
+	int numDriftEvents;
+	double longestDropoutSeconds;
+} ExternalClockMonitor;
+
+/**
+ * Desc: Initializes monitor for a stream whose external clock should run at
+ *       expectedScanRate scans per second.
+ * Para: rateTolerance, the fraction the estimated rate may differ from
+ *           expectedScanRate before CLOCK_STATUS_DRIFT is set, e.g. 0.02
+ *       dropoutSeconds, how long the device may collect no scans before
+ *           CLOCK_STATUS_DROPOUT is set
+**/
+void InitExternalClockMonitor(ExternalClockMonitor * monitor,
+	double expectedScanRate, double rateTolerance, double dropoutSeconds);
+
+/**
+ * Desc: Updates monitor with the result of one stream read at hostTick.
+ *       Callers that do not read with ExternalClockStreamRead, such as stream
+ *       callbacks, may call this after each LJM_eStreamRead.
+ * Para: numScans, the number of scans the read returned, which is 0 for
+ *           LJME_NO_SCANS_RETURNED
+ *       deviceScanBacklog, LJMScanBacklog, the backlogs of the read
+**/
+void UpdateExternalClockMonitor(ExternalClockMonitor * monitor, int numScans,
+	int deviceScanBacklog, int LJMScanBacklog, LJM_LONG_LONG_RETURN hostTick);
+
+/**
+ * Desc: Performs LJM_eStreamRead of scansPerRead scans and updates monitor.
+ *       Check monitor->status after each read.
+ * Retr: the LJM error code of LJM_eStreamRead. LJME_NO_SCANS_RETURNED updates
+ *       monitor as a read with no scans. Other errors do not update monitor.
+**/
+int ExternalClockStreamRead(ExternalClockMonitor * monitor, int handle,
+	int scansPerRead, double * aData, int * deviceScanBacklog,
+	int * LJMScanBacklog);
+
+/**
+ * Desc: Prints the estimated clock rate, status and counters of monitor
+**/
+void PrintExternalClockMonitorStatistics(const ExternalClockMonitor * monitor);
+
+enum { MAX_PLANNED_CHANNELS = 128 };
+
+// aRequestBits value of a request for a whole channel value
+enum { PLAN_WHOLE_VALUE = -1 };
+
+// Returned by PlanStreamScanList and TestStreamPlan when memory could not be
+// allocated
+enum { STREAM_PLAN_OUT_OF_MEMORY = -1 };
+
+/**
+ * A channel to stream, as requested of PlanStreamScanList.
+ * name: any streamable register name, or a single DIO line such as "FIO3",
+ *     "EIO0" or "DIO17", which is read as a bit of its DIO state register
+ * range: the AIN range in volts (T7 and T8), or 0 for the default
+ * resolutionIndex: the resolution index the channel needs, or 0 for the
+ *     default. Stream has one resolution index, so the highest is used.
+**/
+typedef struct StreamChannelRequest {
+	const char * name;
+	double range;
+	int resolutionIndex;
+} StreamChannelRequest;
+
+/**
+ * A scan list planned by PlanStreamScanList. Analog inputs come first,
+ * grouped by range so that the range changes as few times per scan as
+ * possible, then the DIO state registers, then the other channels in their
+ * requested order. Other channels are neither reordered nor merged because
+ * STREAM_DATA_CAPTURE_16 must follow the register it captures.
+**/
+typedef struct StreamPlan {
+	int deviceType;
+	int resolutionIndex;
+
+	int numChannels;
+	int aScanList[MAX_PLANNED_CHANNELS];
+	char aNames[MAX_PLANNED_CHANNELS][LJM_MAX_NAME_SIZE];
+	int aIsAIN[MAX_PLANNED_CHANNELS];
+	double aRanges[MAX_PLANNED_CHANNELS];
+
+	// For each request, the index of its channel in aScanList, and its bit
+	// of a DIO state register or PLAN_WHOLE_VALUE
+	int numRequests;
+	int aRequestChannels[MAX_PLANNED_CHANNELS];
+	int aRequestBits[MAX_PLANNED_CHANNELS];
+
+	// The predicted maximum scan rates of the plan and of the requests as
+	// written, with one scan list entry per request
+	double predictedScanRate;
+	double predictedRequestedScanRate;
+
+	int numMergedRequests;
+	int numRangeChanges;
+	int numRequestedRangeChanges;
+} StreamPlan;
+
+/**
+ * The result of TestStreamPlan
+**/
+typedef struct StreamPlanResult {
+	double requestedScanRate;
+
+	// The scan rate LJM_eStreamStart returned
+	double actualScanRate;
+
+	// The scan rate measured from the scans collected over host time
+	double measuredScanRate;
+
+	int maxDeviceScanBacklog;
+	int maxLJMScanBacklog;
+	int numSkippedScans;
+	int err;
+} StreamPlanResult;
+
+/**
+ * Desc: Plans the scan list of numRequests channels for deviceType (LJM_dtT4,
+ *       LJM_dtT7 or LJM_dtT8) and predicts its maximum scan rate. Duplicate
+ *       analog inputs are streamed once, and DIO lines and DIO state
+ *       registers are merged into one read of each DIO state register.
+ * Retr: the LJM error code of resolving a request's name,
+ *       LJME_INVALID_NAME for a DIO line that does not exist, such as CIO4,
+ *       or STREAM_PLAN_OUT_OF_MEMORY
+ * Note: The predictions use approximate per-sample times of the device
+ *       datasheets. Use TestStreamPlan to compare them to the device.
+**/
+int PlanStreamScanList(int deviceType, int numRequests,
+	const StreamChannelRequest * aRequests, StreamPlan * plan);
+
+/**
+ * Desc: Writes STREAM_RESOLUTION_INDEX, STREAM_SETTLING_US (automatic) and
+ *       the AIN#_RANGE of each analog input with a range of plan with one
+ *       LJM_eWriteAddresses call.
+ * Retr: the LJM error code
+**/
+int ConfigureStreamPlan(int handle, const StreamPlan * plan);
+
+/**
+ * Desc: Returns the value of request requestI of plan from aScan, one scan of
+ *       the stream of plan->aScanList. The value of a DIO line is 0 or 1.
+**/
+double PlannedRequestValue(const StreamPlan * plan, const double * aScan,
+	int requestI);
+
+/**
+ * Desc: Streams plan at scanRate for numReads reads of scansPerRead scans
+ *       and measures the scan rate the device sustains.
+ * Retr: the LJM error code or STREAM_PLAN_OUT_OF_MEMORY, which is also
+ *       result->err
+**/
+int TestStreamPlan(int handle, const StreamPlan * plan, double scanRate,
+	int scansPerRead, int numReads, StreamPlanResult * result);
+
+/**
+ * Desc: Prints the scan list of plan with its predicted scan rates, and the
+ *       actual and measured scan rates of result if it is not NULL.
+**/
+void PrintStreamPlanReport(const StreamPlan * plan,
+	const StreamPlanResult * result);
+
 /**
  * Does a printf of the message then outputs the text to the debug
  * logger. Requires C99 or later standard and LABJACK_DEBUG_LOG_OUTPUT must be
@@ -296,6 +508,667 @@ void EnableFIO0PulseOut(int handle, int pulseRate, int numPulses)
 	WriteNameOrDie(handle, "DIO0_EF_ENABLE", 1);
 }
 
+void InitExternalClockMonitor(ExternalClockMonitor * monitor,
+	double expectedScanRate, double rateTolerance, double dropoutSeconds)
+{
+	memset(monitor, 0, sizeof(ExternalClockMonitor));
+	monitor->expectedScanRate = expectedScanRate;
+	monitor->rateTolerance = rateTolerance;
+	monitor->dropoutSeconds = dropoutSeconds;
+}
+
+void _ResetExternalClockRegression(ExternalClockMonitor * monitor,
+	LJM_LONG_LONG_RETURN hostTick)
+{
+	monitor->regressionStartTick = hostTick;
+	monitor->regressionStartScans = monitor->numScansCollected;
+	monitor->sumWeights = 0;
+	monitor->sumT = 0;
+	monitor->sumS = 0;
+	monitor->sumTT = 0;
+	monitor->sumTS = 0;
+	monitor->numRegressionReads = 0;
+}
+
+void UpdateExternalClockMonitor(ExternalClockMonitor * monitor, int numScans,
+	int deviceScanBacklog, int LJMScanBacklog, LJM_LONG_LONG_RETURN hostTick)
+{
+	double collected, t, s, denominator, outageSeconds, error;
+	const double DECAY = 1 - 1.0 / CLOCK_MONITOR_REGRESSION_READS;
+
+	monitor->numReads++;
+	if (numScans == 0) {
+		monitor->numEmptyReads++;
+	}
+
+	// The scans the device has collected so far. Scans in the backlogs
+	// were collected before this read returned, so counting them keeps a
+	// read of buffered scans from looking like a burst of clock pulses.
+	monitor->numScansRead += numScans;
+	collected = monitor->numScansRead + deviceScanBacklog + LJMScanBacklog;
+
+	if (!monitor->hasStarted) {
+		monitor->hasStarted = 1;
+		monitor->numScansCollected = collected;
+		monitor->lastProgressTick = hostTick;
+		_ResetExternalClockRegression(monitor, hostTick);
+	}
+
+	if (collected <= monitor->numScansCollected) {
+		outageSeconds = (hostTick - monitor->lastProgressTick) / 1000000.0;
+		if (outageSeconds > monitor->dropoutSeconds &&
+			!(monitor->status & CLOCK_STATUS_DROPOUT))
+		{
+			monitor->status |= CLOCK_STATUS_DROPOUT;
+			monitor->numDropouts++;
+		}
+		if ((monitor->status & CLOCK_STATUS_DROPOUT) &&
+			outageSeconds > monitor->longestDropoutSeconds)
+		{
+			monitor->longestDropoutSeconds = outageSeconds;
+		}
+		return;
+	}
+
+	// The clock has resumed. The scan count jumps across a dropout, so the
+	// regression restarts.
+	monitor->numScansCollected = collected;
+	if (monitor->status & CLOCK_STATUS_DROPOUT) {
+		monitor->status &= ~CLOCK_STATUS_DROPOUT;
+		_ResetExternalClockRegression(monitor, hostTick);
+	}
+	monitor->lastProgressTick = hostTick;
+
+	t = (hostTick - monitor->regressionStartTick) / 1000000.0;
+	s = collected - monitor->regressionStartScans;
+	monitor->sumWeights = monitor->sumWeights * DECAY + 1;
+	monitor->sumT = monitor->sumT * DECAY + t;
+	monitor->sumS = monitor->sumS * DECAY + s;
+	monitor->sumTT = monitor->sumTT * DECAY + t * t;
+	monitor->sumTS = monitor->sumTS * DECAY + t * s;
+	monitor->numRegressionReads++;
+
+	if (monitor->numRegressionReads < CLOCK_MONITOR_MIN_READS) {
+		return;
+	}
+
+	denominator = monitor->sumWeights * monitor->sumTT -
+		monitor->sumT * monitor->sumT;
+	if (denominator <= 0) {
+		return;
+	}
+	monitor->estimatedScanRate = (monitor->sumWeights * monitor->sumTS -
+		monitor->sumT * monitor->sumS) / denominator;
+
+	error = (monitor->estimatedScanRate - monitor->expectedScanRate) /
+		monitor->expectedScanRate;
+	if (error < 0) {
+		error = -error;
+	}
+	if (error > monitor->rateTolerance) {
+		if (!(monitor->status & CLOCK_STATUS_DRIFT)) {
+			monitor->status |= CLOCK_STATUS_DRIFT;
+			monitor->numDriftEvents++;
+		}
+	}
+	else {
+		monitor->status &= ~CLOCK_STATUS_DRIFT;
+	}
+}
+
+int ExternalClockStreamRead(ExternalClockMonitor * monitor, int handle,
+	int scansPerRead, double * aData, int * deviceScanBacklog,
+	int * LJMScanBacklog)
+{
+	int err = LJM_eStreamRead(handle, aData, deviceScanBacklog,
+		LJMScanBacklog);
+	LJM_LONG_LONG_RETURN hostTick = LJM_GetHostTick();
+
+	if (err == LJME_NOERROR) {
+		UpdateExternalClockMonitor(monitor, scansPerRead, *deviceScanBacklog,
+			*LJMScanBacklog, hostTick);
+	}
+	else if (err == LJME_NO_SCANS_RETURNED) {
+		UpdateExternalClockMonitor(monitor, 0, *deviceScanBacklog,
+			*LJMScanBacklog, hostTick);
+	}
+
+	return err;
+}
+
+void PrintExternalClockMonitorStatistics(const ExternalClockMonitor * monitor)
+{
+	printf("External clock: estimated %.02f Hz (expected %.02f Hz)%s%s\n",
+		monitor->estimatedScanRate, monitor->expectedScanRate,
+		(monitor->status & CLOCK_STATUS_DROPOUT) ? ", dropout" : "",
+		(monitor->status & CLOCK_STATUS_DRIFT) ? ", drift" : "");
+	printf("    %d reads, %d empty reads, %.0f scans read\n",
+		monitor->numReads, monitor->numEmptyReads, monitor->numScansRead);
+	printf("    %d dropouts (longest %.3f s), %d drift events\n",
+		monitor->numDropouts, monitor->longestDropoutSeconds,
+		monitor->numDriftEvents);
+}
+
+// Approximate maximum stream sample rates of the T4 and T7 at the widest
+// range, and scan rates of the T8, whose analog inputs are sampled
+// simultaneously, by resolution index starting at 1
+static const double T4_MAX_SAMPLE_RATES[] = {40000, 20000, 10000, 5000, 2500};
+static const double T7_MAX_SAMPLE_RATES[] =
+	{100000, 48000, 22000, 11000, 5500, 2500, 1200, 600};
+static const double T8_MAX_SCAN_RATES[] =
+	{40000, 20000, 10000, 5000, 2500, 1250, 625, 312};
+
+// Approximate time of a stream sample that is not an analog input
+static const double T4_DIGITAL_SAMPLE_US = 25;
+static const double T7_DIGITAL_SAMPLE_US = 10;
+static const double T8_DIGITAL_SAMPLE_US = 3;
+
+// Approximate extra settling time of the T7's +/-0.1 V and +/-0.01 V ranges,
+// and of a sample whose range differs from the previous sample's
+static const double T7_RANGE_0_1_SETTLING_US = 15;
+static const double T7_RANGE_0_01_SETTLING_US = 90;
+static const double T7_RANGE_CHANGE_US = 10;
+
+static const char * PLAN_DIO_STATE_NAMES[] =
+	{"FIO_STATE", "EIO_STATE", "CIO_STATE", "MIO_STATE"};
+static const char * PLAN_DIO_LINE_PREFIXES[] = {"FIO", "EIO", "CIO", "MIO"};
+static const int PLAN_DIO_LINES_PER_STATE_REGISTER[] = {8, 8, 4, 3};
+enum { PLAN_NUM_DIO_STATE_REGISTERS = 4 };
+
+// Returned by _PlanDIOStateRegister for a DIO line that does not exist
+enum { PLAN_INVALID_DIO_LINE = -2 };
+
+// If name is a DIO state register or a DIO line (FIO#, EIO#, CIO#, MIO# or
+// DIO#), returns the index of its state register in PLAN_DIO_STATE_NAMES and
+// sets bit, which is PLAN_WHOLE_VALUE for a state register. Returns
+// PLAN_INVALID_DIO_LINE for a line past the last of its state register, such
+// as CIO4, and -1 if name is not a DIO line or state register.
+int _PlanDIOStateRegister(const char * name, int * bit)
+{
+	int i, line, length;
+
+	for (i = 0; i < PLAN_NUM_DIO_STATE_REGISTERS; i++) {
+		if (strcmp(name, PLAN_DIO_STATE_NAMES[i]) == 0) {
+			*bit = PLAN_WHOLE_VALUE;
+			return i;
+		}
+	}
+
+	for (i = 0; i < PLAN_NUM_DIO_STATE_REGISTERS; i++) {
+		if (strncmp(name, PLAN_DIO_LINE_PREFIXES[i], 3) == 0 &&
+			sscanf(name + 3, "%d%n", &line, &length) == 1 &&
+			name[3 + length] == '\0' && line >= 0)
+		{
+			if (line >= PLAN_DIO_LINES_PER_STATE_REGISTER[i]) {
+				return PLAN_INVALID_DIO_LINE;
+			}
+			*bit = line;
+			return i;
+		}
+	}
+
+	// DIO# numbers the lines of all state registers in order: FIO0 is DIO0,
+	// EIO0 is DIO8, CIO0 is DIO16 and MIO0 is DIO20
+	if (strncmp(name, "DIO", 3) == 0 &&
+		sscanf(name + 3, "%d%n", &line, &length) == 1 &&
+		name[3 + length] == '\0' && line >= 0)
+	{
+		for (i = 0; i < PLAN_NUM_DIO_STATE_REGISTERS; i++) {
+			if (line < PLAN_DIO_LINES_PER_STATE_REGISTER[i]) {
+				*bit = line;
+				return i;
+			}
+			line -= PLAN_DIO_LINES_PER_STATE_REGISTER[i];
+		}
+		return PLAN_INVALID_DIO_LINE;
+	}
+
+	return -1;
+}
+
+// Returns the approximate time of one analog input sample at
+// resolutionIndex, not including range settling
+double _PlanAINSampleMicroseconds(int deviceType, int resolutionIndex)
+{
+	const double * aRates = T7_MAX_SAMPLE_RATES;
+	int numRates = sizeof(T7_MAX_SAMPLE_RATES) / sizeof(double);
+
+	if (deviceType == LJM_dtT4) {
+		aRates = T4_MAX_SAMPLE_RATES;
+		numRates = sizeof(T4_MAX_SAMPLE_RATES) / sizeof(double);
+	}
+
+	if (resolutionIndex < 1) {
+		resolutionIndex = 1;
+	}
+	if (resolutionIndex > numRates) {
+		resolutionIndex = numRates;
+	}
+	return 1000000 / aRates[resolutionIndex - 1];
+}
+
+// Returns the predicted time of one scan of numEntries scan list entries in
+// microseconds, and counts the range changes of each scan, including the
+// change from the last analog input of one scan to the first of the next
+double _PredictScanMicroseconds(int deviceType, int resolutionIndex,
+	int numEntries, const int * aIsAIN, const double * aRanges,
+	int * numRangeChanges)
+{
+	int i;
+	int numAIN = 0;
+	int numRates = sizeof(T8_MAX_SCAN_RATES) / sizeof(double);
+	double scanUS = 0;
+	double lastRange = 0;
+	double digitalUS = T7_DIGITAL_SAMPLE_US;
+
+	if (deviceType == LJM_dtT4) {
+		digitalUS = T4_DIGITAL_SAMPLE_US;
+	}
+	else if (deviceType == LJM_dtT8) {
+		digitalUS = T8_DIGITAL_SAMPLE_US;
+	}
+
+	for (i = numEntries - 1; i >= 0; i--) {
+		if (aIsAIN[i]) {
+			lastRange = aRanges[i];
+			break;
+		}
+	}
+
+	*numRangeChanges = 0;
+	for (i = 0; i < numEntries; i++) {
+		if (!aIsAIN[i]) {
+			scanUS += digitalUS;
+			continue;
+		}
+
+		numAIN++;
+		if (aRanges[i] != lastRange) {
+			++*numRangeChanges;
+		}
+
+		if (deviceType == LJM_dtT7) {
+			scanUS += _PlanAINSampleMicroseconds(deviceType, resolutionIndex);
+			if (aRanges[i] <= 0.01) {
+				scanUS += T7_RANGE_0_01_SETTLING_US;
+			}
+			else if (aRanges[i] <= 0.1) {
+				scanUS += T7_RANGE_0_1_SETTLING_US;
+			}
+			if (aRanges[i] != lastRange) {
+				scanUS += T7_RANGE_CHANGE_US;
+			}
+		}
+		else if (deviceType == LJM_dtT4) {
+			scanUS += _PlanAINSampleMicroseconds(deviceType, resolutionIndex);
+		}
+
+		lastRange = aRanges[i];
+	}
+
+	// The T8 samples every analog input at once
+	if (deviceType == LJM_dtT8 && numAIN > 0) {
+		if (resolutionIndex < 1) {
+			resolutionIndex = 1;
+		}
+		if (resolutionIndex > numRates) {
+			resolutionIndex = numRates;
+		}
+		scanUS += 1000000 / T8_MAX_SCAN_RATES[resolutionIndex - 1];
+	}
+
+	return scanUS;
+}
+
+// Returns the index of the channel of plan with address, or -1
+int _FindPlannedChannel(const StreamPlan * plan, int address)
+{
+	int i;
+	for (i = 0; i < plan->numChannels; i++) {
+		if (plan->aScanList[i] == address) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+// Orders the channels of plan: analog inputs by descending range, keeping
+// their requested order within a range, then DIO state registers by address,
+// then the other channels in their requested order. Returns LJME_NOERROR or
+// STREAM_PLAN_OUT_OF_MEMORY.
+int _OrderPlannedChannels(StreamPlan * plan, int numDIOStateChannels,
+	const int * aIsDIOState)
+{
+	int i, j, numOrdered, channel;
+	int aOrder[MAX_PLANNED_CHANNELS];
+	int aNewIndexes[MAX_PLANNED_CHANNELS];
+	StreamPlan * unordered = (StreamPlan *)malloc(sizeof(StreamPlan));
+
+	if (unordered == NULL) {
+		return STREAM_PLAN_OUT_OF_MEMORY;
+	}
+	memcpy(unordered, plan, sizeof(StreamPlan));
+
+	numOrdered = 0;
+	for (i = 0; i < plan->numChannels; i++) {
+		if (!plan->aIsAIN[i]) {
+			continue;
+		}
+		// Insert after the analog inputs whose range is at least as wide
+		for (j = numOrdered; j > 0 &&
+			plan->aRanges[aOrder[j - 1]] < plan->aRanges[i]; j--)
+		{
+			aOrder[j] = aOrder[j - 1];
+		}
+		aOrder[j] = i;
+		numOrdered++;
+	}
+	for (i = 0; i < plan->numChannels && numDIOStateChannels > 0; i++) {
+		if (!aIsDIOState[i]) {
+			continue;
+		}
+		for (j = numOrdered; j > 0 && aIsDIOState[aOrder[j - 1]] &&
+			plan->aScanList[aOrder[j - 1]] > plan->aScanList[i]; j--)
+		{
+			aOrder[j] = aOrder[j - 1];
+		}
+		aOrder[j] = i;
+		numOrdered++;
+	}
+	for (i = 0; i < plan->numChannels; i++) {
+		if (!plan->aIsAIN[i] && !aIsDIOState[i]) {
+			aOrder[numOrdered++] = i;
+		}
+	}
+
+	for (i = 0; i < plan->numChannels; i++) {
+		channel = aOrder[i];
+		aNewIndexes[channel] = i;
+		plan->aScanList[i] = unordered->aScanList[channel];
+		strcpy(plan->aNames[i], unordered->aNames[channel]);
+		plan->aIsAIN[i] = unordered->aIsAIN[channel];
+		plan->aRanges[i] = unordered->aRanges[channel];
+	}
+	for (i = 0; i < plan->numRequests; i++) {
+		plan->aRequestChannels[i] = aNewIndexes[plan->aRequestChannels[i]];
+	}
+
+	free(unordered);
+	return LJME_NOERROR;
+}
+
+int PlanStreamScanList(int deviceType, int numRequests,
+	const StreamChannelRequest * aRequests, StreamPlan * plan)
+{
+	int i, err, address, type, channel, stateRegister, bit;
+	int numDIOStateChannels = 0;
+	int aIsDIOState[MAX_PLANNED_CHANNELS];
+	int aRequestIsAIN[MAX_PLANNED_CHANNELS];
+	double aRequestRanges[MAX_PLANNED_CHANNELS];
+	double range, scanUS;
+	const char * name;
+
+	if (numRequests < 1 || numRequests > MAX_PLANNED_CHANNELS) {
+		printf("PlanStreamScanList: numRequests must be 1 to %d, not %d\n",
+			MAX_PLANNED_CHANNELS, numRequests);
+		LJM_CloseAll();
+		exit(1);
+	}
+
+	memset(plan, 0, sizeof(StreamPlan));
+	plan->deviceType = deviceType;
+	plan->numRequests = numRequests;
+
+	for (i = 0; i < numRequests; i++) {
+		if (aRequests[i].resolutionIndex > plan->resolutionIndex) {
+			plan->resolutionIndex = aRequests[i].resolutionIndex;
+		}
+
+		bit = PLAN_WHOLE_VALUE;
+		stateRegister = _PlanDIOStateRegister(aRequests[i].name, &bit);
+		if (stateRegister == PLAN_INVALID_DIO_LINE) {
+			printf("PlanStreamScanList: %s is not a DIO line\n",
+				aRequests[i].name);
+			return LJME_INVALID_NAME;
+		}
+		name = (stateRegister >= 0) ? PLAN_DIO_STATE_NAMES[stateRegister] :
+			aRequests[i].name;
+		err = LJM_NameToAddress(name, &address, &type);
+		PrintErrorIfError(err, "PlanStreamScanList: LJM_NameToAddress(%s)",
+			name);
+		if (err != LJME_NOERROR) {
+			return err;
+		}
+
+		// AIN# is at address 2 * #. The T4 has fixed ranges, and the widest
+		// range is the default of the T7 and T8.
+		aRequestIsAIN[i] = (address < 1000 && strncmp(name, "AIN", 3) == 0);
+		range = aRequests[i].range;
+		if (!aRequestIsAIN[i] || deviceType == LJM_dtT4) {
+			range = 0;
+		}
+		else if (range <= 0) {
+			range = 10;
+		}
+		aRequestRanges[i] = range;
+
+		channel = -1;
+		if (aRequestIsAIN[i] || stateRegister >= 0) {
+			channel = _FindPlannedChannel(plan, address);
+		}
+		if (channel >= 0) {
+			// Use the widest range requested so no request is clipped
+			if (range > plan->aRanges[channel]) {
+				plan->aRanges[channel] = range;
+			}
+			plan->numMergedRequests++;
+		}
+		else {
+			channel = plan->numChannels++;
+			plan->aScanList[channel] = address;
+			strncpy(plan->aNames[channel], name, LJM_MAX_NAME_SIZE - 1);
+			plan->aIsAIN[channel] = aRequestIsAIN[i];
+			plan->aRanges[channel] = range;
+			aIsDIOState[channel] = (stateRegister >= 0);
+			if (stateRegister >= 0) {
+				numDIOStateChannels++;
+			}
+		}
+
+		plan->aRequestChannels[i] = channel;
+		plan->aRequestBits[i] = bit;
+	}
+
+	err = _OrderPlannedChannels(plan, numDIOStateChannels, aIsDIOState);
+	if (err != LJME_NOERROR) {
+		printf("PlanStreamScanList: could not allocate the plan\n");
+		return err;
+	}
+
+	scanUS = _PredictScanMicroseconds(deviceType, plan->resolutionIndex,
+		plan->numChannels, plan->aIsAIN, plan->aRanges,
+		&plan->numRangeChanges);
+	plan->predictedScanRate = 1000000 / scanUS;
+
+	scanUS = _PredictScanMicroseconds(deviceType, plan->resolutionIndex,
+		numRequests, aRequestIsAIN, aRequestRanges,
+		&plan->numRequestedRangeChanges);
+	plan->predictedRequestedScanRate = 1000000 / scanUS;
+
+	return LJME_NOERROR;
+}
+
+int ConfigureStreamPlan(int handle, const StreamPlan * plan)
+{
+	int i, err;
+	int numFrames = 0;
+	int errorAddress = INITIAL_ERR_ADDRESS;
+	int aAddresses[MAX_PLANNED_CHANNELS + 2];
+	int aTypes[MAX_PLANNED_CHANNELS + 2];
+	double aValues[MAX_PLANNED_CHANNELS + 2];
+	// Room for the longest channel name and "_RANGE"
+	char name[LJM_MAX_NAME_SIZE + 8];
+
+	err = LJM_NameToAddress("STREAM_RESOLUTION_INDEX", &aAddresses[numFrames],
+		&aTypes[numFrames]);
+	aValues[numFrames++] = plan->resolutionIndex;
+	if (err == LJME_NOERROR) {
+		err = LJM_NameToAddress("STREAM_SETTLING_US", &aAddresses[numFrames],
+			&aTypes[numFrames]);
+		aValues[numFrames++] = 0;
+	}
+
+	for (i = 0; err == LJME_NOERROR && i < plan->numChannels; i++) {
+		if (!plan->aIsAIN[i] || plan->aRanges[i] <= 0) {
+			continue;
+		}
+		sprintf(name, "%s_RANGE", plan->aNames[i]);
+		err = LJM_NameToAddress(name, &aAddresses[numFrames],
+			&aTypes[numFrames]);
+		aValues[numFrames++] = plan->aRanges[i];
+	}
+	PrintErrorIfError(err, "ConfigureStreamPlan: LJM_NameToAddress");
+	if (err != LJME_NOERROR) {
+		return err;
+	}
+
+	err = LJM_eWriteAddresses(handle, numFrames, aAddresses, aTypes, aValues,
+		&errorAddress);
+	PrintErrorWithAddressIfError(err, errorAddress,
+		"ConfigureStreamPlan: LJM_eWriteAddresses(Handle=%d, NumFrames=%d, ...)",
+		handle, numFrames);
+
+	return err;
+}
+
+double PlannedRequestValue(const StreamPlan * plan, const double * aScan,
+	int requestI)
+{
+	const double value = aScan[plan->aRequestChannels[requestI]];
+	const int bit = plan->aRequestBits[requestI];
+
+	if (bit == PLAN_WHOLE_VALUE || value == LJM_DUMMY_VALUE) {
+		return value;
+	}
+	return ((unsigned int)value >> bit) & 1;
+}
+
+int TestStreamPlan(int handle, const StreamPlan * plan, double scanRate,
+	int scansPerRead, int numReads, StreamPlanResult * result)
+{
+	int err, stopErr, readI, sampleI;
+	int deviceScanBacklog, LJMScanBacklog;
+	int numSkippedSamples = 0;
+	double numCollected, startCollected = 0;
+	LJM_LONG_LONG_RETURN tick, startTick = 0;
+	const int numSamples = scansPerRead * plan->numChannels;
+	double * aData = (double *)malloc(sizeof(double) * numSamples);
+
+	memset(result, 0, sizeof(StreamPlanResult));
+	result->requestedScanRate = scanRate;
+	result->actualScanRate = scanRate;
+
+	if (aData == NULL) {
+		printf("TestStreamPlan: could not allocate %d scans\n", scansPerRead);
+		result->err = STREAM_PLAN_OUT_OF_MEMORY;
+		return STREAM_PLAN_OUT_OF_MEMORY;
+	}
+
+	err = LJM_eStreamStart(handle, scansPerRead, plan->numChannels,
+		plan->aScanList, &result->actualScanRate);
+	PrintErrorIfError(err, "TestStreamPlan: LJM_eStreamStart");
+	if (err != LJME_NOERROR) {
+		free(aData);
+		result->err = err;
+		return err;
+	}
+
+	for (readI = 0; readI < numReads; readI++) {
+		err = LJM_eStreamRead(handle, aData, &deviceScanBacklog,
+			&LJMScanBacklog);
+		if (err != LJME_NOERROR) {
+			PrintErrorIfError(err, "TestStreamPlan: LJM_eStreamRead");
+			break;
+		}
+		tick = LJM_GetHostTick();
+
+		for (sampleI = 0; sampleI < numSamples; sampleI++) {
+			if (aData[sampleI] == LJM_DUMMY_VALUE) {
+				++numSkippedSamples;
+			}
+		}
+		if (deviceScanBacklog > result->maxDeviceScanBacklog) {
+			result->maxDeviceScanBacklog = deviceScanBacklog;
+		}
+		if (LJMScanBacklog > result->maxLJMScanBacklog) {
+			result->maxLJMScanBacklog = LJMScanBacklog;
+		}
+
+		// The scans the device has collected, measured from the first read
+		// so that stream start-up is not included
+		numCollected = (double)(readI + 1) * scansPerRead + deviceScanBacklog +
+			LJMScanBacklog;
+		if (readI == 0) {
+			startTick = tick;
+			startCollected = numCollected;
+		}
+		else if (tick > startTick) {
+			result->measuredScanRate = (numCollected - startCollected) /
+				((tick - startTick) / 1000000.0);
+		}
+	}
+	result->numSkippedScans = numSkippedSamples / plan->numChannels;
+
+	stopErr = LJM_eStreamStop(handle);
+	PrintErrorIfError(stopErr, "TestStreamPlan: LJM_eStreamStop");
+	if (err == LJME_NOERROR) {
+		err = stopErr;
+	}
+
+	free(aData);
+	result->err = err;
+	return err;
+}
+
+void PrintStreamPlanReport(const StreamPlan * plan,
+	const StreamPlanResult * result)
+{
+	int i;
+
+	printf("Stream plan for %s, resolution index %d: %d requests in %d "
+		"channels (%d merged)\n", NumberToDeviceType(plan->deviceType),
+		plan->resolutionIndex, plan->numRequests, plan->numChannels,
+		plan->numMergedRequests);
+	for (i = 0; i < plan->numChannels; i++) {
+		printf("    %-24s address %5d", plan->aNames[i], plan->aScanList[i]);
+		if (plan->aIsAIN[i] && plan->aRanges[i] > 0) {
+			printf(", range +/-%g V", plan->aRanges[i]);
+		}
+		printf("\n");
+	}
+	printf("    range changes per scan: %d (%d as requested)\n",
+		plan->numRangeChanges, plan->numRequestedRangeChanges);
+	printf("    predicted maximum scan rate: %.02f Hz (%.02f Hz as requested)\n",
+		plan->predictedScanRate, plan->predictedRequestedScanRate);
+
+	if (result == NULL) {
+		return;
+	}
+
+	printf("    requested scan rate: %.02f Hz, LJM_eStreamStart: %.02f Hz, "
+		"measured: %.02f Hz (%.1f %% of predicted)\n",
+		result->requestedScanRate, result->actualScanRate,
+		result->measuredScanRate,
+		100 * result->measuredScanRate / plan->predictedScanRate);
+	printf("    max deviceScanBacklog: %d, max LJMScanBacklog: %d, "
+		"skipped scans: %d\n", result->maxDeviceScanBacklog,
+		result->maxLJMScanBacklog, result->numSkippedScans);
+	if (result->err != LJME_NOERROR || result->numSkippedScans > 0) {
+		printf("    The device did not sustain %.02f Hz\n",
+			result->actualScanRate);
+	}
+}
+
 #ifdef LABJACK_DEBUG_LOG_OUTPUT
 void PrintAndLog(const char * outputString, ...)
 {
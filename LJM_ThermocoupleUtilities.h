@@ -0,0 +1,844 @@
+/**
+ * Name: LJM_ThermocoupleUtilities.h
+ * Desc: Provides host-side conversion of whole blocks of thermocouple voltages
+ *       to temperatures, such as the blocks returned by LJM_eStreamRead.
+ *       The cold junction temperature of each scan is read from a CJC channel
+ *       of the same scan, converted to an equivalent thermocouple voltage and
+ *       added to each thermocouple voltage, which is then converted to a
+ *       temperature with the NIST ITS-90 inverse polynomials. This is the
+ *       same conversion as LJM_TCVoltsToTemp without a library call per
+ *       reading.
+ *       Also provides TCArray, which configures the thermocouple AIN_EF of
+ *       many channels of a T7 or T8 with one call and reads all of their
+ *       temperatures, volts and CJC temperatures with one call per cycle.
+ * Note: Type C (W-5% Re / W-26% Re) has no NIST polynomials. Its conversion
+ *       is interpolated from a table of LJM_TCVoltsToTemp results, which is
+ *       built the first time a type C channel is used.
+**/
+
+#ifndef LJM_THERMOCOUPLE_UTILITIES
+#define LJM_THERMOCOUPLE_UTILITIES
+
+#include <math.h>
+
+#include "LJM_Utilities.h"
+
+// The maximum number of channels of one TCConverter
+enum { TC_MAX_CHANNELS = 128 };
+
+// The maximum number of coefficients of one polynomial
+enum { TC_MAX_COEFFS = 15 };
+
+// The number of scans converted per pass over the channels
+enum { TC_SCANS_PER_CHUNK = 256 };
+
+// Passed as a channel's type to TCConverter to leave its readings unchanged,
+// such as for the CJC channel
+enum { TC_NOT_A_THERMOCOUPLE = 0 };
+
+typedef struct TCConverter {
+	int numChannels;
+
+	// The scan index of the CJC channel, whose readings are converted to
+	// Kelvin with reading * cjcSlope + cjcOffset
+	int cjcChannel;
+	double cjcSlope;
+	double cjcOffset;
+
+	// The LJM_tt* type of each channel, or TC_NOT_A_THERMOCOUPLE
+	long aTCTypes[TC_MAX_CHANNELS];
+} TCConverter;
+
+/**
+ * Desc: Prepares converter for a scan list.
+ * Para: aTCTypes, the LJM_tt* type of each channel of the scan list, or
+ *           TC_NOT_A_THERMOCOUPLE for channels that are not thermocouples
+ *       cjcChannel, the scan index of the CJC channel
+ *       cjcSlope, cjcOffset, the CJC Kelvin per volt and Kelvin offset, as
+ *           with the AIN#_EF thermocouple configs D and E. For example, for
+ *           AIN14 of a T7 (the internal temperature sensor), these are -92.6
+ *           and 467.6.
+**/
+void InitTCConverter(TCConverter * converter, int numChannels,
+	const long * aTCTypes, int cjcChannel, double cjcSlope, double cjcOffset);
+
+/**
+ * Desc: Converts numScans scans of volts in aVolts to temperatures in Kelvin
+ *       in aTempsK. aVolts and aTempsK may be the same array. Readings that
+ *       are out of the range of their thermocouple type, and LJM_DUMMY_VALUE
+ *       readings, become LJM_DUMMY_VALUE.
+**/
+void ConvertTCVoltsToTemps(const TCConverter * converter, int numScans,
+	const double * aVolts, double * aTempsK);
+
+/**
+ * Desc: Converts one reading like LJM_TCVoltsToTemp.
+ * Retr: the thermocouple temperature in Kelvin, or LJM_DUMMY_VALUE if tcVolts
+ *       is out of the range of tcType
+**/
+double TCVoltsToTempK(long tcType, double tcVolts, double cjTempK);
+
+/**
+ * Desc: Returns the thermocouple voltage, in volts, of tcType at tempK
+ *       relative to a cold junction at 0 °C, or LJM_DUMMY_VALUE if tempK is
+ *       out of the range of tcType
+**/
+double TCTempKToVolts(long tcType, double tempK);
+
+// The temperature units of a TCArray channel, as written to AIN#_EF_CONFIG_A
+typedef enum {
+	TC_UNITS_K = 0,
+	TC_UNITS_C = 1,
+	TC_UNITS_F = 2
+} TCUnits;
+
+// The maximum number of channels of one TCArray
+enum { TC_ARRAY_MAX_CHANNELS = 64 };
+
+// Passed as a TCChannelConfig's negChannel for a single-ended measurement
+enum { TC_NEG_CHANNEL_GND = 199 };
+
+// The configuration of one thermocouple AIN_EF channel of a T7 or T8
+typedef struct TCChannelConfig {
+	// The LJM_tt* type
+	long tcType;
+
+	// The AIN of signal+. For a differential reading on a T7, negChannel
+	// should be posChannel + 1 and posChannel should be even.
+	int posChannel;
+
+	// The AIN of signal-, or TC_NEG_CHANNEL_GND. Only used by the T7.
+	int negChannel;
+
+	// The AIN#_RESOLUTION_INDEX, where 0 is the device default
+	int resolutionIndex;
+
+	// The Modbus address of the CJC sensor and its Kelvin per unit and
+	// Kelvin offset. For TEMPERATURE_DEVICE_K, these are 60052, 1 and 0.
+	int cjcAddress;
+	double cjcSlope;
+	double cjcOffset;
+
+	TCUnits units;
+} TCChannelConfig;
+
+typedef struct TCArray {
+	int handle;
+	int numChannels;
+	TCChannelConfig aConfigs[TC_ARRAY_MAX_CHANNELS];
+
+	// The read frames, AIN#_EF_READ_A, _B and _C of each channel, built once
+	// by InitTCArray
+	int aReadAddresses[TC_ARRAY_MAX_CHANNELS * 3];
+	int aReadTypes[TC_ARRAY_MAX_CHANNELS * 3];
+	double aReadValues[TC_ARRAY_MAX_CHANNELS * 3];
+
+	// The readings of the latest ReadTCArray, in each channel's units
+	double aTemps[TC_ARRAY_MAX_CHANNELS];
+	double aVolts[TC_ARRAY_MAX_CHANNELS];
+	double aCJTemps[TC_ARRAY_MAX_CHANNELS];
+
+	// Statistics
+	int numConfigures;
+	int numReads;
+} TCArray;
+
+/**
+ * Desc: Initializes tcArray for the device of handle with numChannels
+ *       channels. No registers are written until ConfigureTCArray.
+**/
+void InitTCArray(TCArray * tcArray, int handle, int numChannels,
+	const TCChannelConfig * aConfigs);
+
+/**
+ * Desc: Configures the thermocouple AIN_EF of every channel with a single
+ *       LJM_eWriteAddresses call.
+ * Retr: the LJM error code, which is LJME_NOERROR on success
+**/
+int ConfigureTCArray(TCArray * tcArray);
+void ConfigureTCArrayOrDie(TCArray * tcArray);
+
+/**
+ * Desc: Reads the temperature, thermocouple volts and CJC temperature of every
+ *       channel with a single LJM_eReadAddresses call, into aTemps, aVolts
+ *       and aCJTemps.
+ * Retr: the LJM error code, which is LJME_NOERROR on success
+**/
+int ReadTCArray(TCArray * tcArray);
+void ReadTCArrayOrDie(TCArray * tcArray);
+
+/**
+ * Desc: Returns 'K', 'C' or 'F'
+**/
+char TCUnitsSymbol(TCUnits units);
+
+/**
+ * Desc: Prints the number of configure and read calls of tcArray
+**/
+void PrintTCArrayStatistics(const TCArray * tcArray);
+
+
+// Source
+
+typedef struct {
+	// The range of the polynomial's input, in °C for the temperature to
+	// millivolts polynomials or mV for the millivolts to temperature ones
+	double min;
+	double max;
+
+	int numCoeffs;
+	double aCoeffs[TC_MAX_COEFFS];
+} _TCPolynomial;
+
+typedef struct {
+	const _TCPolynomial * aForward;
+	int numForward;
+	const _TCPolynomial * aInverse;
+	int numInverse;
+} _TCTables;
+
+// NIST ITS-90 thermocouple reference functions (temperature in °C to mV) and
+// inverse functions (mV to temperature in °C)
+
+static const _TCPolynomial _TC_B_FORWARD[] = {
+	{0.000, 630.615, 7, {0.000000000000E+00, -0.246508183460E-03,
+		0.590404211710E-05, -0.132579316360E-08, 0.156682919010E-11,
+		-0.169445292400E-14, 0.629903470940E-18}},
+	{630.615, 1820.000, 9, {-0.389381686210E+01, 0.285717474700E-01,
+		-0.848851047850E-04, 0.157852801640E-06, -0.168353448640E-09,
+		0.111097940130E-12, -0.445154310330E-16, 0.989756408210E-20,
+		-0.937913302890E-24}}
+};
+static const _TCPolynomial _TC_B_INVERSE[] = {
+	{0.291, 2.431, 9, {9.8423321E+01, 6.9971500E+02, -8.4765304E+02,
+		1.0052644E+03, -8.3345952E+02, 4.5508542E+02, -1.5523037E+02,
+		2.9886750E+01, -2.4742860E+00}},
+	{2.431, 13.820, 9, {2.1315071E+02, 2.8510504E+02, -5.2742887E+01,
+		9.9160804E+00, -1.2965303E+00, 1.1195870E-01, -6.0625199E-03,
+		1.8661696E-04, -2.4878585E-06}}
+};
+
+static const _TCPolynomial _TC_E_FORWARD[] = {
+	{-270.000, 0.000, 14, {0.000000000000E+00, 0.586655087080E-01,
+		0.454109771240E-04, -0.779980486860E-06, -0.258001608430E-07,
+		-0.594525830570E-09, -0.932140586670E-11, -0.102876055340E-12,
+		-0.803701236210E-15, -0.439794973910E-17, -0.164147763550E-19,
+		-0.396736195160E-22, -0.558273287210E-25, -0.346578420130E-28}},
+	{0.000, 1000.000, 11, {0.000000000000E+00, 0.586655087100E-01,
+		0.450322755820E-04, 0.289084072120E-07, -0.330568966520E-09,
+		0.650244032700E-12, -0.191974955040E-15, -0.125366004970E-17,
+		0.214892175690E-20, -0.143880417820E-23, 0.359608994810E-27}}
+};
+static const _TCPolynomial _TC_E_INVERSE[] = {
+	{-8.825, 0.000, 9, {0.0000000E+00, 1.6977288E+01, -4.3514970E-01,
+		-1.5859697E-01, -9.2502871E-02, -2.6084314E-02, -4.1360199E-03,
+		-3.4034030E-04, -1.1564890E-05}},
+	{0.000, 76.373, 10, {0.0000000E+00, 1.7057035E+01, -2.3301759E-01,
+		6.5435585E-03, -7.3562749E-05, -1.7896001E-06, 8.4036165E-08,
+		-1.3735879E-09, 1.0629823E-11, -3.2447087E-14}}
+};
+
+static const _TCPolynomial _TC_J_FORWARD[] = {
+	{-210.000, 760.000, 9, {0.000000000000E+00, 0.503811878150E-01,
+		0.304758369300E-04, -0.856810657200E-07, 0.132281952950E-09,
+		-0.170529583370E-12, 0.209480906970E-15, -0.125383953360E-18,
+		0.156317256970E-22}},
+	{760.000, 1200.000, 6, {0.296456256810E+03, -0.149761277860E+01,
+		0.317871039240E-02, -0.318476867010E-05, 0.157208190040E-08,
+		-0.306913690560E-12}}
+};
+static const _TCPolynomial _TC_J_INVERSE[] = {
+	{-8.095, 0.000, 9, {0.0000000E+00, 1.9528268E+01, -1.2286185E+00,
+		-1.0752178E+00, -5.9086933E-01, -1.7256713E-01, -2.8131513E-02,
+		-2.3963370E-03, -8.3823321E-05}},
+	{0.000, 42.919, 8, {0.000000E+00, 1.978425E+01, -2.001204E-01,
+		1.036969E-02, -2.549687E-04, 3.585153E-06, -5.344285E-08,
+		5.099890E-10}},
+	{42.919, 69.553, 6, {-3.11358187E+03, 3.00543684E+02, -9.94773230E+00,
+		1.70276630E-01, -1.43033468E-03, 4.73886084E-06}}
+};
+
+// Type K's reference function above 0 °C also has the term
+// 0.118597600000 * exp(-0.118343200000E-03 * (t - 126.9686)^2), which is
+// added by _TCForwardMillivolts
+static const _TCPolynomial _TC_K_FORWARD[] = {
+	{-270.000, 0.000, 11, {0.000000000000E+00, 0.394501280250E-01,
+		0.236223735980E-04, -0.328589067840E-06, -0.499048287770E-08,
+		-0.675090591730E-10, -0.574103274280E-12, -0.310888728940E-14,
+		-0.104516093650E-16, -0.198892668780E-19, -0.163226974860E-22}},
+	{0.000, 1372.000, 10, {-0.176004136860E-01, 0.389212049750E-01,
+		0.185587700320E-04, -0.994575928740E-07, 0.318409457190E-09,
+		-0.560728448890E-12, 0.560750590590E-15, -0.320207200030E-18,
+		0.971511471520E-22, -0.121047212750E-25}}
+};
+static const _TCPolynomial _TC_K_INVERSE[] = {
+	{-5.891, 0.000, 9, {0.0000000E+00, 2.5173462E+01, -1.1662878E+00,
+		-1.0833638E+00, -8.9773540E-01, -3.7342377E-01, -8.6632643E-02,
+		-1.0450598E-02, -5.1920577E-04}},
+	{0.000, 20.644, 10, {0.000000E+00, 2.508355E+01, 7.860106E-02,
+		-2.503131E-01, 8.315270E-02, -1.228034E-02, 9.804036E-04,
+		-4.413030E-05, 1.057734E-06, -1.052755E-08}},
+	{20.644, 54.886, 7, {-1.318058E+02, 4.830222E+01, -1.646031E+00,
+		5.464731E-02, -9.650715E-04, 8.802193E-06, -3.110810E-08}}
+};
+
+static const _TCPolynomial _TC_N_FORWARD[] = {
+	{-270.000, 0.000, 9, {0.000000000000E+00, 0.261591059620E-01,
+		0.109574842280E-04, -0.938411115540E-07, -0.464120397590E-10,
+		-0.263033577160E-11, -0.226534380030E-13, -0.760893007910E-16,
+		-0.934196678350E-19}},
+	{0.000, 1300.000, 11, {0.000000000000E+00, 0.259293946010E-01,
+		0.157101418800E-04, 0.438256272370E-07, -0.252611697940E-09,
+		0.643118193390E-12, -0.100634715190E-14, 0.997453389920E-18,
+		-0.608632456070E-21, 0.208492293390E-24, -0.306821961510E-28}}
+};
+static const _TCPolynomial _TC_N_INVERSE[] = {
+	{-3.990, 0.000, 10, {0.0000000E+00, 3.8436847E+01, 1.1010485E+00,
+		5.2229312E+00, 7.2060525E+00, 5.8488586E+00, 2.7754916E+00,
+		7.7075166E-01, 1.1582665E-01, 7.3138868E-03}},
+	{0.000, 20.613, 8, {0.00000E+00, 3.86896E+01, -1.08267E+00, 4.70205E-02,
+		-2.12169E-06, -1.17272E-04, 5.39280E-06, -7.98156E-08}},
+	{20.613, 47.513, 6, {1.972485E+01, 3.300943E+01, -3.915159E-01,
+		9.855391E-03, -1.274371E-04, 7.767022E-07}}
+};
+
+static const _TCPolynomial _TC_R_FORWARD[] = {
+	{-50.000, 1064.180, 10, {0.000000000000E+00, 0.528961729765E-02,
+		0.139166589782E-04, -0.238855693017E-07, 0.356916001063E-10,
+		-0.462347665839E-13, 0.500777441034E-16, -0.373105886191E-19,
+		0.157716482367E-22, -0.281038625251E-26}},
+	{1064.180, 1664.500, 6, {0.295157925316E+01, -0.252061251332E-02,
+		0.159564501865E-04, -0.764085947576E-08, 0.205305291024E-11,
+		-0.293359668173E-15}},
+	{1664.500, 1768.100, 5, {0.152232118209E+03, -0.268819888545E+00,
+		0.171280280471E-03, -0.345895706453E-07, -0.934633971046E-14}}
+};
+static const _TCPolynomial _TC_R_INVERSE[] = {
+	{-0.226, 1.923, 11, {0.0000000E+00, 1.8891380E+02, -9.3835290E+01,
+		1.3068619E+02, -2.2703580E+02, 3.5145659E+02, -3.8953900E+02,
+		2.8239471E+02, -1.2607281E+02, 3.1353611E+01, -3.3187769E+00}},
+	{1.923, 11.361, 10, {1.334584505E+01, 1.472644573E+02, -1.844024844E+01,
+		4.031129726E+00, -6.249428360E-01, 6.468412046E-02,
+		-4.458750426E-03, 1.994710149E-04, -5.313401790E-06,
+		6.481976217E-08}},
+	{11.361, 19.739, 6, {-8.199599416E+01, 1.553962042E+02,
+		-8.342197663E+00, 4.279433549E-01, -1.191577910E-02,
+		1.492290091E-04}},
+	{19.739, 21.103, 5, {3.406177836E+04, -7.023729171E+03, 5.582903813E+02,
+		-1.952394635E+01, 2.560740231E-01}}
+};
+
+static const _TCPolynomial _TC_S_FORWARD[] = {
+	{-50.000, 1064.180, 9, {0.000000000000E+00, 0.540313308631E-02,
+		0.125934289740E-04, -0.232477968689E-07, 0.322028823036E-10,
+		-0.331465196389E-13, 0.255744251786E-16, -0.125068871393E-19,
+		0.271443176145E-23}},
+	{1064.180, 1664.500, 5, {0.132900444085E+01, 0.334509311344E-02,
+		0.654805192818E-05, -0.164856259209E-08, 0.129989605174E-13}},
+	{1664.500, 1768.100, 5, {0.146628232636E+03, -0.258430516752E+00,
+		0.163693574641E-03, -0.330439046987E-07, -0.943223690612E-14}}
+};
+static const _TCPolynomial _TC_S_INVERSE[] = {
+	{-0.235, 1.874, 10, {0.00000000E+00, 1.84949460E+02, -8.00504062E+01,
+		1.02237430E+02, -1.52248592E+02, 1.88821343E+02, -1.59085941E+02,
+		8.23027880E+01, -2.34181944E+01, 2.79786260E+00}},
+	{1.874, 10.332, 10, {1.291507177E+01, 1.466298863E+02, -1.534713402E+01,
+		3.145945973E+00, -4.163257839E-01, 3.187963771E-02,
+		-1.291637500E-03, 2.183475087E-05, -1.447379511E-07,
+		8.211272125E-09}},
+	{10.332, 17.536, 6, {-8.087801117E+01, 1.621573104E+02,
+		-8.536869453E+00, 4.719686976E-01, -1.441693666E-02,
+		2.081618890E-04}},
+	{17.536, 18.693, 5, {5.333875126E+04, -1.235892298E+04, 1.092657613E+03,
+		-4.265693686E+01, 6.247205420E-01}}
+};
+
+static const _TCPolynomial _TC_T_FORWARD[] = {
+	{-270.000, 0.000, 15, {0.000000000000E+00, 0.387481063640E-01,
+		0.441944343470E-04, 0.118443231050E-06, 0.200329735540E-07,
+		0.901380195590E-09, 0.226511565930E-10, 0.360711542050E-12,
+		0.384939398830E-14, 0.282135219250E-16, 0.142515947790E-18,
+		0.487686622860E-21, 0.107955392700E-23, 0.139450270620E-26,
+		0.797951539270E-30}},
+	{0.000, 400.000, 9, {0.000000000000E+00, 0.387481063640E-01,
+		0.332922278800E-04, 0.206182434040E-06, -0.218822568460E-08,
+		0.109968809280E-10, -0.308157587720E-13, 0.454791352900E-16,
+		-0.275129016730E-19}}
+};
+static const _TCPolynomial _TC_T_INVERSE[] = {
+	{-5.603, 0.000, 8, {0.0000000E+00, 2.5949192E+01, -2.1316967E-01,
+		7.9018692E-01, 4.2527777E-01, 1.3304473E-01, 2.0241446E-02,
+		1.2668171E-03}},
+	{0.000, 20.872, 7, {0.000000E+00, 2.592800E+01, -7.602961E-01,
+		4.637791E-02, -2.165394E-03, 6.048144E-05, -7.293422E-07}}
+};
+
+#define _TC_TABLES(FORWARD, INVERSE) { \
+	FORWARD, sizeof(FORWARD) / sizeof(FORWARD[0]), \
+	INVERSE, sizeof(INVERSE) / sizeof(INVERSE[0]) }
+
+// Indexed by tcType - LJM_ttB. Type C has no polynomials.
+static const _TCTables _TC_TABLES_BY_TYPE[] = {
+	_TC_TABLES(_TC_B_FORWARD, _TC_B_INVERSE),
+	_TC_TABLES(_TC_E_FORWARD, _TC_E_INVERSE),
+	_TC_TABLES(_TC_J_FORWARD, _TC_J_INVERSE),
+	_TC_TABLES(_TC_K_FORWARD, _TC_K_INVERSE),
+	_TC_TABLES(_TC_N_FORWARD, _TC_N_INVERSE),
+	_TC_TABLES(_TC_R_FORWARD, _TC_R_INVERSE),
+	_TC_TABLES(_TC_S_FORWARD, _TC_S_INVERSE),
+	_TC_TABLES(_TC_T_FORWARD, _TC_T_INVERSE),
+	{NULL, 0, NULL, 0}
+};
+
+#undef _TC_TABLES
+
+enum { _TC_NUM_TYPES = 9 };
+
+// The type C table: the temperature in °C at every _TC_C_STEP_MV mV from 0 mV
+enum { _TC_C_MAX_ENTRIES = 4000 };
+static const double _TC_C_STEP_MV = 0.01;
+static double _tcCTable[_TC_C_MAX_ENTRIES];
+static int _tcCTableSize = 0;
+
+// Builds the type C table from LJM_TCVoltsToTemp if it has not been built
+void _InitTCTypeCTable()
+{
+	int i, err;
+	double tempK;
+
+	if (_tcCTableSize > 0) {
+		return;
+	}
+
+	for (i = 0; i < _TC_C_MAX_ENTRIES; i++) {
+		// With the cold junction at 0 °C, no CJC voltage is added
+		err = LJM_TCVoltsToTemp(LJM_ttC, i * _TC_C_STEP_MV / 1000, 273.15,
+			&tempK);
+		if (err != LJME_NOERROR) {
+			break;
+		}
+		_tcCTable[i] = tempK - 273.15;
+	}
+	_tcCTableSize = i;
+
+	if (_tcCTableSize < 2) {
+		printf("_InitTCTypeCTable: LJM_TCVoltsToTemp failed for type C\n");
+		LJM_CloseAll();
+		exit(1);
+	}
+}
+
+double _TCPolynomialValue(const _TCPolynomial * poly, double x)
+{
+	int i;
+	double value = poly->aCoeffs[poly->numCoeffs - 1];
+	for (i = poly->numCoeffs - 2; i >= 0; i--) {
+		value = value * x + poly->aCoeffs[i];
+	}
+	return value;
+}
+
+// Returns the polynomial of aPolys whose range contains x, or NULL
+const _TCPolynomial * _TCFindPolynomial(const _TCPolynomial * aPolys,
+	int numPolys, double x)
+{
+	int i;
+
+	if (x < aPolys[0].min || x > aPolys[numPolys - 1].max) {
+		return NULL;
+	}
+	for (i = 0; i < numPolys - 1; i++) {
+		if (x < aPolys[i].max) {
+			break;
+		}
+	}
+	return &aPolys[i];
+}
+
+// Returns the thermocouple voltage in mV at tempC, or LJM_DUMMY_VALUE
+double _TCForwardMillivolts(long tcType, double tempC)
+{
+	int low, high, mid;
+	const _TCTables * tables;
+	const _TCPolynomial * poly;
+	double millivolts;
+
+	if (tcType == LJM_ttC) {
+		// Binary search the increasing temperatures of the table
+		_InitTCTypeCTable();
+		if (tempC < _tcCTable[0] || tempC > _tcCTable[_tcCTableSize - 1]) {
+			return LJM_DUMMY_VALUE;
+		}
+		low = 0;
+		high = _tcCTableSize - 1;
+		while (high - low > 1) {
+			mid = (low + high) / 2;
+			if (_tcCTable[mid] <= tempC) {
+				low = mid;
+			}
+			else {
+				high = mid;
+			}
+		}
+		return (low + (tempC - _tcCTable[low]) /
+			(_tcCTable[high] - _tcCTable[low])) * _TC_C_STEP_MV;
+	}
+
+	tables = &_TC_TABLES_BY_TYPE[tcType - LJM_ttB];
+	poly = _TCFindPolynomial(tables->aForward, tables->numForward, tempC);
+	if (poly == NULL) {
+		return LJM_DUMMY_VALUE;
+	}
+
+	millivolts = _TCPolynomialValue(poly, tempC);
+	if (tcType == LJM_ttK && tempC >= 0) {
+		millivolts += 0.118597600000 * exp(-0.118343200000E-03 *
+			(tempC - 126.9686) * (tempC - 126.9686));
+	}
+	return millivolts;
+}
+
+// Returns the temperature in °C of a thermocouple voltage in mV, or
+// LJM_DUMMY_VALUE
+double _TCInverseTempC(long tcType, double millivolts)
+{
+	int i;
+	double position;
+	const _TCTables * tables;
+	const _TCPolynomial * poly;
+
+	if (tcType == LJM_ttC) {
+		_InitTCTypeCTable();
+		position = millivolts / _TC_C_STEP_MV;
+		if (position < 0 || position > _tcCTableSize - 1) {
+			return LJM_DUMMY_VALUE;
+		}
+		i = (int)position;
+		if (i == _tcCTableSize - 1) {
+			return _tcCTable[i];
+		}
+		return _tcCTable[i] + (position - i) *
+			(_tcCTable[i + 1] - _tcCTable[i]);
+	}
+
+	tables = &_TC_TABLES_BY_TYPE[tcType - LJM_ttB];
+	poly = _TCFindPolynomial(tables->aInverse, tables->numInverse,
+		millivolts);
+	if (poly == NULL) {
+		return LJM_DUMMY_VALUE;
+	}
+	return _TCPolynomialValue(poly, millivolts);
+}
+
+// Exits if tcType is not an LJM_tt* type
+void _CheckTCType(const char * description, long tcType)
+{
+	if (tcType < LJM_ttB || tcType >= LJM_ttB + _TC_NUM_TYPES) {
+		printf("%s: invalid thermocouple type %ld\n", description, tcType);
+		LJM_CloseAll();
+		exit(1);
+	}
+}
+
+double TCVoltsToTempK(long tcType, double tcVolts, double cjTempK)
+{
+	double cjMillivolts, tempC;
+
+	_CheckTCType("TCVoltsToTempK", tcType);
+
+	cjMillivolts = _TCForwardMillivolts(tcType, cjTempK - 273.15);
+	if (cjMillivolts == LJM_DUMMY_VALUE) {
+		return LJM_DUMMY_VALUE;
+	}
+	tempC = _TCInverseTempC(tcType, tcVolts * 1000 + cjMillivolts);
+	if (tempC == LJM_DUMMY_VALUE) {
+		return LJM_DUMMY_VALUE;
+	}
+	return tempC + 273.15;
+}
+
+double TCTempKToVolts(long tcType, double tempK)
+{
+	double millivolts;
+
+	_CheckTCType("TCTempKToVolts", tcType);
+
+	millivolts = _TCForwardMillivolts(tcType, tempK - 273.15);
+	if (millivolts == LJM_DUMMY_VALUE) {
+		return LJM_DUMMY_VALUE;
+	}
+	return millivolts / 1000;
+}
+
+void InitTCConverter(TCConverter * converter, int numChannels,
+	const long * aTCTypes, int cjcChannel, double cjcSlope, double cjcOffset)
+{
+	int i;
+
+	if (numChannels > TC_MAX_CHANNELS) {
+		printf("InitTCConverter: more than %d channels\n", TC_MAX_CHANNELS);
+		LJM_CloseAll();
+		exit(1);
+	}
+	if (cjcChannel < 0 || cjcChannel >= numChannels) {
+		printf("InitTCConverter: invalid CJC channel %d\n", cjcChannel);
+		LJM_CloseAll();
+		exit(1);
+	}
+
+	converter->numChannels = numChannels;
+	converter->cjcChannel = cjcChannel;
+	converter->cjcSlope = cjcSlope;
+	converter->cjcOffset = cjcOffset;
+	for (i = 0; i < numChannels; i++) {
+		if (aTCTypes[i] != TC_NOT_A_THERMOCOUPLE) {
+			_CheckTCType("InitTCConverter", aTCTypes[i]);
+			if (aTCTypes[i] == LJM_ttC) {
+				_InitTCTypeCTable();
+			}
+		}
+		converter->aTCTypes[i] = aTCTypes[i];
+	}
+}
+
+void ConvertTCVoltsToTemps(const TCConverter * converter, int numScans,
+	const double * aVolts, double * aTempsK)
+{
+	int chunkStart, chunkScans, scanI, chanI, typeI;
+	const int numChannels = converter->numChannels;
+	long tcType;
+	double volts, tempC;
+
+	// The CJC voltage of each scan of the chunk for each type, computed once
+	// per type rather than once per channel
+	double aCJMillivolts[_TC_NUM_TYPES][TC_SCANS_PER_CHUNK];
+	int aCJComputed[_TC_NUM_TYPES];
+	double aCJTempC[TC_SCANS_PER_CHUNK];
+
+	for (chunkStart = 0; chunkStart < numScans;
+		chunkStart += TC_SCANS_PER_CHUNK)
+	{
+		chunkScans = numScans - chunkStart;
+		if (chunkScans > TC_SCANS_PER_CHUNK) {
+			chunkScans = TC_SCANS_PER_CHUNK;
+		}
+
+		// Read the CJC channel before the scans are overwritten
+		for (scanI = 0; scanI < chunkScans; scanI++) {
+			volts = aVolts[(chunkStart + scanI) * numChannels +
+				converter->cjcChannel];
+			if (volts == LJM_DUMMY_VALUE) {
+				aCJTempC[scanI] = LJM_DUMMY_VALUE;
+			}
+			else {
+				aCJTempC[scanI] = volts * converter->cjcSlope +
+					converter->cjcOffset - 273.15;
+			}
+		}
+		memset(aCJComputed, 0, sizeof(aCJComputed));
+
+		for (chanI = 0; chanI < numChannels; chanI++) {
+			tcType = converter->aTCTypes[chanI];
+			if (tcType == TC_NOT_A_THERMOCOUPLE) {
+				if (aTempsK != aVolts) {
+					for (scanI = 0; scanI < chunkScans; scanI++) {
+						aTempsK[(chunkStart + scanI) * numChannels + chanI] =
+							aVolts[(chunkStart + scanI) * numChannels +
+							chanI];
+					}
+				}
+				continue;
+			}
+
+			typeI = tcType - LJM_ttB;
+			if (!aCJComputed[typeI]) {
+				for (scanI = 0; scanI < chunkScans; scanI++) {
+					aCJMillivolts[typeI][scanI] =
+						aCJTempC[scanI] == LJM_DUMMY_VALUE ? LJM_DUMMY_VALUE :
+						_TCForwardMillivolts(tcType, aCJTempC[scanI]);
+				}
+				aCJComputed[typeI] = 1;
+			}
+
+			for (scanI = 0; scanI < chunkScans; scanI++) {
+				volts = aVolts[(chunkStart + scanI) * numChannels + chanI];
+				if (volts == LJM_DUMMY_VALUE ||
+					aCJMillivolts[typeI][scanI] == LJM_DUMMY_VALUE)
+				{
+					tempC = LJM_DUMMY_VALUE;
+				}
+				else {
+					tempC = _TCInverseTempC(tcType,
+						volts * 1000 + aCJMillivolts[typeI][scanI]);
+				}
+				aTempsK[(chunkStart + scanI) * numChannels + chanI] =
+					tempC == LJM_DUMMY_VALUE ? LJM_DUMMY_VALUE : tempC + 273.15;
+			}
+		}
+	}
+}
+
+// AIN_EF register addresses of AIN0. The address of AIN# is the address of
+// AIN0 plus 2 * # for 32-bit registers or # for 16-bit registers.
+enum {
+	_TC_EF_READ_A = 7000,
+	_TC_EF_READ_B = 7300,
+	_TC_EF_READ_C = 7600,
+	_TC_EF_INDEX = 9000,
+	_TC_EF_CONFIG_A = 9300,
+	_TC_EF_CONFIG_B = 9600,
+	_TC_EF_CONFIG_D = 10200,
+	_TC_EF_CONFIG_E = 10500,
+	_TC_NEGATIVE_CH = 41000,
+	_TC_RESOLUTION_INDEX = 41500
+};
+
+// The AIN_EF index of each thermocouple type, indexed by tcType - LJM_ttB
+static const int _TC_EF_INDEXES[_TC_NUM_TYPES] =
+	{28, 20, 21, 22, 27, 23, 25, 24, 30};
+
+void InitTCArray(TCArray * tcArray, int handle, int numChannels,
+	const TCChannelConfig * aConfigs)
+{
+	int i, ch;
+
+	if (numChannels > TC_ARRAY_MAX_CHANNELS) {
+		printf("InitTCArray: more than %d channels\n", TC_ARRAY_MAX_CHANNELS);
+		LJM_CloseAll();
+		exit(1);
+	}
+
+	memset(tcArray, 0, sizeof(TCArray));
+	tcArray->handle = handle;
+	tcArray->numChannels = numChannels;
+	for (i = 0; i < numChannels; i++) {
+		_CheckTCType("InitTCArray", aConfigs[i].tcType);
+		tcArray->aConfigs[i] = aConfigs[i];
+
+		// Reading READ_A takes a new measurement, which READ_B and READ_C
+		// then return the volts and CJC temperature of
+		ch = aConfigs[i].posChannel;
+		tcArray->aReadAddresses[i * 3] = _TC_EF_READ_A + 2 * ch;
+		tcArray->aReadAddresses[i * 3 + 1] = _TC_EF_READ_B + 2 * ch;
+		tcArray->aReadAddresses[i * 3 + 2] = _TC_EF_READ_C + 2 * ch;
+		tcArray->aReadTypes[i * 3] = LJM_FLOAT32;
+		tcArray->aReadTypes[i * 3 + 1] = LJM_FLOAT32;
+		tcArray->aReadTypes[i * 3 + 2] = LJM_FLOAT32;
+	}
+}
+
+// Adds one frame to the configuration frames
+void _AddTCConfigFrame(int * numFrames, int * aAddresses, int * aTypes,
+	double * aValues, int address, int type, double value)
+{
+	aAddresses[*numFrames] = address;
+	aTypes[*numFrames] = type;
+	aValues[*numFrames] = value;
+	(*numFrames)++;
+}
+
+int ConfigureTCArray(TCArray * tcArray)
+{
+	// At most 8 frames per channel
+	enum { MAX_FRAMES = TC_ARRAY_MAX_CHANNELS * 8 };
+	int aAddresses[MAX_FRAMES];
+	int aTypes[MAX_FRAMES];
+	double aValues[MAX_FRAMES];
+	int numFrames = 0;
+	int errorAddress = INITIAL_ERR_ADDRESS;
+	int i, ch, isT7;
+	const TCChannelConfig * config;
+
+	int deviceType = GetDeviceType(tcArray->handle);
+	if (deviceType == LJM_dtT4) {
+		printf("ConfigureTCArray: the T4 does not support the thermocouple "
+			"AIN_EF\n");
+		LJM_CloseAll();
+		exit(1);
+	}
+	isT7 = (deviceType == LJM_dtT7);
+
+	for (i = 0; i < tcArray->numChannels; i++) {
+		config = &tcArray->aConfigs[i];
+		ch = config->posChannel;
+
+		_AddTCConfigFrame(&numFrames, aAddresses, aTypes, aValues,
+			_TC_RESOLUTION_INDEX + ch, LJM_UINT16, config->resolutionIndex);
+		if (isT7) {
+			_AddTCConfigFrame(&numFrames, aAddresses, aTypes, aValues,
+				_TC_NEGATIVE_CH + ch, LJM_UINT16, config->negChannel);
+		}
+
+		// Disable the AIN_EF before changing its index
+		_AddTCConfigFrame(&numFrames, aAddresses, aTypes, aValues,
+			_TC_EF_INDEX + 2 * ch, LJM_UINT32, 0);
+		_AddTCConfigFrame(&numFrames, aAddresses, aTypes, aValues,
+			_TC_EF_INDEX + 2 * ch, LJM_UINT32,
+			_TC_EF_INDEXES[config->tcType - LJM_ttB]);
+
+		_AddTCConfigFrame(&numFrames, aAddresses, aTypes, aValues,
+			_TC_EF_CONFIG_A + 2 * ch, LJM_UINT32, config->units);
+		_AddTCConfigFrame(&numFrames, aAddresses, aTypes, aValues,
+			_TC_EF_CONFIG_B + 2 * ch, LJM_UINT32, config->cjcAddress);
+		_AddTCConfigFrame(&numFrames, aAddresses, aTypes, aValues,
+			_TC_EF_CONFIG_D + 2 * ch, LJM_FLOAT32, config->cjcSlope);
+		_AddTCConfigFrame(&numFrames, aAddresses, aTypes, aValues,
+			_TC_EF_CONFIG_E + 2 * ch, LJM_FLOAT32, config->cjcOffset);
+	}
+
+	tcArray->numConfigures++;
+	return LJM_eWriteAddresses(tcArray->handle, numFrames, aAddresses, aTypes,
+		aValues, &errorAddress);
+}
+
+void ConfigureTCArrayOrDie(TCArray * tcArray)
+{
+	ErrorCheck(ConfigureTCArray(tcArray), "ConfigureTCArray");
+}
+
+int ReadTCArray(TCArray * tcArray)
+{
+	int err, i;
+	int errorAddress = INITIAL_ERR_ADDRESS;
+
+	tcArray->numReads++;
+	err = LJM_eReadAddresses(tcArray->handle, tcArray->numChannels * 3,
+		tcArray->aReadAddresses, tcArray->aReadTypes, tcArray->aReadValues,
+		&errorAddress);
+	if (err != LJME_NOERROR) {
+		return err;
+	}
+
+	for (i = 0; i < tcArray->numChannels; i++) {
+		tcArray->aTemps[i] = tcArray->aReadValues[i * 3];
+		tcArray->aVolts[i] = tcArray->aReadValues[i * 3 + 1];
+		tcArray->aCJTemps[i] = tcArray->aReadValues[i * 3 + 2];
+	}
+
+	return LJME_NOERROR;
+}
+
+void ReadTCArrayOrDie(TCArray * tcArray)
+{
+	ErrorCheck(ReadTCArray(tcArray), "ReadTCArray");
+}
+
+char TCUnitsSymbol(TCUnits units)
+{
+	switch (units) {
+	case TC_UNITS_C:
+		return 'C';
+	case TC_UNITS_F:
+		return 'F';
+	default:
+		return 'K';
+	}
+}
+
+void PrintTCArrayStatistics(const TCArray * tcArray)
+{
+	printf("TCArray of %d channels: %d configure call(s), %d read call(s)\n",
+		tcArray->numChannels, tcArray->numConfigures, tcArray->numReads);
+}
+
+#endif // #define LJM_THERMOCOUPLE_UTILITIES
@@ -0,0 +1,239 @@
+/**
+ * Name: LJM_ThreadUtilities.h
+ * Desc: Provides minimal portable thread and mutex helper functions, using the
+ *       Windows thread API on Windows and POSIX threads otherwise, and a
+ *       lock-free single-producer, single-consumer queue.
+ * Note: On Linux and Mac OS X, programs that include this file must link with
+ *       pthread (see the link_libs of the SConstruct file).
+**/
+
+#ifndef LJM_THREAD_UTILITIES
+#define LJM_THREAD_UTILITIES
+
+// On Windows, LJM_Utilities.h includes Winsock2.h, which includes windows.h
+#include "LJM_Utilities.h"
+
+#ifndef _WIN32
+	#include <pthread.h>
+#endif
+
+#ifdef _WIN32
+	typedef HANDLE Thread;
+	typedef CRITICAL_SECTION Mutex;
+#else
+	typedef pthread_t Thread;
+	typedef pthread_mutex_t Mutex;
+#endif
+
+typedef void (*ThreadFunction)(void * arg);
+
+/**
+ * Desc: Starts a new thread that calls function(arg).
+ * Retr: 0 on success, non-zero if the thread could not be started
+**/
+int StartThread(Thread * thread, ThreadFunction function, void * arg);
+
+/**
+ * Desc: Waits for thread to return and releases its resources.
+**/
+void JoinThread(Thread thread);
+
+/**
+ * Desc: Initializes, locks, unlocks and destroys a non-recursive mutex.
+**/
+void InitMutex(Mutex * mutex);
+void LockMutex(Mutex * mutex);
+void UnlockMutex(Mutex * mutex);
+void DestroyMutex(Mutex * mutex);
+
+/**
+ * Desc: Reads and writes an int that is shared between threads without a
+ *       mutex. Memory written before an AtomicStoreInt is visible to another
+ *       thread after its AtomicLoadInt of the stored value.
+**/
+int AtomicLoadInt(volatile int * value);
+void AtomicStoreInt(volatile int * value, int newValue);
+
+/**
+ * The indexes of a lock-free queue of numSlots slots between one producer
+ * thread and one consumer thread. The slots themselves belong to the user of
+ * the queue, so no data is copied. One slot is always unused, so the queue
+ * holds up to numSlots - 1 entries.
+**/
+typedef struct SPSCQueue {
+	int numSlots;
+
+	// The next slot to write, only changed by the producer
+	volatile int head;
+
+	// The next slot to read, only changed by the consumer
+	volatile int tail;
+} SPSCQueue;
+
+void InitSPSCQueue(SPSCQueue * queue, int numSlots);
+
+/**
+ * Desc: For the producer, returns the slot to write the next entry to, or -1
+ *       if the queue is full. SPSCQueuePush makes the written slot available
+ *       to the consumer.
+**/
+int SPSCQueueWriteSlot(SPSCQueue * queue);
+void SPSCQueuePush(SPSCQueue * queue);
+
+/**
+ * Desc: For the consumer, returns the slot of the oldest entry, or -1 if the
+ *       queue is empty. SPSCQueuePop returns the slot to the producer.
+**/
+int SPSCQueueReadSlot(SPSCQueue * queue);
+void SPSCQueuePop(SPSCQueue * queue);
+
+
+// Source
+
+typedef struct _ThreadStart {
+	ThreadFunction function;
+	void * arg;
+} _ThreadStart;
+
+#ifdef _WIN32
+	DWORD WINAPI _ThreadMain(LPVOID startPtr)
+#else
+	void * _ThreadMain(void * startPtr)
+#endif
+{
+	_ThreadStart start = *(_ThreadStart *)startPtr;
+	free(startPtr);
+	start.function(start.arg);
+	return 0;
+}
+
+int StartThread(Thread * thread, ThreadFunction function, void * arg)
+{
+	_ThreadStart * start = (_ThreadStart *)malloc(sizeof(_ThreadStart));
+	if (start == NULL) {
+		return 1;
+	}
+	start->function = function;
+	start->arg = arg;
+
+#ifdef _WIN32
+	*thread = CreateThread(NULL, 0, _ThreadMain, start, 0, NULL);
+	if (*thread == NULL) {
+		free(start);
+		return 1;
+	}
+#else
+	if (pthread_create(thread, NULL, _ThreadMain, start) != 0) {
+		free(start);
+		return 1;
+	}
+#endif
+
+	return 0;
+}
+
+void JoinThread(Thread thread)
+{
+#ifdef _WIN32
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+#else
+	pthread_join(thread, NULL);
+#endif
+}
+
+void InitMutex(Mutex * mutex)
+{
+#ifdef _WIN32
+	InitializeCriticalSection(mutex);
+#else
+	pthread_mutex_init(mutex, NULL);
+#endif
+}
+
+void LockMutex(Mutex * mutex)
+{
+#ifdef _WIN32
+	EnterCriticalSection(mutex);
+#else
+	pthread_mutex_lock(mutex);
+#endif
+}
+
+void UnlockMutex(Mutex * mutex)
+{
+#ifdef _WIN32
+	LeaveCriticalSection(mutex);
+#else
+	pthread_mutex_unlock(mutex);
+#endif
+}
+
+void DestroyMutex(Mutex * mutex)
+{
+#ifdef _WIN32
+	DeleteCriticalSection(mutex);
+#else
+	pthread_mutex_destroy(mutex);
+#endif
+}
+
+// Full memory barriers keep these simple: they are used once per block of
+// data, not per sample
+int AtomicLoadInt(volatile int * value)
+{
+	int loaded = *value;
+#ifdef _WIN32
+	MemoryBarrier();
+#else
+	__sync_synchronize();
+#endif
+	return loaded;
+}
+
+void AtomicStoreInt(volatile int * value, int newValue)
+{
+#ifdef _WIN32
+	MemoryBarrier();
+#else
+	__sync_synchronize();
+#endif
+	*value = newValue;
+}
+
+void InitSPSCQueue(SPSCQueue * queue, int numSlots)
+{
+	queue->numSlots = numSlots;
+	queue->head = 0;
+	queue->tail = 0;
+}
+
+int SPSCQueueWriteSlot(SPSCQueue * queue)
+{
+	int head = queue->head;
+	if ((head + 1) % queue->numSlots == AtomicLoadInt(&queue->tail)) {
+		return -1;
+	}
+	return head;
+}
+
+void SPSCQueuePush(SPSCQueue * queue)
+{
+	AtomicStoreInt(&queue->head, (queue->head + 1) % queue->numSlots);
+}
+
+int SPSCQueueReadSlot(SPSCQueue * queue)
+{
+	int tail = queue->tail;
+	if (tail == AtomicLoadInt(&queue->head)) {
+		return -1;
+	}
+	return tail;
+}
+
+void SPSCQueuePop(SPSCQueue * queue)
+{
+	AtomicStoreInt(&queue->tail, (queue->tail + 1) % queue->numSlots);
+}
+
+#endif // #define LJM_THREAD_UTILITIES
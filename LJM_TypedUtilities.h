@@ -0,0 +1,303 @@
+/**
+ * Name: LJM_TypedUtilities.h
+ * Desc: Provides typed read/write helper functions that move register values
+ *       as their native types (unsigned short for UINT16, unsigned int for
+ *       UINT32, int for INT32 and float for FLOAT32) instead of as doubles.
+ *       Values are transferred as raw bytes with
+ *       LJM_eReadAddressByteArray/LJM_eWriteAddressByteArray and the
+ *       big-endian Modbus register data is converted directly in the caller's
+ *       array, so no intermediate double or byte array is needed.
+ * Note: Each call accesses consecutive registers starting at the given address
+ *       or name, such as FIO_STATE through MIO_STATE (UINT16) or AIN0 through
+ *       AIN3 (FLOAT32).
+ *       The conversion loops are simple enough for the compiler to vectorize
+ *       when optimizations are enabled.
+**/
+
+#ifndef LJM_TYPED_UTILITIES
+#define LJM_TYPED_UTILITIES
+
+#include "LJM_Utilities.h"
+
+/**
+ * Desc: Converts numValues big-endian 16-bit or 32-bit register values in
+ *       place into host byte order. aValues points to the raw bytes as
+ *       received from the device, and holds host-order values on return.
+**/
+void BigEndianToHost16(unsigned short * aValues, int numValues);
+void BigEndianToHost32(unsigned int * aValues, int numValues);
+
+/**
+ * Desc: Converts numValues host-order values in place into big-endian register
+ *       bytes, ready to be written to the device. Reverses BigEndianToHost16
+ *       and BigEndianToHost32.
+**/
+void HostToBigEndian16(unsigned short * aValues, int numValues);
+void HostToBigEndian32(unsigned int * aValues, int numValues);
+
+/**
+ * Desc: Reads numValues consecutive values starting at address into aValues
+ *       in a single LJM_eReadAddressByteArray call.
+ * Retr: the LJM error code, which is LJME_NOERROR on success
+**/
+int ReadAddressUINT16Array(int handle, int address, int numValues,
+	unsigned short * aValues);
+int ReadAddressUINT32Array(int handle, int address, int numValues,
+	unsigned int * aValues);
+int ReadAddressINT32Array(int handle, int address, int numValues,
+	int * aValues);
+int ReadAddressFLOAT32Array(int handle, int address, int numValues,
+	float * aValues);
+
+/**
+ * Desc: Writes numValues consecutive values starting at address in a single
+ *       LJM_eWriteAddressByteArray call. aValues is not modified.
+ * Retr: the LJM error code, which is LJME_NOERROR on success
+**/
+int WriteAddressUINT16Array(int handle, int address, int numValues,
+	const unsigned short * aValues);
+int WriteAddressUINT32Array(int handle, int address, int numValues,
+	const unsigned int * aValues);
+int WriteAddressINT32Array(int handle, int address, int numValues,
+	const int * aValues);
+int WriteAddressFLOAT32Array(int handle, int address, int numValues,
+	const float * aValues);
+
+/**
+ * Desc: Looks up the address of name, then reads/writes like the functions
+ *       above. On error, prints message and exits the program.
+**/
+void ReadNameUINT16ArrayOrDie(int handle, const char * name, int numValues,
+	unsigned short * aValues);
+void ReadNameUINT32ArrayOrDie(int handle, const char * name, int numValues,
+	unsigned int * aValues);
+void ReadNameFLOAT32ArrayOrDie(int handle, const char * name, int numValues,
+	float * aValues);
+void WriteNameUINT16ArrayOrDie(int handle, const char * name, int numValues,
+	const unsigned short * aValues);
+void WriteNameUINT32ArrayOrDie(int handle, const char * name, int numValues,
+	const unsigned int * aValues);
+void WriteNameFLOAT32ArrayOrDie(int handle, const char * name, int numValues,
+	const float * aValues);
+
+
+// Source
+
+void BigEndianToHost16(unsigned short * aValues, int numValues)
+{
+	int i;
+	unsigned char * bytes = (unsigned char *)aValues;
+	for (i = 0; i < numValues; i++) {
+		aValues[i] = (unsigned short)((bytes[2 * i] << 8) | bytes[2 * i + 1]);
+	}
+}
+
+void BigEndianToHost32(unsigned int * aValues, int numValues)
+{
+	int i;
+	unsigned char * bytes = (unsigned char *)aValues;
+	for (i = 0; i < numValues; i++) {
+		aValues[i] =
+			((unsigned int)bytes[4 * i] << 24) |
+			((unsigned int)bytes[4 * i + 1] << 16) |
+			((unsigned int)bytes[4 * i + 2] << 8) |
+			(unsigned int)bytes[4 * i + 3];
+	}
+}
+
+void HostToBigEndian16(unsigned short * aValues, int numValues)
+{
+	int i;
+	unsigned short value;
+	unsigned char * bytes = (unsigned char *)aValues;
+	for (i = 0; i < numValues; i++) {
+		value = aValues[i];
+		bytes[2 * i] = (unsigned char)(value >> 8);
+		bytes[2 * i + 1] = (unsigned char)value;
+	}
+}
+
+void HostToBigEndian32(unsigned int * aValues, int numValues)
+{
+	int i;
+	unsigned int value;
+	unsigned char * bytes = (unsigned char *)aValues;
+	for (i = 0; i < numValues; i++) {
+		value = aValues[i];
+		bytes[4 * i] = (unsigned char)(value >> 24);
+		bytes[4 * i + 1] = (unsigned char)(value >> 16);
+		bytes[4 * i + 2] = (unsigned char)(value >> 8);
+		bytes[4 * i + 3] = (unsigned char)value;
+	}
+}
+
+// Reads numBytes raw register bytes starting at address into aBytes
+int _ReadAddressRawBytes(int handle, int address, int numBytes, void * aBytes)
+{
+	int errorAddress = INITIAL_ERR_ADDRESS;
+	int err = LJM_eReadAddressByteArray(handle, address, numBytes,
+		(char *)aBytes, &errorAddress);
+	PrintErrorWithAddressIfError(err, errorAddress,
+		"LJM_eReadAddressByteArray(Handle=%d, Address=%d, NumBytes=%d, ...)",
+		handle, address, numBytes);
+	return err;
+}
+
+// Writes numBytes raw register bytes starting at address from aBytes
+int _WriteAddressRawBytes(int handle, int address, int numBytes,
+	const void * aBytes)
+{
+	int errorAddress = INITIAL_ERR_ADDRESS;
+	int err = LJM_eWriteAddressByteArray(handle, address, numBytes,
+		(const char *)aBytes, &errorAddress);
+	PrintErrorWithAddressIfError(err, errorAddress,
+		"LJM_eWriteAddressByteArray(Handle=%d, Address=%d, NumBytes=%d, ...)",
+		handle, address, numBytes);
+	return err;
+}
+
+int ReadAddressUINT16Array(int handle, int address, int numValues,
+	unsigned short * aValues)
+{
+	int err = _ReadAddressRawBytes(handle, address, numValues * 2, aValues);
+	if (err == LJME_NOERROR) {
+		BigEndianToHost16(aValues, numValues);
+	}
+	return err;
+}
+
+int ReadAddressUINT32Array(int handle, int address, int numValues,
+	unsigned int * aValues)
+{
+	int err = _ReadAddressRawBytes(handle, address, numValues * 4, aValues);
+	if (err == LJME_NOERROR) {
+		BigEndianToHost32(aValues, numValues);
+	}
+	return err;
+}
+
+int ReadAddressINT32Array(int handle, int address, int numValues,
+	int * aValues)
+{
+	return ReadAddressUINT32Array(handle, address, numValues,
+		(unsigned int *)aValues);
+}
+
+int ReadAddressFLOAT32Array(int handle, int address, int numValues,
+	float * aValues)
+{
+	int i;
+	unsigned int value;
+	unsigned char * bytes = (unsigned char *)aValues;
+	int err = _ReadAddressRawBytes(handle, address, numValues * 4, aValues);
+	if (err != LJME_NOERROR) {
+		return err;
+	}
+
+	// Copy the IEEE 754 bits of each big-endian value into the float
+	for (i = 0; i < numValues; i++) {
+		value =
+			((unsigned int)bytes[4 * i] << 24) |
+			((unsigned int)bytes[4 * i + 1] << 16) |
+			((unsigned int)bytes[4 * i + 2] << 8) |
+			(unsigned int)bytes[4 * i + 3];
+		memcpy(&aValues[i], &value, sizeof(float));
+	}
+	return LJME_NOERROR;
+}
+
+int WriteAddressUINT16Array(int handle, int address, int numValues,
+	const unsigned short * aValues)
+{
+	int err;
+	unsigned short * aBytes = malloc(sizeof(unsigned short) * numValues);
+	memcpy(aBytes, aValues, sizeof(unsigned short) * numValues);
+	HostToBigEndian16(aBytes, numValues);
+	err = _WriteAddressRawBytes(handle, address, numValues * 2, aBytes);
+	free(aBytes);
+	return err;
+}
+
+int WriteAddressUINT32Array(int handle, int address, int numValues,
+	const unsigned int * aValues)
+{
+	int err;
+	unsigned int * aBytes = malloc(sizeof(unsigned int) * numValues);
+	memcpy(aBytes, aValues, sizeof(unsigned int) * numValues);
+	HostToBigEndian32(aBytes, numValues);
+	err = _WriteAddressRawBytes(handle, address, numValues * 4, aBytes);
+	free(aBytes);
+	return err;
+}
+
+int WriteAddressINT32Array(int handle, int address, int numValues,
+	const int * aValues)
+{
+	return WriteAddressUINT32Array(handle, address, numValues,
+		(const unsigned int *)aValues);
+}
+
+int WriteAddressFLOAT32Array(int handle, int address, int numValues,
+	const float * aValues)
+{
+	int err;
+	unsigned int * aBytes = malloc(sizeof(unsigned int) * numValues);
+	memcpy(aBytes, aValues, sizeof(float) * numValues);
+	HostToBigEndian32(aBytes, numValues);
+	err = _WriteAddressRawBytes(handle, address, numValues * 4, aBytes);
+	free(aBytes);
+	return err;
+}
+
+void _TypedErrorCheck(int err)
+{
+	if (err != LJME_NOERROR) {
+		WaitForUserIfWindows();
+		LJM_CloseAll();
+		exit(err);
+	}
+}
+
+void ReadNameUINT16ArrayOrDie(int handle, const char * name, int numValues,
+	unsigned short * aValues)
+{
+	_TypedErrorCheck(ReadAddressUINT16Array(handle,
+		GetAddressFromNameOrDie(name), numValues, aValues));
+}
+
+void ReadNameUINT32ArrayOrDie(int handle, const char * name, int numValues,
+	unsigned int * aValues)
+{
+	_TypedErrorCheck(ReadAddressUINT32Array(handle,
+		GetAddressFromNameOrDie(name), numValues, aValues));
+}
+
+void ReadNameFLOAT32ArrayOrDie(int handle, const char * name, int numValues,
+	float * aValues)
+{
+	_TypedErrorCheck(ReadAddressFLOAT32Array(handle,
+		GetAddressFromNameOrDie(name), numValues, aValues));
+}
+
+void WriteNameUINT16ArrayOrDie(int handle, const char * name, int numValues,
+	const unsigned short * aValues)
+{
+	_TypedErrorCheck(WriteAddressUINT16Array(handle,
+		GetAddressFromNameOrDie(name), numValues, aValues));
+}
+
+void WriteNameUINT32ArrayOrDie(int handle, const char * name, int numValues,
+	const unsigned int * aValues)
+{
+	_TypedErrorCheck(WriteAddressUINT32Array(handle,
+		GetAddressFromNameOrDie(name), numValues, aValues));
+}
+
+void WriteNameFLOAT32ArrayOrDie(int handle, const char * name, int numValues,
+	const float * aValues)
+{
+	_TypedErrorCheck(WriteAddressFLOAT32Array(handle,
+		GetAddressFromNameOrDie(name), numValues, aValues));
+}
+
+#endif // #define LJM_TYPED_UTILITIES
@@ -0,0 +1,96 @@
+/**
+ * Name: 1-wire_temperatures.c
+ * Desc: Demonstrates LJM_OneWireUtilities.h by reading every DS18B20, DS1822
+ *       or DS18S20 temperature sensor on a 1-Wire bus.
+ *       - Enumerates the ROMs of all devices on EIO0.
+ *       - Then, repeatedly starts a conversion on all sensors at once and
+ *         reads every sensor with a single LJM_eNames call.
+ * Note: Usage: 1-wire_temperatures [num_reads]
+ *
+ * Relevant Documentation:
+ *
+ * LJM Library:
+ *	LJM Library Installer
+ *		 https://labjack.com/support/software/installers/ljm
+ *	LJM Users Guide:
+ *		https://labjack.com/support/software/api/ljm
+ *	Opening and Closing:
+ *		https://labjack.com/support/software/api/ljm/function-reference/opening-and-closing
+ *	eNames:
+ *		https://labjack.com/support/software/api/ljm/function-reference/ljmenames
+ *
+ * T-Series and I/O:
+ *	1-Wire:
+ *		https://labjack.com/support/datasheets/t-series/digital-io/1-wire
+ *	Modbus Map:
+ *		https://labjack.com/support/software/api/modbus/modbus-map
+ *	Digital I/O:
+ *		https://labjack.com/support/datasheets/t-series/digital-io
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <LabJackM.h>
+
+#include "../../LJM_OneWireUtilities.h"
+
+int main(int argc, const char * argv[])
+{
+    int handle, err, i, r, numValid;
+    int numReads = 5;
+    double aTemperatures[ONEWIRE_MAX_ROMS];
+    LJM_LONG_LONG_RETURN start;
+    OneWireBus bus;
+
+    // DQ on EIO0 (8), no dynamic pullup and no options, as in 1-wire.c
+    const int dqDIONum = 8;
+    const int dpuDIONum = 0;
+    const int options = 0;
+
+    if (argc >= 2) {
+        numReads = atoi(argv[1]);
+    }
+
+    // Open first found LabJack
+    handle = OpenOrDie(LJM_dtANY, LJM_ctANY, "LJM_idANY");
+    // handle = OpenSOrDie("LJM_dtANY", "LJM_ctANY", "LJM_idANY");
+
+    PrintDeviceInfoFromHandle(handle);
+    printf("\n");
+
+    InitOneWireBus(&bus, handle, dqDIONum, dpuDIONum, options);
+
+    start = LJM_GetHostTick();
+    err = EnumerateOneWireBus(&bus);
+    ErrorCheck(err, "EnumerateOneWireBus");
+    PrintOneWireROMs(&bus);
+    printf("Enumerated in %.1f ms\n\n", (LJM_GetHostTick() - start) / 1000.0);
+
+    for (i = 0; i < numReads; i++) {
+        start = LJM_GetHostTick();
+        err = ReadOneWireTemperatures(&bus, aTemperatures, &numValid);
+        ErrorCheck(err, "ReadOneWireTemperatures");
+
+        printf("Read %d of %d sensors in %.1f ms:", numValid, bus.numROMs,
+            (LJM_GetHostTick() - start) / 1000.0);
+        for (r = 0; r < bus.numROMs; r++) {
+            if (aTemperatures[r] == ONEWIRE_INVALID_TEMPERATURE) {
+                printf("  ---");
+            }
+            else {
+                printf("  %.4f C", aTemperatures[r]);
+            }
+        }
+        printf("\n");
+    }
+
+    printf("\n");
+    PrintOneWireBusStatistics(&bus);
+
+    CloseOrDie(handle);
+
+    WaitForUserIfWindows();
+
+    return LJME_NOERROR;
+}
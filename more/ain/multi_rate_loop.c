@@ -0,0 +1,158 @@
+/**
+ * Name: multi_rate_loop.c
+ * Desc: Demonstrates reading several groups of registers at different rates
+ *       from one LabJack using LJM_IntervalScheduler.h. A single
+ *       LJM_StartInterval loop runs at the greatest common divisor of the
+ *       group periods; on each interval, every group that is due is merged
+ *       into one LJM_eNames call so the groups never contend for the device.
+ *       Overruns (skipped intervals) and timing jitter are reported at the
+ *       end.
+ * Note: Command-response round trips take roughly 0.1 ms to several ms
+ *       depending on the connection type, so a 1 ms base interval may overrun
+ *       on slower connections. Use stream mode for faster, hardware-timed
+ *       AIN data.
+ *
+ * Relevant Documentation:
+ *
+ * LJM Library:
+ *	LJM Library Installer:
+ *		https://labjack.com/support/software/installers/ljm
+ *	LJM Users Guide:
+ *		https://labjack.com/support/software/api/ljm
+ *	Opening and Closing:
+ *		https://labjack.com/support/software/api/ljm/function-reference/opening-and-closing
+ *	Multiple Value Functions(such as eNames):
+ *		https://labjack.com/support/software/api/ljm/function-reference/multiple-value-functions
+ *	Timing Functions(such as StartInterval):
+ *		https://labjack.com/support/software/api/ljm/function-reference/timing-functions
+ *
+ * T-Series and I/O:
+ *	Modbus Map:
+ *		https://labjack.com/support/software/api/modbus/modbus-map
+ *	Analog Inputs:
+ *		https://labjack.com/support/datasheets/t-series/ain
+ *	Digital I/O:
+ *		https://labjack.com/support/datasheets/t-series/digital-io
+**/
+
+// For printf
+#include <stdio.h>
+
+// For the LabJackM Library
+#include <LabJackM.h>
+
+// For LabJackM helper functions, such as OpenOrDie, PrintDeviceInfoFromHandle,
+// ErrorCheck, etc.
+#include "../../LJM_Utilities.h"
+
+// For Scheduler, InitScheduler, RunSchedulerInterval, etc.
+#include "../../LJM_IntervalScheduler.h"
+
+enum { RUN_SECONDS = 10 };
+
+enum { INTERVAL_HANDLE = 1 };
+
+void ConfigureAIN(int handle, int deviceType);
+
+int main()
+{
+	int handle, deviceType;
+	int aRanGroups[MAX_SCHEDULED_GROUPS];
+	Scheduler scheduler;
+
+	enum { NUM_AIN = 4 };
+	const char * aNamesAIN[NUM_AIN] = {"AIN0", "AIN1", "AIN2", "AIN3"};
+	const int aWritesAIN[NUM_AIN] = {LJM_READ, LJM_READ, LJM_READ, LJM_READ};
+	double aValuesAIN[NUM_AIN] = {0};
+
+	enum { NUM_TEMPERATURES = 2 };
+	const char * aNamesTemperatures[NUM_TEMPERATURES] = {
+		"TEMPERATURE_DEVICE_K",
+		"TEMPERATURE_AIR_K"
+	};
+	const int aWritesTemperatures[NUM_TEMPERATURES] = {LJM_READ, LJM_READ};
+	double aValuesTemperatures[NUM_TEMPERATURES] = {0};
+
+	enum { NUM_STATUS = 2 };
+	const char * aNamesStatus[NUM_STATUS] = {"CORE_TIMER", "DIO_STATE"};
+	const int aWritesStatus[NUM_STATUS] = {LJM_READ, LJM_READ};
+	double aValuesStatus[NUM_STATUS] = {0};
+
+	enum { AIN_GROUP, TEMPERATURE_GROUP, STATUS_GROUP, NUM_GROUPS };
+	ScheduledGroup groups[NUM_GROUPS];
+
+	groups[AIN_GROUP].description = "AIN (1 kHz)";
+	groups[AIN_GROUP].periodUS = 1000;
+	groups[AIN_GROUP].numFrames = NUM_AIN;
+	groups[AIN_GROUP].aNames = aNamesAIN;
+	groups[AIN_GROUP].aWrites = aWritesAIN;
+	groups[AIN_GROUP].aValues = aValuesAIN;
+
+	groups[TEMPERATURE_GROUP].description = "temperatures (10 Hz)";
+	groups[TEMPERATURE_GROUP].periodUS = 100000;
+	groups[TEMPERATURE_GROUP].numFrames = NUM_TEMPERATURES;
+	groups[TEMPERATURE_GROUP].aNames = aNamesTemperatures;
+	groups[TEMPERATURE_GROUP].aWrites = aWritesTemperatures;
+	groups[TEMPERATURE_GROUP].aValues = aValuesTemperatures;
+
+	groups[STATUS_GROUP].description = "status (1 Hz)";
+	groups[STATUS_GROUP].periodUS = 1000000;
+	groups[STATUS_GROUP].numFrames = NUM_STATUS;
+	groups[STATUS_GROUP].aNames = aNamesStatus;
+	groups[STATUS_GROUP].aWrites = aWritesStatus;
+	groups[STATUS_GROUP].aValues = aValuesStatus;
+
+	// Open first found LabJack
+	handle = OpenOrDie(LJM_dtANY, LJM_ctANY, "LJM_idANY");
+	// handle = OpenSOrDie("LJM_dtANY", "LJM_ctANY", "LJM_idANY");
+
+	PrintDeviceInfoFromHandle(handle);
+	deviceType = GetDeviceType(handle);
+
+	ConfigureAIN(handle, deviceType);
+
+	InitScheduler(&scheduler, handle, INTERVAL_HANDLE, NUM_GROUPS, groups);
+	printf("\nBase interval: %d us. Running for %d seconds.\n",
+		scheduler.baseUS, RUN_SECONDS);
+
+	StartScheduler(&scheduler);
+	while (scheduler.tick * (double)scheduler.baseUS < RUN_SECONDS * 1e6) {
+		RunSchedulerInterval(&scheduler, aRanGroups);
+
+		// Print once per second, when the status group runs
+		if (aRanGroups[STATUS_GROUP]) {
+			printf("CORE_TIMER: %.0f, DIO_STATE: 0x%05x, "
+				"AIN0: %f V, device: %.2f K, air: %.2f K\n",
+				aValuesStatus[0], (unsigned int)aValuesStatus[1],
+				aValuesAIN[0], aValuesTemperatures[0],
+				aValuesTemperatures[1]);
+		}
+	}
+	StopScheduler(&scheduler);
+
+	printf("\n");
+	PrintSchedulerStatistics(&scheduler);
+
+	CloseOrDie(handle);
+
+	WaitForUserIfWindows();
+
+	return LJME_NOERROR;
+}
+
+void ConfigureAIN(int handle, int deviceType)
+{
+	// Resolution index = 0 (default), settling = 0 (auto)
+	WriteNameOrDie(handle, "AIN_ALL_RESOLUTION_INDEX", 0);
+	WriteNameOrDie(handle, "AIN_ALL_SETTLING_US", 0);
+
+	// Range/gain configs only apply to the T7/T8
+	if (deviceType != LJM_dtT4) {
+		// Range = 10; This corresponds to +/-10V (T7), or +/-11V (T8)
+		WriteNameOrDie(handle, "AIN_ALL_RANGE", 10);
+	}
+	// Negative channel = single ended (199). Only applies to the T7
+	if (deviceType == LJM_dtT7) {
+		WriteNameOrDie(handle, "AIN_ALL_NEGATIVE_CH", LJM_GND);
+	}
+}
@@ -0,0 +1,100 @@
+/**
+ * Name: thermocouple_array.c
+ * Desc: Demonstrates TCArray of LJM_ThermocoupleUtilities.h, which configures
+ *       the thermocouple AIN_EF of several channels with one
+ *       LJM_eWriteAddresses call and reads every channel's temperature,
+ *       volts and CJC temperature with one LJM_eReadAddresses call per
+ *       cycle. Each channel may use different temperature units.
+ *       The thermocouple AIN_EF is supported by the T7 and T8.
+ *
+ * Relevant Documentation:
+ *
+ * Thermocouple App-Note:
+ *		https://labjack.com/support/app-notes/thermocouples
+ *
+ * LJM Library:
+ *	LJM Library Installer:
+ *		https://labjack.com/support/software/installers/ljm
+ *	LJM Users Guide:
+ *		https://labjack.com/support/software/api/ljm
+ *	Opening and Closing:
+ *		https://labjack.com/support/software/api/ljm/function-reference/opening-and-closing
+ *	Multiple Value Functions(such as eReadAddresses):
+ *		https://labjack.com/support/software/api/ljm/function-reference/multiple-value-functions
+ *
+ * T-Series and I/O:
+ *	Modbus Map:
+ *		https://labjack.com/support/software/api/modbus/modbus-map
+ *	Analog Inputs:
+ *		https://labjack.com/support/datasheets/t-series/ain
+ *	Thermocouple AIN_EF:
+ *		https://labjack.com/support/datasheets/t-series/ain/extended-features/thermocouple
+**/
+
+#include <stdio.h>
+
+#include <LabJackM.h>
+
+#include "../../LJM_ThermocoupleUtilities.h"
+
+enum { NUM_CHANNELS = 4 };
+enum { NUM_CYCLES = 10 };
+
+// Use TEMPERATURE_DEVICE_K for CJC
+enum { CJC_ADDRESS = 60052 };
+
+int main()
+{
+	int handle, cycle, i;
+	LJM_LONG_LONG_RETURN start;
+	TCArray tcArray;
+
+	// Type K thermocouples on AIN0 to AIN3, single-ended
+	const TCChannelConfig CONFIGS[NUM_CHANNELS] = {
+		{LJM_ttK, 0, TC_NEG_CHANNEL_GND, 0, CJC_ADDRESS, 1, 0, TC_UNITS_C},
+		{LJM_ttK, 1, TC_NEG_CHANNEL_GND, 0, CJC_ADDRESS, 1, 0, TC_UNITS_C},
+		{LJM_ttK, 2, TC_NEG_CHANNEL_GND, 0, CJC_ADDRESS, 1, 0, TC_UNITS_F},
+		{LJM_ttK, 3, TC_NEG_CHANNEL_GND, 0, CJC_ADDRESS, 1, 0, TC_UNITS_K}
+	};
+
+	// Open first found LabJack
+	handle = OpenOrDie(LJM_dtANY, LJM_ctANY, "LJM_idANY");
+	// handle = OpenSOrDie("LJM_dtANY", "LJM_ctANY", "LJM_idANY");
+
+	PrintDeviceInfoFromHandle(handle);
+	printf("\n");
+
+	if (GetDeviceType(handle) == LJM_dtT4) {
+		printf("The T4 does not support the thermocouple AIN_EF\n");
+		CloseOrDie(handle);
+		WaitForUserIfWindows();
+		return 1;
+	}
+
+	InitTCArray(&tcArray, handle, NUM_CHANNELS, CONFIGS);
+	ConfigureTCArrayOrDie(&tcArray);
+
+	for (cycle = 0; cycle < NUM_CYCLES; cycle++) {
+		start = LJM_GetHostTick();
+		ReadTCArrayOrDie(&tcArray);
+
+		printf("Cycle %d (%.1f ms):\n", cycle,
+			(LJM_GetHostTick() - start) / 1000.0);
+		for (i = 0; i < NUM_CHANNELS; i++) {
+			printf("    AIN%d: TCTemp: %f %c,\tTCVolts: %f,\tCJTemp: %f %c\n",
+				CONFIGS[i].posChannel, tcArray.aTemps[i],
+				TCUnitsSymbol(CONFIGS[i].units), tcArray.aVolts[i],
+				tcArray.aCJTemps[i], TCUnitsSymbol(CONFIGS[i].units));
+		}
+
+		MillisecondSleep(1000);
+	}
+
+	PrintTCArrayStatistics(&tcArray);
+
+	CloseOrDie(handle);
+
+	WaitForUserIfWindows();
+
+	return LJME_NOERROR;
+}
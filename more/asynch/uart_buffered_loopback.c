@@ -0,0 +1,101 @@
+/**
+ * Name: uart_buffered_loopback.c
+ * Desc: Demonstrates LJM_AsynchUtilities.h at 115200/8/N/1. A block of bytes
+ *       is written with AsynchWrite and read back with AsynchRead while the
+ *       AsynchPort thread continuously drains the device's RX buffer, then
+ *       the bytes read are compared with the bytes written.
+ *       If you short RX to TX, then you will read back the same bytes that
+ *       you write.
+ *
+ * Relevant Documentation:
+ *
+ * LJM Library:
+ *	LJM Library Installer:
+ *		https://labjack.com/support/software/installers/ljm
+ *	LJM Users Guide:
+ *		https://labjack.com/support/software/api/ljm
+ *	Opening and Closing:
+ *		https://labjack.com/support/software/api/ljm/function-reference/opening-and-closing
+ *	eNames:
+ *		https://labjack.com/support/software/api/ljm/function-reference/ljmenames
+ *
+ * T-Series and I/O:
+ *	Modbus Map:
+ *		https://labjack.com/support/software/api/modbus/modbus-map
+ *	Asynchronous Serial:
+ *		https://labjack.com/support/datasheets/t-series/digital-io/asynchronous-serial
+**/
+
+#include <stdio.h>
+
+#include <LabJackM.h>
+
+#include "../../LJM_AsynchUtilities.h"
+
+enum { NUM_BYTES = 4096 };
+enum { READ_TIMEOUT_MS = 1000 };
+
+int main()
+{
+	int handle, i;
+	int numWritten, numRead, numMismatched;
+	unsigned char aWrite[NUM_BYTES];
+	unsigned char aRead[NUM_BYTES];
+	LJM_LONG_LONG_RETURN start;
+	AsynchPort port;
+
+	// Open first found LabJack
+	handle = OpenOrDie(LJM_dtANY, LJM_ctANY, "LJM_idANY");
+	// handle = OpenSOrDie("LJM_dtANY", "LJM_ctANY", "LJM_idANY");
+
+	PrintDeviceInfoFromHandle(handle);
+	printf("\n");
+
+	printf("Short FIO0 and FIO1 together to read back the same bytes:\n\n");
+
+	// RX on FIO0 and TX on FIO1, as in uart_loopback_test.c, with 512-byte
+	// device buffers
+	InitAsynchPort(&port, handle, 0, 1, 115200, 8, 0, 1, 512, 512);
+	ErrorCheck(StartAsynchPort(&port), "StartAsynchPort");
+
+	for (i = 0; i < NUM_BYTES; i++) {
+		aWrite[i] = (unsigned char)(i * 13);
+	}
+
+	start = LJM_GetHostTick();
+
+	numWritten = AsynchWrite(&port, aWrite, NUM_BYTES, READ_TIMEOUT_MS);
+	printf("Queued %d bytes\n", numWritten);
+
+	// Read until no more bytes arrive within READ_TIMEOUT_MS
+	numRead = 0;
+	while (numRead < NUM_BYTES) {
+		i = AsynchRead(&port, aRead + numRead, NUM_BYTES - numRead,
+			READ_TIMEOUT_MS);
+		if (i == 0) {
+			break;
+		}
+		numRead += i;
+	}
+
+	printf("Read %d bytes in %.1f ms\n", numRead,
+		(LJM_GetHostTick() - start) / 1000.0);
+
+	numMismatched = 0;
+	for (i = 0; i < numRead; i++) {
+		if (aRead[i] != aWrite[i]) {
+			numMismatched++;
+		}
+	}
+	printf("%d of the bytes read did not match the bytes written\n\n",
+		numMismatched);
+
+	StopAsynchPort(&port);
+	PrintAsynchPortStatistics(&port);
+
+	CloseOrDie(handle);
+
+	WaitForUserIfWindows();
+
+	return LJME_NOERROR;
+}
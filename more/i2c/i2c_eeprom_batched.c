@@ -0,0 +1,142 @@
+/**
+ * Name: i2c_eeprom_batched.c
+ * Desc: Demonstrates LJM_I2CUtilities.h by reading the user memory of a
+ *       LJTick-DAC EEPROM in 8-byte transactions, first executing one
+ *       transaction per LJM_eNames call and then queueing all transactions
+ *       and executing them with a single LJM_eNames call.
+ *       The LJTick-DAC is connected to FIO0/FIO1 for the T7 and T8, or
+ *       FIO4/FIO5 for the T4, as in i2c_eeprom.c.
+ *
+ * Relevant Documentation:
+ *
+ * LJM Library:
+ *	LJM Library Installer:
+ *		https://labjack.com/support/software/installers/ljm
+ *	LJM Users Guide:
+ *		https://labjack.com/support/software/api/ljm
+ *	Opening and Closing:
+ *		https://labjack.com/support/software/api/ljm/function-reference/opening-and-closing
+ *	eNames:
+ *		https://labjack.com/support/software/api/ljm/function-reference/ljmenames
+ *
+ * T-Series and I/O:
+ *	Modbus Map:
+ *		https://labjack.com/support/software/api/modbus/modbus-map
+ *	Digital I/O:
+ *		https://labjack.com/support/datasheets/t-series/digital-io
+ *	I2C:
+ *		https://labjack.com/support/datasheets/t-series/digital-io/i2c
+ *	LJTick-DAC:
+ *		https://labjack.com/support/datasheets/accessories/ljtick-dac
+**/
+
+#include <stdio.h>
+
+#include <LabJackM.h>
+
+#include "../../LJM_I2CUtilities.h"
+
+// The LJTick-DAC EEPROM
+enum { EEPROM_SLAVE_ADDRESS = 80 }; // 0x50
+enum { USER_MEMORY_BYTES = 64 };
+enum { BYTES_PER_TRANSACTION = 8 };
+
+enum { NUM_TRANSACTIONS = USER_MEMORY_BYTES / BYTES_PER_TRANSACTION };
+
+// Reads the user memory into aMemory, executing each transaction separately
+// if batched is 0 or all transactions together otherwise
+void ReadUserMemory(I2CBus * bus, int batched,
+	unsigned char aMemory[USER_MEMORY_BYTES]);
+
+int main()
+{
+	int handle, i;
+	int sdaDIONum, sclDIONum;
+	LJM_LONG_LONG_RETURN start;
+	double singleMS, batchedMS;
+	unsigned char aMemory[USER_MEMORY_BYTES];
+	I2CBus bus;
+
+	// Open first found LabJack
+	handle = OpenOrDie(LJM_dtANY, LJM_ctANY, "LJM_idANY");
+	// handle = OpenSOrDie("LJM_dtANY", "LJM_ctANY", "LJM_idANY");
+
+	PrintDeviceInfoFromHandle(handle);
+	printf("\n");
+
+	if (GetDeviceType(handle) == LJM_dtT4) {
+		// FIO0 to FIO3 are reserved for analog inputs on the T4
+		sdaDIONum = 5; // FIO5
+		sclDIONum = 4; // FIO4
+	}
+	else {
+		sdaDIONum = 1; // FIO1
+		sclDIONum = 0; // FIO0
+	}
+
+	// Speed throttle 0 (the fastest) and no options
+	InitI2CBus(&bus, handle, sdaDIONum, sclDIONum, 0, 0);
+
+	start = LJM_GetHostTick();
+	ReadUserMemory(&bus, 0, aMemory);
+	singleMS = (LJM_GetHostTick() - start) / 1000.0;
+
+	start = LJM_GetHostTick();
+	ReadUserMemory(&bus, 1, aMemory);
+	batchedMS = (LJM_GetHostTick() - start) / 1000.0;
+
+	printf("User Memory [0-%d]:\n", USER_MEMORY_BYTES - 1);
+	for (i = 0; i < USER_MEMORY_BYTES; i++) {
+		printf("%3d ", aMemory[i]);
+		if (i % 16 == 15) {
+			printf("\n");
+		}
+	}
+	printf("\n");
+
+	printf("%d transactions, one at a time: %.2f ms\n", NUM_TRANSACTIONS,
+		singleMS);
+	printf("%d transactions, batched:       %.2f ms\n", NUM_TRANSACTIONS,
+		batchedMS);
+	PrintI2CBusStatistics(&bus);
+
+	CloseOrDie(handle);
+
+	WaitForUserIfWindows();
+
+	return LJME_NOERROR;
+}
+
+void ReadUserMemory(I2CBus * bus, int batched,
+	unsigned char aMemory[USER_MEMORY_BYTES])
+{
+	int t, err;
+	unsigned char memoryPointer;
+	unsigned int aAcks[NUM_TRANSACTIONS];
+
+	// Each transaction writes the EEPROM's memory pointer, then reads
+	for (t = 0; t < NUM_TRANSACTIONS; t++) {
+		memoryPointer = (unsigned char)(t * BYTES_PER_TRANSACTION);
+		if (batched) {
+			err = QueueI2CTransaction(bus, EEPROM_SLAVE_ADDRESS, 1,
+				&memoryPointer, BYTES_PER_TRANSACTION,
+				aMemory + memoryPointer, &aAcks[t]);
+			ErrorCheck(err, "QueueI2CTransaction");
+		}
+		else {
+			I2CTransferOrDie(bus, EEPROM_SLAVE_ADDRESS, 1, &memoryPointer,
+				BYTES_PER_TRANSACTION, aMemory + memoryPointer, &aAcks[t]);
+		}
+	}
+	if (batched) {
+		err = ExecuteI2CTransactions(bus);
+		ErrorCheck(err, "ExecuteI2CTransactions");
+	}
+
+	for (t = 0; t < NUM_TRANSACTIONS; t++) {
+		if (aAcks[t] == 0) {
+			printf("Transaction %d was not acknowledged. Is the LJTick-DAC "
+				"connected?\n", t);
+		}
+	}
+}
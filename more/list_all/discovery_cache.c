@@ -0,0 +1,92 @@
+/**
+ * Name: discovery_cache.c
+ * Desc: Demonstrates LJM_DiscoveryCache.h. On the first run, devices are found
+ *       with LJM_ListAllExtended and the results are saved to a cache file. On
+ *       later runs, the cached devices are opened in parallel without waiting
+ *       for discovery, and the cache is refreshed in a background thread while
+ *       the devices are read.
+ *
+ * Relevant Documentation:
+ *
+ * LJM Library:
+ *	LJM Library Installer:
+ *		https://labjack.com/support/software/installers/ljm
+ *	LJM Users Guide:
+ *		https://labjack.com/support/software/api/ljm
+ *	Opening and Closing:
+ *		https://labjack.com/support/software/api/ljm/function-reference/opening-and-closing
+ *	ListAllExtended:
+ *		https://labjack.com/support/software/api/ljm/function-reference/ljmlistallextended
+ *	NamesToAddresses:
+ *		https://labjack.com/support/software/api/ljm/function-reference/utility/ljmnamestoaddresses
+ *	Single Value Functions(such as eReadName):
+ *		https://labjack.com/support/software/api/ljm/function-reference/single-value-functions
+**/
+
+#include <stdio.h>
+
+#include <LabJackM.h>
+
+#include "../../LJM_DiscoveryCache.h"
+
+static const char * CACHE_FILE_PATH = "ljm_discovery_cache.txt";
+
+int main()
+{
+	const int DeviceType = LJM_dtANY;
+	const int ConnectionType = LJM_ctANY;
+	enum { NumAddresses = 2 };
+	const char * aNames[NumAddresses] = {"DEVICE_NAME_DEFAULT", "FIRMWARE_VERSION"};
+
+	int err, i, numCached, numOpened;
+	int aHandles[LJM_LIST_ALL_SIZE];
+	LJM_LONG_LONG_RETURN start;
+	DiscoveryCache cache;
+
+	err = InitDiscoveryCache(&cache, CACHE_FILE_PATH, NumAddresses, aNames);
+	ErrorCheck(err, "InitDiscoveryCache");
+
+	start = LJM_GetHostTick();
+
+	numCached = LoadDiscoveryCache(&cache);
+	if (numCached > 0) {
+		printf("Loaded %d cached device connections from %s\n", numCached,
+			CACHE_FILE_PATH);
+
+		// Refresh while the cached devices are opened and used
+		StartDiscoveryRefresh(&cache, DeviceType, ConnectionType);
+	}
+	else {
+		printf("No usable cache at %s, calling LJM_ListAllExtended\n",
+			CACHE_FILE_PATH);
+		err = RefreshDiscoveryCache(&cache, DeviceType, ConnectionType);
+		ErrorCheck(err, "RefreshDiscoveryCache");
+	}
+
+	numOpened = OpenCachedDevices(&cache, LJM_LIST_ALL_SIZE, aHandles);
+	printf("Opened %d devices in %.1f ms\n\n", numOpened,
+		(LJM_GetHostTick() - start) / 1000.0);
+
+	for (i = 0; i < numOpened; i++) {
+		PrintDeviceInfoFromHandle(aHandles[i]);
+		GetAndPrint(aHandles[i], "SERIAL_NUMBER");
+		printf("\n");
+	}
+
+	err = WaitForDiscoveryRefresh(&cache);
+	PrintErrorIfError(err, "WaitForDiscoveryRefresh");
+	if (numCached > 0 && err == LJME_NOERROR) {
+		printf("Background refresh took %.1f ms\n", cache.refreshMS);
+	}
+	PrintCachedDevices(&cache);
+
+	for (i = 0; i < numOpened; i++) {
+		CloseOrDie(aHandles[i]);
+	}
+
+	CleanDiscoveryCache(&cache);
+
+	WaitForUserIfWindows();
+
+	return LJME_NOERROR;
+}
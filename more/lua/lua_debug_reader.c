@@ -0,0 +1,101 @@
+/**
+ * Name: lua_debug_reader.c
+ * Desc: Runs a Lua script that prints quickly and reads its debug output with
+ *       a LuaDebugReader from LJM_LuaUtilities.h. The reader drains
+ *       LUA_DEBUG_DATA in a background thread, polling faster while output is
+ *       arriving, and passes each line to a callback. Each line is also passed
+ *       to LJM_Log at the LJM_DEBUG level.
+ * Note: Usage: lua_debug_reader [seconds]
+ *
+ * Relevant Documentation:
+ *
+ * LJM Library:
+ *	LJM Library Installer:
+ *		https://labjack.com/support/software/installers/ljm
+ *	LJM Users Guide:
+ *		https://labjack.com/support/software/api/ljm
+ *	Opening and Closing:
+ *		https://labjack.com/support/software/api/ljm/function-reference/opening-and-closing
+ *	Multiple Value Functions(such as eReadNameByteArray):
+ *		https://labjack.com/support/software/api/ljm/function-reference/multiple-value-functions
+ *
+ * T-Series and I/O:
+ *	Modbus Map:
+ *		https://labjack.com/support/software/api/modbus/modbus-map
+ *	Lua Scripting:
+ *		https://labjack.com/support/datasheets/t-series/lua-scripting
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <LabJackM.h>
+
+#include "../../LJM_LuaUtilities.h"
+
+// Prints each line of Lua debug output. Called from the reader's thread.
+void PrintLuaLine(const char * line, void * userData)
+{
+	int * lineCount = (int *)userData;
+	(*lineCount)++;
+	printf("Lua: %s\n", line);
+}
+
+int main(int argc, const char * argv[])
+{
+	int err, handle;
+	int uploadedBytes;
+	int lineCount = 0;
+	int seconds = 10;
+	LuaDebugReader reader;
+
+	// Prints a burst of lines every two seconds, with no output in between
+	const char * luaScript =
+		"LJ.IntervalConfig(0, 2000)\n"
+		"local burst = 0\n"
+		"while true do\n"
+		"  if LJ.CheckInterval(0) then\n"
+		"    burst = burst + 1\n"
+		"    for i = 1, 20 do\n"
+		"      print(string.format(\"burst %d line %d\", burst, i))\n"
+		"    end\n"
+		"  end\n"
+		"end\n";
+
+	if (argc >= 2) {
+		seconds = atoi(argv[1]);
+	}
+
+	// Open first found LabJack
+	handle = OpenOrDie(LJM_dtANY, LJM_ctANY, "LJM_idANY");
+	PrintDeviceInfoFromHandle(handle);
+
+	err = DeployLuaScript(handle, luaScript, &uploadedBytes);
+	if (err != LUA_DEPLOY_NOT_VERIFIED) {
+		ErrorCheck(err, "DeployLuaScript");
+	}
+
+	err = StartLuaDebugReader(&reader, handle, PrintLuaLine, &lineCount,
+		LJM_DEBUG);
+	if (err) {
+		StopLuaScript(handle);
+		CloseOrDie(handle);
+		exit(1);
+	}
+
+	printf("Reading Lua debug output for %d seconds\n", seconds);
+	MillisecondSleep(seconds * 1000);
+
+	StopLuaDebugReader(&reader);
+	printf("\n%d lines\n", lineCount);
+	PrintLuaDebugReaderStatistics(&reader);
+
+	err = StopLuaScript(handle);
+	PrintErrorIfError(err, "StopLuaScript");
+
+	CloseOrDie(handle);
+
+	WaitForUserIfWindows();
+
+	return LJME_NOERROR;
+}
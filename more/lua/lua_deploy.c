@@ -0,0 +1,157 @@
+/**
+ * Name: lua_deploy.c
+ * Desc: Deploys a Lua script to one or more LabJacks in parallel using
+ *       LJM_LuaUtilities.h. The script is minified, uploaded in packet-sized
+ *       chunks, started, and verified by reading back the deploy nonce it
+ *       prints from the Lua debug output.
+ * Note: Usage: lua_deploy [script_file [identifier ...]]
+ *       Without a script file, a built-in example script is deployed. Without
+ *       identifiers, the first found LabJack is used.
+ *
+ * Relevant Documentation:
+ *
+ * LJM Library:
+ *	LJM Library Installer:
+ *		https://labjack.com/support/software/installers/ljm
+ *	LJM Users Guide:
+ *		https://labjack.com/support/software/api/ljm
+ *	Opening and Closing:
+ *		https://labjack.com/support/software/api/ljm/function-reference/opening-and-closing
+ *	Multiple Value Functions(such as eWriteNameByteArray):
+ *		https://labjack.com/support/software/api/ljm/function-reference/multiple-value-functions
+ *
+ * T-Series and I/O:
+ *	Modbus Map:
+ *		https://labjack.com/support/software/api/modbus/modbus-map
+ *	Lua Scripting:
+ *		https://labjack.com/support/datasheets/t-series/lua-scripting
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <LabJackM.h>
+
+#include "../../LJM_LuaUtilities.h"
+
+/**
+ * Desc: Reads the whole file at path into a null-terminated string.
+ * Retr: the string, which the caller must free, or NULL if the file could not
+ *       be read
+**/
+char * ReadScriptFile(const char * path);
+
+int main(int argc, const char * argv[])
+{
+	int i, numHandles, numVerified;
+	int uploadedBytes;
+	int deviceType, connectionType, serialNumber, ipAddress, port,
+		maxBytesPerMB;
+	int aHandles[LJM_LIST_ALL_SIZE];
+	int aErrors[LJM_LIST_ALL_SIZE];
+	char * minified;
+	char * luaScript = NULL;
+	char errorString[LJM_MAX_NAME_SIZE];
+	LJM_LONG_LONG_RETURN start;
+
+	const char * exampleScript =
+		"-- Print the tick count once per second\n"
+		"LJ.IntervalConfig(0, 1000)\n"
+		"while true do\n"
+		"  if LJ.CheckInterval(0) then\n"
+		"    print(LJ.Tick())\n"
+		"  end\n"
+		"end\n";
+
+	if (argc >= 2) {
+		luaScript = ReadScriptFile(argv[1]);
+		if (luaScript == NULL) {
+			printf("Could not read %s\n", argv[1]);
+			exit(1);
+		}
+	}
+	else {
+		luaScript = malloc(strlen(exampleScript) + 1);
+		strcpy(luaScript, exampleScript);
+	}
+
+	if (argc <= 2) {
+		// Open first found LabJack
+		aHandles[0] = OpenOrDie(LJM_dtANY, LJM_ctANY, "LJM_idANY");
+		numHandles = 1;
+	}
+	else {
+		numHandles = 0;
+		for (i = 2; i < argc && numHandles < LJM_LIST_ALL_SIZE; i++) {
+			aHandles[numHandles++] = OpenOrDie(LJM_dtANY, LJM_ctANY, argv[i]);
+		}
+	}
+
+	minified = MinifyLuaScript(luaScript);
+	printf("Script: %d bytes, minified: %d bytes\n", (int)strlen(luaScript),
+		(int)strlen(minified));
+	free(minified);
+
+	start = LJM_GetHostTick();
+	if (numHandles == 1) {
+		aErrors[0] = DeployLuaScript(aHandles[0], luaScript, &uploadedBytes);
+		printf("Uploaded %d bytes\n", uploadedBytes);
+		numVerified = (aErrors[0] == LJME_NOERROR);
+	}
+	else {
+		numVerified = DeployLuaScriptToDevices(numHandles, aHandles, luaScript,
+			aErrors);
+	}
+	printf("Deployed to %d of %d devices in %.1f ms\n\n", numVerified,
+		numHandles, (LJM_GetHostTick() - start) / 1000.0);
+
+	for (i = 0; i < numHandles; i++) {
+		ErrorCheck(LJM_GetHandleInfo(aHandles[i], &deviceType, &connectionType,
+			&serialNumber, &ipAddress, &port, &maxBytesPerMB),
+			"LJM_GetHandleInfo");
+		printf("%s %d: ", NumberToDeviceType(deviceType), serialNumber);
+		if (aErrors[i] == LJME_NOERROR) {
+			printf("verified\n");
+		}
+		else if (aErrors[i] == LUA_DEPLOY_NOT_VERIFIED) {
+			printf("started, but the deploy nonce was not read back\n");
+		}
+		else {
+			LJM_ErrorToString(aErrors[i], errorString);
+			printf("%s\n", errorString);
+		}
+		CloseOrDie(aHandles[i]);
+	}
+
+	free(luaScript);
+
+	WaitForUserIfWindows();
+
+	return LJME_NOERROR;
+}
+
+char * ReadScriptFile(const char * path)
+{
+	long size;
+	char * script;
+	FILE * file = fopen(path, "rb");
+	if (file == NULL) {
+		return NULL;
+	}
+
+	fseek(file, 0, SEEK_END);
+	size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	script = malloc(size + 1);
+	if (fread(script, 1, size, file) != (size_t)size) {
+		free(script);
+		fclose(file);
+		return NULL;
+	}
+	script[size] = '\0';
+	fclose(file);
+
+	return script;
+}
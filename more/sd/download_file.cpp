@@ -0,0 +1,29 @@
+#include "sd_util.hpp"
+
+int main(int argc, const char * argv[])
+{
+    if (argc != 3) {
+        printf("Usage: %s file_to_download local_file\n", argv[0]);
+        printf("Run again with the same arguments to resume an interrupted "
+            "download.\n");
+        exit(1);
+    }
+
+    int handle = OpenDevice();
+
+    DownloadStatistics stats;
+    int err = DownloadFile(handle, argv[1], argv[2], &stats);
+    PrintDownloadStatistics(&stats);
+    if (err == LJME_NOERROR) {
+        printf("Downloaded %s to %s\n", argv[1], argv[2]);
+    }
+    else {
+        printf("Download interrupted. Run again to resume.\n");
+    }
+
+    CloseOrDie(handle);
+
+    WaitForUserIfWindows();
+
+    return err;
+}
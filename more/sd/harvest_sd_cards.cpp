@@ -0,0 +1,333 @@
+/**
+ * Name: harvest_sd_cards.cpp
+ * Desc: Downloads new files from the SD cards of several devices at once. Each
+ *       device is opened by serial number and handled by its own thread.
+ *       Files already downloaded are recorded, by name and size, in a manifest
+ *       per device so later runs only download new or changed files.
+ *       Optionally, each file is deleted from the SD card once its download
+ *       has been verified by reading it from the SD card again and comparing
+ *       its CRC-32 with that of the local file. Deleted files are removed
+ *       from the manifest.
+ * Note: The local files are named <serial>_<name> and the manifests
+ *       <serial>_manifest.txt, both in local_dir.
+ *       Interrupted downloads are resumed by DownloadFile on the next run.
+ *       An error on one device is recorded for that device and does not stop
+ *       the other devices.
+**/
+
+#include <vector>
+
+#include "sd_util.hpp"
+
+#include "../../LJM_ThreadUtilities.h"
+
+// The files of a device that have already been downloaded, by name and size
+typedef std::map<std::string, int> Manifest;
+
+typedef struct {
+    std::string serial;
+    std::string sdDir;
+    std::string localDir;
+    bool deleteAfterVerify;
+
+    // Results
+    int err;
+    int numFiles;
+    int numDownloaded;
+    int numSkipped;
+    int numDeleted;
+    int numMismatched;
+    double bytesDownloaded;
+    double seconds;
+} HarvestJob;
+
+// Downloads the new files of one device. Thread function.
+void HarvestDevice(void * jobPtr);
+
+Manifest LoadManifest(const std::string & manifestPath);
+
+// Appends one downloaded file to the manifest
+void AppendToManifest(const std::string & manifestPath,
+    const std::string & name, int size);
+
+// Rewrites the manifest with the files of manifest
+void SaveManifest(const std::string & manifestPath, const Manifest & manifest);
+
+// Returns the size of the local file at path, or -1 if it cannot be opened
+long GetLocalFileSize(const std::string & path);
+
+int main(int argc, const char * argv[])
+{
+    bool deleteAfterVerify = false;
+    std::vector<std::string> serials;
+    const char * sdDir = "/";
+    const char * localDir = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--delete") == 0) {
+            deleteAfterVerify = true;
+        }
+        else if (strncmp(argv[i], "--sd-dir=", 9) == 0) {
+            sdDir = argv[i] + 9;
+        }
+        else if (localDir == NULL) {
+            localDir = argv[i];
+        }
+        else {
+            serials.push_back(argv[i]);
+        }
+    }
+    if (localDir == NULL || serials.empty()) {
+        printf("Usage: %s [--delete] [--sd-dir=absolute_directory] "
+            "local_dir serial [serial ...]\n", argv[0]);
+        exit(1);
+    }
+
+    LJM_LONG_LONG_RETURN start = LJM_GetHostTick();
+
+    std::vector<HarvestJob> jobs(serials.size());
+    std::vector<Thread> threads(serials.size());
+    std::vector<bool> threadStarted(serials.size());
+    for (size_t i = 0; i < serials.size(); i++) {
+        jobs[i].serial = serials[i];
+        jobs[i].sdDir = sdDir;
+        jobs[i].localDir = localDir;
+        jobs[i].deleteAfterVerify = deleteAfterVerify;
+        threadStarted[i] = (StartThread(&threads[i], HarvestDevice, &jobs[i])
+            == 0);
+        if (!threadStarted[i]) {
+            HarvestDevice(&jobs[i]);
+        }
+    }
+
+    for (size_t i = 0; i < serials.size(); i++) {
+        if (threadStarted[i]) {
+            JoinThread(threads[i]);
+        }
+    }
+
+    double totalBytes = 0;
+    printf("\n%10s  %6s  %10s  %7s  %7s  %8s  %10s  %8s\n", "Serial",
+        "Files", "Downloaded", "Skipped", "Deleted", "Mismatch", "KB",
+        "Seconds");
+    for (size_t i = 0; i < jobs.size(); i++) {
+        printf("%10s  %6d  %10d  %7d  %7d  %8d  %10.1f  %8.1f",
+            jobs[i].serial.c_str(), jobs[i].numFiles, jobs[i].numDownloaded,
+            jobs[i].numSkipped, jobs[i].numDeleted, jobs[i].numMismatched,
+            jobs[i].bytesDownloaded / 1024,
+            jobs[i].seconds);
+        if (jobs[i].err == DOWNLOAD_LOCAL_FILE_ERROR) {
+            printf("  error: local file");
+        }
+        else if (jobs[i].err != LJME_NOERROR) {
+            char errName[LJM_MAX_NAME_SIZE];
+            LJM_ErrorToString(jobs[i].err, errName);
+            printf("  error: %s", errName);
+        }
+        printf("\n");
+        totalBytes += jobs[i].bytesDownloaded;
+    }
+    printf("Downloaded %.1f KB from %d devices in %.1f seconds\n",
+        totalBytes / 1024, (int)jobs.size(),
+        (LJM_GetHostTick() - start) / 1000000.0);
+
+    WaitForUserIfWindows();
+
+    return LJME_NOERROR;
+}
+
+void HarvestDevice(void * jobPtr)
+{
+    HarvestJob * job = (HarvestJob *)jobPtr;
+    LJM_LONG_LONG_RETURN start = LJM_GetHostTick();
+    int handle;
+
+    job->err = LJME_NOERROR;
+    job->numFiles = 0;
+    job->numDownloaded = 0;
+    job->numSkipped = 0;
+    job->numDeleted = 0;
+    job->numMismatched = 0;
+    job->bytesDownloaded = 0;
+
+    job->err = LJM_Open(LJM_dtANY, LJM_ctANY, job->serial.c_str(), &handle);
+    if (job->err != LJME_NOERROR) {
+        job->seconds = (LJM_GetHostTick() - start) / 1000000.0;
+        return;
+    }
+
+    std::string prefix = job->localDir + "/" + job->serial + "_";
+    std::string manifestPath = prefix + "manifest.txt";
+    Manifest manifest = LoadManifest(manifestPath);
+
+    DirContents dir;
+    job->err = TryGoToPath(handle, job->sdDir.c_str());
+    if (job->err == LJME_NOERROR) {
+        job->err = TryGetCurDirContents(handle, &dir);
+    }
+    if (job->err != LJME_NOERROR) {
+        printf("%s: could not list %s\n", job->serial.c_str(),
+            job->sdDir.c_str());
+        LJM_Close(handle);
+        job->seconds = (LJM_GetHostTick() - start) / 1000000.0;
+        return;
+    }
+
+    std::string sdDir = job->sdDir;
+    if (sdDir[sdDir.size() - 1] != '/') {
+        sdDir += "/";
+    }
+
+    for (DirContents::iterator it = dir.begin(); it != dir.end(); ++it) {
+        // 1<<5: the item is a file
+        if (!(it->second.attributes & (1<<5))) {
+            continue;
+        }
+        job->numFiles++;
+
+        Manifest::iterator found = manifest.find(it->first);
+        if (found != manifest.end() && found->second == it->second.size) {
+            job->numSkipped++;
+            continue;
+        }
+
+        std::string sdPath = sdDir + it->first;
+        std::string localPath = prefix + it->first;
+        DownloadStatistics stats;
+        int err = DownloadFile(handle, sdPath.c_str(), localPath.c_str(),
+            &stats);
+        job->bytesDownloaded += stats.bytesRead;
+        if (err != LJME_NOERROR) {
+            // Leave it for the next run, which resumes the download
+            printf("%s: could not download %s\n", job->serial.c_str(),
+                sdPath.c_str());
+            job->err = err;
+            continue;
+        }
+
+        // Verify against the size from the listing before recording or
+        // deleting the file
+        if (GetLocalFileSize(localPath) != it->second.size) {
+            printf("%s: %s does not match the size on the SD card "
+                "(%d bytes)\n", job->serial.c_str(), localPath.c_str(),
+                it->second.size);
+            continue;
+        }
+        AppendToManifest(manifestPath, it->first, it->second.size);
+        manifest[it->first] = it->second.size;
+        job->numDownloaded++;
+        printf("%s: downloaded %s\n", job->serial.c_str(), sdPath.c_str());
+
+        if (job->deleteAfterVerify) {
+            // The size cannot catch corrupted content, so compare the local
+            // file with a second read of the file on the SD card
+            unsigned int sdCRC, localCRC;
+            err = ReadFileCRC32(handle, sdPath.c_str(), &sdCRC);
+            if (err != LJME_NOERROR) {
+                printf("%s: could not read %s again to verify it\n",
+                    job->serial.c_str(), sdPath.c_str());
+                job->err = err;
+                continue;
+            }
+            err = LocalFileCRC32(localPath.c_str(), &localCRC);
+            if (err != LJME_NOERROR) {
+                job->err = err;
+                continue;
+            }
+            if (sdCRC != localCRC) {
+                printf("%s: %s does not match the SD card (CRC-32 %08X, "
+                    "SD card %08X); not deleting it\n", job->serial.c_str(),
+                    localPath.c_str(), localCRC, sdCRC);
+                job->numMismatched++;
+                continue;
+            }
+
+            err = TryDeleteFile(handle, sdPath.c_str());
+            if (err != LJME_NOERROR) {
+                job->err = err;
+                continue;
+            }
+            job->numDeleted++;
+
+            // A new file with the same name and size is not a harvested file
+            manifest.erase(it->first);
+        }
+    }
+
+    if (job->numDeleted > 0) {
+        SaveManifest(manifestPath, manifest);
+    }
+
+    int closeErr = LJM_Close(handle);
+    if (job->err == LJME_NOERROR) {
+        job->err = closeErr;
+    }
+
+    job->seconds = (LJM_GetHostTick() - start) / 1000000.0;
+}
+
+Manifest LoadManifest(const std::string & manifestPath)
+{
+    Manifest manifest;
+    char line[LJM_MAX_NAME_SIZE];
+    char * name;
+
+    FILE * fp = fopen(manifestPath.c_str(), "r");
+    if (fp == NULL) {
+        return manifest;
+    }
+
+    // Each line is the size, a space, then the name, which may contain spaces
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        int size = (int)strtol(line, &name, 10);
+        if (name == line || *name != ' ') {
+            continue;
+        }
+        name++;
+        name[strcspn(name, "\r\n")] = '\0';
+        manifest[name] = size;
+    }
+    fclose(fp);
+
+    return manifest;
+}
+
+void AppendToManifest(const std::string & manifestPath,
+    const std::string & name, int size)
+{
+    FILE * fp = fopen(manifestPath.c_str(), "a");
+    if (fp == NULL) {
+        printf("Unable to update %s\n", manifestPath.c_str());
+        return;
+    }
+    fprintf(fp, "%d %s\n", size, name.c_str());
+    fclose(fp);
+}
+
+void SaveManifest(const std::string & manifestPath, const Manifest & manifest)
+{
+    FILE * fp = fopen(manifestPath.c_str(), "w");
+    if (fp == NULL) {
+        printf("Unable to update %s\n", manifestPath.c_str());
+        return;
+    }
+    for (Manifest::const_iterator it = manifest.begin(); it != manifest.end();
+        ++it)
+    {
+        fprintf(fp, "%d %s\n", it->second, it->first.c_str());
+    }
+    fclose(fp);
+}
+
+long GetLocalFileSize(const std::string & path)
+{
+    FILE * fp = fopen(path.c_str(), "rb");
+    if (fp == NULL) {
+        return -1;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fclose(fp);
+
+    return size;
+}
@@ -0,0 +1,39 @@
+#include "sd_util.hpp"
+
+int main(int argc, const char * argv[])
+{
+    const char * dirToRead = "/";
+    if (argc == 2) {
+        dirToRead = argv[1];
+    }
+    else if (argc != 1) {
+        printf("Usage: %s [absolute_directory]\n", argv[0]);
+        exit(1);
+    }
+
+    int handle = OpenDevice();
+    DirCache cache;
+
+    // The first listing reads the SD card, the second is served from the
+    // cache
+    for (int i = 0; i < 2; i++) {
+        LJM_LONG_LONG_RETURN start = LJM_GetHostTick();
+        const DirContents & dir = GetDirContentsCached(handle, cache,
+            dirToRead);
+        double ms = (LJM_GetHostTick() - start) / 1000.0;
+
+        if (i == 0) {
+            printf("%s Directory Contents:\n", dirToRead);
+            PrintDirContents(dir);
+            printf("\n");
+        }
+        printf("Listing %d: %d items in %.3f ms\n", i + 1, (int)dir.size(),
+            ms);
+    }
+
+    CloseOrDie(handle);
+
+    WaitForUserIfWindows();
+
+    return LJME_NOERROR;
+}
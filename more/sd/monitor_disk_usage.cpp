@@ -0,0 +1,42 @@
+#include "sd_util.hpp"
+
+int main(int argc, const char * argv[])
+{
+    int numPolls = 10;
+    int intervalMS = 2000;
+    if (argc == 3) {
+        numPolls = atoi(argv[1]);
+        intervalMS = atoi(argv[2]);
+    }
+    else if (argc != 1) {
+        printf("Usage: %s [num_polls interval_ms]\n", argv[0]);
+        exit(1);
+    }
+
+    int handle = OpenDevice();
+
+    DiskInfo info = GetDiskInfo(handle);
+    printf("%u byte sectors, %u sectors per cluster, %u clusters, "
+        "%.3f total megabytes\n", info.sectorSize, info.sectorsPerCluster,
+        info.totalClusters, (double)info.totalBytes / 1048576);
+
+    for (int i = 0; i < numPolls; i++) {
+        LJM_LONG_LONG_RETURN start = LJM_GetHostTick();
+        DiskBytes freeBytes = GetDiskFreeBytes(handle);
+        double ms = (LJM_GetHostTick() - start) / 1000.0;
+
+        printf("%.3f megabytes free, %.2f%% used (read in %.3f ms)\n",
+            (double)freeBytes / 1048576,
+            100.0 * (info.totalBytes - freeBytes) / info.totalBytes, ms);
+
+        if (i + 1 < numPolls) {
+            MillisecondSleep(intervalMS);
+        }
+    }
+
+    CloseOrDie(handle);
+
+    WaitForUserIfWindows();
+
+    return LJME_NOERROR;
+}
@@ -4,7 +4,10 @@
  *       - Get disk info ()
  *       - List directory contents (takes an optional sd path param, defaults
  *       to the root dir)
+ *       - Cache directory listings by path
  *       - Read single file (takes sd path param and local path param)
+ *       - Download single file in chunks, resuming an interrupted download
+ *       (takes sd path param and local path param)
  *       - Delete single file (takes sd path param)
  *
  * Relevant Documentation:
@@ -49,11 +52,43 @@ int OpenDevice(bool quiet = true);
 // Prints how much free space is remaining, etc.
 void PrintDiskInfo(int handle);
 
+// Sizes are in bytes and computed in 64 bits, since cards larger than 2 GB
+// overflow an int
+typedef LJM_LONG_LONG_RETURN DiskBytes;
+
+typedef struct {
+    unsigned int sectorSize;
+    unsigned int sectorsPerCluster;
+    unsigned int totalClusters;
+    unsigned int freeClusters;
+    DiskBytes totalBytes;
+    DiskBytes freeBytes;
+} DiskInfo;
+
+// Reads all disk parameters in one LJM_eReadNames call. The sector size,
+// sectors per cluster and total clusters do not change while the card is
+// inserted, so they are cached per handle for GetDiskFreeBytes.
+DiskInfo GetDiskInfo(int handle);
+
+// Returns the free space on the SD card. Uses the cached disk geometry, so
+// only the free cluster count is read from the device, which makes this cheap
+// enough to poll. GetDiskInfo is called the first time for each handle.
+DiskBytes GetDiskFreeBytes(int handle);
+
+// Drops the cached disk geometry of handle, such as after the SD card is
+// replaced
+void InvalidateDiskGeometry(int handle);
+
 void ListDirContents(int handle, const char * = "/");
 
+// Prints the name, type and size of each item in dir
+void PrintDirContents(const DirContents & dir);
+
 // Copies data from sdPath (must be absolute) to localPath
 // (must be absolute path - local (computer) destination)
 // Creates the destination file if it does not already exist
+// Exits on LJM errors. If the local file cannot be written, prints why and
+// returns.
 //     Input:
 //         - handle - device handle
 //         - sdPath - the absolute path of the file located on the SD card
@@ -75,13 +110,87 @@ void GoToPath(int handle, const char * sdPath);
 
 // Returns a map with the key value as the name of the file and the mapped
 // value as a structure containing the size and attribute of the file
+// Each item takes two round trips: one LJM_eNames packet that moves to the
+// item and reads its name length, attributes and size, and one read of its
+// name.
 DirContents GetCurDirContents(int handle);
 
+// Versions of GoToPath, GetCurDirContents and DeleteFile that print and return
+// the LJM error code instead of exiting, for programs that must keep going
+// when one device fails, such as harvest_sd_cards.cpp
+int TryGoToPath(int handle, const char * sdPath);
+int TryGetCurDirContents(int handle, DirContents * dir);
+int TryDeleteFile(int handle, const char * sdPath);
+
+// Directory listings by absolute path. Listing a directory is slow for large
+// directories, so listings are kept until they are invalidated by
+// DeleteFileCached or InvalidateDirCache.
+typedef std::map<std::string, DirContents> DirCache;
+
+// Returns the contents of sdPath (must be absolute), listing the directory
+// only if it is not in cache. When it is listed, the current working
+// directory is left at sdPath.
+const DirContents & GetDirContentsCached(int handle, DirCache & cache,
+    const char * sdPath);
+
+// Deletes the file at sdPath and invalidates the cached listing of its
+// directory. If sdPath is relative, all cached listings are invalidated.
+void DeleteFileCached(int handle, DirCache & cache, const char * sdPath);
+
+// Invalidates the cached listing of sdPath, or of every directory if sdPath is
+// NULL. Call this after the SD card is changed by other means, such as by a
+// Lua script.
+void InvalidateDirCache(DirCache & cache, const char * sdPath = NULL);
+
 // Input: absolute path for a file
 // Output: data within the file
 // Caller must deallocate the returned C-string
 const char * ReadFile(int handle, const char * sdPath);
 
+// Returned by DownloadFile when the local file cannot be opened or written
+const int DOWNLOAD_LOCAL_FILE_ERROR = -1;
+
+typedef struct {
+    unsigned int fileSize;
+    unsigned int resumeOffset;
+    unsigned int bytesRead;
+    unsigned int chunkSize;
+    double seconds;
+} DownloadStatistics;
+
+// Copies sdPath (must be absolute) to localPath in fixed-size chunks, writing
+// each chunk to localPath as it is read, so memory use does not depend on the
+// file size and binary data is copied unchanged. The chunk size is the
+// largest FILE_IO_READ that fits in one packet of the connection.
+// Progress is recorded in localPath + DOWNLOAD_RESUME_SUFFIX. If a download
+// of the same file was interrupted, it resumes from the recorded offset. The
+// SD card cannot seek, so the bytes before the offset are read again and
+// compared to the local file rather than written; the download restarts from
+// the first byte that differs.
+//     Input:
+//         - handle - device handle
+//         - sdPath - the absolute path of the file located on the SD card
+//         - localPath - the path of the destination file on the computer
+//         - stats - receives the transfer statistics (optional)
+//     Returns: the LJM error code, which is LJME_NOERROR on success, or
+//     DOWNLOAD_LOCAL_FILE_ERROR if localPath could not be written
+int DownloadFile(int handle, const char * sdPath, const char * localPath,
+    DownloadStatistics * stats = NULL);
+
+// Prints the size, resume offset and throughput of a download
+void PrintDownloadStatistics(const DownloadStatistics * stats);
+
+// Reads sdPath (must be absolute) from the SD card again in the same chunks as
+// DownloadFile and computes its CRC-32, so a download can be verified by
+// content before the file is deleted from the SD card.
+//     Returns: the LJM error code
+int ReadFileCRC32(int handle, const char * sdPath, unsigned int * crc);
+
+// Computes the CRC-32 of the local file at localPath
+//     Returns: LJME_NOERROR, or DOWNLOAD_LOCAL_FILE_ERROR if localPath could
+//     not be read
+int LocalFileCRC32(const char * localPath, unsigned int * crc);
+
 int OpenDevice(bool quiet)
 {
     // Open first found LabJack
@@ -102,37 +211,89 @@ int OpenDevice(bool quiet)
     return handle;
 }
 
+// Disk geometry by handle, for GetDiskFreeBytes
+std::map<int, DiskInfo> DISK_GEOMETRY_CACHE;
+
 void PrintDiskInfo(int handle)
 {
-    double value;
+    DiskInfo info = GetDiskInfo(handle);
+
+    printf("%.3f megabytes free of %.3f total megabytes.\n",
+        (double)info.freeBytes / 1048576, (double)info.totalBytes / 1048576);
+}
+
+DiskInfo GetDiskInfo(int handle)
+{
     int err;
+    int errAddr = -1;
 
     // All disk parameters are captured when you read
-    // FILE_IO_DISK_SECTOR_SIZE_BYTES
-    err = LJM_eReadName(handle, "FILE_IO_DISK_SECTOR_SIZE_BYTES", &value);
-    ErrorCheck(err, "eReadName(handle, FILE_IO_DISK_SECTOR_SIZE_BYTES)");
-    int sectorSize = (int) value;
+    // FILE_IO_DISK_SECTOR_SIZE_BYTES, so it is read first
+    enum { NUM_FRAMES = 4 };
+    const char * aNames[NUM_FRAMES] = {
+        "FILE_IO_DISK_SECTOR_SIZE_BYTES",
+        "FILE_IO_DISK_SECTORS_PER_CLUSTER",
+        "FILE_IO_DISK_TOTAL_CLUSTERS",
+        "FILE_IO_DISK_FREE_CLUSTERS"
+    };
+    double aValues[NUM_FRAMES];
+    err = LJM_eReadNames(handle, NUM_FRAMES, aNames, aValues, &errAddr);
+    ErrorCheckWithAddress(err, errAddr, "LJM_eReadNames(handle, "
+        "FILE_IO_DISK_SECTOR_SIZE_BYTES, ...)");
+
+    DiskInfo info;
+    info.sectorSize = (unsigned int) aValues[0];
+    info.sectorsPerCluster = (unsigned int) aValues[1];
+    info.totalClusters = (unsigned int) aValues[2];
+    info.freeClusters = (unsigned int) aValues[3];
+
+    DiskBytes bytesPerCluster = (DiskBytes) info.sectorSize
+        * info.sectorsPerCluster;
 
-    err = LJM_eReadName(handle, "FILE_IO_DISK_SECTORS_PER_CLUSTER", &value);
-    ErrorCheck(err, "eReadName(handle, FILE_IO_DISK_SECTORS_PER_CLUSTER)");
-    int sectorsPerCluster = (int) value;
+    // Total size = SECTOR_SIZE * SECTORS_PER_CLUSTER * TOTAL_CLUSTERS
+    info.totalBytes = bytesPerCluster * info.totalClusters;
 
-    err = LJM_eReadName(handle, "FILE_IO_DISK_TOTAL_CLUSTERS", &value);
-    ErrorCheck(err, "eReadName(handle, FILE_IO_DISK_TOTAL_CLUSTERS)");
-    int totalClusters = (int) value;
+    // Free size = SECTOR_SIZE * SECTORS_PER_CLUSTER * FREE_CLUSTERS
+    info.freeBytes = bytesPerCluster * info.freeClusters;
 
-    err = LJM_eReadName(handle, "FILE_IO_DISK_FREE_CLUSTERS", &value);
-    ErrorCheck(err, "eReadName(handle, FILE_IO_DISK_FREE_CLUSTERS)");
-    int freeClusters = (int) value;
+    DISK_GEOMETRY_CACHE[handle] = info;
 
-    // Total size = SECTOR_SIZE * SECTORS_PER_CLUSTER * TOTAL_CLUSTERS
-    int totalSize = sectorSize * sectorsPerCluster * totalClusters;
+    return info;
+}
 
-    // Free size = SECTOR_SIZE * SECTORS_PER_CLUSTER * FREE_CLUSTERS
-    int freeSize = (sectorSize * sectorsPerCluster * freeClusters);
+DiskBytes GetDiskFreeBytes(int handle)
+{
+    std::map<int, DiskInfo>::iterator it = DISK_GEOMETRY_CACHE.find(handle);
+    if (it == DISK_GEOMETRY_CACHE.end()) {
+        return GetDiskInfo(handle).freeBytes;
+    }
 
-    printf("%.3f megabytes free of %.3f total megabytes.\n",
-        (double)freeSize / 1048576, (double)totalSize / 1048576);
+    int err;
+    int errAddr = -1;
+
+    // FILE_IO_DISK_SECTOR_SIZE_BYTES is read in the same packet only because
+    // reading it captures the current free cluster count
+    enum { NUM_FRAMES = 2 };
+    const char * aNames[NUM_FRAMES] = {
+        "FILE_IO_DISK_SECTOR_SIZE_BYTES",
+        "FILE_IO_DISK_FREE_CLUSTERS"
+    };
+    double aValues[NUM_FRAMES];
+    err = LJM_eReadNames(handle, NUM_FRAMES, aNames, aValues, &errAddr);
+    ErrorCheckWithAddress(err, errAddr, "LJM_eReadNames(handle, "
+        "FILE_IO_DISK_FREE_CLUSTERS, ...)");
+
+    DiskInfo & info = it->second;
+    info.freeClusters = (unsigned int) aValues[1];
+    info.freeBytes = (DiskBytes) info.sectorSize * info.sectorsPerCluster
+        * info.freeClusters;
+
+    return info.freeBytes;
+}
+
+void InvalidateDiskGeometry(int handle)
+{
+    DISK_GEOMETRY_CACHE.erase(handle);
 }
 
 void ListDirContents(int handle, const char * sdPath)
@@ -152,10 +313,19 @@ void ListDirContents(int handle, const char * sdPath)
     }
     // dir contains the contents of the directory
     DirContents dir = GetCurDirContents(handle);
+    PrintDirContents(dir);
+
+    // Return to the starting directory
+    GoToPath(handle, startingDirectory);
 
+    delete [] startingDirectory;
+}
+
+void PrintDirContents(const DirContents & dir)
+{
     // Print results
     printf("%40.40s  %9.9s  %9s\n", "Name", "Type", "Size");
-    for (DirContents::iterator it=dir.begin(); it!=dir.end(); ++it) {
+    for (DirContents::const_iterator it=dir.begin(); it!=dir.end(); ++it) {
         // Check 4 or 5 bit
         const char * type = "";
         // 1<<5 = 0b 0010 0000
@@ -179,35 +349,28 @@ void ListDirContents(int handle, const char * sdPath)
             printf("\n");
         }
     }
-
-    // Return to the starting directory
-    GoToPath(handle, startingDirectory);
-
-    delete [] startingDirectory;
 }
 
 void CopyFile(int handle, const char * sdPath, const char * localPath)
 {
-    // Get Data from SD Card
-    const char * data = ReadFile(handle, sdPath);
-
-    // Write Data to local
-    FILE * fp;
-    fp = fopen (localPath, "w+");
-
-    if (fp == NULL) {
-        printf("\nUnable to open the specified local file.\n");
-    }
-    else {
-        fprintf(fp, "%s", data);
-        printf("Copied data from %s to %s\n", sdPath, localPath);
+    // DownloadFile copies binary data unchanged and without holding the
+    // whole file in memory
+    int err = DownloadFile(handle, sdPath, localPath);
+    if (err == DOWNLOAD_LOCAL_FILE_ERROR) {
+        // DownloadFile has printed which local file operation failed
+        return;
     }
-    fclose(fp);
-
-    delete [] data;
+    ErrorCheck(err, "CopyFile(handle, %s, %s)", sdPath, localPath);
+    printf("Copied data from %s to %s\n", sdPath, localPath);
 }
 
 void DeleteFile(int handle, const char * sdPath)
+{
+    int err = TryDeleteFile(handle, sdPath);
+    ErrorCheck(err, "DeleteFile(handle, %s)", sdPath);
+}
+
+int TryDeleteFile(int handle, const char * sdPath)
 {
     int err;
     int errAddr = -1;
@@ -217,20 +380,30 @@ void DeleteFile(int handle, const char * sdPath)
 
     // 1) Write the length of the file name to FILE_IO_PATH_WRITE_LEN_BYTES
     err = LJM_eWriteName(handle, "FILE_IO_PATH_WRITE_LEN_BYTES", pathLen);
-    ErrorCheck(err, "eWriteName(handle, FILE_IO_PATH_WRITE_LEN_BYTES)");
+    PrintErrorIfError(err, "eWriteName(handle, FILE_IO_PATH_WRITE_LEN_BYTES)");
+    if (err != LJME_NOERROR) {
+        return err;
+    }
 
     // 2) Write the name to FILE_IO_PATH_WRITE (with null terminator)
     err = LJM_eWriteNameByteArray(handle, "FILE_IO_PATH_WRITE", pathLen,
         sdPath, &errAddr);
-    ErrorCheck(err, "eWriteNameByteArray(handle, FILE_IO_PATH_WRITE)");
+    PrintErrorIfError(err, "eWriteNameByteArray(handle, FILE_IO_PATH_WRITE)");
+    if (err != LJME_NOERROR) {
+        return err;
+    }
 
     printf("Deleting file at %s\n", sdPath);
     // 3) Write a value to FILE_IO_DELETE to delete the file at the specified
     // path
     err = LJM_eWriteName(handle, "FILE_IO_DELETE", 1);
-    ErrorCheck(err, "eWriteName(handle, FILE_IO_DELETE, 1)");
+    PrintErrorIfError(err, "eWriteName(handle, FILE_IO_DELETE, 1)");
+    if (err != LJME_NOERROR) {
+        return err;
+    }
 
     printf("Successfully deleted file.\n");
+    return LJME_NOERROR;
 }
 
 const char * GetCurrentWorkingDirectory(int handle)
@@ -260,6 +433,12 @@ const char * GetCurrentWorkingDirectory(int handle)
 }
 
 void GoToPath(int handle, const char * sdPath)
+{
+    int err = TryGoToPath(handle, sdPath);
+    ErrorCheck(err, "GoToPath(handle, %s)", sdPath);
+}
+
+int TryGoToPath(int handle, const char * sdPath)
 {
     int err;
     int errAddr = -1;
@@ -269,88 +448,158 @@ void GoToPath(int handle, const char * sdPath)
 
     // 1) Write the length of the file name to FILE_IO_PATH_WRITE_LEN_BYTES
     err = LJM_eWriteName(handle, "FILE_IO_PATH_WRITE_LEN_BYTES", pathLen);
-    ErrorCheck(err, "eWriteName(handle, FILE_IO_PATH_WRITE_LEN_BYTES)");
+    PrintErrorIfError(err, "eWriteName(handle, FILE_IO_PATH_WRITE_LEN_BYTES)");
+    if (err != LJME_NOERROR) {
+        return err;
+    }
 
     // 2) Write the directory string (converted to an array of bytes, with null
     // terminator) to FILE_IO_PATH_WRITE.  (array size = length from step 2)
     err = LJM_eWriteNameByteArray(handle, "FILE_IO_PATH_WRITE", pathLen,
         sdPath, &errAddr);
-    ErrorCheck(err, "eWriteNameByteArray(handle, FILE_IO_PATH_WRITE)");
+    PrintErrorIfError(err, "eWriteNameByteArray(handle, FILE_IO_PATH_WRITE)");
+    if (err != LJME_NOERROR) {
+        return err;
+    }
 
     // 3) Write a value of 1 to FILE_IO_DIR_CHANGE.
     err = LJM_eWriteName(handle, "FILE_IO_DIR_CHANGE", 1);
-    ErrorCheck(err, "eWriteName(handle, FILE_IO_DIR_CHANGE)");
+    PrintErrorIfError(err, "eWriteName(handle, FILE_IO_DIR_CHANGE)");
+    return err;
+}
+
+// Returns true if err from FILE_IO_DIR_FIRST or FILE_IO_DIR_NEXT indicates
+// that there are no more items in the directory
+bool IsEndOfDir(int err)
+{
+    return (
+        err == 2966 // FILE_IO_END_OF_CWD
+        || err == 2960 // FILE_IO_NOT_FOUND
+        || err == 2809 // FILE_IO_INVALID_OBJECT
+    );
 }
 
 DirContents GetCurDirContents(int handle)
 {
-    double value;
+    DirContents dir;
+    int err = TryGetCurDirContents(handle, &dir);
+    ErrorCheck(err, "GetCurDirContents(handle)");
+    return dir;
+}
+
+int TryGetCurDirContents(int handle, DirContents * dir)
+{
     int err;
     int errAddr = -1;
 
-    // 1) Write a value of 1 to FILE_IO_DIR_FIRST. The error returned indicates
-    // whether anything was found.
-    // No error (0) indicates that something was found.
-    // FILE_IO_NOT_FOUND (2960) indicates that nothing was found.
-    err = LJM_eWriteName(handle, "FILE_IO_DIR_FIRST", 1);
-    ErrorCheck(err, "eWriteName(handle, FILE_IO_DIR_FIRST)");
+    dir->clear();
+
+    // Each iteration moves to the next item and reads its name length,
+    // attributes and size in a single packet, then reads its name.
+    //     1) Write a value of 1 to FILE_IO_DIR_FIRST (first iteration) or
+    //     FILE_IO_DIR_NEXT. The error returned indicates whether anything was
+    //     found. No error (0) indicates that something was found.
+    //     FILE_IO_NOT_FOUND (2960), FILE_IO_END_OF_CWD (2966) or
+    //     FILE_IO_INVALID_OBJECT (2809) indicates that there are no more
+    //     items. Since the write is the first frame, the reads are not
+    //     performed when it fails.
+    //     2) Read FILE_IO_PATH_READ_LEN_BYTES, FILE_IO_ATTRIBUTES, and
+    //     FILE_IO_SIZE_BYTES.
+    enum { NUM_FRAMES = 4 };
+    const char * aNames[NUM_FRAMES] = {
+        "FILE_IO_DIR_FIRST",
+        "FILE_IO_PATH_READ_LEN_BYTES",
+        "FILE_IO_ATTRIBUTES",
+        "FILE_IO_SIZE_BYTES"
+    };
+    int aWrites[NUM_FRAMES] = {LJM_WRITE, LJM_READ, LJM_READ, LJM_READ};
+    int aNumValues[NUM_FRAMES] = {1, 1, 1, 1};
+    double aValues[NUM_FRAMES];
+
+    while (true) {
+        aValues[0] = 1;
+        err = LJM_eNames(handle, NUM_FRAMES, aNames, aWrites, aNumValues,
+            aValues, &errAddr);
+        if (IsEndOfDir(err)) {
+            break;
+        }
+        PrintErrorWithAddressIfError(err, errAddr,
+            "LJM_eNames(handle, %s, ...)", aNames[0]);
+        if (err != LJME_NOERROR) {
+            return err;
+        }
 
-    DirContents dir;
+        int fileNameLen = int(aValues[1]);
+        int fileType = int(aValues[2]);
+        int fileSize = int(aValues[3]);
 
-    // Loop, reading name and properties of one file per iteration
-    bool noMoreFiles = false;
-    while (!noMoreFiles) {
-        // 2) Read FILE_IO_PATH_READ_LEN_BYTES, FILE_IO_ATTRIBUTES, and
-        // FILE_IO_SIZE. Store the attributes and size associated with each
-        // file.
-        err = LJM_eReadName(handle, "FILE_IO_PATH_READ_LEN_BYTES", &value);
-        ErrorCheck(err, "LJM_eReadName(handle, FILE_IO_PATH_READ_LEN_BYTES)");
-        int fileNameLen = int(value);
-
-        err = LJM_eReadName(handle, "FILE_IO_ATTRIBUTES", &value);
-        ErrorCheck(err, "LJM_eReadName(handle, FILE_IO_ATTRIBUTES)");
-        int fileType = int(value);
-
-        err = LJM_eReadName(handle, "FILE_IO_SIZE_BYTES", &value);
-        ErrorCheck(err, "LJM_eReadName(handle, FILE_IO_SIZE_BYTES)");
-        int fileSize = int(value);
-
-        // 3) Read an array from FILE_IO_NAME_READ of size
+        // 3) Read an array from FILE_IO_PATH_READ of size
         // FILE_IO_PATH_READ_LEN_BYTES. This is the name of the file/folder.
         char * fileNameAsBytes = new char[fileNameLen];
         err = LJM_eReadNameByteArray(handle, "FILE_IO_PATH_READ",
             fileNameLen, fileNameAsBytes, &errAddr);
-        ErrorCheck(err, "LJM_eReadNameByteArray(handle, FILE_IO_PATH_READ)");
+        PrintErrorIfError(err,
+            "LJM_eReadNameByteArray(handle, FILE_IO_PATH_READ)");
+        if (err != LJME_NOERROR) {
+            delete [] fileNameAsBytes;
+            return err;
+        }
 
         // Add to list
         FileProperties fileprops;
         fileprops.size = fileSize;
         fileprops.attributes = fileType;
-        dir[fileNameAsBytes] = fileprops;
+        (*dir)[fileNameAsBytes] = fileprops;
 
         delete [] fileNameAsBytes;
 
-        // 4) Write a value of 1 to FILE_IO_DIR_NEXT. The error returned
-        // indicates whether anything was found. No error (0) indicates that
-        // there are more items -> go back to step 2.
-        // FILE_IO_INVALID_OBJECT (2809) and potentially error code
-        // FILE_IO_NOT_FOUND (2960) indicates that there are no more items.
-        err = LJM_eWriteName(handle, "FILE_IO_DIR_NEXT", 1);
-        if (
-            err == 2966 // FILE_IO_END_OF_CWD
-            || err == 2960 // FILE_IO_NOT_FOUND
-            || err == 2809 // FILE_IO_INVALID_OBJECT
-        ) {
-            noMoreFiles = true;
-        }
-        else if (err != LJME_NOERROR) {
-            ErrorCheck(err, "eWriteName(handle, FILE_IO_DIR_NEXT)");
-        }
+        aNames[0] = "FILE_IO_DIR_NEXT";
+    }
+
+    return LJME_NOERROR;
+}
+
+const DirContents & GetDirContentsCached(int handle, DirCache & cache,
+    const char * sdPath)
+{
+    DirCache::iterator it = cache.find(sdPath);
+    if (it != cache.end()) {
+        return it->second;
     }
 
+    GoToPath(handle, sdPath);
+    DirContents & dir = cache[sdPath];
+    dir = GetCurDirContents(handle);
     return dir;
 }
 
+void DeleteFileCached(int handle, DirCache & cache, const char * sdPath)
+{
+    DeleteFile(handle, sdPath);
+
+    const char * lastSlash = strrchr(sdPath, '/');
+    if (sdPath[0] != '/' || lastSlash == NULL) {
+        InvalidateDirCache(cache);
+    }
+    else if (lastSlash == sdPath) {
+        InvalidateDirCache(cache, "/");
+    }
+    else {
+        InvalidateDirCache(cache,
+            std::string(sdPath, lastSlash - sdPath).c_str());
+    }
+}
+
+void InvalidateDirCache(DirCache & cache, const char * sdPath)
+{
+    if (sdPath == NULL) {
+        cache.clear();
+    }
+    else {
+        cache.erase(sdPath);
+    }
+}
+
 const char * ReadFile(int handle, const char * sdPath)
 {
     int err;
@@ -438,3 +687,363 @@ const char * ReadFile(int handle, const char * sdPath)
 
     return fileDataAsBytes;
 }
+
+// Appended to the local path to name the file that records download progress
+const char * const DOWNLOAD_RESUME_SUFFIX = ".resume";
+
+// Download progress is recorded after at least this many new bytes
+const unsigned int DOWNLOAD_RESUME_SAVE_BYTES = 65536;
+
+// Bytes of each Modbus feedback response that are not FILE_IO_READ data
+const int FILE_IO_READ_OVERHEAD_BYTES = 16;
+
+// Opens sdPath (must be absolute) for FILE_IO_READ and gets its size
+int OpenFileForRead(int handle, const char * sdPath, unsigned int * fileSize)
+{
+    int err;
+    int errAddr = -1;
+    double value;
+
+    const char * lastSlash = strrchr(sdPath, '/');
+    if (lastSlash == NULL) {
+        printf("Error: path must be absolute\n");
+        exit(1);
+    }
+
+    // Navigate to the directory of the file
+    std::string path(sdPath, lastSlash - sdPath);
+    if (path.empty()) {
+        path = "/";
+    }
+    err = TryGoToPath(handle, path.c_str());
+    if (err != LJME_NOERROR) {
+        return err;
+    }
+
+    // Add 1 for the null terminator
+    const char * file = lastSlash + 1;
+    int fileNameLen = strlen(file) + 1;
+
+    err = LJM_eWriteName(handle, "FILE_IO_PATH_WRITE_LEN_BYTES",
+        fileNameLen);
+    PrintErrorIfError(err, "eWriteName(handle, FILE_IO_PATH_WRITE_LEN_BYTES)");
+    if (err != LJME_NOERROR) {
+        return err;
+    }
+
+    err = LJM_eWriteNameByteArray(handle, "FILE_IO_PATH_WRITE", fileNameLen,
+        file, &errAddr);
+    PrintErrorIfError(err, "eWriteNameByteArray(handle, FILE_IO_PATH_WRITE)");
+    if (err != LJME_NOERROR) {
+        return err;
+    }
+
+    err = LJM_eWriteName(handle, "FILE_IO_OPEN", 1);
+    PrintErrorIfError(err, "LJM_eWriteName(handle, FILE_IO_OPEN)");
+    if (err != LJME_NOERROR) {
+        return err;
+    }
+
+    // FILE_IO_SIZE_BYTES holds the size of the file that was just opened, so
+    // the directory does not need to be listed
+    err = LJM_eReadName(handle, "FILE_IO_SIZE_BYTES", &value);
+    PrintErrorIfError(err, "LJM_eReadName(handle, FILE_IO_SIZE_BYTES)");
+    if (err != LJME_NOERROR) {
+        // Do not leave the file open when the caller will not read it
+        LJM_eWriteName(handle, "FILE_IO_CLOSE", 1);
+        return err;
+    }
+    *fileSize = (unsigned int) value;
+
+    return LJME_NOERROR;
+}
+
+// Reads the recorded offset of an interrupted download of sdPath with the
+// given size. Returns 0 if there is no matching record.
+unsigned int LoadDownloadOffset(const std::string & resumePath,
+    const char * sdPath, unsigned int fileSize)
+{
+    char recordedPath[LJM_MAX_NAME_SIZE];
+    unsigned int recordedSize = 0;
+    unsigned int recordedOffset = 0;
+
+    FILE * fp = fopen(resumePath.c_str(), "r");
+    if (fp == NULL) {
+        return 0;
+    }
+    int numParsed = fscanf(fp, "%255s %u %u", recordedPath, &recordedSize,
+        &recordedOffset);
+    fclose(fp);
+
+    if (numParsed != 3 || strcmp(recordedPath, sdPath) != 0
+        || recordedSize != fileSize || recordedOffset > fileSize)
+    {
+        return 0;
+    }
+    return recordedOffset;
+}
+
+void SaveDownloadOffset(const std::string & resumePath, const char * sdPath,
+    unsigned int fileSize, unsigned int offset)
+{
+    FILE * fp = fopen(resumePath.c_str(), "w");
+    if (fp == NULL) {
+        printf("Unable to record download progress in %s\n",
+            resumePath.c_str());
+        return;
+    }
+    fprintf(fp, "%s %u %u\n", sdPath, fileSize, offset);
+    fclose(fp);
+}
+
+// Gets the largest number of FILE_IO_READ bytes that fit in one packet of the
+// connection of handle, rounded down to an even number
+int GetFileReadChunkSize(int handle, int * chunkSize)
+{
+    int deviceType, connectionType, serialNumber, ipAddress, port;
+    int maxBytesPerMB;
+
+    int err = LJM_GetHandleInfo(handle, &deviceType, &connectionType,
+        &serialNumber, &ipAddress, &port, &maxBytesPerMB);
+    PrintErrorIfError(err, "LJM_GetHandleInfo");
+    if (err != LJME_NOERROR) {
+        return err;
+    }
+
+    *chunkSize = (maxBytesPerMB - FILE_IO_READ_OVERHEAD_BYTES) & ~1;
+    return LJME_NOERROR;
+}
+
+int DownloadFile(int handle, const char * sdPath, const char * localPath,
+    DownloadStatistics * stats)
+{
+    int err;
+    int errAddr = -1;
+    int chunkSize;
+    unsigned int fileSize = 0;
+    DownloadStatistics localStats;
+    if (stats == NULL) {
+        stats = &localStats;
+    }
+    memset(stats, 0, sizeof(DownloadStatistics));
+
+    LJM_LONG_LONG_RETURN startTime = LJM_GetHostTick();
+
+    err = GetFileReadChunkSize(handle, &chunkSize);
+    if (err != LJME_NOERROR) {
+        return err;
+    }
+    stats->chunkSize = chunkSize;
+
+    err = OpenFileForRead(handle, sdPath, &fileSize);
+    if (err != LJME_NOERROR) {
+        return err;
+    }
+    stats->fileSize = fileSize;
+
+    std::string resumePath = std::string(localPath) + DOWNLOAD_RESUME_SUFFIX;
+    unsigned int resumeOffset = LoadDownloadOffset(resumePath, sdPath,
+        fileSize);
+
+    FILE * fp = NULL;
+    if (resumeOffset > 0) {
+        fp = fopen(localPath, "r+b");
+    }
+    if (fp == NULL) {
+        resumeOffset = 0;
+        fp = fopen(localPath, "wb");
+    }
+    if (fp == NULL) {
+        printf("\nUnable to open the specified local file.\n");
+        LJM_eWriteName(handle, "FILE_IO_CLOSE", 1);
+        return DOWNLOAD_LOCAL_FILE_ERROR;
+    }
+    stats->resumeOffset = resumeOffset;
+
+    char * chunk = new char[chunkSize];
+    char * localChunk = new char[chunkSize];
+    unsigned int offset = 0;
+    unsigned int lastSavedOffset = resumeOffset;
+    bool comparing = (resumeOffset > 0);
+
+    while (offset < fileSize) {
+        int numBytes = chunkSize;
+        if (fileSize - offset < (unsigned int) numBytes) {
+            numBytes = fileSize - offset;
+        }
+
+        err = LJM_eReadNameByteArray(handle, "FILE_IO_READ", numBytes, chunk,
+            &errAddr);
+        PrintErrorIfError(err, "LJM_eReadNameByteArray(handle, FILE_IO_READ)");
+        if (err != LJME_NOERROR) {
+            break;
+        }
+        stats->bytesRead += numBytes;
+
+        if (comparing) {
+            // Compare with the local bytes from the interrupted download
+            int numCompared = numBytes;
+            if (resumeOffset - offset < (unsigned int) numCompared) {
+                numCompared = resumeOffset - offset;
+            }
+            if (fread(localChunk, 1, numCompared, fp) != (size_t) numCompared
+                || memcmp(localChunk, chunk, numCompared) != 0)
+            {
+                printf("Local file differs before the resume offset, "
+                    "restarting the download at offset %u\n", offset);
+                numCompared = 0;
+            }
+            if (numCompared < numBytes) {
+                // Write the rest of this chunk and everything after it
+                comparing = false;
+                fseek(fp, offset + numCompared, SEEK_SET);
+                if (fwrite(chunk + numCompared, 1, numBytes - numCompared, fp)
+                    != (size_t) (numBytes - numCompared))
+                {
+                    printf("\nUnable to write to the specified local file.\n");
+                    offset += numCompared;
+                    err = DOWNLOAD_LOCAL_FILE_ERROR;
+                    break;
+                }
+            }
+        }
+        else if (fwrite(chunk, 1, numBytes, fp) != (size_t) numBytes) {
+            printf("\nUnable to write to the specified local file.\n");
+            err = DOWNLOAD_LOCAL_FILE_ERROR;
+            break;
+        }
+        offset += numBytes;
+
+        if (!comparing
+            && offset - lastSavedOffset >= DOWNLOAD_RESUME_SAVE_BYTES)
+        {
+            fflush(fp);
+            SaveDownloadOffset(resumePath, sdPath, fileSize, offset);
+            lastSavedOffset = offset;
+        }
+    }
+
+    delete [] localChunk;
+    delete [] chunk;
+
+    int closeErr = LJM_eWriteName(handle, "FILE_IO_CLOSE", 1);
+    PrintErrorIfError(closeErr, "eWriteName(handle, FILE_IO_CLOSE)");
+
+    if (fclose(fp) != 0 && err == LJME_NOERROR) {
+        printf("\nUnable to write to the specified local file.\n");
+        err = DOWNLOAD_LOCAL_FILE_ERROR;
+    }
+
+    if (err == LJME_NOERROR) {
+        remove(resumePath.c_str());
+    }
+    else if (!comparing && offset > lastSavedOffset) {
+        // Everything before offset was written, so it can be resumed
+        SaveDownloadOffset(resumePath, sdPath, fileSize, offset);
+    }
+
+    stats->seconds = (LJM_GetHostTick() - startTime) / 1000000.0;
+
+    return err;
+}
+
+void PrintDownloadStatistics(const DownloadStatistics * stats)
+{
+    printf("File size: %u bytes\n", stats->fileSize);
+    if (stats->resumeOffset > 0) {
+        printf("Resumed at offset: %u bytes\n", stats->resumeOffset);
+    }
+    printf("Read %u bytes in %u-byte chunks in %.3f seconds", stats->bytesRead,
+        stats->chunkSize, stats->seconds);
+    if (stats->seconds > 0) {
+        printf(" (%.1f KB/s)", stats->bytesRead / 1024.0 / stats->seconds);
+    }
+    printf("\n");
+}
+
+// Updates crc, which starts at 0, with numBytes of data. This is the CRC-32
+// used by zip and PNG.
+unsigned int UpdateCRC32(unsigned int crc, const char * data, int numBytes)
+{
+    crc = ~crc;
+    for (int i = 0; i < numBytes; i++) {
+        crc ^= (unsigned char) data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+int ReadFileCRC32(int handle, const char * sdPath, unsigned int * crc)
+{
+    int err;
+    int errAddr = -1;
+    int chunkSize;
+    unsigned int fileSize = 0;
+
+    *crc = 0;
+
+    err = GetFileReadChunkSize(handle, &chunkSize);
+    if (err != LJME_NOERROR) {
+        return err;
+    }
+
+    err = OpenFileForRead(handle, sdPath, &fileSize);
+    if (err != LJME_NOERROR) {
+        return err;
+    }
+
+    char * chunk = new char[chunkSize];
+    unsigned int offset = 0;
+    while (offset < fileSize) {
+        int numBytes = chunkSize;
+        if (fileSize - offset < (unsigned int) numBytes) {
+            numBytes = fileSize - offset;
+        }
+
+        err = LJM_eReadNameByteArray(handle, "FILE_IO_READ", numBytes, chunk,
+            &errAddr);
+        PrintErrorIfError(err, "LJM_eReadNameByteArray(handle, FILE_IO_READ)");
+        if (err != LJME_NOERROR) {
+            break;
+        }
+        *crc = UpdateCRC32(*crc, chunk, numBytes);
+        offset += numBytes;
+    }
+    delete [] chunk;
+
+    int closeErr = LJM_eWriteName(handle, "FILE_IO_CLOSE", 1);
+    PrintErrorIfError(closeErr, "eWriteName(handle, FILE_IO_CLOSE)");
+    if (err == LJME_NOERROR) {
+        err = closeErr;
+    }
+
+    return err;
+}
+
+int LocalFileCRC32(const char * localPath, unsigned int * crc)
+{
+    enum { CHUNK_SIZE = 4096 };
+    char chunk[CHUNK_SIZE];
+    size_t numBytes;
+
+    *crc = 0;
+
+    FILE * fp = fopen(localPath, "rb");
+    if (fp == NULL) {
+        printf("\nUnable to open %s\n", localPath);
+        return DOWNLOAD_LOCAL_FILE_ERROR;
+    }
+    while ((numBytes = fread(chunk, 1, CHUNK_SIZE, fp)) > 0) {
+        *crc = UpdateCRC32(*crc, chunk, (int) numBytes);
+    }
+    int readFailed = ferror(fp);
+    fclose(fp);
+
+    if (readFailed) {
+        printf("\nUnable to read %s\n", localPath);
+        return DOWNLOAD_LOCAL_FILE_ERROR;
+    }
+    return LJME_NOERROR;
+}
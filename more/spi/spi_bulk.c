@@ -0,0 +1,105 @@
+/**
+ * Name: spi_bulk.c
+ * Desc: Demonstrates bulk SPI transfers with LJM_SPIUtilities.h. A 1000-byte
+ *       buffer is sent in one SPITransfer call, which splits it into
+ *       packet-sized chunks while keeping chip select asserted, and the
+ *       received bytes are compared with the sent bytes.
+ *
+ *       Short MOSI to MISO for this example, using the same lines as spi.c:
+ *
+ *       T7 and T8:
+ *           MOSI    FIO2
+ *           MISO    FIO3
+ *           CLK     FIO0
+ *           CS      FIO1
+ *
+ *       T4:
+ *           MOSI    FIO6
+ *           MISO    FIO7
+ *           CLK     FIO4
+ *           CS      FIO5
+ *
+ * Relevant Documentation:
+ *
+ * LJM Library:
+ *	LJM Library Installer:
+ *		https://labjack.com/support/software/installers/ljm
+ *	LJM Users Guide:
+ *		https://labjack.com/support/software/api/ljm
+ *	Opening and Closing:
+ *		https://labjack.com/support/software/api/ljm/function-reference/opening-and-closing
+ *	eNames:
+ *		https://labjack.com/support/software/api/ljm/function-reference/ljmenames
+ *
+ * T-Series and I/O:
+ *	Modbus Map:
+ *		https://labjack.com/support/software/api/modbus/modbus-map
+ *	Digital I/O:
+ *		https://labjack.com/support/datasheets/t-series/digital-io
+ *	SPI:
+ *		https://labjack.com/support/datasheets/t-series/digital-io/spi
+**/
+
+#include <stdio.h>
+
+#include <LabJackM.h>
+
+#include "../../LJM_SPIUtilities.h"
+
+enum { NUM_BYTES = 1000 };
+enum { NUM_TRANSFERS = 10 };
+
+int main()
+{
+	int handle, i, t;
+	int numMismatched = 0;
+	unsigned char aTX[NUM_BYTES];
+	unsigned char aRX[NUM_BYTES];
+	SPIBus bus;
+
+	// Open first found LabJack
+	handle = OpenOrDie(LJM_dtANY, LJM_ctANY, "LJM_idANY");
+	// handle = OpenSOrDie("LJM_dtANY", "LJM_ctANY", "LJM_idANY");
+
+	PrintDeviceInfoFromHandle(handle);
+	printf("\n");
+
+	// Mode 3 (CPHA=1, CPOL=1), the fastest speed throttle and the default
+	// options
+	if (GetDeviceType(handle) == LJM_dtT4) {
+		// FIO0 to FIO3 are reserved for analog inputs on the T4
+		InitSPIBus(&bus, handle, 5, 4, 7, 6, 3, 0, 0);
+	}
+	else {
+		InitSPIBus(&bus, handle, 1, 0, 3, 2, 3, 0, 0);
+	}
+	printf("Sending %d bytes per transfer in chunks of up to %d bytes\n",
+		NUM_BYTES, bus.chunkBytes);
+
+	for (i = 0; i < NUM_BYTES; i++) {
+		aTX[i] = (unsigned char)(i * 7);
+	}
+
+	for (t = 0; t < NUM_TRANSFERS; t++) {
+		SPITransferOrDie(&bus, NUM_BYTES, aTX, aRX);
+
+		for (i = 0; i < NUM_BYTES; i++) {
+			if (aRX[i] != aTX[i]) {
+				numMismatched++;
+			}
+		}
+	}
+
+	printf("%d of %d received bytes did not match the sent bytes\n",
+		numMismatched, NUM_BYTES * NUM_TRANSFERS);
+	if (numMismatched > 0) {
+		printf("Is MOSI shorted to MISO?\n");
+	}
+	PrintSPIBusStatistics(&bus);
+
+	CloseOrDie(handle);
+
+	WaitForUserIfWindows();
+
+	return LJME_NOERROR;
+}
@@ -0,0 +1,160 @@
+/**
+ * Name: stream_burst_capture.c
+ * Desc: Demonstrates large stream bursts with LJM_StreamCaptureUtilities.h.
+ *       With only STREAM_NUM_SCANS, the burst is captured as float32 into a
+ *       buffer, using huge pages if available, and then verified by several
+ *       threads. With OUTPUT_FILE, the burst is instead written to the file
+ *       as it is read.
+ * Note: Connect AIN0 to any constant voltage to check that it is streaming
+ *       correctly.
+ *
+ * Relevant Documentation:
+ *
+ * LJM Library:
+ *	LJM Library Installer:
+ *		https://labjack.com/support/software/installers/ljm
+ *	LJM Users Guide:
+ *		https://labjack.com/support/software/api/ljm
+ *	Opening and Closing:
+ *		https://labjack.com/support/software/api/ljm/function-reference/opening-and-closing
+ *	StreamBurst:
+ *		https://labjack.com/support/software/api/ljm/function-reference/ljmstreamburst
+ *	Stream Functions (eStreamRead, eStreamStart, etc.):
+ *		https://labjack.com/support/software/api/ljm/function-reference/stream-functions
+ *
+ * T-Series and I/O:
+ *	Modbus Map:
+ *		https://labjack.com/support/software/api/modbus/modbus-map
+ *	Stream Mode:
+ *		https://labjack.com/support/datasheets/t-series/communication/stream-mode
+ *	Analog Inputs:
+ *		https://labjack.com/support/datasheets/t-series/ain
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <LabJackM.h>
+
+#include "../../LJM_StreamCaptureUtilities.h"
+#include "../../LJM_StreamUtilities.h"
+
+enum { NUM_CHANNELS = 2 };
+const char * CHANNEL_NAMES[NUM_CHANNELS] = {"AIN0", "FIO_STATE"};
+const double CHANNEL_DELTAS[NUM_CHANNELS] = {0.01, 0};
+
+enum { NUM_VERIFY_THREADS = 4 };
+
+int main(int argc, char * argv[])
+{
+	int handle, err, numScans, numScansCaptured, usedHugePages;
+	int aScanList[NUM_CHANNELS];
+	double aExpected[NUM_CHANNELS];
+	size_t numSamples, numMismatches;
+	float * aSamples;
+	FILE * file = NULL;
+	unsigned int timeStart, timeEnd;
+	int errorAddress = INITIAL_ERR_ADDRESS;
+
+	// How fast to stream in Hz. 10 kHz of 2 channels is 20 kS/s, which the
+	// T4, T7 and T8 can all sustain.
+	double scanRate = 10000;
+
+	if (argc != 2 && argc != 3) {
+		printf("Usage: %s STREAM_NUM_SCANS [OUTPUT_FILE]\n", argv[0]);
+		WaitForUserIfWindows();
+		exit(1);
+	}
+
+	numScans = strtol(argv[1], NULL, 10);
+	if (numScans <= 0) {
+		printf("STREAM_NUM_SCANS must be greater than 0\n");
+		WaitForUserIfWindows();
+		exit(1);
+	}
+	numSamples = (size_t)numScans * NUM_CHANNELS;
+
+	if (argc == 3) {
+		file = fopen(argv[2], "wb");
+		if (file == NULL) {
+			printf("Could not open %s\n", argv[2]);
+			WaitForUserIfWindows();
+			exit(1);
+		}
+	}
+
+	// Open first found LabJack
+	handle = OpenOrDie(LJM_dtANY, LJM_ctANY, "LJM_idANY");
+	// handle = OpenSOrDie("LJM_dtANY", "LJM_ctANY", "LJM_idANY");
+
+	PrintDeviceInfoFromHandle(handle);
+	printf("\n");
+
+	DisableStreamIfEnabled(handle);
+
+	WriteNameOrDie(handle, "STREAM_TRIGGER_INDEX", 0);
+	WriteNameOrDie(handle, "STREAM_CLOCK_SOURCE", 0);
+	WriteNameOrDie(handle, "STREAM_RESOLUTION_INDEX", 0);
+	WriteNameOrDie(handle, "STREAM_SETTLING_US", 0);
+
+	err = LJM_NamesToAddresses(NUM_CHANNELS, CHANNEL_NAMES, aScanList, NULL);
+	ErrorCheck(err, "LJM_NamesToAddresses");
+
+	// The stream should read the same values as a command-response read
+	err = LJM_eReadNames(handle, NUM_CHANNELS, CHANNEL_NAMES, aExpected,
+		&errorAddress);
+	ErrorCheckWithAddress(err, errorAddress, "LJM_eReadNames");
+
+	printf("Starting a burst of %d scans (%lu samples)\n", numScans,
+		(unsigned long)numSamples);
+
+	if (file) {
+		timeStart = GetCurrentTimeMS();
+		err = StreamBurstToFile(handle, NUM_CHANNELS, aScanList, &scanRate,
+			numScans, file, &numScansCaptured);
+		timeEnd = GetCurrentTimeMS();
+		fclose(file);
+		ErrorCheck(err, "StreamBurstToFile");
+
+		printf("Wrote %d scans of float32 samples to %s in %u ms at %.02f Hz\n",
+			numScansCaptured, argv[2], timeEnd - timeStart, scanRate);
+	}
+	else {
+		aSamples = AllocateCaptureBuffer(numSamples, 1, &usedHugePages);
+		if (aSamples == NULL) {
+			printf("Could not allocate %lu samples\n",
+				(unsigned long)numSamples);
+			LJM_CloseAll();
+			WaitForUserIfWindows();
+			exit(1);
+		}
+		printf("Capture buffer: %.1f MB%s\n",
+			numSamples * sizeof(float) / 1048576.0,
+			usedHugePages ? ", huge pages" : "");
+
+		timeStart = GetCurrentTimeMS();
+		err = StreamBurstToBuffer(handle, NUM_CHANNELS, aScanList, &scanRate,
+			numScans, aSamples, &numScansCaptured);
+		timeEnd = GetCurrentTimeMS();
+		ErrorCheck(err, "StreamBurstToBuffer");
+
+		printf("Captured %d scans in %u ms at %.02f Hz\n", numScansCaptured,
+			timeEnd - timeStart, scanRate);
+
+		timeStart = GetCurrentTimeMS();
+		numMismatches = VerifyCapture(aSamples, numScansCaptured,
+			NUM_CHANNELS, aExpected, CHANNEL_DELTAS, NUM_VERIFY_THREADS);
+		timeEnd = GetCurrentTimeMS();
+		printf("Verified with %d threads in %u ms: %lu mismatched samples\n",
+			NUM_VERIFY_THREADS, timeEnd - timeStart,
+			(unsigned long)numMismatches);
+
+		FreeCaptureBuffer(aSamples, numSamples, usedHugePages);
+	}
+
+	CloseOrDie(handle);
+
+	WaitForUserIfWindows();
+
+	return LJME_NOERROR;
+}
@@ -1,6 +1,8 @@
 /**
  * Name: stream_external_clock.c
  * Desc: Shows how to stream with the T7 or T8 in external clock stream mode.
+ *       An ExternalClockMonitor estimates the external clock rate and
+ *       reports when the clock stops or drifts.
  * Note: Similar to stream_callback.c, which uses a callback to read from stream.
  *
  * Relevant Documentation:
@@ -166,6 +168,12 @@ void StreamReturnAllOrNone(int handle)
 	int LJMScanBacklog = 0;
 	int streamRead = 0;
 
+	// Flag the external clock if it stops for 1 second or is more than 2%
+	// off of SCAN_RATE
+	ExternalClockMonitor monitor;
+	int lastClockStatus = CLOCK_STATUS_OK;
+	InitExternalClockMonitor(&monitor, SCAN_RATE, 0.02, 1);
+
 	// Configure LJM for unpredictable stream timing
 	SetConfigValue(LJM_STREAM_SCANS_RETURN, LJM_STREAM_SCANS_RETURN_ALL_OR_NONE);
 	SetConfigValue(LJM_STREAM_RECEIVE_TIMEOUT_MODE, LJM_STREAM_RECEIVE_TIMEOUT_MODE_MANUAL);
@@ -191,7 +199,16 @@ void StreamReturnAllOrNone(int handle)
 	while (streamRead++ < NUM_LOOP_ITERATIONS) {
 		VariableStreamSleep(SCANS_PER_READ, SCAN_RATE, LJMScanBacklog);
 
-		err = LJM_eStreamRead(handle, aData, &deviceScanBacklog, &LJMScanBacklog);
+		err = ExternalClockStreamRead(&monitor, handle, SCANS_PER_READ, aData,
+			&deviceScanBacklog, &LJMScanBacklog);
+		if (monitor.status != lastClockStatus) {
+			printf("\nExternal clock status: %s%s%s (estimated %.02f Hz)\n",
+				monitor.status == CLOCK_STATUS_OK ? "OK" : "",
+				(monitor.status & CLOCK_STATUS_DROPOUT) ? "dropout " : "",
+				(monitor.status & CLOCK_STATUS_DRIFT) ? "drift" : "",
+				monitor.estimatedScanRate);
+			lastClockStatus = monitor.status;
+		}
 		if (err == LJME_NO_SCANS_RETURNED) {
 			// printf("Stream has not collected %d scans yet.\n", SCANS_PER_READ);
 			printf(".");
@@ -212,6 +229,7 @@ void StreamReturnAllOrNone(int handle)
 	free(aScanList);
 
 	printf("\nDone with %d iterations\n", NUM_LOOP_ITERATIONS);
+	PrintExternalClockMonitorStatistics(&monitor);
 }
 
 void HardcodedPrintScans(const char ** chanNames, const double * aData,
@@ -0,0 +1,174 @@
+/**
+ * Name: stream_multi_device.c
+ * Desc: Demonstrates LJM_MultiDeviceStream.h by streaming AIN0 and AIN1 from
+ *       every LabJack found at the same time. The scans of each device are
+ *       aligned on the host's clock and delivered as frames, and the first
+ *       scan of each frame is printed for every device along with how far it
+ *       is from the first device's first scan.
+ * Note: For the most precise alignment, connect a common clock to each
+ *       device's CIO3 (DIO18) and set USE_EXTERNAL_CLOCK, or connect a common
+ *       trigger to each device's DIO0 and set TRIGGER_INDEX to 2000.
+ *
+ * Relevant Documentation:
+ *
+ * LJM Library:
+ *	LJM Library Installer:
+ *		https://labjack.com/support/software/installers/ljm
+ *	LJM Users Guide:
+ *		https://labjack.com/support/software/api/ljm
+ *	Opening and Closing:
+ *		https://labjack.com/support/software/api/ljm/function-reference/opening-and-closing
+ *	ListAll:
+ *		https://labjack.com/support/software/api/ljm/function-reference/ljmlistall
+ *	NamesToAddresses:
+ *		https://labjack.com/support/software/api/ljm/function-reference/utility/ljmnamestoaddresses
+ *	Stream Functions (eStreamRead, eStreamStart, etc.):
+ *		https://labjack.com/support/software/api/ljm/function-reference/stream-functions
+ *
+ * T-Series and I/O:
+ *	Modbus Map:
+ *		https://labjack.com/support/software/api/modbus/modbus-map
+ *	Stream Mode:
+ *		https://labjack.com/support/datasheets/t-series/communication/stream-mode
+ *	Analog Inputs:
+ *		https://labjack.com/support/datasheets/t-series/ain
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <LabJackM.h>
+
+#include "../../LJM_MultiDeviceStream.h"
+
+enum { NUM_CHANNELS = 2 };
+const char * CHANNEL_NAMES[NUM_CHANNELS] = {"AIN0", "AIN1"};
+
+const double SCAN_RATE = 1000;
+const int SCANS_PER_READ = 500;
+const int NUM_FRAMES = 20;
+
+// Set to 1 to stream every device from a clock on CIO3
+const int USE_EXTERNAL_CLOCK = 0;
+
+// Set to 2000 to start every device's stream on an edge of DIO0
+const int TRIGGER_INDEX = 0;
+
+// Opens each device found, once even if it has several connections. Returns
+// the number of devices opened.
+int OpenAllDevices(int * aHandles)
+{
+	int err, i, j;
+	int numFound = 0;
+	int numOpened = 0;
+	int aDeviceTypes[LJM_LIST_ALL_SIZE];
+	int aConnectionTypes[LJM_LIST_ALL_SIZE];
+	int aSerialNumbers[LJM_LIST_ALL_SIZE];
+	int aIPAddresses[LJM_LIST_ALL_SIZE];
+	int aOpenedSerials[MAX_MULTI_STREAM_DEVICES];
+	char serialString[LJM_STRING_ALLOCATION_SIZE];
+
+	err = LJM_ListAll(LJM_dtANY, LJM_ctANY, &numFound, aDeviceTypes,
+		aConnectionTypes, aSerialNumbers, aIPAddresses);
+	ErrorCheck(err, "LJM_ListAll");
+
+	for (i = 0; i < numFound && numOpened < MAX_MULTI_STREAM_DEVICES; i++) {
+		for (j = 0; j < numOpened; j++) {
+			if (aOpenedSerials[j] == aSerialNumbers[i]) {
+				break;
+			}
+		}
+		if (j < numOpened) {
+			continue;
+		}
+
+		sprintf(serialString, "%d", aSerialNumbers[i]);
+		aHandles[numOpened] = OpenOrDie(aDeviceTypes[i], LJM_ctANY,
+			serialString);
+		aOpenedSerials[numOpened] = aSerialNumbers[i];
+		numOpened++;
+	}
+
+	return numOpened;
+}
+
+int main()
+{
+	int err, i, frameI, numDevices;
+	int aHandles[MAX_MULTI_STREAM_DEVICES];
+	int aScanList[NUM_CHANNELS];
+	const MultiDeviceFrame * frame;
+	MultiDeviceStream stream;
+
+	numDevices = OpenAllDevices(aHandles);
+	if (numDevices == 0) {
+		printf("No devices found\n");
+		WaitForUserIfWindows();
+		return 1;
+	}
+
+	for (i = 0; i < numDevices; i++) {
+		PrintDeviceInfoFromHandle(aHandles[i]);
+		DisableStreamIfEnabled(aHandles[i]);
+		// The negative ch register is not valid for the T4
+		if (GetDeviceType(aHandles[i]) != LJM_dtT4) {
+			WriteNameOrDie(aHandles[i], "AIN_ALL_NEGATIVE_CH", LJM_GND);
+		}
+		WriteNameOrDie(aHandles[i], "STREAM_SETTLING_US", 0);
+		WriteNameOrDie(aHandles[i], "STREAM_RESOLUTION_INDEX", 0);
+	}
+	printf("\n");
+
+	err = LJM_NamesToAddresses(NUM_CHANNELS, CHANNEL_NAMES, aScanList, NULL);
+	ErrorCheck(err, "LJM_NamesToAddresses");
+
+	InitMultiDeviceStream(&stream, numDevices, aHandles, NUM_CHANNELS,
+		aScanList, SCAN_RATE, SCANS_PER_READ);
+	stream.useExternalClock = USE_EXTERNAL_CLOCK;
+	stream.triggerIndex = TRIGGER_INDEX;
+
+	err = StartMultiDeviceStream(&stream);
+	ErrorCheck(err, "StartMultiDeviceStream");
+	printf("Stream started on %d devices\n\n", numDevices);
+
+	for (frameI = 0; frameI < NUM_FRAMES; frameI++) {
+		// Wait longer than a read for the first clock or trigger
+		frame = GetMultiDeviceFrame(&stream, 10000);
+		if (frame == NULL) {
+			PrintErrorIfError(stream.err, "GetMultiDeviceFrame");
+			if (stream.err == LJME_NOERROR) {
+				printf("No frame within 10 seconds\n");
+			}
+			break;
+		}
+
+		printf("frame: %d - host time: %.6f s\n", frameI, frame->hostTime);
+		for (i = 0; i < numDevices; i++) {
+			printf("    handle %d: scan %.0f, %+.6f s, %s = %f V, "
+				"%s = %f V\n", aHandles[i], frame->aFirstScanIndexes[i],
+				frame->aTimeOffsets[i], CHANNEL_NAMES[0],
+				MultiDeviceFrameValue(&stream, frame, i, 0, 0),
+				CHANNEL_NAMES[1],
+				MultiDeviceFrameValue(&stream, frame, i, 0, 1));
+		}
+
+		ReleaseMultiDeviceFrame(&stream);
+	}
+
+	printf("\n");
+	PrintMultiDeviceStreamStatistics(&stream);
+
+	printf("Stopping stream\n");
+	err = StopMultiDeviceStream(&stream);
+	PrintErrorIfError(err, "StopMultiDeviceStream");
+
+	FreeMultiDeviceStream(&stream);
+
+	for (i = 0; i < numDevices; i++) {
+		CloseOrDie(aHandles[i]);
+	}
+
+	WaitForUserIfWindows();
+
+	return LJME_NOERROR;
+}
@@ -0,0 +1,147 @@
+/**
+ * Name: stream_planned_scan_list.c
+ * Desc: Demonstrates PlanStreamScanList of LJM_StreamUtilities.h. The
+ *       requested channels, some with different ranges, duplicates and single
+ *       DIO lines, are planned into a scan list that groups the analog inputs
+ *       by range and reads each DIO state register once. The plan is then
+ *       streamed at its predicted maximum scan rate to compare the predicted
+ *       rate to the rate the device sustains, and each request's value is
+ *       printed from the planned scans.
+ *
+ * Relevant Documentation:
+ *
+ * LJM Library:
+ *	LJM Library Installer:
+ *		https://labjack.com/support/software/installers/ljm
+ *	LJM Users Guide:
+ *		https://labjack.com/support/software/api/ljm
+ *	Opening and Closing:
+ *		https://labjack.com/support/software/api/ljm/function-reference/opening-and-closing
+ *	NameToAddress:
+ *		https://labjack.com/support/software/api/ljm/function-reference/utility/ljmnametoaddress
+ *	Stream Functions (eStreamRead, eStreamStart, etc.):
+ *		https://labjack.com/support/software/api/ljm/function-reference/stream-functions
+ *
+ * T-Series and I/O:
+ *	Modbus Map:
+ *		https://labjack.com/support/software/api/modbus/modbus-map
+ *	Stream Mode:
+ *		https://labjack.com/support/datasheets/t-series/communication/stream-mode
+ *	Analog Inputs:
+ *		https://labjack.com/support/datasheets/t-series/ain
+ *	Digital I/O:
+ *		https://labjack.com/support/datasheets/t-series/digital-io
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <LabJackM.h>
+
+#include "../../LJM_StreamUtilities.h"
+
+enum { NUM_REQUESTS = 8 };
+
+// Ranges are ignored for the T4, which has fixed ranges
+const StreamChannelRequest REQUESTS[NUM_REQUESTS] = {
+	{"AIN0", 10, 0},
+	{"FIO0", 0, 0},
+	{"AIN1", 1, 0},
+	{"FIO1", 0, 0},
+	{"AIN2", 10, 0},
+	{"AIN0", 10, 0},
+	{"SYSTEM_TIMER_20HZ", 0, 0},
+	{"STREAM_DATA_CAPTURE_16", 0, 0}
+};
+
+const int NUM_TEST_READS = 20;
+const int NUM_PRINTED_READS = 5;
+
+int main()
+{
+	int handle, err, iteration, requestI;
+	int deviceScanBacklog, LJMScanBacklog;
+	int scansPerRead;
+	double scanRate;
+	double * aData;
+	StreamPlan plan;
+	StreamPlanResult result;
+
+	// Open first found LabJack
+	handle = OpenOrDie(LJM_dtANY, LJM_ctANY, "LJM_idANY");
+	// handle = OpenSOrDie("LJM_dtANY", "LJM_ctANY", "LJM_idANY");
+
+	PrintDeviceInfoFromHandle(handle);
+	printf("\n");
+
+	err = PlanStreamScanList(GetDeviceType(handle), NUM_REQUESTS, REQUESTS,
+		&plan);
+	ErrorCheck(err, "PlanStreamScanList");
+
+	DisableStreamIfEnabled(handle);
+
+	WriteNameOrDie(handle, "STREAM_TRIGGER_INDEX", 0);
+	WriteNameOrDie(handle, "STREAM_CLOCK_SOURCE", 0);
+
+	// The negative ch register is not valid for the T4, so don't use it if
+	// the device is a T4.
+	if (plan.deviceType != LJM_dtT4) {
+		WriteNameOrDie(handle, "AIN_ALL_NEGATIVE_CH", LJM_GND);
+	}
+
+	err = ConfigureStreamPlan(handle, &plan);
+	ErrorCheck(err, "ConfigureStreamPlan");
+
+	// Read about every 0.1 seconds
+	scanRate = plan.predictedScanRate;
+	scansPerRead = (int)(scanRate / 10);
+	if (scansPerRead < 1) {
+		scansPerRead = 1;
+	}
+
+	TestStreamPlan(handle, &plan, scanRate, scansPerRead, NUM_TEST_READS,
+		&result);
+	PrintStreamPlanReport(&plan, &result);
+	printf("\n");
+
+	// Stream the plan and print each request's value of the first scan
+	aData = malloc(sizeof(double) * plan.numChannels * scansPerRead);
+	if (aData == NULL) {
+		printf("Could not allocate %d scans\n", scansPerRead);
+		LJM_CloseAll();
+		exit(1);
+	}
+
+	// Back off if the device did not sustain the predicted rate
+	scanRate = result.actualScanRate;
+	if (result.err != LJME_NOERROR || result.numSkippedScans > 0) {
+		scanRate /= 2;
+	}
+	err = LJM_eStreamStart(handle, scansPerRead, plan.numChannels,
+		plan.aScanList, &scanRate);
+	ErrorCheck(err, "LJM_eStreamStart");
+
+	for (iteration = 0; iteration < NUM_PRINTED_READS; iteration++) {
+		err = LJM_eStreamRead(handle, aData, &deviceScanBacklog,
+			&LJMScanBacklog);
+		ErrorCheck(err, "LJM_eStreamRead");
+
+		printf("iteration: %d -", iteration);
+		for (requestI = 0; requestI < NUM_REQUESTS; requestI++) {
+			printf(" %s = %g", REQUESTS[requestI].name,
+				PlannedRequestValue(&plan, aData, requestI));
+		}
+		printf("\n");
+	}
+
+	err = LJM_eStreamStop(handle);
+	ErrorCheck(err, "LJM_eStreamStop");
+
+	free(aData);
+
+	CloseOrDie(handle);
+
+	WaitForUserIfWindows();
+
+	return LJME_NOERROR;
+}
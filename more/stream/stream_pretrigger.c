@@ -0,0 +1,167 @@
+/**
+ * Name: stream_pretrigger.c
+ * Desc: Demonstrates a software pre-trigger capture with PreTriggerCapture of
+ *       LJM_StreamCaptureUtilities.h. Unlike stream_triggered.c, the stream
+ *       runs freely and the trigger is evaluated on the host, so each window
+ *       includes the scans before the trigger and the trigger re-arms
+ *       without restarting the stream. The trigger is a rising edge of AIN0
+ *       through 1.0 V.
+ * Note: Connect AIN0 to a signal that crosses 1.0 V, such as a function
+ *       generator or DAC0, to see windows.
+ *
+ * Relevant Documentation:
+ *
+ * LJM Library:
+ *	LJM Library Installer:
+ *		https://labjack.com/support/software/installers/ljm
+ *	LJM Users Guide:
+ *		https://labjack.com/support/software/api/ljm
+ *	Opening and Closing:
+ *		https://labjack.com/support/software/api/ljm/function-reference/opening-and-closing
+ *	NamesToAddresses:
+ *		https://labjack.com/support/software/api/ljm/function-reference/utility/ljmnamestoaddresses
+ *	Stream Functions (eStreamRead, eStreamStart, etc.):
+ *		https://labjack.com/support/software/api/ljm/function-reference/stream-functions
+ *
+ * T-Series and I/O:
+ *	Modbus Map:
+ *		https://labjack.com/support/software/api/modbus/modbus-map
+ *	Stream Mode:
+ *		https://labjack.com/support/datasheets/t-series/communication/stream-mode
+ *	Analog Inputs:
+ *		https://labjack.com/support/datasheets/t-series/ain
+ *	Digital I/O:
+ *		https://labjack.com/support/datasheets/t-series/digital-io
+**/
+
+#include <stdio.h>
+
+#include <LabJackM.h>
+
+#include "../../LJM_StreamCaptureUtilities.h"
+#include "../../LJM_StreamUtilities.h"
+
+enum { NUM_CHANNELS = 2 };
+const char * CHANNEL_NAMES[NUM_CHANNELS] = {"AIN0", "FIO_STATE"};
+
+enum { NUM_PRE_SCANS = 1000 };
+enum { NUM_POST_SCANS = 1000 };
+
+const int SCANS_PER_READ = 500;
+const int NUM_READS = 40;
+
+void PrintCaptureWindow(const CaptureWindow * window);
+
+int main()
+{
+	int handle, err, iteration;
+	int deviceScanBacklog, LJMScanBacklog;
+	int aScanList[NUM_CHANNELS];
+	PreTriggerCapture capture;
+	CaptureWindow window;
+
+	// How fast to stream in Hz
+	double scanRate = 10000;
+
+	// Trigger when AIN0, the first channel, rises through 1.0 V
+	StreamTrigger trigger;
+	trigger.type = TRIGGER_RISING_EDGE;
+	trigger.channel = 0;
+	trigger.level = 1.0;
+	trigger.mask = 0;
+	trigger.match = 0;
+
+	// To trigger when FIO0 goes high instead:
+	// trigger.type = TRIGGER_DIO_MASK;
+	// trigger.channel = 1;
+	// trigger.mask = 0x01;
+	// trigger.match = 0x01;
+
+	// Open first found LabJack
+	handle = OpenOrDie(LJM_dtANY, LJM_ctANY, "LJM_idANY");
+	// handle = OpenSOrDie("LJM_dtANY", "LJM_ctANY", "LJM_idANY");
+
+	PrintDeviceInfoFromHandle(handle);
+	printf("\n");
+
+	InitPreTriggerCapture(&capture, NUM_CHANNELS, SCANS_PER_READ,
+		NUM_PRE_SCANS, NUM_POST_SCANS, &trigger);
+
+	DisableStreamIfEnabled(handle);
+
+	WriteNameOrDie(handle, "STREAM_TRIGGER_INDEX", 0);
+	WriteNameOrDie(handle, "STREAM_CLOCK_SOURCE", 0);
+	WriteNameOrDie(handle, "STREAM_RESOLUTION_INDEX", 0);
+	WriteNameOrDie(handle, "STREAM_SETTLING_US", 0);
+
+	// Range and negative ch registers are not valid for the T4, so don't use
+	// them if the device is a T4.
+	if (GetDeviceType(handle) != LJM_dtT4) {
+		WriteNameOrDie(handle, "AIN_ALL_NEGATIVE_CH", LJM_GND);
+		WriteNameOrDie(handle, "AIN0_RANGE", 10);
+	}
+
+	err = LJM_NamesToAddresses(NUM_CHANNELS, CHANNEL_NAMES, aScanList, NULL);
+	ErrorCheck(err, "LJM_NamesToAddresses");
+
+	err = LJM_eStreamStart(handle, SCANS_PER_READ, NUM_CHANNELS, aScanList,
+		&scanRate);
+	ErrorCheck(err, "LJM_eStreamStart");
+	printf("Stream started. Actual scan rate: %.02f Hz\n", scanRate);
+	printf("Capturing %d scans before and %d scans from each trigger\n\n",
+		NUM_PRE_SCANS, NUM_POST_SCANS);
+
+	for (iteration = 0; iteration < NUM_READS; iteration++) {
+		err = PreTriggerCaptureRead(&capture, handle, &deviceScanBacklog,
+			&LJMScanBacklog);
+		ErrorCheck(err, "PreTriggerCaptureRead");
+
+		while (GetCaptureWindow(&capture, &window)) {
+			printf("iteration: %d - ", iteration);
+			PrintCaptureWindow(&window);
+		}
+	}
+
+	printf("\n");
+	PrintPreTriggerCaptureStatistics(&capture);
+
+	printf("Stopping stream\n");
+	err = LJM_eStreamStop(handle);
+	ErrorCheck(err, "LJM_eStreamStop");
+
+	FreePreTriggerCapture(&capture);
+
+	CloseOrDie(handle);
+
+	WaitForUserIfWindows();
+
+	return LJME_NOERROR;
+}
+
+void PrintCaptureWindow(const CaptureWindow * window)
+{
+	int scanI;
+	double value;
+	const int numScans = window->numFirstScans + window->numSecondScans;
+	double minAIN0 = CaptureWindowValue(window, NUM_CHANNELS, 0, 0);
+	double maxAIN0 = minAIN0;
+
+	for (scanI = 1; scanI < numScans; scanI++) {
+		value = CaptureWindowValue(window, NUM_CHANNELS, scanI, 0);
+		if (value < minAIN0) {
+			minAIN0 = value;
+		}
+		if (value > maxAIN0) {
+			maxAIN0 = value;
+		}
+	}
+
+	printf("window of %d scans (%d + %d in the ring): ", numScans,
+		window->numFirstScans, window->numSecondScans);
+	printf("AIN0 before trigger = %f V, at trigger = %f V, "
+		"min = %f V, max = %f V, FIO_STATE at trigger = %d\n",
+		CaptureWindowValue(window, NUM_CHANNELS, window->triggerScan - 1, 0),
+		CaptureWindowValue(window, NUM_CHANNELS, window->triggerScan, 0),
+		minAIN0, maxAIN0,
+		(int)CaptureWindowValue(window, NUM_CHANNELS, window->triggerScan, 1));
+}
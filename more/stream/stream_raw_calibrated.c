@@ -0,0 +1,153 @@
+/**
+ * Name: stream_raw_calibrated.c
+ * Desc: Streams raw analog input readings and converts them to volts on the
+ *       host with LJM_CalibrationUtilities.h. With LJM_STREAM_AIN_BINARY
+ *       enabled, LJM_eStreamRead returns each reading as the raw 16-bit value
+ *       sent by the device, and each block is converted to volts with the
+ *       calibration constants of the device, which are cached on disk by
+ *       serial number and firmware version.
+ *
+ * Relevant Documentation:
+ *
+ * LJM Library:
+ *	LJM Library Installer:
+ *		https://labjack.com/support/software/installers/ljm
+ *	LJM Users Guide:
+ *		https://labjack.com/support/software/api/ljm
+ *	Opening and Closing:
+ *		https://labjack.com/support/software/api/ljm/function-reference/opening-and-closing
+ *	LJM Configuration:
+ *		https://labjack.com/support/software/api/ljm/function-reference/ljmwritelibraryconfigs
+ *	Stream Functions:
+ *		https://labjack.com/support/software/api/ljm/function-reference/stream-functions
+ *
+ * T-Series and I/O:
+ *	Modbus Map:
+ *		https://labjack.com/support/software/api/modbus/modbus-map
+ *	Stream Mode:
+ *		https://labjack.com/support/datasheets/t-series/communication/stream-mode
+ *	Analog Inputs:
+ *		https://labjack.com/support/datasheets/t-series/ain
+ *	Internal Flash(contains calibration info):
+ *		https://labjack.com/support/datasheets/t-series/internal-flash
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <LabJackM.h>
+
+#include "../../LJM_CalibrationUtilities.h"
+#include "../../LJM_StreamUtilities.h"
+
+int main()
+{
+	int handle, err, iteration, channel;
+	int deviceScanBacklog, LJMScanBacklog;
+	double * aData;
+	LJM_LONG_LONG_RETURN start;
+	LJM_LONG_LONG_RETURN convertTicks = 0;
+	DeviceCalibration cal;
+	RawToVoltsConverter converter;
+
+	double scanRate = 10000;
+	const int SCANS_PER_READ = 5000;
+	const int NUM_READS = 10;
+
+	// The calibration cache files are written to the working directory
+	const char * CAL_CACHE_DIR = ".";
+
+	enum { NUM_CHANNELS = 2 };
+	const char * CHANNEL_NAMES[NUM_CHANNELS] = {"AIN0", "AIN1"};
+	const int AIN_NUMBERS[NUM_CHANNELS] = {0, 1};
+	const double AIN_RANGES[NUM_CHANNELS] = {10, 10};
+	int aScanList[NUM_CHANNELS];
+
+	// Open first found LabJack
+	handle = OpenOrDie(LJM_dtANY, LJM_ctANY, "LJM_idANY");
+	// handle = OpenSOrDie("LJM_dtANY", "LJM_ctANY", "LJM_idANY");
+
+	PrintDeviceInfoFromHandle(handle);
+	printf("\n");
+
+	if (GetDeviceType(handle) == LJM_dtT8) {
+		printf("The T8 is not supported by LJM_CalibrationUtilities.h\n");
+		CloseOrDie(handle);
+		WaitForUserIfWindows();
+		return 1;
+	}
+
+	err = LoadDeviceCalibration(handle, CAL_CACHE_DIR, &cal);
+	ErrorCheck(err, "LoadDeviceCalibration");
+	PrintDeviceCalibration(&cal);
+	printf("\n");
+
+	InitRawToVolts(&converter, &cal, NUM_CHANNELS, AIN_NUMBERS, AIN_RANGES);
+
+	DisableStreamIfEnabled(handle);
+
+	WriteNameOrDie(handle, "STREAM_TRIGGER_INDEX", 0);
+	WriteNameOrDie(handle, "STREAM_CLOCK_SOURCE", 0);
+	WriteNameOrDie(handle, "STREAM_RESOLUTION_INDEX", 0);
+	WriteNameOrDie(handle, "STREAM_SETTLING_US", 0);
+
+	// Range and negative ch registers are not valid for the T4, so don't use
+	// them if the device is a T4.
+	if (GetDeviceType(handle) != LJM_dtT4) {
+		WriteNameOrDie(handle, "AIN0_RANGE", AIN_RANGES[0]);
+		WriteNameOrDie(handle, "AIN1_RANGE", AIN_RANGES[1]);
+		WriteNameOrDie(handle, "AIN_ALL_NEGATIVE_CH", LJM_GND);
+	}
+
+	// Return raw readings instead of volts
+	SetConfigValue(LJM_STREAM_AIN_BINARY, 1);
+
+	err = LJM_NamesToAddresses(NUM_CHANNELS, CHANNEL_NAMES, aScanList, NULL);
+	ErrorCheck(err, "LJM_NamesToAddresses");
+
+	aData = malloc(sizeof(double) * NUM_CHANNELS * SCANS_PER_READ);
+
+	err = LJM_eStreamStart(handle, SCANS_PER_READ, NUM_CHANNELS, aScanList,
+		&scanRate);
+	ErrorCheck(err, "LJM_eStreamStart");
+	printf("Stream started. Actual scan rate: %.02f Hz\n\n", scanRate);
+
+	for (iteration = 0; iteration < NUM_READS; iteration++) {
+		err = LJM_eStreamRead(handle, aData, &deviceScanBacklog,
+			&LJMScanBacklog);
+		ErrorCheck(err, "LJM_eStreamRead");
+
+		printf("iteration: %d - first scan raw:", iteration);
+		for (channel = 0; channel < NUM_CHANNELS; channel++) {
+			printf(" %s = %.0f", CHANNEL_NAMES[channel], aData[channel]);
+		}
+
+		// Convert the whole block in place
+		start = LJM_GetHostTick();
+		ConvertRawToVolts(&converter, SCANS_PER_READ, aData, aData);
+		convertTicks += LJM_GetHostTick() - start;
+
+		printf(", volts:");
+		for (channel = 0; channel < NUM_CHANNELS; channel++) {
+			printf(" %s = %0.5f", CHANNEL_NAMES[channel], aData[channel]);
+		}
+		printf("\n");
+	}
+
+	printf("\nConverted %d samples in %.2f ms\n",
+		NUM_READS * SCANS_PER_READ * NUM_CHANNELS, convertTicks / 1000.0);
+
+	printf("Stopping stream\n");
+	err = LJM_eStreamStop(handle);
+	ErrorCheck(err, "LJM_eStreamStop");
+
+	SetConfigValue(LJM_STREAM_AIN_BINARY, 0);
+
+	free(aData);
+
+	CloseOrDie(handle);
+
+	WaitForUserIfWindows();
+
+	return LJME_NOERROR;
+}
@@ -0,0 +1,140 @@
+/**
+ * Name: stream_supervised.c
+ * Desc: Demonstrates LJM_StreamSupervisor.h, which restarts stream when the
+ *       device reconnects. Streams AIN0 and AIN1 while streaming a looping
+ *       waveform out to DAC0. Unplug and reconnect the USB or Ethernet cable
+ *       while this runs; the stream configuration, including the stream-out
+ *       buffer, is re-applied and a gap line with the outage duration is
+ *       printed where the data is discontinuous.
+ *
+ * Relevant Documentation:
+ *
+ * LJM Library:
+ *	LJM Library Installer:
+ *		https://labjack.com/support/software/installers/ljm
+ *	LJM Users Guide:
+ *		https://labjack.com/support/software/api/ljm
+ *	Opening and Closing:
+ *		https://labjack.com/support/software/api/ljm/function-reference/opening-and-closing
+ *	NamesToAddresses:
+ *		https://labjack.com/support/software/api/ljm/function-reference/utility/ljmnamestoaddresses
+ *	Stream Functions (eStreamRead, eStreamStart, etc.):
+ *		https://labjack.com/support/software/api/ljm/function-reference/stream-functions
+ *	RegisterDeviceReconnectCallback:
+ *		https://labjack.com/support/software/api/ljm/function-reference/LJMRegisterDeviceReconnectCallback
+ *
+ * T-Series and I/O:
+ *	Modbus Map:
+ *		https://labjack.com/support/software/api/modbus/modbus-map
+ *	Stream Mode:
+ *		https://labjack.com/support/datasheets/t-series/communication/stream-mode
+ *	Stream-Out:
+ *		https://labjack.com/support/datasheets/t-series/communication/stream-mode/stream-out/stream-out-description
+ *	Analog Inputs:
+ *		https://labjack.com/support/datasheets/t-series/ain
+ *	DAC:
+ *		https://labjack.com/support/datasheets/t-series/dac
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <LabJackM.h>
+
+#include "../../LJM_StreamSupervisor.h"
+
+enum { NUM_IN_CHANNELS = 2 };
+const char * CHANNEL_IN_NAMES[NUM_IN_CHANNELS] = {"AIN0", "AIN1"};
+
+// The stream-out channel is the last channel of the scan list
+enum { NUM_CHANNELS = NUM_IN_CHANNELS + 1 };
+
+enum { STREAM_OUT_NUM_VALUES = 4 };
+const double STREAM_OUT_VALUES[STREAM_OUT_NUM_VALUES] = {0.5, 1.0, 1.5, 2.0};
+
+const int SCANS_PER_READ = 500;
+const int NUM_READS = 120;
+
+// Keep trying to restart stream for up to 5 minutes after an outage
+const int RESUME_TIMEOUT_MS = 5 * 60 * 1000;
+
+int main()
+{
+	int handle, err, iteration;
+	int deviceScanBacklog, LJMScanBacklog;
+	int aScanList[NUM_CHANNELS];
+	double * aData;
+	StreamSupervisor supervisor;
+
+	// How fast to stream in Hz
+	double scanRate = 1000;
+
+	// Open first found LabJack
+	handle = OpenOrDie(LJM_dtANY, LJM_ctANY, "LJM_idANY");
+	// handle = OpenSOrDie("LJM_dtANY", "LJM_ctANY", "LJM_idANY");
+
+	PrintDeviceInfoFromHandle(handle);
+	printf("\n");
+
+	DisableStreamIfEnabled(handle);
+
+	err = LJM_NamesToAddresses(NUM_IN_CHANNELS, CHANNEL_IN_NAMES, aScanList,
+		NULL);
+	ErrorCheck(err, "LJM_NamesToAddresses");
+	aScanList[NUM_IN_CHANNELS] = STREAM_SUPERVISOR_OUT0_ADDRESS;
+
+	InitStreamSupervisor(&supervisor, handle, NUM_CHANNELS, aScanList,
+		scanRate, SCANS_PER_READ, RESUME_TIMEOUT_MS);
+
+	// Everything that must be configured again after the device reconnects
+	AddStreamConfigWrite(&supervisor, "STREAM_TRIGGER_INDEX", 0);
+	AddStreamConfigWrite(&supervisor, "STREAM_CLOCK_SOURCE", 0);
+	AddStreamConfigWrite(&supervisor, "STREAM_RESOLUTION_INDEX", 0);
+	AddStreamConfigWrite(&supervisor, "STREAM_SETTLING_US", 0);
+	AddStreamConfigWrite(&supervisor, "AIN_ALL_RANGE", 0);
+	AddStreamConfigWrite(&supervisor, "AIN_ALL_NEGATIVE_CH", LJM_GND);
+	err = AddSupervisedStreamOut(&supervisor, 0, "DAC0", 512,
+		STREAM_OUT_NUM_VALUES, STREAM_OUT_VALUES);
+	ErrorCheck(err, "AddSupervisedStreamOut");
+
+	err = StartSupervisedStream(&supervisor);
+	ErrorCheck(err, "StartSupervisedStream");
+	printf("Stream started. Actual scan rate: %.02f Hz\n\n",
+		supervisor.scanRate);
+
+	aData = malloc(sizeof(double) * NUM_CHANNELS * SCANS_PER_READ);
+
+	for (iteration = 0; iteration < NUM_READS; iteration++) {
+		err = SupervisedStreamRead(&supervisor, aData, &deviceScanBacklog,
+			&LJMScanBacklog);
+		if (err == STREAM_SUPERVISOR_GAP) {
+			printf("iteration: %d - GAP: outage of %.3f s, about %.0f scans "
+				"missed, %d restart attempts\n", iteration,
+				supervisor.lastGap.outageSeconds,
+				supervisor.lastGap.numScansMissed,
+				supervisor.lastGap.numRestartAttempts);
+			continue;
+		}
+		ErrorCheck(err, "SupervisedStreamRead");
+
+		printf("iteration: %d - %s = %f V, %s = %f V, deviceScanBacklog: %d, "
+			"LJMScanBacklog: %d\n", iteration, CHANNEL_IN_NAMES[0], aData[0],
+			CHANNEL_IN_NAMES[1], aData[1], deviceScanBacklog, LJMScanBacklog);
+	}
+
+	printf("\n");
+	PrintStreamSupervisorStatistics(&supervisor);
+
+	printf("Stopping stream\n");
+	err = StopSupervisedStream(&supervisor);
+	ErrorCheck(err, "StopSupervisedStream");
+
+	CleanStreamSupervisor(&supervisor);
+	free(aData);
+
+	CloseOrDie(handle);
+
+	WaitForUserIfWindows();
+
+	return LJME_NOERROR;
+}
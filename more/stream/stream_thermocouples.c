@@ -0,0 +1,173 @@
+/**
+ * Name: stream_thermocouples.c
+ * Desc: Streams type K thermocouples on AIN0 to AIN3 along with the T7's
+ *       internal temperature sensor (AIN14) for cold junction compensation,
+ *       and converts each block of stream data to temperatures with
+ *       LJM_ThermocoupleUtilities.h. The first scan of each block is also
+ *       converted with LJM_TCVoltsToTemp to show that the results match.
+ *       This example is for the T7.
+ *
+ * Relevant Documentation:
+ *
+ * Thermocouple App-Note:
+ *		https://labjack.com/support/app-notes/thermocouples
+ *
+ * LJM Library:
+ *	LJM Library Installer:
+ *		https://labjack.com/support/software/installers/ljm
+ *	LJM Users Guide:
+ *		https://labjack.com/support/software/api/ljm
+ *	Opening and Closing:
+ *		https://labjack.com/support/software/api/ljm/function-reference/opening-and-closing
+ *	Stream Functions:
+ *		https://labjack.com/support/software/api/ljm/function-reference/stream-functions
+ *	TCVoltsToTemp:
+ *		https://labjack.com/support/software/api/ud/function-reference/tcvoltstotemp
+ *
+ * T-Series and I/O:
+ *	Modbus Map:
+ *		https://labjack.com/support/software/api/modbus/modbus-map
+ *	Stream Mode:
+ *		https://labjack.com/support/datasheets/t-series/communication/stream-mode
+ *	Analog Inputs:
+ *		https://labjack.com/support/datasheets/t-series/ain
+ *	Internal Temperature Sensor:
+ *		https://labjack.com/support/datasheets/t-series/ain/internal-temp-sensor
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <LabJackM.h>
+
+#include "../../LJM_StreamUtilities.h"
+#include "../../LJM_ThermocoupleUtilities.h"
+
+int main()
+{
+	int handle, err, iteration, channel;
+	int deviceScanBacklog, LJMScanBacklog;
+	double * aData;
+	double libraryTempK, difference;
+	double maxDifference = 0;
+	LJM_LONG_LONG_RETURN start;
+	LJM_LONG_LONG_RETURN convertTicks = 0;
+	TCConverter converter;
+
+	double scanRate = 1000;
+	const int SCANS_PER_READ = 1000;
+	const int NUM_READS = 10;
+
+	// AIN14 reads the internal temperature sensor of the T7, which is
+	// converted to Kelvin with volts * -92.6 + 467.6
+	const double CJC_SLOPE = -92.6;
+	const double CJC_OFFSET = 467.6;
+
+	enum { NUM_CHANNELS = 5 };
+	enum { CJC_CHANNEL = 4 };
+	const char * CHANNEL_NAMES[NUM_CHANNELS] =
+		{"AIN0", "AIN1", "AIN2", "AIN3", "AIN14"};
+	const long TC_TYPES[NUM_CHANNELS] =
+		{LJM_ttK, LJM_ttK, LJM_ttK, LJM_ttK, TC_NOT_A_THERMOCOUPLE};
+	int aScanList[NUM_CHANNELS];
+	double aFirstScanVolts[NUM_CHANNELS];
+
+	// Open first found LabJack
+	handle = OpenOrDie(LJM_dtANY, LJM_ctANY, "LJM_idANY");
+	// handle = OpenSOrDie("LJM_dtANY", "LJM_ctANY", "LJM_idANY");
+
+	PrintDeviceInfoFromHandle(handle);
+	printf("\n");
+
+	if (GetDeviceType(handle) != LJM_dtT7) {
+		printf("This example is for the T7\n");
+		CloseOrDie(handle);
+		WaitForUserIfWindows();
+		return 1;
+	}
+
+	InitTCConverter(&converter, NUM_CHANNELS, TC_TYPES, CJC_CHANNEL,
+		CJC_SLOPE, CJC_OFFSET);
+
+	DisableStreamIfEnabled(handle);
+
+	WriteNameOrDie(handle, "STREAM_TRIGGER_INDEX", 0);
+	WriteNameOrDie(handle, "STREAM_CLOCK_SOURCE", 0);
+	WriteNameOrDie(handle, "STREAM_RESOLUTION_INDEX", 0);
+	WriteNameOrDie(handle, "STREAM_SETTLING_US", 0);
+	WriteNameOrDie(handle, "AIN_ALL_NEGATIVE_CH", LJM_GND);
+
+	// The +/-0.1 V range for the thermocouples, and the +/-10 V range for
+	// the temperature sensor
+	WriteNameOrDie(handle, "AIN0_RANGE", 0.1);
+	WriteNameOrDie(handle, "AIN1_RANGE", 0.1);
+	WriteNameOrDie(handle, "AIN2_RANGE", 0.1);
+	WriteNameOrDie(handle, "AIN3_RANGE", 0.1);
+	WriteNameOrDie(handle, "AIN14_RANGE", 10);
+
+	err = LJM_NamesToAddresses(NUM_CHANNELS, CHANNEL_NAMES, aScanList, NULL);
+	ErrorCheck(err, "LJM_NamesToAddresses");
+
+	aData = malloc(sizeof(double) * NUM_CHANNELS * SCANS_PER_READ);
+
+	err = LJM_eStreamStart(handle, SCANS_PER_READ, NUM_CHANNELS, aScanList,
+		&scanRate);
+	ErrorCheck(err, "LJM_eStreamStart");
+	printf("Stream started. Actual scan rate: %.02f Hz\n\n", scanRate);
+
+	for (iteration = 0; iteration < NUM_READS; iteration++) {
+		err = LJM_eStreamRead(handle, aData, &deviceScanBacklog,
+			&LJMScanBacklog);
+		ErrorCheck(err, "LJM_eStreamRead");
+
+		for (channel = 0; channel < NUM_CHANNELS; channel++) {
+			aFirstScanVolts[channel] = aData[channel];
+		}
+
+		// Convert the whole block in place
+		start = LJM_GetHostTick();
+		ConvertTCVoltsToTemps(&converter, SCANS_PER_READ, aData, aData);
+		convertTicks += LJM_GetHostTick() - start;
+
+		printf("iteration: %d - first scan:", iteration);
+		for (channel = 0; channel < NUM_CHANNELS; channel++) {
+			if (channel == CJC_CHANNEL) {
+				continue;
+			}
+			printf(" %s = %0.2f C", CHANNEL_NAMES[channel],
+				aData[channel] - 273.15);
+
+			err = LJM_TCVoltsToTemp(TC_TYPES[channel],
+				aFirstScanVolts[channel],
+				aFirstScanVolts[CJC_CHANNEL] * CJC_SLOPE + CJC_OFFSET,
+				&libraryTempK);
+			if (err == LJME_NOERROR && aData[channel] != LJM_DUMMY_VALUE) {
+				difference = aData[channel] - libraryTempK;
+				if (difference < 0) {
+					difference = -difference;
+				}
+				if (difference > maxDifference) {
+					maxDifference = difference;
+				}
+			}
+		}
+		printf("\n");
+	}
+
+	printf("\nConverted %d scans in %.2f ms\n", NUM_READS * SCANS_PER_READ,
+		convertTicks / 1000.0);
+	printf("Largest difference from LJM_TCVoltsToTemp: %f K\n",
+		maxDifference);
+
+	printf("Stopping stream\n");
+	err = LJM_eStreamStop(handle);
+	ErrorCheck(err, "LJM_eStreamStop");
+
+	free(aData);
+
+	CloseOrDie(handle);
+
+	WaitForUserIfWindows();
+
+	return LJME_NOERROR;
+}
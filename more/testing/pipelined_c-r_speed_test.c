@@ -0,0 +1,461 @@
+/**
+ * Name: pipelined_c-r_speed_test.c
+ * Desc: Compares the throughput of sequential command-response reads (one
+ *       LJM_eNames call at a time) against pipelined reads that keep several
+ *       Modbus TCP transactions in flight using LJM_WriteRaw/LJM_ReadRaw.
+ * Note: While transactions are in flight, no other LJM function may
+ *       communicate with the device using the same handle, since
+ *       LJM_WriteRaw/LJM_ReadRaw bypass LJM's own transaction handling.
+ *       Pipelining needs a TCP connection (Ethernet or WiFi), where
+ *       responses arrive as a byte stream and each command-response round
+ *       trip is dominated by network latency rather than by device
+ *       processing time. Over USB, each LJM_ReadRaw consumes a whole packet,
+ *       so this test refuses to run on other connection types.
+ *
+ * Relevant Documentation:
+ *
+ * This file extends the test in c-r_speed_test.c, which was used to generate
+ * the data given here:
+ *		https://labjack.com/support/app-notes/maximum-command-response
+ *
+ * LJM Library:
+ *	LJM Library Installer:
+ *		https://labjack.com/support/software/installers/ljm
+ *	LJM Users Guide:
+ *		https://labjack.com/support/software/api/ljm
+ *	Opening and Closing:
+ *		https://labjack.com/support/software/api/ljm/function-reference/opening-and-closing
+ *	eNames:
+ *		https://labjack.com/support/software/api/ljm/function-reference/ljmenames
+ *	Raw Byte Functions:
+ *		https://labjack.com/support/software/api/ljm/function-reference/lowlevel-functions/raw-byte-functions
+ *	Type Conversion Functions:
+ *		https://labjack.com/support/software/api/ljm/function-reference/utility/type-conversion
+ *
+ * T-Series and I/O:
+ *	Modbus Map:
+ *		https://labjack.com/support/software/api/modbus/modbus-map
+ *	Protocol Details:
+ *		https://labjack.com/support/datasheets/t-series/communication/modbus-tcp-protocol
+ *	Analog Inputs:
+ *		https://labjack.com/support/datasheets/t-series/ain
+**/
+
+// For printf
+#include <stdio.h>
+#include <string.h>
+
+// For the LabJackM Library
+#include <LabJackM.h>
+
+// For LabJackM helper functions, such as OpenOrDie, PrintDeviceInfoFromHandle,
+// ErrorCheck, etc.
+#include "../../LJM_Utilities.h"
+
+enum { NUM_ITERATIONS = 1000 };
+
+// The values read each iteration: NUM_VALUES consecutive registers starting at
+// FIRST_NAME. AIN0-AIN3 are consecutive FLOAT32 registers.
+static const char * FIRST_NAME = "AIN0";
+enum { NUM_VALUES = 4 };
+
+// The pipeline depths to test. A depth of 1 is equivalent to sequential reads.
+enum { NUM_DEPTHS = 4 };
+static const int PIPELINE_DEPTHS[NUM_DEPTHS] = {1, 2, 4, 8};
+
+// Modbus TCP framing
+enum { MBAP_HEADER_SIZE = 7 }; // Transaction ID, protocol ID, length, unit ID
+enum { READ_HOLDING_REGISTERS = 0x03 };
+enum { MODBUS_EXCEPTION_FLAG = 0x80 };
+
+// The maximum number of transactions in flight
+enum { MAX_PIPELINE_DEPTH = 16 };
+
+// The maximum number of registers per read. Keeps the responses of a full
+// pipeline (16 * 61 bytes) within the T7's 1040-byte TCP packet size,
+// LJM_MAX_TCP_PACKET_NUM_BYTES_T7.
+enum { MAX_PIPELINE_REGISTERS = 26 };
+enum { MAX_RESPONSE_SIZE = MBAP_HEADER_SIZE + 2 + 2 * MAX_PIPELINE_REGISTERS };
+
+typedef struct PipelinedRead {
+	int handle;
+	int depth;
+
+	// What is read by every transaction
+	int address;
+	int type;
+	int numValues;
+	int numRegisters;
+
+	// Transaction IDs in flight, oldest first, stored as a circular buffer
+	unsigned short aInFlightIDs[MAX_PIPELINE_DEPTH];
+	int oldestInFlight;
+	int numInFlight;
+	unsigned short nextTransactionID;
+
+	// Statistics
+	int numCompleted;
+	int numTransactionIDMismatches;
+} PipelinedRead;
+
+/**
+ * Desc: Prepares pipeline to read numValues values of the given type starting
+ *       at the register named firstName, keeping up to depth transactions in
+ *       flight.
+**/
+void InitPipelinedRead(PipelinedRead * pipeline, int handle, int depth,
+	const char * firstName, int numValues);
+
+/**
+ * Desc: Sends one read command without waiting for its response.
+ * Retr: the LJM error code, which is LJME_NOERROR on success
+**/
+int SendPipelinedRead(PipelinedRead * pipeline);
+
+/**
+ * Desc: Receives the response to the oldest transaction in flight and decodes
+ *       its values into aValues, which must hold pipeline->numValues values.
+ *       If responses to older transactions were lost, they are dropped and
+ *       counted as transaction ID mismatches.
+ * Retr: the LJM error code, which is LJME_NOERROR on success
+**/
+int ReceivePipelinedRead(PipelinedRead * pipeline, double * aValues);
+
+/**
+ * Desc: Receives and discards the responses to all transactions in flight so
+ *       that the handle can be used with other LJM functions again.
+**/
+void DrainPipelinedRead(PipelinedRead * pipeline);
+
+/**
+ * Desc: Performs numIterations reads while keeping pipeline->depth
+ *       transactions in flight. Each new command is sent before the previous
+ *       response is processed, so the device is not idle while the host works.
+ * Retr: the total time in milliseconds
+**/
+double RunPipelinedReads(PipelinedRead * pipeline, int numIterations,
+	double * aValues);
+
+/**
+ * Desc: Performs numIterations sequential LJM_eNames reads of the same values
+ * Retr: the total time in milliseconds
+**/
+double RunSequentialReads(int handle, int numIterations, const char * firstName,
+	int numValues, double * aValues);
+
+void PrintSpeedResult(const char * description, double totalMS,
+	int numIterations, double baselineMS);
+
+int main()
+{
+	int handle, err, depthI, i;
+	int connectionType;
+	double aValues[NUM_VALUES];
+	double sequentialMS, pipelinedMS;
+	char description[LJM_MAX_NAME_SIZE];
+	PipelinedRead pipeline;
+
+	// Open first found LabJack over TCP
+	handle = OpenOrDie(LJM_dtANY, LJM_ctTCP, "LJM_idANY");
+	// handle = OpenOrDie(LJM_dtANY, LJM_ctETHERNET, "LJM_idANY");
+	// handle = OpenSOrDie("LJM_dtANY", "LJM_ctTCP", "LJM_idANY");
+
+	PrintDeviceInfoFromHandle(handle);
+	printf("\n");
+
+	// ReceivePipelinedRead reads the MBAP header and the rest of each response
+	// separately, which only works on a TCP byte stream
+	err = LJM_GetHandleInfo(handle, NULL, &connectionType, NULL, NULL, NULL,
+		NULL);
+	ErrorCheck(err, "LJM_GetHandleInfo");
+	if (!IsTCP(connectionType)) {
+		printf("Pipelined reads require a TCP connection (Ethernet or WiFi), "
+			"not %s\n", NumberToConnectionType(connectionType));
+		CloseOrDie(handle);
+		WaitForUserIfWindows();
+		return 1;
+	}
+
+	printf("Reading %d values starting at %s, %d iterations per test\n\n",
+		NUM_VALUES, FIRST_NAME, NUM_ITERATIONS);
+
+	sequentialMS = RunSequentialReads(handle, NUM_ITERATIONS, FIRST_NAME,
+		NUM_VALUES, aValues);
+	PrintSpeedResult("Sequential LJM_eNames", sequentialMS, NUM_ITERATIONS,
+		sequentialMS);
+
+	for (depthI = 0; depthI < NUM_DEPTHS; depthI++) {
+		InitPipelinedRead(&pipeline, handle, PIPELINE_DEPTHS[depthI],
+			FIRST_NAME, NUM_VALUES);
+		pipelinedMS = RunPipelinedReads(&pipeline, NUM_ITERATIONS, aValues);
+
+		sprintf(description, "Pipelined, depth %d", pipeline.depth);
+		PrintSpeedResult(description, pipelinedMS, NUM_ITERATIONS,
+			sequentialMS);
+		if (pipeline.numTransactionIDMismatches) {
+			printf("    %d transaction ID mismatches\n",
+				pipeline.numTransactionIDMismatches);
+		}
+	}
+
+	printf("\nLast values read:\n");
+	for (i = 0; i < NUM_VALUES; i++) {
+		printf("    %s + %d: %f\n", FIRST_NAME, i, aValues[i]);
+	}
+
+	CloseOrDie(handle);
+
+	WaitForUserIfWindows();
+
+	return LJME_NOERROR;
+}
+
+void InitPipelinedRead(PipelinedRead * pipeline, int handle, int depth,
+	const char * firstName, int numValues)
+{
+	int err;
+
+	memset(pipeline, 0, sizeof(PipelinedRead));
+	pipeline->handle = handle;
+	pipeline->depth = depth;
+	pipeline->numValues = numValues;
+	pipeline->nextTransactionID = 1;
+
+	err = LJM_NameToAddress(firstName, &pipeline->address, &pipeline->type);
+	ErrorCheck(err, "InitPipelinedRead: LJM_NameToAddress(%s, ...)",
+		firstName);
+
+	if (pipeline->type == LJM_UINT16) {
+		pipeline->numRegisters = numValues;
+	}
+	else {
+		pipeline->numRegisters = numValues * 2;
+	}
+
+	if (depth < 1 || depth > MAX_PIPELINE_DEPTH ||
+		pipeline->numRegisters > MAX_PIPELINE_REGISTERS)
+	{
+		printf("InitPipelinedRead: depth must be 1 to %d and the read must be at most %d registers\n",
+			MAX_PIPELINE_DEPTH, MAX_PIPELINE_REGISTERS);
+		LJM_CloseAll();
+		exit(1);
+	}
+}
+
+int SendPipelinedRead(PipelinedRead * pipeline)
+{
+	int err;
+	unsigned short transactionID = pipeline->nextTransactionID++;
+	enum { COMMAND_SIZE = MBAP_HEADER_SIZE + 5 };
+	unsigned char aCommand[COMMAND_SIZE];
+
+	aCommand[0] = (unsigned char)(transactionID >> 8);
+	aCommand[1] = (unsigned char)(transactionID & 0xFF);
+	aCommand[2] = 0; // Protocol ID
+	aCommand[3] = 0;
+	aCommand[4] = 0; // Length of the remaining bytes
+	aCommand[5] = COMMAND_SIZE - 6;
+	aCommand[6] = LJM_DEFAULT_UNIT_ID;
+	aCommand[7] = READ_HOLDING_REGISTERS;
+	aCommand[8] = (unsigned char)(pipeline->address >> 8);
+	aCommand[9] = (unsigned char)(pipeline->address & 0xFF);
+	aCommand[10] = (unsigned char)(pipeline->numRegisters >> 8);
+	aCommand[11] = (unsigned char)(pipeline->numRegisters & 0xFF);
+
+	err = LJM_WriteRaw(pipeline->handle, aCommand, COMMAND_SIZE);
+	if (err != LJME_NOERROR) {
+		return err;
+	}
+
+	pipeline->aInFlightIDs[
+		(pipeline->oldestInFlight + pipeline->numInFlight) % MAX_PIPELINE_DEPTH
+	] = transactionID;
+	++pipeline->numInFlight;
+
+	return LJME_NOERROR;
+}
+
+// Removes transactions in flight up to and including transactionID. Returns 1
+// if transactionID was in flight, 0 if not.
+int _RetireTransaction(PipelinedRead * pipeline, unsigned short transactionID)
+{
+	int i, index;
+	for (i = 0; i < pipeline->numInFlight; i++) {
+		index = (pipeline->oldestInFlight + i) % MAX_PIPELINE_DEPTH;
+		if (pipeline->aInFlightIDs[index] == transactionID) {
+			// Responses to the i older transactions were lost
+			pipeline->numTransactionIDMismatches += i;
+			pipeline->oldestInFlight = (index + 1) % MAX_PIPELINE_DEPTH;
+			pipeline->numInFlight -= i + 1;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int ReceivePipelinedRead(PipelinedRead * pipeline, double * aValues)
+{
+	int err, i, numBodyBytes;
+	unsigned short transactionID;
+	unsigned char aResponse[MAX_RESPONSE_SIZE];
+	enum { HEADER_SIZE = MBAP_HEADER_SIZE + 2 }; // + function, byte count
+
+	while (pipeline->numInFlight > 0) {
+		// The header gives the size of the rest of the response, which is
+		// shorter for Modbus exception responses
+		err = LJM_ReadRaw(pipeline->handle, aResponse, HEADER_SIZE);
+		if (err != LJME_NOERROR) {
+			return err;
+		}
+
+		transactionID = (unsigned short)((aResponse[0] << 8) | aResponse[1]);
+		numBodyBytes = ((aResponse[4] << 8) | aResponse[5]) - 3;
+		if (numBodyBytes < 0 ||
+			HEADER_SIZE + numBodyBytes > MAX_RESPONSE_SIZE)
+		{
+			return LJME_INCORRECT_NUM_RESPONSE_BYTES_RECEIVED;
+		}
+		if (numBodyBytes > 0) {
+			err = LJM_ReadRaw(pipeline->handle, aResponse + HEADER_SIZE,
+				numBodyBytes);
+			if (err != LJME_NOERROR) {
+				return err;
+			}
+		}
+
+		if (!_RetireTransaction(pipeline, transactionID)) {
+			// A stale response, such as one from before a timeout
+			++pipeline->numTransactionIDMismatches;
+			continue;
+		}
+
+		if (aResponse[7] & MODBUS_EXCEPTION_FLAG) {
+			// LJME_MBE1_ILLEGAL_FUNCTION, LJME_MBE2_ILLEGAL_DATA_ADDRESS, etc.
+			return LJME_MODBUS_ERRORS_BEGIN + aResponse[8];
+		}
+		if (aResponse[8] != pipeline->numRegisters * 2) {
+			return LJME_INCORRECT_NUM_RESPONSE_BYTES_RECEIVED;
+		}
+
+		// Registers are big-endian, as expected by the LJM conversion functions
+		switch (pipeline->type) {
+		case LJM_FLOAT32: {
+			float aFloats[MAX_PIPELINE_REGISTERS / 2];
+			LJM_ByteArrayToFLOAT32((const char *)aResponse + HEADER_SIZE, 0,
+				pipeline->numValues, aFloats);
+			for (i = 0; i < pipeline->numValues; i++) {
+				aValues[i] = aFloats[i];
+			}
+			break;
+		}
+		case LJM_UINT16: {
+			unsigned short aUINT16s[MAX_PIPELINE_REGISTERS];
+			LJM_ByteArrayToUINT16((const char *)aResponse + HEADER_SIZE, 0,
+				pipeline->numValues, aUINT16s);
+			for (i = 0; i < pipeline->numValues; i++) {
+				aValues[i] = aUINT16s[i];
+			}
+			break;
+		}
+		case LJM_UINT32: {
+			unsigned int aUINT32s[MAX_PIPELINE_REGISTERS / 2];
+			LJM_ByteArrayToUINT32((const char *)aResponse + HEADER_SIZE, 0,
+				pipeline->numValues, aUINT32s);
+			for (i = 0; i < pipeline->numValues; i++) {
+				aValues[i] = aUINT32s[i];
+			}
+			break;
+		}
+		default: {
+			int aINT32s[MAX_PIPELINE_REGISTERS / 2];
+			LJM_ByteArrayToINT32((const char *)aResponse + HEADER_SIZE, 0,
+				pipeline->numValues, aINT32s);
+			for (i = 0; i < pipeline->numValues; i++) {
+				aValues[i] = aINT32s[i];
+			}
+			break;
+		}
+		}
+
+		++pipeline->numCompleted;
+		return LJME_NOERROR;
+	}
+
+	return LJME_NO_RESPONSE_BYTES_RECEIVED;
+}
+
+void DrainPipelinedRead(PipelinedRead * pipeline)
+{
+	int err;
+	double aValues[MAX_PIPELINE_REGISTERS];
+	while (pipeline->numInFlight > 0) {
+		err = ReceivePipelinedRead(pipeline, aValues);
+		if (err != LJME_NOERROR) {
+			PrintErrorIfError(err, "DrainPipelinedRead");
+			pipeline->numInFlight = 0;
+		}
+	}
+}
+
+double RunPipelinedReads(PipelinedRead * pipeline, int numIterations,
+	double * aValues)
+{
+	int err;
+	int numSent = 0;
+	LJM_LONG_LONG_RETURN start = LJM_GetHostTick();
+
+	// Fill the pipeline
+	while (numSent < numIterations && pipeline->numInFlight < pipeline->depth) {
+		err = SendPipelinedRead(pipeline);
+		ErrorCheck(err, "RunPipelinedReads: SendPipelinedRead");
+		++numSent;
+	}
+
+	while (pipeline->numCompleted < numIterations) {
+		err = ReceivePipelinedRead(pipeline, aValues);
+		if (err != LJME_NOERROR) {
+			DrainPipelinedRead(pipeline);
+			ErrorCheck(err, "RunPipelinedReads: ReceivePipelinedRead");
+		}
+
+		// Keep the device busy before processing aValues
+		if (numSent < numIterations) {
+			err = SendPipelinedRead(pipeline);
+			ErrorCheck(err, "RunPipelinedReads: SendPipelinedRead");
+			++numSent;
+		}
+
+		// Process aValues here
+	}
+
+	return (LJM_GetHostTick() - start) / 1000.0;
+}
+
+double RunSequentialReads(int handle, int numIterations, const char * firstName,
+	int numValues, double * aValues)
+{
+	int err, i;
+	int errorAddress = INITIAL_ERR_ADDRESS;
+	int aWrites[1] = {LJM_READ};
+	int aNumValues[1];
+	LJM_LONG_LONG_RETURN start;
+
+	aNumValues[0] = numValues;
+
+	start = LJM_GetHostTick();
+	for (i = 0; i < numIterations; i++) {
+		err = LJM_eNames(handle, 1, &firstName, aWrites, aNumValues, aValues,
+			&errorAddress);
+		ErrorCheckWithAddress(err, errorAddress, "RunSequentialReads: LJM_eNames");
+	}
+
+	return (LJM_GetHostTick() - start) / 1000.0;
+}
+
+void PrintSpeedResult(const char * description, double totalMS,
+	int numIterations, double baselineMS)
+{
+	printf("%-24s %10.3f ms total, %8.4f ms/read, %8.1f reads/s, %5.2fx\n",
+		description, totalMS, totalMS / numIterations,
+		numIterations * 1000.0 / totalMS, baselineMS / totalMS);
+}
@@ -0,0 +1,128 @@
+/**
+ * Name: register_shadow_test.c
+ * Desc: Repeatedly applies the same stream configuration through a
+ *       RegisterShadow and reports how many configuration writes were skipped
+ *       and how long each configuration pass took.
+ * Note: Unplug and replug the device (or reboot it) while this test waits for
+ *       user input to see the shadow invalidated by the reconnect callback.
+ *
+ * Relevant Documentation:
+ *
+ * LJM Library:
+ *	LJM Library Installer:
+ *		https://labjack.com/support/software/installers/ljm
+ *	LJM Users Guide:
+ *		https://labjack.com/support/software/api/ljm
+ *	Opening and Closing:
+ *		https://labjack.com/support/software/api/ljm/function-reference/opening-and-closing
+ *	Multiple Value Functions(such as eWriteNames):
+ *		https://labjack.com/support/software/api/ljm/function-reference/multiple-value-functions
+ *	RegisterDeviceReconnectCallback:
+ *		https://labjack.com/support/software/api/ljm/function-reference/LJMRegisterDeviceReconnectCallback
+ *
+ * T-Series and I/O:
+ *	Modbus Map:
+ *		https://labjack.com/support/software/api/modbus/modbus-map
+ *	Stream Mode:
+ *		https://labjack.com/support/datasheets/t-series/communication/stream-mode
+ *	Analog Inputs:
+ *		https://labjack.com/support/datasheets/t-series/ain
+**/
+
+// For printf
+#include <stdio.h>
+
+// For the LabJackM Library
+#include <LabJackM.h>
+
+// For RegisterShadow and the LJM_Utilities.h helper functions
+#include "../../LJM_RegisterShadow.h"
+
+enum { NUM_ITERATIONS = 5 };
+
+enum { NUM_CONFIG_FRAMES = 6 };
+static const char * CONFIG_NAMES[NUM_CONFIG_FRAMES] = {
+	"STREAM_TRIGGER_INDEX",
+	"STREAM_CLOCK_SOURCE",
+	"STREAM_RESOLUTION_INDEX",
+	"STREAM_SETTLING_US",
+	"AIN_ALL_RANGE",
+	"AIN_ALL_NEGATIVE_CH"
+};
+
+/**
+ * Desc: Writes the stream configuration through shadow and prints how many
+ *       frames were actually sent to the device.
+**/
+void ConfigureStream(RegisterShadow * shadow, int numFrames);
+
+int main()
+{
+	int handle, iteration;
+	int numFrames = NUM_CONFIG_FRAMES;
+	double aValues[NUM_CONFIG_FRAMES];
+	RegisterShadow shadow;
+
+	// Open first found LabJack
+	handle = OpenOrDie(LJM_dtANY, LJM_ctANY, "LJM_idANY");
+	// handle = OpenSOrDie("LJM_dtANY", "LJM_ctANY", "LJM_idANY");
+
+	PrintDeviceInfoFromHandle(handle);
+	printf("\n");
+
+	// Range and negative ch registers are not valid for the T4, so don't use
+	// them if the device is a T4.
+	if (GetDeviceType(handle) == LJM_dtT4) {
+		numFrames = NUM_CONFIG_FRAMES - 2;
+	}
+
+	InitRegisterShadow(&shadow, handle);
+
+	// The first read goes to the device, the second is served from the shadow
+	ShadowReadNamesOrDie(&shadow, numFrames, CONFIG_NAMES, aValues);
+	ShadowReadNamesOrDie(&shadow, numFrames, CONFIG_NAMES, aValues);
+
+	for (iteration = 0; iteration < NUM_ITERATIONS; iteration++) {
+		printf("iteration %d: ", iteration);
+		ConfigureStream(&shadow, numFrames);
+	}
+
+	printf("\nUnplug and replug the device (or leave it connected).\n");
+	WaitForUser();
+
+	// If the device reconnected, every frame is written again
+	printf("after reconnect: ");
+	ConfigureStream(&shadow, numFrames);
+	printf("\n");
+
+	PrintRegisterShadowStatistics(&shadow);
+
+	CleanRegisterShadow(&shadow);
+
+	CloseOrDie(handle);
+
+	WaitForUserIfWindows();
+
+	return LJME_NOERROR;
+}
+
+void ConfigureStream(RegisterShadow * shadow, int numFrames)
+{
+	int err, numWritten;
+	LJM_LONG_LONG_RETURN start;
+	double aValues[NUM_CONFIG_FRAMES] = {
+		0,      // STREAM_TRIGGER_INDEX: triggered stream disabled
+		0,      // STREAM_CLOCK_SOURCE: internally clocked
+		0,      // STREAM_RESOLUTION_INDEX: default
+		0,      // STREAM_SETTLING_US: auto
+		10.0,   // AIN_ALL_RANGE: +/-10 V
+		LJM_GND // AIN_ALL_NEGATIVE_CH: single-ended
+	};
+
+	start = LJM_GetHostTick();
+	err = ShadowWriteNames(shadow, numFrames, CONFIG_NAMES, aValues,
+		&numWritten);
+	ErrorCheck(err, "ConfigureStream: ShadowWriteNames");
+	printf("wrote %d of %d frames in %.3f ms\n", numWritten, numFrames,
+		(LJM_GetHostTick() - start) / 1000.0);
+}
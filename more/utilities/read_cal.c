@@ -13,8 +13,6 @@
  *		https://labjack.com/support/software/api/ljm/function-reference/opening-and-closing
  *	eAddresses:
  *		https://labjack.com/support/software/api/ljm/function-reference/ljmeaddresses
- *	eWriteAddress:
- *		https://labjack.com/support/software/api/ljm/function-reference/ljmewriteaddress
  *
  * T-Series and I/O:
  *	Modbus Map:
@@ -29,9 +27,10 @@
 // For the LabJackM library
 #include <LabJackM.h>
 
-// For LabJackM helper functions, such as OpenOrDie, PrintDeviceInfoFromHandle,
+// For the calibration constant structures, such as DeviceCalibrationT7,
+// ReadFlashRegion, and LabJackM helper functions, such as OpenOrDie,
 // ErrorCheck, etc.
-#include "../../LJM_Utilities.h"
+#include "../../LJM_CalibrationUtilities.h"
 
 /**
  * Desc: Reads and displays calibration information. If there is
@@ -77,64 +76,24 @@ int main()
 	return LJME_NOERROR;
 }
 
-typedef struct {
-	float PSlope;
-	float NSlope;
-	float Center;
-	float Offset;
-} Cal_Set;
-
-typedef struct{
-	Cal_Set HS[4];
-	Cal_Set HR[4];
-
-	struct{
-		float Slope;
-		float Offset;
-	} DAC[2];
-
-	float Temp_Slope;
-	float Temp_Offset;
-
-	float ISource_10u;
-	float ISource_200u;
-
-	float I_Bias;
-} DeviceCalibrationT8;
-
 void ReadT8Cal(int handle)
 {
-	int err, valueI;
-	int errorAddress = INITIAL_ERR_ADDRESS;
+	int err, valueI, numRoundTrips;
 
-	const double EFAdd_CalValues = 0x3C4000;
-
-	const int FLASH_PTR_ADDRESS = 61810;
-	const int FLASH_PTR_TYPE = LJM_UINT32;
-
-	// 3 packets of 13 values, one packet of 2 values
-	enum { NUM_FRAMES = 4 };
-	const int FLASH_READ_ADDRESSES[1] = {61812};
-	const int FLASH_READ_TYPES[1] = {LJM_FLOAT32};
-	const int FLASH_READ_DIRECTIONS[1] = {LJM_READ};
-	const int FLASH_READ_NUM_VALUES[NUM_FRAMES] = {13, 13, 13, 2};
 	enum { NUM_VALUES = 41 };
 	double calValues[NUM_VALUES] = {0.0};
 
 	DeviceCalibrationT8 cal;
 
 	int i;
-	for (i = 0; i < NUM_FRAMES; i++) {
-		// Set the pointer. This indicates which part of the memory we want to read
-		err = LJM_eWriteAddress(handle, FLASH_PTR_ADDRESS, FLASH_PTR_TYPE,
-			EFAdd_CalValues + i * 13 * 4);
-		ErrorCheck(err, "LJM_eWriteAddress while writing the flash pointer");
-
-		err = LJM_eAddresses(handle, 1, FLASH_READ_ADDRESSES, FLASH_READ_TYPES,
-			FLASH_READ_DIRECTIONS, &(FLASH_READ_NUM_VALUES[i]),
-			calValues + i * 13, &errorAddress);
-		ErrorCheckWithAddress(err, errorAddress, "LJM_eAddresses while reading from flash");
-	}
+
+	// Write the flash pointer and read the values in as few packets as the
+	// connection allows
+	err = ReadFlashRegion(handle, CAL_FLASH_ADDRESS, NUM_VALUES, LJM_FLOAT32,
+		calValues, &numRoundTrips);
+	ErrorCheck(err, "ReadFlashRegion");
+	printf("Read %d values in %d round trip(s)\n\n", NUM_VALUES,
+		numRoundTrips);
 
 	// Copy to our cal constants structure
 	for (valueI = 0; valueI < NUM_VALUES; valueI++) {
@@ -175,57 +134,24 @@ void ReadT8Cal(int handle)
 	printf("I_Bias: %+.10f\n", cal.I_Bias);
 }
 
-typedef struct{
-	Cal_Set HS[4];
-	Cal_Set HR[4];
-
-	struct{
-		float Slope;
-		float Offset;
-	} DAC[2];
-
-	float Temp_Slope;
-	float Temp_Offset;
-
-	float ISource_10u;
-	float ISource_200u;
-
-	float I_Bias;
-} DeviceCalibrationT7;
-
 void ReadT7Cal(int handle)
 {
-	int err, valueI;
-	int errorAddress = INITIAL_ERR_ADDRESS;
+	int err, valueI, numRoundTrips;
 
-	const double EFAdd_CalValues = 0x3C4000;
-
-	const int FLASH_PTR_ADDRESS = 61810;
-	const int FLASH_PTR_TYPE = LJM_UINT32;
-
-	// 3 frames of 13 values, one frame of 2 values
-	enum { NUM_FRAMES = 4 };
-	const int FLASH_READ_ADDRESSES[1] = {61812};
-	const int FLASH_READ_TYPES[1] = {LJM_FLOAT32};
-	const int FLASH_READ_DIRECTIONS[1] = {LJM_READ};
-	const int FLASH_READ_NUM_VALUES[NUM_FRAMES] = {13, 13, 13, 2};
 	enum { NUM_VALUES = 41 };
 	double calValues[NUM_VALUES] = {0.0};
 
 	DeviceCalibrationT7 cal;
 
 	int i;
-	for (i=0; i<NUM_FRAMES; i++) {
-		// Set the pointer. This indicates which part of the memory we want to read
-		err = LJM_eWriteAddress(handle, FLASH_PTR_ADDRESS, FLASH_PTR_TYPE, EFAdd_CalValues + i * 13 * 4);
-		ErrorCheck(err, "LJM_eWriteAddress(..., %d, %d, %f)", FLASH_PTR_ADDRESS, FLASH_PTR_TYPE,
-			EFAdd_CalValues);
-
-		err = LJM_eAddresses(handle, 1, FLASH_READ_ADDRESSES, FLASH_READ_TYPES,
-			FLASH_READ_DIRECTIONS, &(FLASH_READ_NUM_VALUES[i]), calValues + i * 13,
-			&errorAddress);
-		ErrorCheckWithAddress(err, errorAddress, "LJM_eAddresses");
-	}
+
+	// Write the flash pointer and read the values in as few packets as the
+	// connection allows
+	err = ReadFlashRegion(handle, CAL_FLASH_ADDRESS, NUM_VALUES, LJM_FLOAT32,
+		calValues, &numRoundTrips);
+	ErrorCheck(err, "ReadFlashRegion");
+	printf("Read %d values in %d round trip(s)\n\n", NUM_VALUES,
+		numRoundTrips);
 
 	// Copy to our cal constants structure
 	for (valueI=0; valueI<NUM_VALUES; valueI++) {
@@ -266,63 +192,24 @@ void ReadT7Cal(int handle)
 	printf("I_Bias: %+.10f\n", cal.I_Bias);
 }
 
-typedef struct{
-    struct { // 0
-        float Slope;
-        float Offset;
-    } HV[4];
-    struct { // 32
-        float Slope;
-        float Offset;
-    } LV;
-    struct { // 40
-        float Slope;
-        float Offset;
-    } SpecV;
-    struct { // 48
-        float Slope;
-        float Offset;
-    } DAC[2];
-
-    float Temp_Slope;   // 64
-    float Temp_Offset;  // 68
-
-    float I_Bias;   // 72
-} DeviceCalibrationT4;
-
 void ReadT4Cal(int handle)
 {
-	int err, valueI;
-	int errorAddress = INITIAL_ERR_ADDRESS;
-
-	const double EFAdd_CalValues = 0x3C4000;
+	int err, valueI, numRoundTrips;
 
-	const int FLASH_PTR_ADDRESS = 61810;
-	const int FLASH_PTR_TYPE = LJM_UINT32;
-
-	// One frame of 13 values, one frame of 6 values
-	enum { NUM_FRAMES = 2 };
-	const int FLASH_READ_ADDRESSES[1] = {61812};
-	const int FLASH_READ_TYPES[1] = {LJM_FLOAT32};
-	const int FLASH_READ_DIRECTIONS[1] = {LJM_READ};
-	const int FLASH_READ_NUM_VALUES[NUM_FRAMES] = {13, 6};
 	enum { NUM_VALUES = 19 };
 	double calValues[NUM_VALUES] = {0.0};
 
 	DeviceCalibrationT4 cal;
 
 	int i;
-	for (i=0; i<NUM_FRAMES; i++) {
-		// Set the pointer. This indicates which part of the memory we want to read
-		err = LJM_eWriteAddress(handle, FLASH_PTR_ADDRESS, FLASH_PTR_TYPE, EFAdd_CalValues + i * 13 * 4);
-		ErrorCheck(err, "LJM_eWriteAddress(..., %d, %d, %f)", FLASH_PTR_ADDRESS, FLASH_PTR_TYPE,
-			EFAdd_CalValues);
-
-		err = LJM_eAddresses(handle, 1, FLASH_READ_ADDRESSES, FLASH_READ_TYPES,
-			FLASH_READ_DIRECTIONS, &(FLASH_READ_NUM_VALUES[i]), calValues + i * 13,
-			&errorAddress);
-		ErrorCheckWithAddress(err, errorAddress, "LJM_eAddresses");
-	}
+
+	// Write the flash pointer and read the values in as few packets as the
+	// connection allows
+	err = ReadFlashRegion(handle, CAL_FLASH_ADDRESS, NUM_VALUES, LJM_FLOAT32,
+		calValues, &numRoundTrips);
+	ErrorCheck(err, "ReadFlashRegion");
+	printf("Read %d values in %d round trip(s)\n\n", NUM_VALUES,
+		numRoundTrips);
 
 	// Copy to our cal constants structure
 	for (valueI=0; valueI<NUM_VALUES; valueI++) {
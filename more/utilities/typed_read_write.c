@@ -0,0 +1,121 @@
+/**
+ * Name: typed_read_write.c
+ * Desc: Demonstrates the LJM_TypedUtilities.h functions, which read and write
+ *       registers as their native types (unsigned short, unsigned int, float)
+ *       instead of as doubles, and compares their speed with LJM_eReadNames.
+ *
+ * Relevant Documentation:
+ *
+ * LJM Library:
+ *	LJM Library Installer:
+ *		https://labjack.com/support/software/installers/ljm
+ *	LJM Users Guide:
+ *		https://labjack.com/support/software/api/ljm
+ *	Opening and Closing:
+ *		https://labjack.com/support/software/api/ljm/function-reference/opening-and-closing
+ *	Multiple Value Functions(such as eReadAddressByteArray):
+ *		https://labjack.com/support/software/api/ljm/function-reference/multiple-value-functions
+ *
+ * T-Series and I/O:
+ *	Modbus Map:
+ *		https://labjack.com/support/software/api/modbus/modbus-map
+ *	Digital I/O:
+ *		https://labjack.com/support/datasheets/t-series/digital-io
+ *	Analog Inputs:
+ *		https://labjack.com/support/datasheets/t-series/ain
+ *	DAC:
+ *		https://labjack.com/support/datasheets/t-series/dac
+**/
+
+// For printf
+#include <stdio.h>
+
+// For the LabJackM Library
+#include <LabJackM.h>
+
+// For typed read/write functions and the LJM_Utilities.h helper functions
+#include "../../LJM_TypedUtilities.h"
+
+enum { NUM_ITERATIONS = 100 };
+
+// FIO_STATE, EIO_STATE and CIO_STATE are consecutive UINT16 registers
+enum { NUM_DIO_STATES = 3 };
+static const char * DIO_STATE_NAMES[NUM_DIO_STATES] = {
+	"FIO_STATE",
+	"EIO_STATE",
+	"CIO_STATE"
+};
+
+// AIN0-AIN3 are consecutive FLOAT32 registers
+enum { NUM_AIN = 4 };
+
+// DAC0 and DAC1 are consecutive FLOAT32 registers
+enum { NUM_DACS = 2 };
+
+int main()
+{
+	int handle, i;
+	unsigned short aDIOStates[NUM_DIO_STATES];
+	unsigned int dioState;
+	float aAIN[NUM_AIN];
+	const float aDACVolts[NUM_DACS] = {1.5f, 2.5f};
+	double aDoubleDIOStates[NUM_DIO_STATES];
+	int errorAddress = INITIAL_ERR_ADDRESS;
+	int err;
+	LJM_LONG_LONG_RETURN start;
+	double typedMS, doubleMS;
+
+	// Open first found LabJack
+	handle = OpenOrDie(LJM_dtANY, LJM_ctANY, "LJM_idANY");
+	// handle = OpenSOrDie("LJM_dtANY", "LJM_ctANY", "LJM_idANY");
+
+	PrintDeviceInfoFromHandle(handle);
+	printf("\n");
+
+	WriteNameFLOAT32ArrayOrDie(handle, "DAC0", NUM_DACS, aDACVolts);
+	printf("Wrote DAC0 = %.2f V, DAC1 = %.2f V\n\n", aDACVolts[0],
+		aDACVolts[1]);
+
+	ReadNameUINT16ArrayOrDie(handle, DIO_STATE_NAMES[0], NUM_DIO_STATES,
+		aDIOStates);
+	for (i = 0; i < NUM_DIO_STATES; i++) {
+		printf("%s: 0x%04x\n", DIO_STATE_NAMES[i], aDIOStates[i]);
+	}
+
+	ReadNameUINT32ArrayOrDie(handle, "DIO_STATE", 1, &dioState);
+	printf("DIO_STATE: 0x%06x\n", dioState);
+
+	ReadNameFLOAT32ArrayOrDie(handle, "AIN0", NUM_AIN, aAIN);
+	for (i = 0; i < NUM_AIN; i++) {
+		printf("AIN%d: %f V\n", i, aAIN[i]);
+	}
+	printf("\n");
+
+	// Compare with the double-based LJM_eReadNames
+	start = LJM_GetHostTick();
+	for (i = 0; i < NUM_ITERATIONS; i++) {
+		ReadNameUINT16ArrayOrDie(handle, DIO_STATE_NAMES[0], NUM_DIO_STATES,
+			aDIOStates);
+	}
+	typedMS = (LJM_GetHostTick() - start) / 1000.0;
+
+	start = LJM_GetHostTick();
+	for (i = 0; i < NUM_ITERATIONS; i++) {
+		err = LJM_eReadNames(handle, NUM_DIO_STATES, DIO_STATE_NAMES,
+			aDoubleDIOStates, &errorAddress);
+		ErrorCheckWithAddress(err, errorAddress, "LJM_eReadNames");
+	}
+	doubleMS = (LJM_GetHostTick() - start) / 1000.0;
+
+	printf("%d reads of %d DIO states:\n", NUM_ITERATIONS, NUM_DIO_STATES);
+	printf("    typed UINT16: %.3f ms/read, %d bytes of results\n",
+		typedMS / NUM_ITERATIONS, (int)sizeof(aDIOStates));
+	printf("    double:       %.3f ms/read, %d bytes of results\n",
+		doubleMS / NUM_ITERATIONS, (int)sizeof(aDoubleDIOStates));
+
+	CloseOrDie(handle);
+
+	WaitForUserIfWindows();
+
+	return LJME_NOERROR;
+}